@@ -44,6 +44,24 @@ android {
                 "proguard-rules.pro",
             )
         }
+
+        // Release with ThinLTO and PGO for the native library. The profile comes from
+        // tools/pgo/pgo.sh device; -Pvrboy.pgoProfile=<file> points at another one.
+        create("releasePgo") {
+            initWith(getByName("release"))
+            matchingFallbacks += listOf("release")
+            val pgoProfile = (project.findProperty("vrboy.pgoProfile") as String?)
+                ?: rootProject.file("build/pgo/vbcore.profdata").path
+            externalNativeBuild {
+                cmake {
+                    arguments += listOf(
+                        "-DVRBOY_LTO=ON",
+                        "-DVRBOY_PGO=USE",
+                        "-DVRBOY_PGO_PROFILE=$pgoProfile",
+                    )
+                }
+            }
+        }
     }
 
     compileOptions {
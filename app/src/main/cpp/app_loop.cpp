@@ -0,0 +1,72 @@
+#include "app_loop.h"
+
+#include <thread>
+
+#include "log.h"
+#include "xr_stereo_renderer.h"
+
+void AppLoop::setRunning(const bool running) {
+    running_ = running;
+    lifecycleChanged();
+}
+
+void AppLoop::setResumed(const bool resumed) {
+    resumed_ = resumed;
+    lifecycleChanged();
+}
+
+void AppLoop::lifecycleChanged() {
+    // Parked threads block on a condition variable instead of pacing xrWaitFrame at display
+    // rate; the frame in flight still ends.
+    xrRenderer_.setFramePipelinePaused(!active());
+    nextEventPoll_ = Clock::now() + kPausedEventPollInterval;
+}
+
+std::optional<AppLoop::Clock::time_point> AppLoop::nextWakeTime() const {
+    if (active()) {
+        return nextTickTime_;
+    }
+    if (xrRenderer_.initialized() && !xrRenderer_.exitRequested()) {
+        return nextEventPoll_;
+    }
+    return std::nullopt;
+}
+
+bool AppLoop::pollXrEvents() {
+    if (!xrRenderer_.initialized()) {
+        return true;
+    }
+    xrRenderer_.pollEvents();
+    if (xrRenderer_.exitRequested()) {
+        LOGW("OpenXR requested exit");
+        running_ = false;
+        lifecycleChanged();
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::chrono::nanoseconds> AppLoop::tick(const std::function<void()>& frame) {
+    // The looper wait is whole milliseconds; sleep off the rest instead of spinning through it.
+    if (!active()) {
+        if (xrRenderer_.initialized() && !xrRenderer_.exitRequested()) {
+            std::this_thread::sleep_until(nextEventPoll_);
+            nextEventPoll_ = Clock::now() + kPausedEventPollInterval;
+            pollXrEvents();
+        }
+        return std::nullopt;
+    }
+
+    std::this_thread::sleep_until(nextTickTime_);
+    const auto workStart = Clock::now();
+    if (!pollXrEvents()) {
+        return std::nullopt;
+    }
+    frame();
+
+    const auto now = Clock::now();
+    const DisplayPhase display =
+        xrRenderer_.initialized() ? xrRenderer_.displayPhase() : DisplayPhase{};
+    nextTickTime_ = pacer_.nextFrameStart(now, display);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now - workStart);
+}
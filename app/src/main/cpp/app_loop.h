@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+
+#include "display_timing.h"
+
+class XrStereoRenderer;
+
+// Schedule of the emulation thread, which android_main drives from the looper. Started and
+// resumed, it wakes once per paced source frame. Paused or stopped, the XR frame threads are
+// parked and it only wakes every kPausedEventPollInterval to poll XR events, so a session
+// that stops or exits meanwhile is still ended. Emulation thread only.
+class AppLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds kPausedEventPollInterval{100};
+
+    explicit AppLoop(XrStereoRenderer& xrRenderer) : xrRenderer_(xrRenderer) {}
+
+    // APP_CMD_START / APP_CMD_STOP.
+    void setRunning(bool running);
+    // APP_CMD_RESUME / APP_CMD_PAUSE.
+    void setResumed(bool resumed);
+    [[nodiscard]] bool active() const { return running_ && resumed_; }
+
+    // When tick() next has work; nullopt when nothing will until a lifecycle event.
+    [[nodiscard]] std::optional<Clock::time_point> nextWakeTime() const;
+
+    // Active: sleeps off the rest of the looper wait, polls XR events, runs frame() and
+    // schedules the next frame; returns the work time. Inactive: polls XR events when due.
+    // Returns nullopt when no frame ran.
+    std::optional<std::chrono::nanoseconds> tick(const std::function<void()>& frame);
+
+    // Display time of the frame being produced, for the flat renderer's presentation time.
+    [[nodiscard]] int64_t presentTimeNs() const { return pacer_.presentTimeNs(); }
+
+private:
+    void lifecycleChanged();
+    // Polls XR events; false once the runtime asked the app to exit.
+    bool pollXrEvents();
+
+    XrStereoRenderer& xrRenderer_;
+    EmulationPacer pacer_{kVbRefreshHz};
+    bool running_ = false;
+    bool resumed_ = false;
+    Clock::time_point nextTickTime_{};
+    Clock::time_point nextEventPoll_{};
+};
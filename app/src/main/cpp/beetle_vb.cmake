@@ -0,0 +1,98 @@
+# Beetle VB core sources and build settings, shared by the app and tools/core_bench.
+# Set BEETLE_VB_DIR before including.
+
+if(NOT EXISTS "${BEETLE_VB_DIR}/libretro.cpp")
+    message(FATAL_ERROR
+        "Missing Beetle VB core source at ${BEETLE_VB_DIR}. "
+        "Run: git submodule update --init --recursive"
+    )
+endif()
+
+set(BEETLE_VB_SOURCES
+    "${BEETLE_VB_DIR}/libretro.cpp"
+    "${BEETLE_VB_DIR}/mednafen/hw_cpu/v810/v810_cpu.cpp"
+    "${BEETLE_VB_DIR}/mednafen/mempatcher.cpp"
+    "${BEETLE_VB_DIR}/mednafen/vb/vsu.c"
+    "${BEETLE_VB_DIR}/mednafen/vb/input.c"
+    "${BEETLE_VB_DIR}/mednafen/vb/timer.c"
+    "${BEETLE_VB_DIR}/mednafen/vb/vip.c"
+    "${BEETLE_VB_DIR}/mednafen/hw_cpu/v810/fpu-new/softfloat.c"
+    "${BEETLE_VB_DIR}/mednafen/sound/Blip_Buffer.c"
+    "${BEETLE_VB_DIR}/mednafen/state.c"
+    "${BEETLE_VB_DIR}/mednafen/settings.c"
+    "${BEETLE_VB_DIR}/libretro-common/compat/compat_strl.c"
+    "${BEETLE_VB_DIR}/libretro-common/compat/compat_snprintf.c"
+)
+
+set(BEETLE_VB_INCLUDE_DIRS
+    "${BEETLE_VB_DIR}"
+    "${BEETLE_VB_DIR}/mednafen"
+    "${BEETLE_VB_DIR}/mednafen/include"
+    "${BEETLE_VB_DIR}/mednafen/hw_sound"
+    "${BEETLE_VB_DIR}/mednafen/hw_cpu"
+    "${BEETLE_VB_DIR}/mednafen/hw_misc"
+    "${BEETLE_VB_DIR}/libretro-common/include"
+)
+
+set(BEETLE_VB_DEFINITIONS
+    WANT_32BPP
+    FRONTEND_SUPPORTS_RGB565
+    STDC_HEADERS
+    __STDC_LIMIT_MACROS
+    __LIBRETRO__
+    MEDNAFEN_VERSION=\"0.9.31\"
+    MEDNAFEN_VERSION_NUMERIC=931
+    INLINE=inline
+    LSB_FIRST
+)
+
+# Whole-program and profile-guided optimization (clang only):
+#   VRBOY_LTO=ON                      ThinLTO
+#   VRBOY_PGO=GENERATE                instrumented build; runs write LLVM_PROFILE_FILE
+#   VRBOY_PGO=USE                     optimize with VRBOY_PGO_PROFILE (.profdata)
+# Profiles come from tools/pgo/pgo.sh, which replays input movies through tools/core_bench.
+option(VRBOY_LTO "Build with ThinLTO" OFF)
+set(VRBOY_PGO "OFF" CACHE STRING "Profile-guided optimization: OFF, GENERATE or USE")
+set_property(CACHE VRBOY_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(VRBOY_PGO_PROFILE "" CACHE FILEPATH "Merged .profdata for VRBOY_PGO=USE")
+
+function(vrboy_apply_optimizations target)
+    if(NOT VRBOY_LTO AND VRBOY_PGO STREQUAL "OFF")
+        return()
+    endif()
+    if(NOT CMAKE_CXX_COMPILER_ID MATCHES "Clang" OR NOT CMAKE_C_COMPILER_ID MATCHES "Clang")
+        message(FATAL_ERROR "VRBOY_LTO and VRBOY_PGO need clang")
+    endif()
+
+    if(VRBOY_LTO)
+        target_compile_options(${target} PRIVATE -flto=thin)
+        target_link_options(${target} PRIVATE -flto=thin)
+        if(NOT ANDROID)
+            # The NDK links with lld already; GNU ld cannot read ThinLTO bitcode.
+            target_link_options(${target} PRIVATE -fuse-ld=lld)
+        endif()
+    endif()
+
+    if(VRBOY_PGO STREQUAL "GENERATE")
+        target_compile_options(${target} PRIVATE -fprofile-instr-generate)
+        target_link_options(${target} PRIVATE -fprofile-instr-generate)
+    elseif(VRBOY_PGO STREQUAL "USE")
+        if(NOT EXISTS "${VRBOY_PGO_PROFILE}")
+            message(FATAL_ERROR
+                "VRBOY_PGO=USE needs VRBOY_PGO_PROFILE; got '${VRBOY_PGO_PROFILE}'. "
+                "Collect one with tools/pgo/pgo.sh"
+            )
+        endif()
+        # Front-end profiles match by function and control-flow hash, so a profile collected
+        # from core_bench applies to the same sources in the app. Functions it never ran, and
+        # target-specific paths such as the NEON blitter, are left unprofiled.
+        target_compile_options(
+            ${target} PRIVATE
+            "-fprofile-instr-use=${VRBOY_PGO_PROFILE}"
+            -Wno-profile-instr-unprofiled
+            -Wno-profile-instr-out-of-date
+        )
+    elseif(NOT VRBOY_PGO STREQUAL "OFF")
+        message(FATAL_ERROR "VRBOY_PGO must be OFF, GENERATE or USE; got '${VRBOY_PGO}'")
+    endif()
+endfunction()
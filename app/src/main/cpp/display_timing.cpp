@@ -0,0 +1,131 @@
+#include "display_timing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Cadence errors closer than this are treated as equal so the cheaper rate wins.
+constexpr float kCadenceTieTolerance = 0.01f;
+// Falling further behind than this restarts the schedule instead of bursting to catch up.
+constexpr auto kMaxPacerLag = std::chrono::milliseconds(100);
+
+}  // namespace
+
+float CadenceError(const float displayHz, const double sourceHz) {
+    if (displayHz <= 0.0f || sourceHz <= 0.0) {
+        return 1.0f;
+    }
+    const double ratio = static_cast<double>(displayHz) / sourceHz;
+    const double repeats = std::max(1.0, std::round(ratio));
+    return static_cast<float>(std::abs(ratio - repeats));
+}
+
+int LooperTimeoutMs(
+    const std::optional<std::chrono::steady_clock::time_point>& deadline,
+    const std::chrono::steady_clock::time_point now) {
+    if (!deadline) {
+        return -1;
+    }
+    if (*deadline <= now) {
+        return 0;
+    }
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - now).count();
+    return static_cast<int>(std::min<int64_t>(remaining, std::numeric_limits<int>::max()));
+}
+
+float SelectDisplayRefreshRate(const float* rates, const size_t count, const double sourceHz) {
+    float bestRate = 0.0f;
+    float bestError = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const float rate = rates[i];
+        if (rate <= 0.0f) {
+            continue;
+        }
+        const float error = CadenceError(rate, sourceHz);
+        const bool better = bestRate == 0.0f || error < bestError - kCadenceTieTolerance ||
+                            (error <= bestError + kCadenceTieTolerance && rate < bestRate);
+        if (better) {
+            bestRate = rate;
+            bestError = error;
+        }
+    }
+    return bestRate;
+}
+
+void CadenceStats::reset(const float displayHz, const double sourceHz) {
+    *this = CadenceStats{};
+    if (displayHz > 0.0f && sourceHz > 0.0) {
+        expectedRepeats_ =
+            std::max(1, static_cast<int>(std::lround(static_cast<double>(displayHz) / sourceHz)));
+    }
+}
+
+void CadenceStats::recordDisplayFrame(const bool newSourceFrame) {
+    if (newSourceFrame) {
+        // The first frame has no predecessor to judge.
+        if (sourceFrames_ > 0 && currentRepeats_ != expectedRepeats_) {
+            judderFrames_++;
+        }
+        sourceFrames_++;
+        currentRepeats_ = 0;
+    }
+    currentRepeats_++;
+}
+
+float CadenceStats::judderPercent() const {
+    if (sourceFrames_ < 2) {
+        return 0.0f;
+    }
+    return 100.0f * static_cast<float>(judderFrames_) / static_cast<float>(sourceFrames_ - 1);
+}
+
+void FrameTimeStats::add(const double ms) {
+    count_++;
+    const double delta = ms - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (ms - mean_);
+    max_ = std::max(max_, ms);
+}
+
+double FrameTimeStats::stddevMs() const {
+    return count_ < 2 ? 0.0 : std::sqrt(m2_ / (count_ - 1));
+}
+
+EmulationPacer::EmulationPacer(const double sourceHz)
+    : sourcePeriod_(static_cast<int64_t>(1.0e9 / sourceHz)) {}
+
+EmulationPacer::Clock::time_point EmulationPacer::nextFrameStart(
+    const Clock::time_point now, const DisplayPhase& display) {
+    if (nextFrame_ == Clock::time_point{} || now - nextFrame_ > kMaxPacerLag) {
+        nextFrame_ = now;
+    }
+    nextFrame_ += sourcePeriod_;
+    if (display.periodNs <= 0 || display.vsyncNs <= 0) {
+        frameStart_ = nextFrame_;
+        return frameStart_;
+    }
+
+    // Snap the ideal source time to the nearest refresh. The long-run rate stays at the source
+    // rate; only the phase moves, so repeats fall on whole display frames.
+    const int64_t idealNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                nextFrame_.time_since_epoch())
+                                .count();
+    const int64_t offset = idealNs - display.vsyncNs;
+    const int64_t refreshes = static_cast<int64_t>(
+        std::llround(static_cast<double>(offset) / static_cast<double>(display.periodNs)));
+    frameStart_ = Clock::time_point(
+        std::chrono::nanoseconds(display.vsyncNs + refreshes * display.periodNs));
+    return frameStart_;
+}
+
+int64_t EmulationPacer::presentTimeNs() const {
+    if (frameStart_ == Clock::time_point{}) {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               (frameStart_ + sourcePeriod_).time_since_epoch())
+        .count();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Virtual Boy display refresh; not a clean divisor of any common headset rate.
+constexpr double kVbRefreshHz = 50.27;
+
+// Distance of displayHz / sourceHz from the nearest whole repeat count, in display frames.
+// 0 means every source frame is shown for the same number of refreshes.
+float CadenceError(float displayHz, double sourceHz);
+
+// Picks the rate with the smallest cadence error; near-ties go to the lower rate.
+// Returns 0 when rates is empty.
+float SelectDisplayRefreshRate(const float* rates, size_t count, double sourceHz);
+
+// How long the main loop may block in ALooper_pollOnce before deadline, in milliseconds; -1
+// waits for the next event when there is no deadline. Rounded down, so the caller sleeps off
+// the sub-millisecond remainder itself.
+int LooperTimeoutMs(
+    const std::optional<std::chrono::steady_clock::time_point>& deadline,
+    std::chrono::steady_clock::time_point now);
+
+// Display refresh phase in steady_clock nanoseconds, published by the XR frame-wait thread.
+struct DisplayPhase {
+    int64_t vsyncNs = 0;
+    int64_t periodNs = 0;
+};
+
+// Tracks how many display refreshes each source frame stayed on screen.
+class CadenceStats {
+public:
+    void reset(float displayHz, double sourceHz);
+    // Call once per presented display frame; newSourceFrame is true when its content changed.
+    void recordDisplayFrame(bool newSourceFrame);
+
+    [[nodiscard]] int expectedRepeats() const { return expectedRepeats_; }
+    [[nodiscard]] uint32_t sourceFrames() const { return sourceFrames_; }
+    [[nodiscard]] uint32_t judderFrames() const { return judderFrames_; }
+    [[nodiscard]] float judderPercent() const;
+
+private:
+    int expectedRepeats_ = 1;
+    int currentRepeats_ = 0;
+    uint32_t sourceFrames_ = 0;
+    uint32_t judderFrames_ = 0;
+};
+
+// Mean, standard deviation and worst case of a series of frame times (Welford's method).
+class FrameTimeStats {
+public:
+    void add(double ms);
+    void reset() { *this = FrameTimeStats{}; }
+
+    [[nodiscard]] uint32_t count() const { return count_; }
+    [[nodiscard]] double meanMs() const { return mean_; }
+    [[nodiscard]] double stddevMs() const;
+    [[nodiscard]] double maxMs() const { return max_; }
+
+private:
+    uint32_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double max_ = 0.0;
+};
+
+// Schedules emulation frames at the source rate, snapped to display refreshes when known so
+// each new frame is ready just after a vsync instead of drifting across it.
+class EmulationPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit EmulationPacer(double sourceHz);
+
+    void reset() {
+        nextFrame_ = {};
+        frameStart_ = {};
+    }
+    Clock::time_point nextFrameStart(Clock::time_point now, const DisplayPhase& display);
+    // Steady-clock display time for the frame started at the last nextFrameStart: it replaces
+    // its predecessor one source period later, so every frame is queued equally deep.
+    // 0 before the first frame was scheduled.
+    [[nodiscard]] int64_t presentTimeNs() const;
+
+private:
+    std::chrono::nanoseconds sourcePeriod_;
+    Clock::time_point nextFrame_{};
+    Clock::time_point frameStart_{};
+};
@@ -0,0 +1,82 @@
+#include "frame_buffer_pool.h"
+
+#include "log.h"
+
+const char* FrameBufferUseName(const FrameBufferUse use) {
+    switch (use) {
+        case FrameBufferUse::CoreFrame:
+            return "core";
+        case FrameBufferUse::Metadata:
+            return "metadata";
+        case FrameBufferUse::Compose:
+            return "compose";
+        case FrameBufferUse::Textures:
+            return "textures";
+        case FrameBufferUse::Capture:
+            return "capture";
+        case FrameBufferUse::Screenshots:
+            return "screenshots";
+        case FrameBufferUse::Count:
+            break;
+    }
+    return "?";
+}
+
+FrameBufferUse FrameBufferPool::UseOf(const PooledBuffer buffer) {
+    return buffer == PooledBuffer::CoreFrame ? FrameBufferUse::CoreFrame : FrameBufferUse::Compose;
+}
+
+void FrameBufferPool::configure(const int maxWidth, const int maxHeight) {
+    if (maxWidth <= 0 || maxHeight <= 0) {
+        return;
+    }
+    maxWidth_ = maxWidth;
+    maxHeight_ = maxHeight;
+    const size_t count = static_cast<size_t>(maxWidth) * static_cast<size_t>(maxHeight);
+    reserve(PooledBuffer::CoreFrame, count);
+    // Only a frame loop that composes has reserved this one; headless runs leave it empty.
+    if (pooled_[static_cast<size_t>(PooledBuffer::Compose)].capacity() > 0) {
+        reserve(PooledBuffer::Compose, count);
+    }
+}
+
+void FrameBufferPool::reserve(const PooledBuffer buffer, const size_t count) {
+    pooled_[static_cast<size_t>(buffer)].reserve(count);
+    account(buffer);
+}
+
+std::vector<uint32_t>& FrameBufferPool::pixels(const PooledBuffer buffer, const size_t count) {
+    std::vector<uint32_t>& pooled = pooled_[static_cast<size_t>(buffer)];
+    if (count > pooled.capacity()) {
+        LOGW("Frame buffer pool: %s grows from %zu to %zu pixels",
+             FrameBufferUseName(UseOf(buffer)), pooled.capacity(), count);
+        growths_.fetch_add(1, std::memory_order_relaxed);
+        pooled.resize(count);
+        account(buffer);
+        return pooled;
+    }
+    pooled.resize(count);
+    return pooled;
+}
+
+const std::vector<uint32_t>& FrameBufferPool::pixels(const PooledBuffer buffer) const {
+    return pooled_[static_cast<size_t>(buffer)];
+}
+
+void FrameBufferPool::reportBytes(const FrameBufferUse use, const size_t bytes) {
+    bytes_[static_cast<size_t>(use)].store(bytes, std::memory_order_relaxed);
+}
+
+FrameBufferPool::Usage FrameBufferPool::usage() const {
+    Usage usage;
+    for (size_t i = 0; i < kFrameBufferUseCount; ++i) {
+        usage.bytes[i] = bytes_[i].load(std::memory_order_relaxed);
+        usage.totalBytes += usage.bytes[i];
+    }
+    usage.growths = growths_.load(std::memory_order_relaxed);
+    return usage;
+}
+
+void FrameBufferPool::account(const PooledBuffer buffer) {
+    reportBytes(UseOf(buffer), pooled_[static_cast<size_t>(buffer)].capacity() * sizeof(uint32_t));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Who holds frame-sized memory. The pool owns the CPU pixel buffers the frame loop writes;
+// the rest keep their own storage and report its size, so one report covers every frame copy.
+enum class FrameBufferUse {
+    // The core's video, copied out of the libretro callback (pooled).
+    CoreFrame,
+    // Per-pixel depth planes captured with the frame.
+    Metadata,
+    // The info panel drawn over the game, or the standby screen: never both in one tick, so
+    // they share one pooled buffer.
+    Compose,
+    // Frame and metadata textures plus pixel unpack buffers.
+    Textures,
+    Capture,
+    Screenshots,
+    Count,
+};
+
+constexpr size_t kFrameBufferUseCount = static_cast<size_t>(FrameBufferUse::Count);
+
+// The uses the pool owns buffers for; the others can only report, so they never reach pixels().
+enum class PooledBuffer {
+    CoreFrame,
+    Compose,
+    Count,
+};
+
+const char* FrameBufferUseName(FrameBufferUse use);
+
+// Sized once from the core's maximum geometry so the frame loop never reallocates. Buffers
+// are handed out by use and keep their storage across ROM loads. pixels() belongs to the
+// thread that runs the core; usage() and reportBytes() may be called from any thread.
+class FrameBufferPool {
+public:
+    struct Usage {
+        std::array<size_t, kFrameBufferUseCount> bytes{};
+        size_t totalBytes = 0;
+        // Requests larger than the configured geometry, each of which reallocated.
+        uint32_t growths = 0;
+    };
+
+    FrameBufferPool() = default;
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    // Reserves the core frame, and the compose buffer once something reserved it, for
+    // maxWidth x maxHeight frames. Never shrinks them.
+    void configure(int maxWidth, int maxHeight);
+
+    // Makes room for count pixels in a pooled buffer ahead of time, for fixed-size screens.
+    void reserve(PooledBuffer buffer, size_t count);
+
+    // The pooled buffer resized to count pixels. Contents are whatever the previous holder
+    // left. Growing past the reservation is logged and counted.
+    std::vector<uint32_t>& pixels(PooledBuffer buffer, size_t count);
+    [[nodiscard]] const std::vector<uint32_t>& pixels(PooledBuffer buffer) const;
+
+    // Records what a subsystem outside the pool currently holds.
+    void reportBytes(FrameBufferUse use, size_t bytes);
+
+    [[nodiscard]] Usage usage() const;
+    [[nodiscard]] int maxWidth() const { return maxWidth_; }
+    [[nodiscard]] int maxHeight() const { return maxHeight_; }
+
+private:
+    static constexpr size_t kPooledCount = static_cast<size_t>(PooledBuffer::Count);
+
+    static FrameBufferUse UseOf(PooledBuffer buffer);
+    void account(PooledBuffer buffer);
+
+    int maxWidth_ = 0;
+    int maxHeight_ = 0;
+    std::array<std::vector<uint32_t>, kPooledCount> pooled_;
+    std::array<std::atomic<size_t>, kFrameBufferUseCount> bytes_{};
+    std::atomic<uint32_t> growths_{0};
+};
@@ -0,0 +1,518 @@
+#include "frame_capture.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "log.h"
+#include "thread_policy.h"
+
+namespace {
+
+constexpr size_t kChunkHeaderSize = 5;
+constexpr size_t kFrameHeaderSize = 8;
+constexpr size_t kMaxLiteral = 128;
+constexpr size_t kMinRun = 3;
+constexpr size_t kMaxRun = 130;
+// A key frame every ~6 s bounds how much a damaged file loses.
+constexpr uint32_t kKeyFrameInterval = 300;
+constexpr uint32_t kColorMask = 0x00FFFFFF;
+constexpr uint32_t kMaxPayloadSize = 64u << 20;
+
+void PutU16(std::vector<uint8_t>& out, const uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, const uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint16_t GetU16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t GetU32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Returns the offset of the chunk's size field, patched by EndChunk.
+size_t BeginChunk(std::vector<uint8_t>& out, const char type) {
+    out.push_back(static_cast<uint8_t>(type));
+    const size_t sizeOffset = out.size();
+    PutU32(out, 0);
+    return sizeOffset;
+}
+
+void EndChunk(std::vector<uint8_t>& out, const size_t sizeOffset) {
+    const auto size = static_cast<uint32_t>(out.size() - sizeOffset - 4);
+    for (int i = 0; i < 4; ++i) {
+        out[sizeOffset + i] = static_cast<uint8_t>(size >> (i * 8));
+    }
+}
+
+void AppendAudioChunk(const std::vector<int16_t>& samples, std::vector<uint8_t>& out) {
+    if (samples.empty()) {
+        return;
+    }
+    const size_t sizeOffset = BeginChunk(out, 'A');
+    const size_t start = out.size();
+    out.resize(start + samples.size() * sizeof(int16_t));
+    std::memcpy(out.data() + start, samples.data(), samples.size() * sizeof(int16_t));
+    EndChunk(out, sizeOffset);
+}
+
+void PackRow(const uint8_t* row, const size_t count, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < kMaxRun && row[i + run] == row[i]) {
+            ++run;
+        }
+        if (run >= kMinRun) {
+            out.push_back(static_cast<uint8_t>(run + 125));
+            out.push_back(row[i]);
+            i += run;
+            continue;
+        }
+        // Literals up to the next run worth coding.
+        const size_t start = i;
+        while (i < count && i - start < kMaxLiteral) {
+            if (i + 2 < count && row[i] == row[i + 1] && row[i] == row[i + 2]) {
+                break;
+            }
+            ++i;
+        }
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), row + start, row + i);
+    }
+}
+
+bool UnpackRow(const uint8_t*& data, const uint8_t* end, uint8_t* row, const size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        if (data >= end) {
+            return false;
+        }
+        const uint8_t control = *data++;
+        if (control < 128) {
+            const size_t length = control + 1u;
+            if (length > count - i || static_cast<size_t>(end - data) < length) {
+                return false;
+            }
+            std::memcpy(row + i, data, length);
+            data += length;
+            i += length;
+        } else {
+            const size_t length = control - 125u;
+            if (length > count - i || data >= end) {
+                return false;
+            }
+            std::memset(row + i, *data++, length);
+            i += length;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+void CaptureEncoder::reset() {
+    clearPalette();
+    indices_.clear();
+    previous_.clear();
+    width_ = 0;
+    height_ = 0;
+    framesSinceKey_ = 0;
+    havePrevious_ = false;
+}
+
+void CaptureEncoder::clearPalette() {
+    palette_.clear();
+    slotIndices_.fill(-1);
+    paletteChanged_ = true;
+}
+
+int CaptureEncoder::findOrAddColor(const uint32_t color) {
+    size_t slot = (color * 2654435761u) >> 22;
+    while (slotIndices_[slot] >= 0) {
+        if (slotColors_[slot] == color) {
+            return slotIndices_[slot];
+        }
+        slot = (slot + 1) & (kColorSlots - 1);
+    }
+    if (palette_.size() >= 256) {
+        return -1;
+    }
+    const auto index = static_cast<int16_t>(palette_.size());
+    palette_.push_back(color);
+    slotColors_[slot] = color;
+    slotIndices_[slot] = index;
+    paletteChanged_ = true;
+    return index;
+}
+
+bool CaptureEncoder::indexPixels(const uint32_t* pixels, const size_t count) {
+    // VIP frames are long runs of a few shades; most pixels hit the one-entry cache.
+    uint32_t lastColor = ~0u;
+    uint8_t lastIndex = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t color = pixels[i] & kColorMask;
+        if (color != lastColor) {
+            const int index = findOrAddColor(color);
+            if (index < 0) {
+                return false;
+            }
+            lastColor = color;
+            lastIndex = static_cast<uint8_t>(index);
+        }
+        indices_[i] = lastIndex;
+    }
+    return true;
+}
+
+void CaptureEncoder::encode(const uint32_t* pixels, const int width, const int height,
+                            const uint32_t frameIndex, std::vector<uint8_t>& out) {
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    indices_.resize(count);
+    bool indexed = indexPixels(pixels, count);
+    if (!indexed) {
+        // Start over from this frame's colors before giving up on indexing it.
+        clearPalette();
+        indexed = indexPixels(pixels, count);
+    }
+
+    if (!indexed) {
+        clearPalette();
+        havePrevious_ = false;
+        const size_t sizeOffset = BeginChunk(out, 'R');
+        PutU32(out, frameIndex);
+        PutU16(out, static_cast<uint16_t>(width));
+        PutU16(out, static_cast<uint16_t>(height));
+        const size_t start = out.size();
+        out.resize(start + count * sizeof(uint32_t));
+        std::memcpy(out.data() + start, pixels, count * sizeof(uint32_t));
+        EndChunk(out, sizeOffset);
+        return;
+    }
+
+    if (paletteChanged_) {
+        const size_t sizeOffset = BeginChunk(out, 'P');
+        PutU16(out, static_cast<uint16_t>(palette_.size()));
+        for (const uint32_t color : palette_) {
+            PutU32(out, color);
+        }
+        EndChunk(out, sizeOffset);
+        paletteChanged_ = false;
+    }
+
+    const bool key = !havePrevious_ || width != width_ || height != height_ ||
+                     framesSinceKey_ >= kKeyFrameInterval;
+    const size_t sizeOffset = BeginChunk(out, key ? 'K' : 'D');
+    PutU32(out, frameIndex);
+    PutU16(out, static_cast<uint16_t>(width));
+    PutU16(out, static_cast<uint16_t>(height));
+    row_.resize(static_cast<size_t>(width));
+    for (int y = 0; y < height; ++y) {
+        const size_t offset = static_cast<size_t>(y) * static_cast<size_t>(width);
+        const uint8_t* row = indices_.data() + offset;
+        if (!key) {
+            const uint8_t* previousRow = previous_.data() + offset;
+            for (int x = 0; x < width; ++x) {
+                row_[x] = row[x] ^ previousRow[x];
+            }
+            row = row_.data();
+        }
+        PackRow(row, static_cast<size_t>(width), out);
+    }
+    EndChunk(out, sizeOffset);
+
+    previous_.swap(indices_);
+    width_ = width;
+    height_ = height;
+    framesSinceKey_ = key ? 1 : framesSinceKey_ + 1;
+    havePrevious_ = true;
+}
+
+bool FrameCapture::start(const std::string& path, const double frameRateHz,
+                         const int audioSampleRate) {
+    stop();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        LOGE("Failed to create capture %s", path.c_str());
+        return false;
+    }
+    // The worker writes a few KB per frame; batch them into fewer, larger writes.
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+    std::vector<uint8_t> header(kCaptureMagic, kCaptureMagic + sizeof(kCaptureMagic));
+    PutU32(header, static_cast<uint32_t>(frameRateHz * 1000.0 + 0.5));
+    PutU32(header, static_cast<uint32_t>(audioSampleRate));
+
+    path_ = path;
+    freeSlots_.clear();
+    for (size_t i = 0; i < kSlotCount; ++i) {
+        freeSlots_.push_back(i);
+    }
+    readySlots_.clear();
+    pendingAudio_.clear();
+    nextFrameIndex_ = 0;
+    stopWorker_ = false;
+    writeFailed_ = false;
+    stats_ = {};
+    // Slots keep their storage from an earlier capture.
+    for (const Slot& slot : slots_) {
+        stats_.bufferBytes += slot.pixels.capacity() * sizeof(uint32_t);
+    }
+    writeChunks(header);
+    worker_ = std::thread(&FrameCapture::workerLoop, this);
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopWorker_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+
+    // Audio after the last frame; the worker is gone, so this thread owns the file now.
+    std::vector<uint8_t> tail;
+    AppendAudioChunk(pendingAudio_, tail);
+    pendingAudio_.clear();
+    writeChunks(tail);
+    if (std::fclose(file_) != 0 && !writeFailed_) {
+        LOGW("Failed to finish capture %s", path_.c_str());
+    }
+    file_ = nullptr;
+    LOGI("Capture %s: %u frames, %u dropped, %llu bytes", path_.c_str(), stats_.frames,
+         stats_.dropped, static_cast<unsigned long long>(stats_.bytes));
+}
+
+void FrameCapture::submitAudio(const int16_t* interleavedSamples, const size_t frames) {
+    if (!active()) {
+        return;
+    }
+    pendingAudio_.insert(pendingAudio_.end(), interleavedSamples, interleavedSamples + frames * 2);
+}
+
+void FrameCapture::submitFrame(const uint32_t* pixels, const int width, const int height) {
+    if (!active()) {
+        return;
+    }
+    const uint32_t frameIndex = nextFrameIndex_++;
+    size_t slotIndex = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.frames;
+        if (freeSlots_.empty()) {
+            // The audio stays pending and goes out with the next frame that gets a slot.
+            ++stats_.dropped;
+            return;
+        }
+        slotIndex = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+
+    // The slot belongs to this thread until it is queued.
+    Slot& slot = slots_[slotIndex];
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const size_t oldCapacity = slot.pixels.capacity();
+    slot.pixels.resize(count);
+    const size_t grownBytes = (slot.pixels.capacity() - oldCapacity) * sizeof(uint32_t);
+    std::memcpy(slot.pixels.data(), pixels, count * sizeof(uint32_t));
+    slot.width = width;
+    slot.height = height;
+    slot.frameIndex = frameIndex;
+    slot.audio.swap(pendingAudio_);
+    pendingAudio_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readySlots_.push_back(slotIndex);
+        stats_.bufferBytes += grownBytes;
+    }
+    cv_.notify_one();
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FrameCapture::writeChunks(const std::vector<uint8_t>& bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file_) == bytes.size();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes += bytes.size();
+    if (!written && !writeFailed_) {
+        writeFailed_ = true;
+        LOGW("Failed to write capture %s", path_.c_str());
+    }
+}
+
+void FrameCapture::workerLoop() {
+    ApplyThreadPolicy(ThreadRole::Background);
+    CaptureEncoder encoder;
+    std::vector<uint8_t> out;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopWorker_ || !readySlots_.empty(); });
+        if (readySlots_.empty()) {
+            return;
+        }
+        const size_t slotIndex = readySlots_.front();
+        readySlots_.pop_front();
+        lock.unlock();
+
+        Slot& slot = slots_[slotIndex];
+        out.clear();
+        AppendAudioChunk(slot.audio, out);
+        slot.audio.clear();
+        encoder.encode(slot.pixels.data(), slot.width, slot.height, slot.frameIndex, out);
+        writeChunks(out);
+
+        lock.lock();
+        freeSlots_.push_back(slotIndex);
+    }
+}
+
+bool CaptureReader::open(const std::string& path) {
+    close();
+    lastError_.clear();
+    file_ = std::fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+        lastError_ = "cannot open " + path;
+        return false;
+    }
+    uint8_t header[sizeof(kCaptureMagic) + 8];
+    if (std::fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+        std::memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+        lastError_ = path + " is not a capture";
+        close();
+        return false;
+    }
+    frameRateMilliHz_ = GetU32(header + sizeof(kCaptureMagic));
+    audioSampleRate_ = static_cast<int>(GetU32(header + sizeof(kCaptureMagic) + 4));
+    palette_.clear();
+    haveIndices_ = false;
+    return true;
+}
+
+void CaptureReader::close() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+CaptureReader::Item CaptureReader::fail(const std::string& error) {
+    lastError_ = error;
+    return Item::Error;
+}
+
+CaptureReader::Item CaptureReader::next() {
+    while (file_ != nullptr) {
+        uint8_t header[kChunkHeaderSize];
+        const size_t got = std::fread(header, 1, sizeof(header), file_);
+        if (got == 0) {
+            return Item::End;
+        }
+        if (got != sizeof(header)) {
+            // A capture cut off mid-write still plays up to its last whole chunk.
+            return fail("truncated chunk header");
+        }
+        const uint32_t size = GetU32(header + 1);
+        if (size > kMaxPayloadSize) {
+            return fail("chunk too large");
+        }
+        payload_.resize(size);
+        if (std::fread(payload_.data(), 1, size, file_) != size) {
+            return fail("truncated chunk");
+        }
+
+        switch (header[0]) {
+            case 'P': {
+                const size_t count = size >= 2 ? GetU16(payload_.data()) : 0;
+                if (size < 2 || count > 256 || size != 2 + count * 4) {
+                    return fail("bad palette chunk");
+                }
+                palette_.resize(count);
+                for (size_t i = 0; i < count; ++i) {
+                    palette_[i] = GetU32(payload_.data() + 2 + i * 4);
+                }
+                break;
+            }
+            case 'A':
+                audio_.resize(size / sizeof(int16_t));
+                std::memcpy(audio_.data(), payload_.data(), audio_.size() * sizeof(int16_t));
+                return Item::Audio;
+            case 'K':
+            case 'D':
+            case 'R':
+                return decodeFrame(header[0]);
+            default:
+                // Unknown chunk types are skipped so the format can grow.
+                break;
+        }
+    }
+    return Item::End;
+}
+
+CaptureReader::Item CaptureReader::decodeFrame(const uint8_t type) {
+    if (payload_.size() < kFrameHeaderSize) {
+        return fail("bad frame chunk");
+    }
+    const uint32_t frameIndex = GetU32(payload_.data());
+    const int width = GetU16(payload_.data() + 4);
+    const int height = GetU16(payload_.data() + 6);
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const uint8_t* data = payload_.data() + kFrameHeaderSize;
+    const uint8_t* end = payload_.data() + payload_.size();
+    pixels_.resize(count);
+
+    if (type == 'R') {
+        if (static_cast<size_t>(end - data) != count * sizeof(uint32_t)) {
+            return fail("bad raw frame");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            pixels_[i] = GetU32(data + i * 4) | ~kColorMask;
+        }
+        haveIndices_ = false;
+    } else {
+        const bool delta = type == 'D';
+        if (delta && (!haveIndices_ || width != width_ || height != height_)) {
+            return fail("delta frame without a matching previous frame");
+        }
+        indices_.resize(count);
+        row_.resize(static_cast<size_t>(width));
+        for (int y = 0; y < height; ++y) {
+            uint8_t* row = indices_.data() + static_cast<size_t>(y) * static_cast<size_t>(width);
+            if (!UnpackRow(data, end, delta ? row_.data() : row, static_cast<size_t>(width))) {
+                return fail("bad frame rows");
+            }
+            if (delta) {
+                for (int x = 0; x < width; ++x) {
+                    row[x] ^= row_[x];
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (indices_[i] >= palette_.size()) {
+                return fail("palette index out of range");
+            }
+            pixels_[i] = palette_[indices_[i]] | ~kColorMask;
+        }
+        haveIndices_ = true;
+    }
+    width_ = width;
+    height_ = height;
+    frameIndex_ = frameIndex;
+    return Item::Frame;
+}
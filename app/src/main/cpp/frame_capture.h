@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Gameplay capture (.vbcap). The emulation thread only copies each frame into a free slot; a
+// worker maps it to palette indices, XORs them with the previous frame and run-length codes
+// each row. tools/capture_convert turns a capture into a standard video.
+//
+// Little-endian layout: kCaptureMagic, u32 frame rate in mHz, u32 audio sample rate, then
+// chunks of u8 type, u32 payload size and the payload:
+//   'P'  u16 count, count XRGB words; replaces the palette.
+//   'K'  key frame: u32 frame index, u16 width, u16 height, then each row's palette indices
+//        as runs (control c < 128: c + 1 literal bytes follow; else the next byte c - 125
+//        times).
+//   'D'  delta frame: as 'K', with the indices XORed with the previous frame's.
+//   'R'  raw frame: the 'K' header, then XRGB words; for frames with over 256 colors.
+//   'A'  interleaved stereo s16 audio played before the next frame.
+// Frame indices count submitted frames. A gap is frames dropped while the worker was behind;
+// players repeat the previous picture for them.
+
+constexpr char kCaptureMagic[8] = {'V', 'B', 'C', 'A', 'P', '\0', '\0', '\1'};
+
+// Stateful frame encoder: deltas and the palette carry over from the previous frame.
+class CaptureEncoder {
+public:
+    CaptureEncoder() { reset(); }
+
+    // Appends the chunks for one frame, preceded by a palette chunk when colors were added.
+    void encode(const uint32_t* pixels, int width, int height, uint32_t frameIndex,
+                std::vector<uint8_t>& out);
+    void reset();
+
+private:
+    static constexpr size_t kColorSlots = 1024;
+
+    bool indexPixels(const uint32_t* pixels, size_t count);
+    int findOrAddColor(uint32_t color);
+    void clearPalette();
+
+    std::vector<uint32_t> palette_;
+    bool paletteChanged_ = false;
+    // Open-addressed color -> palette index table; -1 marks an empty slot.
+    std::array<uint32_t, kColorSlots> slotColors_{};
+    std::array<int16_t, kColorSlots> slotIndices_{};
+    std::vector<uint8_t> indices_;
+    std::vector<uint8_t> previous_;
+    std::vector<uint8_t> row_;
+    int width_ = 0;
+    int height_ = 0;
+    uint32_t framesSinceKey_ = 0;
+    bool havePrevious_ = false;
+};
+
+// Writes a capture. submit* calls come from the emulation thread only; encoding and file
+// writes happen on a background worker.
+class FrameCapture {
+public:
+    struct Stats {
+        uint32_t frames = 0;
+        uint32_t dropped = 0;
+        uint64_t bytes = 0;
+        // Memory held by the frame slots.
+        size_t bufferBytes = 0;
+    };
+
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture() { stop(); }
+
+    // Creates path and starts the worker. Audio is stereo s16 at audioSampleRate.
+    bool start(const std::string& path, double frameRateHz, int audioSampleRate);
+    // Encodes everything queued, then closes the file.
+    void stop();
+
+    // Queues the audio played since the last frame.
+    void submitAudio(const int16_t* interleavedSamples, size_t frames);
+    // Copies the frame into a free slot. With all slots waiting for the worker the frame is
+    // counted as dropped instead, so the frame loop never waits on encoding.
+    void submitFrame(const uint32_t* pixels, int width, int height);
+
+    [[nodiscard]] bool active() const { return worker_.joinable(); }
+    [[nodiscard]] const std::string& path() const { return path_; }
+    [[nodiscard]] Stats stats() const;
+
+private:
+    static constexpr size_t kSlotCount = 4;
+
+    struct Slot {
+        std::vector<uint32_t> pixels;
+        int width = 0;
+        int height = 0;
+        uint32_t frameIndex = 0;
+        std::vector<int16_t> audio;
+    };
+
+    void workerLoop();
+    void writeChunks(const std::vector<uint8_t>& bytes);
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    std::array<Slot, kSlotCount> slots_;
+    std::vector<size_t> freeSlots_;
+    std::deque<size_t> readySlots_;
+    // Emulation thread only.
+    std::vector<int16_t> pendingAudio_;
+    uint32_t nextFrameIndex_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopWorker_ = false;
+    bool writeFailed_ = false;
+    Stats stats_;
+    std::thread worker_;
+};
+
+// Reads a capture back chunk by chunk; used by the converter and the harness.
+class CaptureReader {
+public:
+    enum class Item {
+        Frame,
+        Audio,
+        End,
+        Error,
+    };
+
+    CaptureReader() = default;
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+    ~CaptureReader() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    // Decodes up to the next frame or audio chunk.
+    Item next();
+
+    [[nodiscard]] double frameRateHz() const { return frameRateMilliHz_ / 1000.0; }
+    [[nodiscard]] int audioSampleRate() const { return audioSampleRate_; }
+    // Valid after next() returned Frame. Pixels are XRGB with the X byte set.
+    [[nodiscard]] const std::vector<uint32_t>& framePixels() const { return pixels_; }
+    [[nodiscard]] int frameWidth() const { return width_; }
+    [[nodiscard]] int frameHeight() const { return height_; }
+    [[nodiscard]] uint32_t frameIndex() const { return frameIndex_; }
+    // Valid after next() returned Audio.
+    [[nodiscard]] const std::vector<int16_t>& audioSamples() const { return audio_; }
+    [[nodiscard]] const std::string& lastError() const { return lastError_; }
+
+private:
+    Item fail(const std::string& error);
+    Item decodeFrame(uint8_t type);
+
+    FILE* file_ = nullptr;
+    uint32_t frameRateMilliHz_ = 0;
+    int audioSampleRate_ = 0;
+    std::vector<uint8_t> payload_;
+    std::vector<uint32_t> palette_;
+    std::vector<uint8_t> indices_;
+    std::vector<uint8_t> row_;
+    std::vector<uint32_t> pixels_;
+    std::vector<int16_t> audio_;
+    int width_ = 0;
+    int height_ = 0;
+    uint32_t frameIndex_ = 0;
+    bool haveIndices_ = false;
+    std::string lastError_;
+};
@@ -0,0 +1,119 @@
+#include "info_pages.h"
+
+#include <cstddef>
+#include <cstdio>
+
+#include "info_panel.h"
+
+namespace {
+
+constexpr double kBytesPerMb = 1024.0 * 1024.0;
+
+double Megabytes(const FrameBufferPool::Usage& memory, const FrameBufferUse use) {
+    return static_cast<double>(memory.bytes[static_cast<size_t>(use)]) / kBytesPerMb;
+}
+
+// Lines are at most 29 characters, what an eye-wide panel fits at kTextScale; the font has
+// no '%' glyph.
+size_t BuildControls(const InfoPanelStatus& status, InfoPanel& panel) {
+    char text[64];
+    size_t line = 0;
+    panel.setLine(line++, status.hintVisible ? "PUSH RIGHT STICK FOR STATS" : " ");
+    std::snprintf(text, sizeof(text), "FPS: %.1f", status.fps);
+    panel.setLine(line++, text);
+    panel.setLine(line++, status.romLine);
+
+    panel.setLine(line++, "ROM PICKER: HIDE INFO + L3");
+    std::snprintf(text, sizeof(text), "VIEW: %s (TOGGLE \"B\")", status.viewMode);
+    panel.setLine(line++, text);
+    if (status.hasMetadata) {
+        std::snprintf(text, sizeof(text), "DEPTH: %s (L+R+B)", status.depthRenderMode);
+        panel.setLine(line++, text);
+    }
+
+    if (status.worldAnchored) {
+        panel.setLine(line++, "NAV (HOLD ANY GRIP)");
+        panel.setLine(line++, "  L-STICK MOVE, R-STICK LOOK");
+        panel.setLine(line++, "  L/R UP/DOWN, A RESET VIEW");
+    }
+
+    std::snprintf(text, sizeof(text), "SHOT: L3  %s (L+R+L3)", status.screenshotMode);
+    panel.setLine(line++, text);
+    if (status.capturing) {
+        std::snprintf(text, sizeof(text), "REC: %.1f MB DROP %u",
+                      static_cast<double>(status.captureBytes) / kBytesPerMb,
+                      status.captureDropped);
+        panel.setLine(line++, text);
+    } else {
+        panel.setLine(line++, "CAPTURE: \"SELECT\"");
+    }
+
+    std::snprintf(text, sizeof(text), "SCREEN SIZE: %.2f", status.screenScale);
+    panel.setLine(line++, text);
+    if (!status.worldAnchored) {
+        std::snprintf(text, sizeof(text), "STEREO CONV: %.3f", status.stereoConvergence);
+        panel.setLine(line++, text);
+        panel.setLine(line++, "CALIB: HOLD L+R");
+        panel.setLine(line++, "U/D SIZE, L/R CONV, A RESET");
+    } else {
+        panel.setLine(line++, "CALIB: HOLD L+R");
+        panel.setLine(line++, "U/D SIZE, A RESET");
+    }
+    return line;
+}
+
+size_t BuildStats(const InfoPanelStatus& status, InfoPanel& panel) {
+    char text[64];
+    size_t line = 0;
+    panel.setLine(line++, status.hintVisible ? "PUSH RIGHT STICK TO CLOSE" : " ");
+    std::snprintf(text, sizeof(text), "FPS: %.1f", status.fps);
+    panel.setLine(line++, text);
+    std::snprintf(text, sizeof(text), "FRAME: %.1f MS SD %.1f", status.frameWorkMeanMs,
+                  status.frameWorkStddevMs);
+    panel.setLine(line++, text);
+
+    // Frame-sized memory by holder, in MB; GROW counts buffers that outgrew the pool.
+    const FrameBufferPool::Usage& memory = status.memory;
+    std::snprintf(text, sizeof(text), "MEM: %.1f MB GROW %u",
+                  static_cast<double>(memory.totalBytes) / kBytesPerMb, memory.growths);
+    panel.setLine(line++, text);
+    std::snprintf(text, sizeof(text), "CORE %.1f UI %.1f TEX %.1f",
+                  Megabytes(memory, FrameBufferUse::CoreFrame) +
+                      Megabytes(memory, FrameBufferUse::Metadata),
+                  Megabytes(memory, FrameBufferUse::Compose),
+                  Megabytes(memory, FrameBufferUse::Textures));
+    panel.setLine(line++, text);
+    std::snprintf(text, sizeof(text), "REC %.1f SHOT %.1f",
+                  Megabytes(memory, FrameBufferUse::Capture),
+                  Megabytes(memory, FrameBufferUse::Screenshots));
+    panel.setLine(line++, text);
+
+    if (status.xrSession) {
+        // JUD is the judder in percent.
+        std::snprintf(text, sizeof(text), "HZ %.1f X%d JUD %.1f", status.displayRefreshHz,
+                      status.cadenceRepeats, status.judderPercent);
+        panel.setLine(line++, text);
+        if (status.gpuTimerAvailable && status.hasMetadata) {
+            // L and M are the layer and mesh depth paths.
+            std::snprintf(text, sizeof(text), "GPU %.1f L %.1f M %.1f", status.frameGpuTimeMs,
+                          status.layerGpuTimeMs, status.meshGpuTimeMs);
+            panel.setLine(line++, text);
+        } else if (status.gpuTimerAvailable) {
+            std::snprintf(text, sizeof(text), "GPU %.1f MS", status.frameGpuTimeMs);
+            panel.setLine(line++, text);
+        }
+        if (status.inputLatencyMs > 0.0f) {
+            std::snprintf(text, sizeof(text), "LATENCY: %.1f MS", status.inputLatencyMs);
+            panel.setLine(line++, text);
+        }
+    }
+    return line;
+}
+
+}  // namespace
+
+void BuildInfoPage(const InfoPage page, const InfoPanelStatus& status, InfoPanel& panel) {
+    const size_t lineCount =
+        page == InfoPage::Controls ? BuildControls(status, panel) : BuildStats(status, panel);
+    panel.setLineCount(lineCount);
+}
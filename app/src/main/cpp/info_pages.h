@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "frame_buffer_pool.h"
+
+class InfoPanel;
+
+// The info panel's pages, cycled with the right stick: the controls, then frame-time, memory
+// and display diagnostics. Each page has to fit the 224-line VIP frame it is drawn over.
+enum class InfoPage {
+    Controls,
+    Stats,
+};
+
+// What the pages show, gathered by the app each frame. romLine must outlive BuildInfoPage.
+struct InfoPanelStatus {
+    // Blink phase of the right-stick hint.
+    bool hintVisible = true;
+    double fps = 0.0;
+    double frameWorkMeanMs = 0.0;
+    double frameWorkStddevMs = 0.0;
+    FrameBufferPool::Usage memory;
+
+    // Display diagnostics, shown while an XR session runs.
+    bool xrSession = false;
+    float displayRefreshHz = 0.0f;
+    int cadenceRepeats = 1;
+    float judderPercent = 0.0f;
+    bool gpuTimerAvailable = false;
+    float frameGpuTimeMs = 0.0f;
+    float layerGpuTimeMs = 0.0f;
+    float meshGpuTimeMs = 0.0f;
+    float inputLatencyMs = 0.0f;
+
+    // The core exports depth metadata, so the depth render mode applies.
+    bool hasMetadata = false;
+    std::string_view romLine;
+    const char* viewMode = "";
+    const char* depthRenderMode = "";
+    const char* screenshotMode = "";
+    bool worldAnchored = false;
+    bool capturing = false;
+    uint64_t captureBytes = 0;
+    uint32_t captureDropped = 0;
+    float screenScale = 0.0f;
+    float stereoConvergence = 0.0f;
+};
+
+// Sets panel's lines to page. Unchanged lines stay cached in the panel.
+void BuildInfoPage(InfoPage page, const InfoPanelStatus& status, InfoPanel& panel);
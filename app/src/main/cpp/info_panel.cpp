@@ -0,0 +1,127 @@
+#include "info_panel.h"
+
+#include <algorithm>
+
+#include "text_renderer.h"
+
+namespace {
+
+constexpr int kPanelPadding = 6;
+constexpr int kPanelMaxWidth = 360;
+constexpr int kPanelBorder = 2;
+constexpr int kLineHeight = (kGlyphHeight * kTextScale) + 1;
+constexpr uint32_t kPanelBackground = 0xFF080808;
+constexpr uint32_t kPanelForeground = 0xFFFFFFFF;
+
+int PanelWidthFor(const int eyeWidth) { return std::min(eyeWidth - 12, kPanelMaxWidth); }
+
+}  // namespace
+
+int InfoPanel::HeightFor(const size_t lineCount) {
+    return (kPanelPadding * 2) + (kLineHeight * static_cast<int>(lineCount));
+}
+
+int InfoPanel::TextWidthFor(const int eyeWidth) {
+    return PanelWidthFor(eyeWidth) - (kPanelPadding * 2);
+}
+
+void InfoPanel::setLine(const size_t index, const std::string_view text) {
+    if (index >= lines_.size()) {
+        lines_.resize(index + 1);
+    }
+    if (index >= lineCount_) {
+        lineCount_ = index + 1;
+        ++generation_;
+    }
+    Line& line = lines_[index];
+    if (line.text == text) {
+        return;
+    }
+    line.text.assign(text);
+    line.dirty = true;
+    ++generation_;
+}
+
+void InfoPanel::setLineCount(const size_t count) {
+    if (count == lineCount_) {
+        return;
+    }
+    if (count > lines_.size()) {
+        lines_.resize(count);
+    }
+    lineCount_ = count;
+    ++generation_;
+}
+
+void InfoPanel::rasterize(const int panelWidth) {
+    const int panelHeight = HeightFor(lineCount_);
+    const int maxTextWidth = panelWidth - (kPanelPadding * 2);
+    if (!bitmapValid_ || panelWidth != bitmapWidth_ || panelHeight != bitmapHeight_) {
+        // The frame moved or resized: every line goes again.
+        bitmapWidth_ = panelWidth;
+        bitmapHeight_ = panelHeight;
+        bitmap_.assign(static_cast<size_t>(panelWidth) * static_cast<size_t>(panelHeight),
+                       kPanelBackground);
+        FillRect(bitmap_, panelWidth, panelHeight, 0, 0, panelWidth, kPanelBorder, kPanelForeground);
+        FillRect(bitmap_, panelWidth, panelHeight, 0, panelHeight - kPanelBorder, panelWidth,
+                 kPanelBorder, kPanelForeground);
+        FillRect(bitmap_, panelWidth, panelHeight, 0, 0, kPanelBorder, panelHeight, kPanelForeground);
+        FillRect(bitmap_, panelWidth, panelHeight, panelWidth - kPanelBorder, 0, kPanelBorder,
+                 panelHeight, kPanelForeground);
+        for (size_t i = 0; i < lineCount_; ++i) {
+            lines_[i].dirty = true;
+        }
+        bitmapValid_ = true;
+    }
+
+    for (size_t i = 0; i < lineCount_; ++i) {
+        Line& line = lines_[i];
+        if (!line.dirty) {
+            continue;
+        }
+        const int textY = kPanelPadding + (static_cast<int>(i) * kLineHeight);
+        line.fitted = FitTextToWidth(line.text, maxTextWidth, kTextScale);
+        FillRect(bitmap_, panelWidth, panelHeight, kPanelPadding, textY, maxTextWidth, kLineHeight,
+                 kPanelBackground);
+        DrawText(bitmap_, panelWidth, panelHeight, line.fitted, kPanelPadding, textY, kTextScale,
+                 kPanelForeground);
+        line.dirty = false;
+    }
+    bitmapGeneration_ = generation_;
+}
+
+void InfoPanel::draw(
+    std::vector<uint32_t>& frame,
+    const int frameWidth,
+    const int frameHeight,
+    const int eyeOffsetX,
+    const int eyeWidth) {
+    if (eyeWidth <= 0 || lineCount_ == 0 || frameWidth <= 0 || frameHeight <= 0 ||
+        frame.size() < static_cast<size_t>(frameWidth) * static_cast<size_t>(frameHeight)) {
+        return;
+    }
+    const int panelWidth = PanelWidthFor(eyeWidth);
+    if (panelWidth <= 0) {
+        return;
+    }
+    const int panelHeight = HeightFor(lineCount_);
+    if (!bitmapValid_ || bitmapGeneration_ != generation_ || panelWidth != bitmapWidth_ ||
+        panelHeight != bitmapHeight_) {
+        rasterize(panelWidth);
+    }
+
+    const int panelX = eyeOffsetX + ((eyeWidth - panelWidth) / 2);
+    const int panelY = (frameHeight - panelHeight) / 2;
+    const int x0 = std::max(panelX, 0);
+    const int x1 = std::min(panelX + panelWidth, frameWidth);
+    const int y0 = std::max(panelY, 0);
+    const int y1 = std::min(panelY + panelHeight, frameHeight);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    for (int y = y0; y < y1; ++y) {
+        const uint32_t* src =
+            bitmap_.data() + static_cast<size_t>(y - panelY) * panelWidth + (x0 - panelX);
+        std::copy(src, src + (x1 - x0), frame.data() + static_cast<size_t>(y) * frameWidth + x0);
+    }
+}
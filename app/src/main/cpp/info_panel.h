@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Retained model of the info panel: lines are set every frame but only changed ones are
+// re-fitted and re-rasterized into a cached panel bitmap, which draw() then copies.
+class InfoPanel {
+public:
+    // Unchanged text is a no-op; anything else marks the line dirty and bumps the generation.
+    void setLine(size_t index, std::string_view text);
+    // Drops lines from count on.
+    void setLineCount(size_t count);
+
+    // Changes whenever the panel content does; an unchanged value means a redraw can be skipped.
+    [[nodiscard]] uint64_t generation() const { return generation_; }
+    [[nodiscard]] size_t lineCount() const { return lineCount_; }
+    [[nodiscard]] const std::string& line(size_t index) const { return lines_[index].text; }
+
+    // Pixel height of a panel of lineCount lines, and the text width a panel centred in an eye
+    // of eyeWidth leaves; wider lines are cut off.
+    [[nodiscard]] static int HeightFor(size_t lineCount);
+    [[nodiscard]] static int TextWidthFor(int eyeWidth);
+
+    // Draws the panel centred in the eye spanning [eyeOffsetX, eyeOffsetX + eyeWidth).
+    void draw(
+        std::vector<uint32_t>& frame, int frameWidth, int frameHeight, int eyeOffsetX, int eyeWidth);
+
+private:
+    struct Line {
+        std::string text;
+        std::string fitted;
+        bool dirty = true;
+    };
+
+    void rasterize(int panelWidth);
+
+    std::vector<Line> lines_;
+    size_t lineCount_ = 0;
+    uint64_t generation_ = 0;
+
+    std::vector<uint32_t> bitmap_;
+    int bitmapWidth_ = 0;
+    int bitmapHeight_ = 0;
+    uint64_t bitmapGeneration_ = 0;
+    bool bitmapValid_ = false;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single-producer single-consumer ring of timestamped joypad masks. Lock-free, so input
+// callbacks can feed it from one thread while the emulation thread drains it.
+class InputEventQueue {
+public:
+    struct Event {
+        // steady_clock (CLOCK_MONOTONIC) nanoseconds the state took effect.
+        int64_t timeNs = 0;
+        // Complete joypad state after the event, in libretro RETRO_DEVICE_ID_JOYPAD bits.
+        uint16_t mask = 0;
+    };
+
+    static constexpr size_t kCapacity = 64;
+
+    // Producer side. Returns false when the ring is full.
+    bool push(const Event& event) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= kCapacity) {
+            return false;
+        }
+        events_[tail % kCapacity] = event;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool peek(Event& outEvent) const {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        outEvent = events_[head % kCapacity];
+        return true;
+    }
+
+    void pop() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    void clear() { head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    std::array<Event, kCapacity> events_{};
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+};
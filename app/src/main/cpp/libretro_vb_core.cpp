@@ -1,9 +1,14 @@
 #include "libretro_vb_core.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <utility>
 
 #include "log.h"
 
@@ -31,14 +36,54 @@ void retro_run(void);
 LibretroVbCore* gCore = nullptr;
 retro_pixel_format gPixelFormat = RETRO_PIXEL_FORMAT_XRGB8888;
 
+LogLevel ToLogLevel(const retro_log_level level) {
+    switch (level) {
+        case RETRO_LOG_DEBUG:
+            return LogLevel::Debug;
+        case RETRO_LOG_INFO:
+            return LogLevel::Info;
+        case RETRO_LOG_WARN:
+            return LogLevel::Warn;
+        default:
+            return LogLevel::Error;
+    }
+}
+
+// Every core message goes through LogMessage, so one LOG_AT site would give them all a single
+// budget. Instead each level has its own table keyed by the core's format pointer: a chatty
+// debug stream never starves errors, and formats of one level only share on a hash collision.
+constexpr size_t kCoreLogLevels = 4;
+constexpr size_t kCoreLogSitesPerLevel = 16;
+std::array<std::array<log_detail::CallSite, kCoreLogSitesPerLevel>, kCoreLogLevels> gCoreLogSites;
+
+log_detail::CallSite& CoreLogSite(const retro_log_level level, const char* fmt) {
+    const size_t levelIndex = std::min(static_cast<size_t>(level), kCoreLogLevels - 1);
+    const auto key = reinterpret_cast<uintptr_t>(fmt);
+    return gCoreLogSites[levelIndex][((key >> 3) ^ (key >> 11)) % kCoreLogSitesPerLevel];
+}
+
 void LogMessage(enum retro_log_level level, const char* fmt, ...) {
-    (void)level;
+    const LogLevel logLevel = ToLogLevel(level);
+    if (!LogEnabled(logLevel)) {
+        return;
+    }
+    // A va_list cannot outlive this call, so core messages are formatted here, but only once the
+    // rate limiter has let them through; the logger still takes the write off this thread.
+    uint32_t suppressed = 0;
+    if (!log_detail::Admit(CoreLogSite(level, fmt), suppressed)) {
+        return;
+    }
     va_list args;
     va_start(args, fmt);
-    char buffer[1024] = {};
+    char buffer[256];
     std::vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
-    LOGI("[beetle-vb] %s", buffer);
+    // Core messages carry their own newline; the sinks add one.
+    size_t length = std::strlen(buffer);
+    while (length > 0 && buffer[length - 1] == '\n') {
+        buffer[--length] = '\0';
+    }
+    log_detail::Log(logLevel, suppressed, "[beetle-vb] %s", buffer);
 }
 
 bool EnvironmentCallback(unsigned cmd, void* data) {
@@ -120,7 +165,17 @@ size_t AudioSampleBatchCallback(const int16_t* data, size_t frames) {
     return frames;
 }
 
-void InputPollCallback() {}
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void InputPollCallback() {
+    if (gCore != nullptr) {
+        gCore->pollInput();
+    }
+}
 
 int16_t InputStateCallback(unsigned port, unsigned device, unsigned index, unsigned id) {
     (void)index;
@@ -227,6 +282,8 @@ bool LibretroVbCore::loadRomFromBytes(
     } else {
         audioSampleRate_ = 44100;
     }
+    framePool_.configure(static_cast<int>(avInfo.geometry.max_width),
+                         static_cast<int>(avInfo.geometry.max_height));
 
     romLoaded_ = true;
     lastError_.clear();
@@ -243,6 +300,8 @@ void LibretroVbCore::unloadRom() {
         retro_unload_game();
     }
     romLoaded_ = false;
+    inputQueue_.clear();
+    inputMask_ = 0;
     frameReady_ = false;
     frameWidth_ = 0;
     frameHeight_ = 0;
@@ -250,11 +309,12 @@ void LibretroVbCore::unloadRom() {
     metadataWidth_ = 0;
     metadataHeight_ = 0;
     metadataFrameId_ = 0;
-    frameBuffer_.clear();
-    metadataDisparity_.clear();
-    metadataWorldIds_.clear();
+    // Emptied but not freed: the next ROM reuses the storage.
+    framePool_.pixels(PooledBuffer::CoreFrame, 0);
+    metadataDepth_.clear();
     metadataSourceX_.clear();
     metadataSourceY_.clear();
+    reportMetadataBytes();
     romData_.clear();
     std::scoped_lock lock(audioMutex_);
     audioQueue_.clear();
@@ -295,8 +355,52 @@ unsigned LibretroVbCore::mapInputToBitmask(const VbInputState& inputState) {
     return mask;
 }
 
+void LibretroVbCore::setInputPoller(std::function<VbInputState()> poller) {
+    inputPoller_ = std::move(poller);
+}
+
+void LibretroVbCore::queueInputState(const VbInputState& inputState, const int64_t timeNs) {
+    InputEventQueue::Event event;
+    event.timeNs = timeNs;
+    event.mask = static_cast<uint16_t>(mapInputToBitmask(inputState));
+    if (!inputQueue_.push(event)) {
+        // The next poll queues the current state again, so only intermediate taps are lost.
+        if (droppedInputEvents_++ == 0) {
+            LOGW("Input event queue full; dropping events");
+        }
+    }
+}
+
 void LibretroVbCore::setInputState(const VbInputState& inputState) {
-    inputMask_ = static_cast<uint16_t>(mapInputToBitmask(inputState));
+    queueInputState(inputState, SteadyNowNs());
+}
+
+void LibretroVbCore::pollInput() {
+    const int64_t pollNs = SteadyNowNs();
+    if (inputPoller_) {
+        queueInputState(inputPoller_(), pollNs);
+    }
+    applyQueuedInput(pollNs);
+    inputSampleNs_ = pollNs;
+}
+
+void LibretroVbCore::applyQueuedInput(const int64_t pollNs) {
+    // Beetle VB latches the pad once per frame, so a frame can show each button in one state.
+    // Applying transitions in order up to a button's second one keeps presses and releases that
+    // fall between two polls, deferring the rest to the next frame.
+    uint16_t mask = inputMask_;
+    uint16_t transitioned = 0;
+    InputEventQueue::Event event;
+    while (inputQueue_.peek(event) && event.timeNs <= pollNs) {
+        const auto changed = static_cast<uint16_t>(mask ^ event.mask);
+        if ((changed & transitioned) != 0) {
+            break;
+        }
+        mask = event.mask;
+        transitioned |= changed;
+        inputQueue_.pop();
+    }
+    inputMask_ = mask;
 }
 
 void LibretroVbCore::onVideoFrame(const void* data, unsigned width, unsigned height, size_t pitch) {
@@ -304,10 +408,11 @@ void LibretroVbCore::onVideoFrame(const void* data, unsigned width, unsigned hei
     frameReady_ = true;
     frameWidth_ = static_cast<int>(width);
     frameHeight_ = static_cast<int>(height);
-    frameBuffer_.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    std::vector<uint32_t>& frame = framePool_.pixels(
+        PooledBuffer::CoreFrame, static_cast<size_t>(width) * static_cast<size_t>(height));
 
     for (unsigned y = 0; y < height; ++y) {
-        auto* dstRow = frameBuffer_.data() + static_cast<size_t>(y) * width;
+        auto* dstRow = frame.data() + static_cast<size_t>(y) * width;
         const auto* srcRow = reinterpret_cast<const uint32_t*>(src + (y * pitch));
         std::memcpy(dstRow, srcRow, width * sizeof(uint32_t));
     }
@@ -321,10 +426,17 @@ void LibretroVbCore::captureMetadata(const unsigned width, const unsigned height
     metadataWidth_ = 0;
     metadataHeight_ = 0;
     metadataFrameId_ = 0;
-    metadataDisparity_.clear();
-    metadataWorldIds_.clear();
+    metadataDepth_.clear();
     metadataSourceX_.clear();
     metadataSourceY_.clear();
+    reportMetadataBytes();
+}
+
+void LibretroVbCore::reportMetadataBytes() {
+    framePool_.reportBytes(FrameBufferUse::Metadata,
+                           metadataDepth_.capacity() +
+                               (metadataSourceX_.capacity() + metadataSourceY_.capacity()) *
+                                   sizeof(int16_t));
 }
 
 void LibretroVbCore::onAudioBatch(const int16_t* interleavedSamples, const size_t frames) {
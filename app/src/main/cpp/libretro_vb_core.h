@@ -3,10 +3,14 @@
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include "frame_buffer_pool.h"
+#include "input_event_queue.h"
+
 struct VbInputState {
     bool left = false;
     bool right = false;
@@ -29,6 +33,13 @@ public:
     bool loadRomFromBytes(const uint8_t* data, size_t size, const std::string& nameHint);
     void unloadRom();
 
+    // Called when the core polls input inside runFrame, i.e. right before the game reads it, so
+    // the mask is as fresh as possible. Its result is queued behind any pending events.
+    void setInputPoller(std::function<VbInputState()> poller);
+    // Queues the state as of timeNs (steady_clock). Each poll applies queued states in order but
+    // stops before a button's second transition, so a tap shorter than a frame is still seen by
+    // the game for one frame instead of being lost. Call from a single producer thread.
+    void queueInputState(const VbInputState& inputState, int64_t timeNs);
     void setInputState(const VbInputState& inputState);
     void runFrame();
 
@@ -37,27 +48,38 @@ public:
     [[nodiscard]] bool hasFrame() const { return frameReady_; }
     [[nodiscard]] int frameWidth() const { return frameWidth_; }
     [[nodiscard]] int frameHeight() const { return frameHeight_; }
-    [[nodiscard]] const std::vector<uint32_t>& framePixels() const { return frameBuffer_; }
+    [[nodiscard]] const std::vector<uint32_t>& framePixels() const {
+        return framePool_.pixels(PooledBuffer::CoreFrame);
+    }
     [[nodiscard]] bool hasMetadata() const { return metadataReady_; }
     [[nodiscard]] int metadataWidth() const { return metadataWidth_; }
     [[nodiscard]] int metadataHeight() const { return metadataHeight_; }
     [[nodiscard]] uint32_t metadataFrameId() const { return metadataFrameId_; }
-    [[nodiscard]] const std::vector<int8_t>& metadataDisparity() const { return metadataDisparity_; }
-    [[nodiscard]] const std::vector<uint8_t>& metadataWorldIds() const { return metadataWorldIds_; }
+    // Interleaved per-pixel (world id, signed disparity) byte pairs, laid out for direct RG8 upload.
+    [[nodiscard]] const std::vector<uint8_t>& metadataDepthPlane() const { return metadataDepth_; }
     [[nodiscard]] const std::vector<int16_t>& metadataSourceX() const { return metadataSourceX_; }
     [[nodiscard]] const std::vector<int16_t>& metadataSourceY() const { return metadataSourceY_; }
     [[nodiscard]] const std::string& romLabel() const { return romPathLabel_; }
     [[nodiscard]] std::string lastError() const { return lastError_; }
     [[nodiscard]] uint16_t inputMask() const { return inputMask_; }
+    // steady_clock time the current input mask was sampled.
+    [[nodiscard]] int64_t inputSampleTimeNs() const { return inputSampleNs_; }
     [[nodiscard]] int audioSampleRate() const { return audioSampleRate_; }
+    // Frame-sized buffers, sized from the core's max geometry when a ROM loads. The frame loop
+    // takes its compose buffer from here and the other subsystems report into it.
+    [[nodiscard]] FrameBufferPool& framePool() { return framePool_; }
+    [[nodiscard]] const FrameBufferPool& framePool() const { return framePool_; }
 
+    void pollInput();
     void onVideoFrame(const void* data, unsigned width, unsigned height, size_t pitch);
     void onAudioBatch(const int16_t* interleavedSamples, size_t frames);
     size_t drainAudioFrames(int16_t* outInterleavedSamples, size_t maxFrames);
 
 private:
     static unsigned mapInputToBitmask(const VbInputState& inputState);
+    void applyQueuedInput(int64_t pollNs);
     void captureMetadata(unsigned width, unsigned height);
+    void reportMetadataBytes();
     void setError(const std::string& error);
 
     bool initialized_ = false;
@@ -71,11 +93,14 @@ private:
     uint32_t metadataFrameId_ = 0;
     int audioSampleRate_ = 44100;
     uint16_t inputMask_ = 0;
+    int64_t inputSampleNs_ = 0;
+    InputEventQueue inputQueue_;
+    uint32_t droppedInputEvents_ = 0;
+    std::function<VbInputState()> inputPoller_;
     std::string romPathLabel_ = "memory.vb";
     std::vector<uint8_t> romData_;
-    std::vector<uint32_t> frameBuffer_;
-    std::vector<int8_t> metadataDisparity_;
-    std::vector<uint8_t> metadataWorldIds_;
+    FrameBufferPool framePool_;
+    std::vector<uint8_t> metadataDepth_;
     std::vector<int16_t> metadataSourceX_;
     std::vector<int16_t> metadataSourceY_;
     std::deque<int16_t> audioQueue_;
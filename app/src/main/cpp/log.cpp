@@ -0,0 +1,421 @@
+#include "log.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+#include <sys/system_properties.h>
+#endif
+
+#include "thread_policy.h"
+
+namespace {
+
+using log_detail::Arg;
+using log_detail::ArgType;
+
+constexpr size_t kRingCapacity = 256;
+static_assert((kRingCapacity & (kRingCapacity - 1)) == 0, "ring capacity must be a power of two");
+// Copied %s arguments; longer strings are truncated.
+constexpr size_t kTextBytes = 320;
+constexpr size_t kLineBytes = 1024;
+// Producers never signal the writer for routine messages, so logging stays syscall-free;
+// the writer drains on this period instead. Errors and FlushLog() wake it immediately.
+constexpr auto kWriterPeriod = std::chrono::milliseconds(50);
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+LogLevel ParseLevel(const char* text, const LogLevel fallback) {
+    if (text == nullptr || text[0] == '\0') {
+        return fallback;
+    }
+    constexpr std::array<std::pair<const char*, LogLevel>, 5> kNames = {{
+        {"debug", LogLevel::Debug},
+        {"info", LogLevel::Info},
+        {"warn", LogLevel::Warn},
+        {"error", LogLevel::Error},
+        {"silent", LogLevel::Silent},
+    }};
+    for (const auto& [name, level] : kNames) {
+        if (std::strcmp(text, name) == 0) {
+            return level;
+        }
+    }
+    return fallback;
+}
+
+int InitialLevel() {
+#if defined(__ANDROID__)
+    char value[PROP_VALUE_MAX] = {};
+    __system_property_get("debug.vvb.loglevel", value);
+    return static_cast<int>(ParseLevel(value, LogLevel::Info));
+#else
+    return static_cast<int>(ParseLevel(std::getenv("VVB_LOG_LEVEL"), LogLevel::Info));
+#endif
+}
+
+std::atomic<LogSink> gSink{nullptr};
+
+struct Record {
+    std::atomic<size_t> sequence{0};
+    LogLevel level = LogLevel::Info;
+    uint32_t suppressed = 0;
+    const char* format = nullptr;
+    size_t argCount = 0;
+    // String arguments point into text.
+    Arg args[log_detail::kMaxArgs] = {};
+    char text[kTextBytes] = {};
+};
+
+void WriteLine(const LogLevel level, const char* line) {
+    if (const LogSink sink = gSink.load(std::memory_order_acquire)) {
+        sink(level, line);
+        return;
+    }
+#if defined(__ANDROID__)
+    __android_log_write(static_cast<int>(level), LOG_TAG, line);
+#else
+    const char tag = level >= LogLevel::Error  ? 'E'
+                     : level >= LogLevel::Warn ? 'W'
+                     : level >= LogLevel::Info ? 'I'
+                                               : 'D';
+    std::fprintf(stdout, "%c/%s: %s\n", tag, LOG_TAG, line);
+#endif
+}
+
+// Appends one printf conversion. spec holds the flags, width and precision between '%' and
+// the conversion; length modifiers were stripped and are chosen here from the captured type.
+size_t FormatArg(
+    char* out, const size_t room, const char* spec, const bool wide, const char conversion,
+    const Arg& arg) {
+    char format[48];
+    int written = 0;
+    switch (conversion) {
+        case 'd':
+        case 'i': {
+            const long long value = arg.type == ArgType::Double     ? static_cast<long long>(arg.d)
+                                    : arg.type == ArgType::Unsigned ? static_cast<long long>(arg.u)
+                                                                    : static_cast<long long>(arg.i);
+            std::snprintf(format, sizeof(format), "%%%slld", spec);
+            written = std::snprintf(out, room, format, value);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            unsigned long long value = arg.type == ArgType::Double
+                                           ? static_cast<unsigned long long>(arg.d)
+                                       : arg.type == ArgType::Signed
+                                           ? static_cast<unsigned long long>(arg.i)
+                                           : static_cast<unsigned long long>(arg.u);
+            if (!wide) {
+                // A negative int printed with %x shows its 32-bit pattern, as printf would.
+                value &= 0xffffffffull;
+            }
+            std::snprintf(format, sizeof(format), "%%%sll%c", spec, conversion);
+            written = std::snprintf(out, room, format, value);
+            break;
+        }
+        case 'c':
+            std::snprintf(format, sizeof(format), "%%%sc", spec);
+            written = std::snprintf(out, room, format, static_cast<int>(arg.i));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            const double value = arg.type == ArgType::Double     ? arg.d
+                                 : arg.type == ArgType::Signed ? static_cast<double>(arg.i)
+                                                               : static_cast<double>(arg.u);
+            std::snprintf(format, sizeof(format), "%%%s%c", spec, conversion);
+            written = std::snprintf(out, room, format, value);
+            break;
+        }
+        case 's':
+            std::snprintf(format, sizeof(format), "%%%ss", spec);
+            written = std::snprintf(
+                out, room, format,
+                arg.type == ArgType::String && arg.s != nullptr ? arg.s : "(null)");
+            break;
+        case 'p':
+            written = std::snprintf(out, room, "%p", arg.p);
+            break;
+        default:
+            written = std::snprintf(out, room, "%%%c", conversion);
+            break;
+    }
+    if (written < 0) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>(written), room > 0 ? room - 1 : 0);
+}
+
+int ArgAsInt(const Arg& arg) {
+    return arg.type == ArgType::Double     ? static_cast<int>(arg.d)
+           : arg.type == ArgType::Unsigned ? static_cast<int>(arg.u)
+                                           : static_cast<int>(arg.i);
+}
+
+void FormatRecord(const Record& record, char* line, const size_t lineBytes) {
+    size_t length = 0;
+    size_t nextArg = 0;
+    const char* cursor = record.format;
+    while (*cursor != '\0' && length + 1 < lineBytes) {
+        if (cursor[0] != '%') {
+            line[length++] = *cursor++;
+            continue;
+        }
+        if (cursor[1] == '%') {
+            line[length++] = '%';
+            cursor += 2;
+            continue;
+        }
+        ++cursor;
+        char spec[32];
+        size_t specLength = 0;
+        while (*cursor != '\0' && std::strchr("-+ #0123456789.*", *cursor) != nullptr) {
+            if (*cursor != '*') {
+                if (specLength + 1 < sizeof(spec)) {
+                    spec[specLength++] = *cursor;
+                }
+                ++cursor;
+                continue;
+            }
+            // A '*' width or precision takes the next argument, spliced into spec as digits.
+            ++cursor;
+            const int value = nextArg < record.argCount ? ArgAsInt(record.args[nextArg++]) : 0;
+            if (value < 0 && specLength > 0 && spec[specLength - 1] == '.') {
+                // A negative precision counts as none given.
+                --specLength;
+                continue;
+            }
+            const int digits =
+                std::snprintf(spec + specLength, sizeof(spec) - specLength, "%d", value);
+            specLength = std::min(specLength + static_cast<size_t>(std::max(digits, 0)),
+                                  sizeof(spec) - 1);
+        }
+        spec[specLength] = '\0';
+        bool wide = false;
+        while (*cursor != '\0' && std::strchr("hlLqjzt", *cursor) != nullptr) {
+            wide |= *cursor != 'h';
+            ++cursor;
+        }
+        if (*cursor == '\0') {
+            break;
+        }
+        const char conversion = *cursor++;
+        if (nextArg >= record.argCount) {
+            // Format and arguments disagree; show the bare conversion rather than guess.
+            length += std::snprintf(line + length, lineBytes - length, "%%%c", conversion);
+            length = std::min(length, lineBytes - 1);
+            continue;
+        }
+        length += FormatArg(
+            line + length, lineBytes - length, spec, wide, conversion, record.args[nextArg++]);
+    }
+    line[length] = '\0';
+}
+
+class Logger {
+public:
+    Logger() {
+        for (size_t i = 0; i < kRingCapacity; ++i) {
+            ring_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        std::thread(&Logger::writerLoop, this).detach();
+    }
+
+    void enqueue(
+        const LogLevel level, const char* format, const Arg* args, const size_t count,
+        const uint32_t suppressed) {
+        // Bounded multi-producer queue: a slot whose sequence equals the claimed position is
+        // free; publishing sets it to position + 1 for the writer.
+        size_t position = enqueuePos_.load(std::memory_order_relaxed);
+        Record* record = nullptr;
+        while (true) {
+            record = &ring_[position & (kRingCapacity - 1)];
+            const size_t sequence = record->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->level = level;
+        record->suppressed = suppressed;
+        record->format = format;
+        record->argCount = count;
+        size_t textUsed = 0;
+        for (size_t i = 0; i < count; ++i) {
+            Arg arg = args[i];
+            if (arg.type == ArgType::String && arg.s != nullptr) {
+                char* copy = record->text + textUsed;
+                const size_t room = kTextBytes - textUsed;
+                const size_t length = room > 0 ? strnlen(arg.s, room - 1) : 0;
+                if (room > 0) {
+                    std::memcpy(copy, arg.s, length);
+                    copy[length] = '\0';
+                    textUsed += length + 1;
+                    arg.s = copy;
+                } else {
+                    arg.s = "";
+                }
+            }
+            record->args[i] = arg;
+        }
+        record->sequence.store(position + 1, std::memory_order_release);
+
+        if (level >= LogLevel::Error) {
+            // Get errors out promptly in case the process is about to die.
+            wakeCv_.notify_one();
+        }
+    }
+
+    void flush() {
+        const size_t target = enqueuePos_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushRequested_ = true;
+        wakeCv_.notify_one();
+        drainedCv_.wait(lock, [this, target] { return drainedPos_ >= target; });
+    }
+
+private:
+    bool drain() {
+        bool wrote = false;
+        char line[kLineBytes];
+        while (true) {
+            Record& record = ring_[dequeuePos_ & (kRingCapacity - 1)];
+            if (record.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+                break;
+            }
+            FormatRecord(record, line, sizeof(line));
+            const uint32_t suppressed = record.suppressed;
+            const LogLevel level = record.level;
+            record.sequence.store(dequeuePos_ + kRingCapacity, std::memory_order_release);
+            ++dequeuePos_;
+
+            if (suppressed > 0) {
+                const size_t length = std::strlen(line);
+                std::snprintf(
+                    line + length, sizeof(line) - length, " (%u similar suppressed)", suppressed);
+            }
+            WriteLine(level, line);
+            wrote = true;
+        }
+        const uint32_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            std::snprintf(line, sizeof(line), "Log ring full; dropped %u messages", dropped);
+            WriteLine(LogLevel::Warn, line);
+            wrote = true;
+        }
+        return wrote;
+    }
+
+    [[noreturn]] void writerLoop() {
+        ApplyThreadPolicy(ThreadRole::Background);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            lock.unlock();
+            if (drain()) {
+#if !defined(__ANDROID__)
+                std::fflush(stdout);
+#endif
+            }
+            lock.lock();
+            drainedPos_ = dequeuePos_;
+            drainedCv_.notify_all();
+            wakeCv_.wait_for(lock, kWriterPeriod, [this] { return flushRequested_; });
+            flushRequested_ = false;
+        }
+    }
+
+    std::array<Record, kRingCapacity> ring_;
+    std::atomic<size_t> enqueuePos_{0};
+    std::atomic<uint32_t> dropped_{0};
+    // Writer thread only, except drainedPos_ which is published under mutex_.
+    size_t dequeuePos_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable drainedCv_;
+    size_t drainedPos_ = 0;
+    bool flushRequested_ = false;
+};
+
+Logger& GetLogger() {
+    // Never destroyed, so statics torn down at exit can still log; their messages are written
+    // by the exit-time flush.
+    static Logger* logger = [] {
+        auto* created = new Logger();
+        std::atexit(FlushLog);
+        return created;
+    }();
+    return *logger;
+}
+
+}  // namespace
+
+namespace log_detail {
+
+std::atomic<int> gLevel{InitialLevel()};
+
+bool Admit(CallSite& site, uint32_t& outSuppressed) {
+    const int64_t now = SteadyNowNs();
+    int64_t start = site.windowStartNs.load(std::memory_order_relaxed);
+    if (now - start >= kSiteWindowNs &&
+        site.windowStartNs.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        site.count.store(0, std::memory_order_relaxed);
+    }
+    if (site.count.fetch_add(1, std::memory_order_relaxed) >= kSiteBurst) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    outSuppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void Enqueue(
+    const LogLevel level, const char* format, const Arg* args, const size_t count,
+    const uint32_t suppressed) {
+    GetLogger().enqueue(level, format, args, count, suppressed);
+}
+
+}  // namespace log_detail
+
+void SetLogLevel(const LogLevel level) {
+    log_detail::gLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel GetLogLevel() {
+    return static_cast<LogLevel>(log_detail::gLevel.load(std::memory_order_relaxed));
+}
+
+void FlushLog() { GetLogger().flush(); }
+
+void SetLogSink(const LogSink sink) { gSink.store(sink, std::memory_order_release); }
@@ -1,8 +1,147 @@
 #pragma once
 
-#include <android/log.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Asynchronous logging. A LOG* call copies its format pointer and arguments into a lock-free
+// ring; a background thread does the printf formatting and the blocking write (logcat on
+// Android, stdout on Linux hosts). Each call site is rate limited, and messages below the
+// runtime level cost one atomic load.
+//
+// Formats must be string literals. %s arguments are copied at the call site, so temporaries
+// such as path.c_str() are fine; anything else is captured by value.
 
 #define LOG_TAG "VirtualVirtualBoy"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+enum class LogLevel : int {
+    Debug = 3,
+    Info = 4,
+    Warn = 5,
+    Error = 6,
+    Silent = 8,
+};
+
+// Initially Info, or the value of the debug.vvb.loglevel property (VVB_LOG_LEVEL on hosts):
+// one of debug, info, warn, error, silent.
+void SetLogLevel(LogLevel level);
+LogLevel GetLogLevel();
+// Blocks until everything logged so far has been written. Also runs at exit.
+void FlushLog();
+// Replaces the platform sink the writer thread sends finished lines to, e.g. to capture them
+// in tests; nullptr restores it.
+using LogSink = void (*)(LogLevel level, const char* line);
+void SetLogSink(LogSink sink);
+
+namespace log_detail {
+extern std::atomic<int> gLevel;
+}  // namespace log_detail
+
+// Lets callers skip building arguments for a message that would be filtered anyway.
+inline bool LogEnabled(const LogLevel level) {
+    return static_cast<int>(level) >= log_detail::gLevel.load(std::memory_order_relaxed);
+}
+
+namespace log_detail {
+
+// Each call site may log kSiteBurst messages per kSiteWindowNs; the rest are counted and
+// reported with the site's next message.
+constexpr uint32_t kSiteBurst = 10;
+constexpr int64_t kSiteWindowNs = 1'000'000'000;
+constexpr size_t kMaxArgs = 8;
+
+struct CallSite {
+    std::atomic<int64_t> windowStartNs{0};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+enum class ArgType : uint8_t {
+    Signed,
+    Unsigned,
+    Double,
+    String,
+    Pointer,
+};
+
+struct Arg {
+    ArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        const char* s;
+    };
+};
+
+// Returns false when the site is over its budget. outSuppressed receives the number of
+// messages dropped since the site last got through.
+bool Admit(CallSite& site, uint32_t& outSuppressed);
+void Enqueue(
+    LogLevel level, const char* format, const Arg* args, size_t count, uint32_t suppressed);
+
+template <typename T>
+Arg MakeArg(const T value) {
+    Arg arg{};
+    if constexpr (std::is_same_v<T, char*> || std::is_same_v<T, const char*>) {
+        arg.type = ArgType::String;
+        arg.s = value;
+    } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+        arg.type = ArgType::Pointer;
+        arg.p = value;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        arg.type = ArgType::Double;
+        arg.d = static_cast<double>(value);
+    } else if constexpr (std::is_enum_v<T>) {
+        arg.type = ArgType::Signed;
+        arg.i = static_cast<int64_t>(value);
+    } else if constexpr (std::is_signed_v<T>) {
+        static_assert(std::is_integral_v<T>, "unsupported log argument");
+        arg.type = ArgType::Signed;
+        arg.i = value;
+    } else {
+        static_assert(std::is_integral_v<T>, "unsupported log argument");
+        arg.type = ArgType::Unsigned;
+        arg.u = value;
+    }
+    return arg;
+}
+
+// For callers that already went through Admit, e.g. to skip costly argument building for
+// messages the site would drop; suppressed is the count Admit returned.
+template <typename... Args>
+void Log(const LogLevel level, const uint32_t suppressed, const char* format,
+         const Args&... args) {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+    if constexpr (sizeof...(Args) == 0) {
+        Enqueue(level, format, nullptr, 0, suppressed);
+    } else {
+        const Arg packed[] = {MakeArg<std::decay_t<const Args>>(args)...};
+        Enqueue(level, format, packed, sizeof...(Args), suppressed);
+    }
+}
+
+template <typename... Args>
+void Log(const LogLevel level, CallSite& site, const char* format, const Args&... args) {
+    uint32_t suppressed = 0;
+    if (Admit(site, suppressed)) {
+        Log(level, suppressed, format, args...);
+    }
+}
+
+}  // namespace log_detail
+
+#define LOG_AT(level, format, ...)                                                   \
+    do {                                                                             \
+        if (LogEnabled(level)) {                                                     \
+            static log_detail::CallSite logSite;                                     \
+            log_detail::Log(level, logSite, format __VA_OPT__(, ) __VA_ARGS__);      \
+        }                                                                            \
+    } while (0)
+
+#define LOGD(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOGI(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOGW(...) LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOGE(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Column-major 4x4 matrices in the layout glUniformMatrix4fv and std140 expect.
+struct alignas(16) Mat4 {
+    float m[16] = {};
+};
+
+inline Mat4 Mat4Identity() {
+    Mat4 out{};
+    out.m[0] = 1.0f;
+    out.m[5] = 1.0f;
+    out.m[10] = 1.0f;
+    out.m[15] = 1.0f;
+    return out;
+}
+
+// a * b; each output column is a linear combination of a's columns.
+inline Mat4 Mat4Multiply(const Mat4& a, const Mat4& b) {
+    Mat4 out;
+#if defined(__ARM_NEON)
+    const float32x4_t a0 = vld1q_f32(a.m + 0);
+    const float32x4_t a1 = vld1q_f32(a.m + 4);
+    const float32x4_t a2 = vld1q_f32(a.m + 8);
+    const float32x4_t a3 = vld1q_f32(a.m + 12);
+    for (int c = 0; c < 4; ++c) {
+        const float* col = b.m + (c * 4);
+        float32x4_t sum = vmulq_n_f32(a0, col[0]);
+        sum = vmlaq_n_f32(sum, a1, col[1]);
+        sum = vmlaq_n_f32(sum, a2, col[2]);
+        sum = vmlaq_n_f32(sum, a3, col[3]);
+        vst1q_f32(out.m + (c * 4), sum);
+    }
+#elif defined(__SSE2__)
+    const __m128 a0 = _mm_load_ps(a.m + 0);
+    const __m128 a1 = _mm_load_ps(a.m + 4);
+    const __m128 a2 = _mm_load_ps(a.m + 8);
+    const __m128 a3 = _mm_load_ps(a.m + 12);
+    for (int c = 0; c < 4; ++c) {
+        const float* col = b.m + (c * 4);
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(col[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(col[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(col[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(col[3])));
+        _mm_store_ps(out.m + (c * 4), sum);
+    }
+#else
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            out.m[(c * 4) + r] = a.m[(0 * 4) + r] * b.m[(c * 4) + 0] +
+                                 a.m[(1 * 4) + r] * b.m[(c * 4) + 1] +
+                                 a.m[(2 * 4) + r] * b.m[(c * 4) + 2] +
+                                 a.m[(3 * 4) + r] * b.m[(c * 4) + 3];
+        }
+    }
+#endif
+    return out;
+}
+
+// a * Translation(0, 0, z) * Scale(halfSize, halfSize, 1): places a unit quad at depth z
+// with two column scales and one column multiply-add instead of two full products.
+inline Mat4 Mat4MultiplyQuadPlacement(const Mat4& a, const float z, const float halfSize) {
+    Mat4 out;
+    for (int r = 0; r < 4; ++r) {
+        out.m[0 + r] = a.m[0 + r] * halfSize;
+        out.m[4 + r] = a.m[4 + r] * halfSize;
+        out.m[8 + r] = a.m[8 + r];
+        out.m[12 + r] = a.m[8 + r] * z + a.m[12 + r];
+    }
+    return out;
+}
+
+inline Mat4 Mat4Translation(const float x, const float y, const float z) {
+    Mat4 out = Mat4Identity();
+    out.m[12] = x;
+    out.m[13] = y;
+    out.m[14] = z;
+    return out;
+}
+
+inline Mat4 Mat4Scale(const float x, const float y, const float z) {
+    Mat4 out{};
+    out.m[0] = x;
+    out.m[5] = y;
+    out.m[10] = z;
+    out.m[15] = 1.0f;
+    return out;
+}
+
+inline Mat4 Mat4RotationX(const float radians) {
+    Mat4 out = Mat4Identity();
+    const float c = std::cos(radians);
+    const float s = std::sin(radians);
+    out.m[5] = c;
+    out.m[6] = s;
+    out.m[9] = -s;
+    out.m[10] = c;
+    return out;
+}
+
+inline Mat4 Mat4RotationY(const float radians) {
+    Mat4 out = Mat4Identity();
+    const float c = std::cos(radians);
+    const float s = std::sin(radians);
+    out.m[0] = c;
+    out.m[2] = -s;
+    out.m[8] = s;
+    out.m[10] = c;
+    return out;
+}
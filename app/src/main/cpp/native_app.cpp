@@ -4,26 +4,35 @@
 
 #include <algorithm>
 #include <array>
-#include <cctype>
 #include <chrono>
 #include <cmath>
-#include <fstream>
-#include <iomanip>
+#include <cstdio>
+#include <ctime>
 #include <mutex>
-#include <sstream>
+#include <optional>
 #include <string>
-#include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+
+#include "app_loop.h"
 #include "audio_player.h"
+#include "display_timing.h"
+#include "frame_buffer_pool.h"
+#include "frame_capture.h"
+#include "info_pages.h"
+#include "info_panel.h"
 #include "libretro_vb_core.h"
 #include "log.h"
 #include "renderer_gl.h"
+#include "screenshot.h"
+#include "settings_store.h"
+#include "text_renderer.h"
+#include "thread_policy.h"
 #include "xr_stereo_renderer.h"
 
 namespace {
 
-constexpr auto kFrameTarget = std::chrono::milliseconds(20);  // ~50 FPS for VB content.
 constexpr int kRomReloadFrames = 120;
 constexpr float kDefaultScreenScale = 0.62f;
 constexpr float kDefaultStereoConvergence = -0.04f;
@@ -40,6 +49,15 @@ constexpr float kWalkPitchStep = 0.035f;
 constexpr float kWalkPitchLimit = 1.20f;
 constexpr float kWalkStickDeadzone = 0.18f;
 constexpr char kPresentationSettingsFile[] = "presentation_settings.cfg";
+constexpr char kScreenScaleKey[] = "screen_scale";
+constexpr char kStereoConvergenceKey[] = "stereo_convergence";
+constexpr char kViewModeKey[] = "view_mode";
+constexpr char kDepthRenderModeKey[] = "depth_render_mode";
+constexpr char kScreenshotModeKey[] = "screenshot_mode";
+constexpr char kCaptureDir[] = "captures";
+constexpr char kScreenshotDir[] = "screenshots";
+constexpr int kMaxScreenshotWidth = 768;
+constexpr int kMaxScreenshotHeight = 384;
 constexpr int kStandbyFrameWidth = 768;
 constexpr int kStandbyFrameHeight = 384;
 constexpr auto kInfoHintBlinkPeriod = std::chrono::milliseconds(500);
@@ -83,179 +101,20 @@ bool TakePickerDismissedSignal() {
     return true;
 }
 
-using Glyph = std::array<uint8_t, 7>;
-
-constexpr int kGlyphWidth = 5;
-constexpr int kGlyphHeight = 7;
-constexpr int kTextScale = 2;
-constexpr int kTextSpacing = 1;
-
-const Glyph* GetGlyph(char ch) {
-    static constexpr Glyph kBlank = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    static constexpr Glyph kColon = {0x00, 0x04, 0x00, 0x00, 0x04, 0x00, 0x00};
-    static constexpr Glyph kDot = {0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06};
-    static constexpr Glyph kDash = {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00};
-    static constexpr Glyph kPlus = {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00};
-    static constexpr Glyph kSlash = {0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00};
-    static constexpr Glyph kLeftParen = {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02};
-    static constexpr Glyph kRightParen = {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08};
-
-    static constexpr Glyph k0 = {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E};
-    static constexpr Glyph k1 = {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E};
-    static constexpr Glyph k2 = {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F};
-    static constexpr Glyph k3 = {0x1E, 0x01, 0x01, 0x0E, 0x01, 0x01, 0x1E};
-    static constexpr Glyph k4 = {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02};
-    static constexpr Glyph k5 = {0x1F, 0x10, 0x10, 0x1E, 0x01, 0x01, 0x1E};
-    static constexpr Glyph k6 = {0x0E, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x0E};
-    static constexpr Glyph k7 = {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08};
-    static constexpr Glyph k8 = {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E};
-    static constexpr Glyph k9 = {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x0E};
-
-    static constexpr Glyph kA = {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11};
-    static constexpr Glyph kB = {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E};
-    static constexpr Glyph kC = {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E};
-    static constexpr Glyph kD = {0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E};
-    static constexpr Glyph kE = {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F};
-    static constexpr Glyph kF = {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10};
-    static constexpr Glyph kG = {0x0E, 0x11, 0x10, 0x10, 0x13, 0x11, 0x0F};
-    static constexpr Glyph kH = {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11};
-    static constexpr Glyph kI = {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E};
-    static constexpr Glyph kJ = {0x01, 0x01, 0x01, 0x01, 0x11, 0x11, 0x0E};
-    static constexpr Glyph kK = {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11};
-    static constexpr Glyph kL = {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F};
-    static constexpr Glyph kM = {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11};
-    static constexpr Glyph kN = {0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x11};
-    static constexpr Glyph kO = {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E};
-    static constexpr Glyph kP = {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10};
-    static constexpr Glyph kQ = {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D};
-    static constexpr Glyph kR = {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11};
-    static constexpr Glyph kS = {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E};
-    static constexpr Glyph kT = {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04};
-    static constexpr Glyph kU = {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E};
-    static constexpr Glyph kV = {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04};
-    static constexpr Glyph kW = {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A};
-    static constexpr Glyph kX = {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11};
-    static constexpr Glyph kY = {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04};
-    static constexpr Glyph kZ = {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F};
-
-    switch (ch) {
-        case ' ':
-            return &kBlank;
-        case ':':
-            return &kColon;
-        case '.':
-            return &kDot;
-        case '-':
-            return &kDash;
-        case '+':
-            return &kPlus;
-        case '/':
-            return &kSlash;
-        case '(':
-            return &kLeftParen;
-        case ')':
-            return &kRightParen;
-        case '0':
-            return &k0;
-        case '1':
-            return &k1;
-        case '2':
-            return &k2;
-        case '3':
-            return &k3;
-        case '4':
-            return &k4;
-        case '5':
-            return &k5;
-        case '6':
-            return &k6;
-        case '7':
-            return &k7;
-        case '8':
-            return &k8;
-        case '9':
-            return &k9;
-        case 'A':
-            return &kA;
-        case 'B':
-            return &kB;
-        case 'C':
-            return &kC;
-        case 'D':
-            return &kD;
-        case 'E':
-            return &kE;
-        case 'F':
-            return &kF;
-        case 'G':
-            return &kG;
-        case 'H':
-            return &kH;
-        case 'I':
-            return &kI;
-        case 'J':
-            return &kJ;
-        case 'K':
-            return &kK;
-        case 'L':
-            return &kL;
-        case 'M':
-            return &kM;
-        case 'N':
-            return &kN;
-        case 'O':
-            return &kO;
-        case 'P':
-            return &kP;
-        case 'Q':
-            return &kQ;
-        case 'R':
-            return &kR;
-        case 'S':
-            return &kS;
-        case 'T':
-            return &kT;
-        case 'U':
-            return &kU;
-        case 'V':
-            return &kV;
-        case 'W':
-            return &kW;
-        case 'X':
-            return &kX;
-        case 'Y':
-            return &kY;
-        case 'Z':
-            return &kZ;
-        default:
-            return &kBlank;
-    }
-}
-
-int TextWidthPixels(const std::string& text, const int scale) {
-    if (text.empty()) {
-        return 0;
-    }
-    const int charWidth = (kGlyphWidth * scale) + (kTextSpacing * scale);
-    return static_cast<int>(text.size()) * charWidth - (kTextSpacing * scale);
-}
-
-std::string ToUpperAscii(std::string text) {
-    for (char& ch : text) {
-        ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
-    }
-    return text;
-}
-
-std::string FitTextToWidth(std::string text, const int maxWidthPx, const int scale) {
-    if (maxWidthPx <= 0) {
-        return {};
-    }
-    text = ToUpperAscii(text);
-    while (!text.empty() && TextWidthPixels(text, scale) > maxWidthPx) {
-        text.pop_back();
-    }
-    return text;
+VbInputState MergeInput(
+    const VbInputState& keys, const XrStereoRenderer::ControllerState& xrState) {
+    VbInputState merged = keys;
+    merged.left = merged.left || xrState.left;
+    merged.right = merged.right || xrState.right;
+    merged.up = merged.up || xrState.up;
+    merged.down = merged.down || xrState.down;
+    merged.a = merged.a || xrState.a;
+    merged.b = merged.b || xrState.b;
+    merged.l = merged.l || xrState.l;
+    merged.r = merged.r || xrState.r;
+    merged.start = merged.start || xrState.start;
+    merged.select = merged.select || xrState.select;
+    return merged;
 }
 
 std::string BasenameFromPath(const std::string& path) {
@@ -269,114 +128,6 @@ std::string BasenameFromPath(const std::string& path) {
     return path.substr(slash + 1);
 }
 
-void FillRect(
-    std::vector<uint32_t>& frame,
-    const int frameWidth,
-    const int frameHeight,
-    int x,
-    int y,
-    int width,
-    int height,
-    const uint32_t color) {
-    if (frameWidth <= 0 || frameHeight <= 0 || frame.empty() || width <= 0 || height <= 0) {
-        return;
-    }
-    if (x < 0) {
-        width += x;
-        x = 0;
-    }
-    if (y < 0) {
-        height += y;
-        y = 0;
-    }
-    if (x + width > frameWidth) {
-        width = frameWidth - x;
-    }
-    if (y + height > frameHeight) {
-        height = frameHeight - y;
-    }
-    if (width <= 0 || height <= 0) {
-        return;
-    }
-
-    for (int row = 0; row < height; ++row) {
-        uint32_t* dst = frame.data() + static_cast<size_t>(y + row) * frameWidth + x;
-        std::fill(dst, dst + width, color);
-    }
-}
-
-void DrawText(
-    std::vector<uint32_t>& frame,
-    const int frameWidth,
-    const int frameHeight,
-    const std::string& text,
-    int x,
-    const int y,
-    const int scale,
-    const uint32_t color) {
-    const int advance = (kGlyphWidth * scale) + (kTextSpacing * scale);
-    const std::string upper = ToUpperAscii(text);
-    for (const char ch : upper) {
-        const Glyph* glyph = GetGlyph(ch);
-        if (glyph == nullptr) {
-            x += advance;
-            continue;
-        }
-
-        for (int row = 0; row < kGlyphHeight; ++row) {
-            const uint8_t bits = (*glyph)[row];
-            for (int col = 0; col < kGlyphWidth; ++col) {
-                if ((bits & (1u << (kGlyphWidth - 1 - col))) == 0) {
-                    continue;
-                }
-                const int px = x + (col * scale);
-                const int py = y + (row * scale);
-                FillRect(frame, frameWidth, frameHeight, px, py, scale, scale, color);
-            }
-        }
-        x += advance;
-    }
-}
-
-void DrawInfoPanel(
-    std::vector<uint32_t>& frame,
-    const int frameWidth,
-    const int frameHeight,
-    const int eyeOffsetX,
-    const int eyeWidth,
-    const std::vector<std::string>& lines) {
-    if (eyeWidth <= 0 || lines.empty()) {
-        return;
-    }
-
-    const int lineHeight = (kGlyphHeight * kTextScale) + 1;
-    const int padding = 6;
-    const int panelWidth = std::min(eyeWidth - 12, 360);
-    const int panelHeight = (padding * 2) + (lineHeight * static_cast<int>(lines.size()));
-    if (panelWidth <= 0 || panelHeight <= 0) {
-        return;
-    }
-
-    const int panelX = eyeOffsetX + ((eyeWidth - panelWidth) / 2);
-    const int panelY = (frameHeight - panelHeight) / 2;
-
-    FillRect(frame, frameWidth, frameHeight, panelX, panelY, panelWidth, panelHeight, 0xFF080808);
-    FillRect(frame, frameWidth, frameHeight, panelX, panelY, panelWidth, 2, 0xFFFFFFFF);
-    FillRect(
-        frame, frameWidth, frameHeight, panelX, panelY + panelHeight - 2, panelWidth, 2, 0xFFFFFFFF);
-    FillRect(frame, frameWidth, frameHeight, panelX, panelY, 2, panelHeight, 0xFFFFFFFF);
-    FillRect(
-        frame, frameWidth, frameHeight, panelX + panelWidth - 2, panelY, 2, panelHeight, 0xFFFFFFFF);
-
-    const int textX = panelX + padding;
-    const int maxTextWidth = panelWidth - (padding * 2);
-    for (size_t i = 0; i < lines.size(); ++i) {
-        const std::string fitted = FitTextToWidth(lines[i], maxTextWidth, kTextScale);
-        const int textY = panelY + padding + (static_cast<int>(i) * lineHeight);
-        DrawText(frame, frameWidth, frameHeight, fitted, textX, textY, kTextScale, 0xFFFFFFFF);
-    }
-}
-
 class App {
 public:
     enum class ViewMode : int {
@@ -384,30 +135,55 @@ public:
         Anchored = 2,
     };
 
-    explicit App(android_app* app) : app_(app) {}
+    enum class ScreenshotMode : int {
+        // The core's frame, both eyes side by side.
+        Game = 0,
+        // What the flat screen shows, info panel included.
+        Screen = 1,
+        Anaglyph = 2,
+        Eyes = 3,
+    };
+
+    // Constructed on android_main's thread, which also runs the emulation.
+    explicit App(android_app* app) : app_(app) {
+        const ThreadPolicyResult policy = ApplyThreadPolicy(ThreadRole::Emulation);
+        const bool hinted = perfHint_.open(static_cast<int64_t>(1.0e9 / kVbRefreshHz));
+        LOGI("Emulation thread: %s, nice %d, performance hint %s",
+             policy.pinned ? "big cores" : "all cores", policy.niceLevel, hinted ? "on" : "off");
+    }
 
     void onCmd(const int32_t cmd) {
         switch (cmd) {
             case APP_CMD_START:
-                running_ = true;
+                loop_.setRunning(true);
                 break;
             case APP_CMD_RESUME:
-                resumed_ = true;
+                loop_.setResumed(true);
                 break;
             case APP_CMD_PAUSE:
-                resumed_ = false;
+                loop_.setResumed(false);
+                settings_.flush();
+                capture_.stop();
                 break;
             case APP_CMD_STOP:
-                running_ = false;
+                loop_.setRunning(false);
                 break;
             case APP_CMD_INIT_WINDOW:
                 if (!core_.isInitialized()) {
                     core_.initialize();
+                    core_.setInputPoller([this] { return sampleGameInput(); });
+                    // The standby screen is the largest thing composed; overlays reuse it.
+                    core_.framePool().reserve(
+                        PooledBuffer::Compose,
+                        static_cast<size_t>(kStandbyFrameWidth) * kStandbyFrameHeight);
                 }
                 if (!presentationLoaded_) {
                     loadPresentationSettings();
                     presentationLoaded_ = true;
                 }
+                if (!screenshots_.active()) {
+                    startScreenshots();
+                }
                 if (!xrRenderer_.initialized()) {
                     const bool xrOk = xrRenderer_.initialize(app_->activity);
                     LOGI("OpenXR init: %d", xrOk ? 1 : 0);
@@ -435,6 +211,18 @@ public:
     }
 
     int32_t onInput(const AInputEvent* event) {
+        const int32_t handled = applyInputEvent(event);
+        if (handled != 0 && core_.isRomLoaded()) {
+            // Stamped with the event's own time so a tap between two polls still reaches the game.
+            const int64_t timeNs = AInputEvent_getType(event) == AINPUT_EVENT_TYPE_KEY
+                                       ? AKeyEvent_getEventTime(event)
+                                       : AMotionEvent_getEventTime(event);
+            core_.queueInputState(maskUiOwnedInput(xrState_, MergeInput(input_, xrState_)), timeNs);
+        }
+        return handled;
+    }
+
+    int32_t applyInputEvent(const AInputEvent* event) {
         const int32_t eventType = AInputEvent_getType(event);
         if (eventType == AINPUT_EVENT_TYPE_KEY) {
             const int32_t action = AKeyEvent_getAction(event);
@@ -446,7 +234,7 @@ public:
             const bool pressed = action == AKEY_EVENT_ACTION_DOWN;
             lastKeyCode_ = keyCode;
             if (pressed) {
-                LOGI("key event: code=%d", keyCode);
+                LOGD("key event: code=%d", keyCode);
             }
 
             switch (keyCode) {
@@ -509,7 +297,7 @@ public:
                     return 1;
                 case AKEYCODE_BUTTON_THUMBL:
                     if (pressed) {
-                        requestRomPicker();
+                        handleLeftStickClick(MergeInput(input_, xrState_));
                     }
                     return 1;
                 case AKEYCODE_BUTTON_X:
@@ -547,26 +335,43 @@ public:
         return 0;
     }
 
+    // When tick() next has work; nullopt when the looper can block until the next event.
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> nextTickTime() const {
+        return loop_.nextWakeTime();
+    }
+
     void tick() {
-        if (!running_ || !resumed_) {
+        const std::optional<std::chrono::nanoseconds> work = loop_.tick([this] { runFrame(); });
+        if (!work) {
             return;
         }
+        perfHint_.reportWork(work->count());
+        frameWork_.add(std::chrono::duration<double, std::milli>(*work).count());
+        updateFps(std::chrono::steady_clock::now());
+    }
 
-        const auto frameStart = std::chrono::steady_clock::now();
-        if (xrRenderer_.initialized()) {
-            xrRenderer_.pollEvents();
-            if (xrRenderer_.exitRequested()) {
-                LOGW("OpenXR requested exit");
-                running_ = false;
-                return;
-            }
-        }
+    void shutdown() {
+        perfHint_.close();
+        capture_.stop();
+        screenshots_.stop();
+        settings_.close();
+        audioPlayer_.shutdown();
+        xrRenderer_.shutdown();
+        renderer_.shutdown();
+        core_.shutdown();
+    }
 
+private:
+    // One emulator frame plus the UI around it; AppLoop has already polled XR events.
+    void runFrame() {
+        // One sync here for the UI; the game's input is synced again when the core polls it.
         XrStereoRenderer::ControllerState xrState{};
         if (xrRenderer_.initialized()) {
+            xrRenderer_.syncInput();
             xrRenderer_.getControllerState(xrState);
             xrRenderer_.setOverlayVisible(showInfoWindow_);
         }
+        xrState_ = xrState;
         if (xrState.rightThumbClick && !prevXrRightThumbClick_) {
             toggleInfoWindow();
         }
@@ -595,10 +400,12 @@ public:
         }
 
         if (xrState.leftThumbClick && !prevXrLeftThumbClick_) {
-            requestRomPicker();
+            handleLeftStickClick(MergeInput(input_, xrState));
         }
 
         if (!core_.isRomLoaded()) {
+            // There is no game to screenshot; a request must not fire once a ROM loads later.
+            screenshotRequested_ = false;
 
             if (reloadCounter_ <= 0) {
                 tryLoadDefaultRom();
@@ -612,71 +419,91 @@ public:
             const uint32_t* standbyPixels = composeStandbyFrame(standbyWidth, standbyHeight);
             if (xrRenderer_.initialized()) {
                 xrRenderer_.updateFrame(standbyPixels, standbyWidth, standbyHeight);
-                const bool xrRendered = xrRenderer_.renderFrame();
-                if (!xrRendered && renderer_.initialized()) {
+                const bool xrPresenting = xrRenderer_.submitFrame();
+                if (!xrPresenting && renderer_.initialized()) {
                     renderer_.updateFrame(standbyPixels, standbyWidth, standbyHeight);
-                    renderer_.render();
+                    renderer_.render(loop_.presentTimeNs());
                 }
             } else if (renderer_.initialized()) {
                 renderer_.updateFrame(standbyPixels, standbyWidth, standbyHeight);
-                renderer_.render();
+                renderer_.render(loop_.presentTimeNs());
             }
         } else {
-            VbInputState mergedInput = input_;
-            mergedInput.left = mergedInput.left || xrState.left;
-            mergedInput.right = mergedInput.right || xrState.right;
-            mergedInput.up = mergedInput.up || xrState.up;
-            mergedInput.down = mergedInput.down || xrState.down;
-            mergedInput.a = mergedInput.a || xrState.a;
-            mergedInput.b = mergedInput.b || xrState.b;
-            mergedInput.l = mergedInput.l || xrState.l;
-            mergedInput.r = mergedInput.r || xrState.r;
-            mergedInput.start = mergedInput.start || xrState.start;
-            mergedInput.select = mergedInput.select || xrState.select;
-
-            applyCalibrationInput(mergedInput);
-            applyDepthWalkthroughControls(xrState, mergedInput);
-            core_.setInputState(mergedInput);
+            applyCalibrationInput(MergeInput(input_, xrState));
+            applyCaptureToggle(MergeInput(input_, xrState));
+            applyDepthWalkthroughControls(xrState);
+            // The game's input is sampled inside runFrame, see sampleGameInput().
             core_.runFrame();
             pumpAudio();
             if (core_.hasFrame()) {
                 const auto& sourceFrame = core_.framePixels();
                 const int width = core_.frameWidth();
                 const int height = core_.frameHeight();
+                capture_.submitFrame(sourceFrame.data(), width, height);
                 const uint32_t* renderPixels = composeRenderFrame(sourceFrame, width, height);
+                if (screenshotRequested_) {
+                    screenshotRequested_ = false;
+                    takeScreenshot(sourceFrame.data(), renderPixels, width, height);
+                }
 
                 if (xrRenderer_.initialized()) {
                     xrRenderer_.updateFrame(renderPixels, width, height);
-                    const bool xrRendered = xrRenderer_.renderFrame();
-                    if (!xrRendered && renderer_.initialized()) {
+                    const bool xrPresenting = xrRenderer_.submitFrame(core_.inputSampleTimeNs());
+                    if (!xrPresenting && renderer_.initialized()) {
                         renderer_.updateFrame(renderPixels, width, height);
-                        renderer_.render();
+                        renderer_.render(loop_.presentTimeNs());
                     }
                 } else if (renderer_.initialized()) {
                     renderer_.updateFrame(renderPixels, width, height);
-                    renderer_.render();
+                    renderer_.render(loop_.presentTimeNs());
                 }
             }
         }
 
         prevXrLeftThumbClick_ = xrState.leftThumbClick;
         prevXrRightThumbClick_ = xrState.rightThumbClick;
-        updateFps(std::chrono::steady_clock::now());
+    }
 
-        const auto frameElapsed = std::chrono::steady_clock::now() - frameStart;
-        if (frameElapsed < kFrameTarget) {
-            std::this_thread::sleep_for(kFrameTarget - frameElapsed);
+    // Runs inside core_.runFrame() when the game polls, so it sees the freshest controller state.
+    VbInputState sampleGameInput() {
+        if (xrRenderer_.initialized()) {
+            xrRenderer_.syncInput();
+            xrRenderer_.getControllerState(xrState_);
         }
+        return maskUiOwnedInput(xrState_, MergeInput(input_, xrState_));
     }
 
-    void shutdown() {
-        audioPlayer_.shutdown();
-        xrRenderer_.shutdown();
-        renderer_.shutdown();
-        core_.shutdown();
+    // Clears the buttons the calibration panel or walkthrough navigation own this frame.
+    [[nodiscard]] VbInputState maskUiOwnedInput(
+        const XrStereoRenderer::ControllerState& xrState, VbInputState inputState) const {
+        if (showInfoWindow_) {
+            if (inputState.l && inputState.r) {
+                // Calibration controls while both shoulders are held.
+                inputState.left = false;
+                inputState.right = false;
+                inputState.up = false;
+                inputState.down = false;
+                inputState.a = false;
+                inputState.l = false;
+                inputState.r = false;
+            }
+            inputState.b = false;
+            inputState.select = false;
+        }
+        const bool gripHeld = xrState.leftGrip || xrState.rightGrip;
+        if (xrRenderer_.initialized() && isWorldAnchoredMode() && gripHeld) {
+            // Walkthrough navigation.
+            inputState.left = false;
+            inputState.right = false;
+            inputState.up = false;
+            inputState.down = false;
+            inputState.a = false;
+            inputState.l = false;
+            inputState.r = false;
+        }
+        return inputState;
     }
 
-private:
     void pumpAudio() {
         if (!core_.isRomLoaded()) {
             return;
@@ -693,6 +520,7 @@ private:
                 break;
             }
             audioPlayer_.writeFrames(pcmChunk.data(), static_cast<int32_t>(frames));
+            capture_.submitAudio(pcmChunk.data(), frames);
             if (frames < 2048) {
                 break;
             }
@@ -706,9 +534,19 @@ private:
         infoToggleHeld_ = pressed;
     }
 
+    // Cycles closed, controls page, stats page, closed: one page of each fits a VIP frame.
     void toggleInfoWindow() {
-        showInfoWindow_ = !showInfoWindow_;
-        LOGI("Info window %s", showInfoWindow_ ? "enabled" : "disabled");
+        if (!showInfoWindow_) {
+            showInfoWindow_ = true;
+            infoPage_ = InfoPage::Controls;
+        } else if (infoPage_ == InfoPage::Controls) {
+            infoPage_ = InfoPage::Stats;
+        } else {
+            showInfoWindow_ = false;
+        }
+        LOGI("Info window %s", !showInfoWindow_                  ? "disabled"
+                               : infoPage_ == InfoPage::Controls ? "controls"
+                                                                 : "stats");
     }
 
     const char* viewModeName() const {
@@ -722,6 +560,11 @@ private:
         }
     }
 
+    const char* depthRenderModeName() const {
+        return depthRenderMode_ == XrStereoRenderer::DepthRenderMode::DisplacedMesh ? "MESH"
+                                                                                    : "LAYERS";
+    }
+
     bool isDepthModeEnabled() const { return false; }
     bool isWorldAnchoredMode() const { return viewMode_ == ViewMode::Anchored; }
 
@@ -732,8 +575,16 @@ private:
         LOGI("View mode: %s", viewModeName());
     }
 
-    void applyDepthWalkthroughControls(
-        const XrStereoRenderer::ControllerState& xrState, VbInputState& inputState) {
+    void toggleDepthRenderMode() {
+        depthRenderMode_ = depthRenderMode_ == XrStereoRenderer::DepthRenderMode::Layers
+                               ? XrStereoRenderer::DepthRenderMode::DisplacedMesh
+                               : XrStereoRenderer::DepthRenderMode::Layers;
+        applyPresentationConfig();
+        savePresentationSettings();
+        LOGI("Depth render mode: %s", depthRenderModeName());
+    }
+
+    void applyDepthWalkthroughControls(const XrStereoRenderer::ControllerState& xrState) {
         if (!xrRenderer_.initialized()) {
             return;
         }
@@ -779,15 +630,6 @@ private:
 
         xrRenderer_.setWalkthroughOffset(walkOffsetX_, walkOffsetY_, walkOffsetZ_);
         xrRenderer_.setWalkthroughRotation(walkYaw_, walkPitch_);
-
-        // While grip is held in anchored mode, controls drive walkthrough navigation.
-        inputState.left = false;
-        inputState.right = false;
-        inputState.up = false;
-        inputState.down = false;
-        inputState.a = false;
-        inputState.l = false;
-        inputState.r = false;
     }
 
     void applyPresentationConfig() {
@@ -799,6 +641,7 @@ private:
         const float effectiveConvergence = worldAnchoredEnabled ? 0.0f : stereoConvergence_;
         xrRenderer_.setPresentationConfig(screenScale_, effectiveConvergence);
         xrRenderer_.setDepthMetadataEnabled(depthEnabled);
+        xrRenderer_.setDepthRenderMode(depthRenderMode_);
         xrRenderer_.setWorldAnchoredEnabled(worldAnchoredEnabled);
         xrRenderer_.setOverlayVisible(showInfoWindow_);
         xrRenderer_.setWalkthroughOffset(walkOffsetX_, walkOffsetY_, walkOffsetZ_);
@@ -841,51 +684,35 @@ private:
         stereoConvergence_ = kDefaultStereoConvergence;
         viewMode_ = ViewMode::Anchored;
 
-        const std::string path = presentationSettingsPath();
-        if (path.empty()) {
+        if (!settings_.open(presentationSettingsPath())) {
             return;
         }
-
-        std::ifstream in(path);
-        if (!in.good()) {
-            return;
-        }
-
-        float loadedScale = screenScale_;
-        float loadedConvergence = stereoConvergence_;
-        int loadedViewMode = static_cast<int>(viewMode_);
-        in >> loadedScale >> loadedConvergence;
-        if (!in.fail()) {
-            in >> loadedViewMode;
-            if (in.fail()) {
-                in.clear();
-            }
-            screenScale_ = std::clamp(loadedScale, kMinScreenScale, kMaxScreenScale);
-            stereoConvergence_ =
-                std::clamp(loadedConvergence, kMinStereoConvergence, kMaxStereoConvergence);
-            viewMode_ = (loadedViewMode <= 0) ? ViewMode::Classic : ViewMode::Anchored;
-            LOGI(
-                "Loaded presentation settings: scale=%.3f convergence=%.3f viewMode=%d",
-                screenScale_,
-                stereoConvergence_,
-                static_cast<int>(viewMode_));
-        }
+        screenScale_ = std::clamp(
+            settings_.getFloat(kScreenScaleKey, screenScale_), kMinScreenScale, kMaxScreenScale);
+        stereoConvergence_ = std::clamp(
+            settings_.getFloat(kStereoConvergenceKey, stereoConvergence_),
+            kMinStereoConvergence,
+            kMaxStereoConvergence);
+        const int loadedViewMode = settings_.getInt(kViewModeKey, static_cast<int>(viewMode_));
+        viewMode_ = (loadedViewMode <= 0) ? ViewMode::Classic : ViewMode::Anchored;
+        depthRenderMode_ = settings_.getInt(kDepthRenderModeKey, 0) > 0
+                               ? XrStereoRenderer::DepthRenderMode::DisplacedMesh
+                               : XrStereoRenderer::DepthRenderMode::Layers;
+        screenshotMode_ = static_cast<ScreenshotMode>(
+            std::clamp(settings_.getInt(kScreenshotModeKey, 0), 0, 3));
+        LOGI(
+            "Loaded presentation settings: scale=%.3f convergence=%.3f viewMode=%d",
+            screenScale_,
+            stereoConvergence_,
+            static_cast<int>(viewMode_));
     }
 
+    // Only updates the in-memory store; its writer thread persists the change.
     void savePresentationSettings() {
-        const std::string path = presentationSettingsPath();
-        if (path.empty()) {
-            return;
-        }
-
-        std::ofstream out(path, std::ios::trunc);
-        if (!out.good()) {
-            LOGW("Failed to save presentation settings: %s", path.c_str());
-            return;
-        }
-
-        out << std::fixed << std::setprecision(4) << screenScale_ << " " << stereoConvergence_
-            << " " << static_cast<int>(viewMode_) << "\n";
+        settings_.setFloat(kScreenScaleKey, screenScale_);
+        settings_.setFloat(kStereoConvergenceKey, stereoConvergence_);
+        settings_.setInt(kViewModeKey, static_cast<int>(viewMode_));
+        settings_.setInt(kDepthRenderModeKey, static_cast<int>(depthRenderMode_));
     }
 
     void resetCalibrationEdgeState() {
@@ -896,13 +723,18 @@ private:
         adjustResetHeld_ = false;
     }
 
-    void applyCalibrationInput(VbInputState& inputState) {
+    void applyCalibrationInput(const VbInputState& inputState) {
         if (showInfoWindow_) {
             if (inputState.b && !depthToggleHeld_) {
-                toggleDepthViewMode();
+                // With L+R held B switches how depth scenes are drawn instead of the view. Only
+                // a core that exports depth metadata has depth scenes to draw.
+                if (inputState.l && inputState.r && core_.hasMetadata()) {
+                    toggleDepthRenderMode();
+                } else {
+                    toggleDepthViewMode();
+                }
             }
             depthToggleHeld_ = inputState.b;
-            inputState.b = false;
         } else {
             depthToggleHeld_ = false;
         }
@@ -961,16 +793,94 @@ private:
                 stereoConvergence_,
                 static_cast<int>(viewMode_));
         }
+    }
+
+    // SELECT with the info window open starts or stops a gameplay capture.
+    void applyCaptureToggle(const VbInputState& inputState) {
+        const bool pressed = showInfoWindow_ && inputState.select;
+        if (pressed && !captureToggleHeld_) {
+            if (capture_.active()) {
+                capture_.stop();
+            } else {
+                startCapture();
+            }
+        }
+        captureToggleHeld_ = pressed;
+    }
+
+    void startCapture() {
+        if (app_ == nullptr || app_->activity == nullptr ||
+            app_->activity->externalDataPath == nullptr) {
+            LOGW("Capture unavailable: no external data path");
+            return;
+        }
+        const std::string dir = std::string(app_->activity->externalDataPath) + "/" + kCaptureDir;
+        mkdir(dir.c_str(), 0770);
+        const std::time_t now = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&now, &local);
+        char name[64];
+        std::strftime(name, sizeof(name), "/vbcap-%Y%m%d-%H%M%S.vbcap", &local);
+        if (capture_.start(dir + name, kVbRefreshHz, core_.audioSampleRate())) {
+            LOGI("Capturing to %s", capture_.path().c_str());
+        }
+    }
+
+    // L3 opens the ROM picker; with the info window open it takes a screenshot instead, or
+    // with L+R held cycles the screenshot mode.
+    void handleLeftStickClick(const VbInputState& inputState) {
+        if (!showInfoWindow_) {
+            requestRomPicker();
+            return;
+        }
+        if (inputState.l && inputState.r) {
+            const int next = (static_cast<int>(screenshotMode_) + 1) % 4;
+            screenshotMode_ = static_cast<ScreenshotMode>(next);
+            settings_.setInt(kScreenshotModeKey, static_cast<int>(screenshotMode_));
+            LOGI("Screenshot mode: %s", screenshotModeName());
+            return;
+        }
+        screenshotRequested_ = true;
+    }
+
+    const char* screenshotModeName() const {
+        switch (screenshotMode_) {
+            case ScreenshotMode::Screen:
+                return "SCREEN";
+            case ScreenshotMode::Anaglyph:
+                return "ANAGLYPH";
+            case ScreenshotMode::Eyes:
+                return "EYES";
+            default:
+                return "GAME";
+        }
+    }
+
+    void startScreenshots() {
+        if (app_ == nullptr || app_->activity == nullptr ||
+            app_->activity->externalDataPath == nullptr) {
+            return;
+        }
+        const std::string dir =
+            std::string(app_->activity->externalDataPath) + "/" + kScreenshotDir;
+        mkdir(dir.c_str(), 0770);
+        screenshots_.start(dir, kMaxScreenshotWidth, kMaxScreenshotHeight);
+    }
 
-        // Consume calibration controls while both shoulders are held.
-        inputState.left = false;
-        inputState.right = false;
-        inputState.up = false;
-        inputState.down = false;
-        inputState.a = false;
-        inputState.l = false;
-        inputState.r = false;
-        inputState.b = false;
+    // One memcpy into a preallocated buffer; the PNG work happens on the writer thread.
+    void takeScreenshot(const uint32_t* gamePixels, const uint32_t* screenPixels, const int width,
+                        const int height) {
+        const uint32_t* pixels =
+            screenshotMode_ == ScreenshotMode::Screen ? screenPixels : gamePixels;
+        ScreenshotLayout layout = ScreenshotLayout::SideBySide;
+        if (screenshotMode_ == ScreenshotMode::Anaglyph) {
+            layout = ScreenshotLayout::Anaglyph;
+        } else if (screenshotMode_ == ScreenshotMode::Eyes) {
+            layout = ScreenshotLayout::SeparateEyes;
+        }
+        if (!screenshots_.capture(pixels, width, height, layout)) {
+            LOGW("Screenshot skipped: earlier screenshots are still being written");
+        }
     }
 
     void updateFps(const std::chrono::steady_clock::time_point now) {
@@ -984,67 +894,93 @@ private:
             }
             fpsFrameCount_ = 0;
             fpsWindowStart_ = now;
+            frameWorkMeanMs_ = frameWork_.meanMs();
+            frameWorkStddevMs_ = frameWork_.stddevMs();
+            frameWork_.reset();
+            reportFrameMemory();
         }
     }
 
-    std::vector<std::string> buildInfoLines() const {
-        std::vector<std::string> lines;
-        lines.reserve(12);
+    // Updates the pool's accounting for the frame memory held outside it.
+    void reportFrameMemory() {
+        FrameBufferPool& pool = core_.framePool();
+        pool.reportBytes(FrameBufferUse::Textures,
+                         xrRenderer_.textureBytes() + renderer_.textureBytes());
+        pool.reportBytes(FrameBufferUse::Capture, capture_.stats().bufferBytes);
+        pool.reportBytes(FrameBufferUse::Screenshots, screenshots_.stats().bufferBytes);
+    }
+
+    // Refreshes the retained info panel from the current page; the panel only re-fits and
+    // re-rasterizes the lines whose text changed.
+    void updateInfoPanel() {
+        InfoPanelStatus status;
         const auto nowTicks = std::chrono::duration_cast<std::chrono::milliseconds>(
                                   std::chrono::steady_clock::now().time_since_epoch())
                                   .count();
-        const bool blinkOn =
-            ((nowTicks / kInfoHintBlinkPeriod.count()) % 2) == 0;
-        lines.emplace_back(blinkOn ? "PUSH RIGHT STICK TO CLOSE" : " ");
-
-        std::ostringstream fpsText;
-        fpsText << std::fixed << std::setprecision(1) << fps_;
-        lines.emplace_back("FPS: " + fpsText.str());
-
-        if (core_.isRomLoaded()) {
-            lines.emplace_back("ROM: " + BasenameFromPath(core_.romLabel()));
-        } else {
-            lines.emplace_back("ROM: NONE");
-        }
-
-        lines.emplace_back("ROM PICKER: HIDE INFO + L3");
-        lines.emplace_back(std::string("VIEW: ") + viewModeName() + " (TOGGLE \"B\")");
-
-        if (isWorldAnchoredMode()) {
-            lines.emplace_back("NAV (HOLD ANY GRIP)");
-            lines.emplace_back("  L-STICK: MOVE");
-            lines.emplace_back("  R-STICK: LOOK");
-            lines.emplace_back("  L/R TRIGGER: UP/DOWN");
-            lines.emplace_back("  A: RESET VIEW");
-        }
-
-        {
-            std::ostringstream scaleText;
-            scaleText << std::fixed << std::setprecision(2) << screenScale_;
-            lines.emplace_back("SCREEN SIZE: " + scaleText.str());
-        }
-
-        if (!isWorldAnchoredMode()) {
-            std::ostringstream convergenceText;
-            convergenceText << std::fixed << std::setprecision(3)
-                            << stereoConvergence_;
-            lines.emplace_back("STEREO CONV: " + convergenceText.str());
-            lines.emplace_back("CALIB: HOLD L+R");
-            lines.emplace_back("U/D SIZE, L/R CONV, A RESET");
+        status.hintVisible = ((nowTicks / kInfoHintBlinkPeriod.count()) % 2) == 0;
+        status.fps = fps_;
+        status.frameWorkMeanMs = frameWorkMeanMs_;
+        status.frameWorkStddevMs = frameWorkStddevMs_;
+        status.memory = core_.framePool().usage();
+
+        if (xrRenderer_.sessionRunning()) {
+            const auto debug = xrRenderer_.renderDebugState();
+            status.xrSession = true;
+            status.displayRefreshHz = debug.displayRefreshHz;
+            status.cadenceRepeats = debug.cadenceRepeats;
+            status.judderPercent = debug.judderPercent;
+            status.gpuTimerAvailable = debug.gpuTimerAvailable;
+            status.frameGpuTimeMs = debug.frameGpuTimeMs;
+            status.layerGpuTimeMs = debug.layerGpuTimeMs;
+            status.meshGpuTimeMs = debug.meshGpuTimeMs;
+            status.inputLatencyMs = debug.inputLatencyMs;
+        }
+
+        status.hasMetadata = core_.hasMetadata();
+        if (!core_.isRomLoaded()) {
+            status.romLine = "ROM: NONE";
         } else {
-            lines.emplace_back("CALIB: HOLD L+R");
-            lines.emplace_back("U/D SIZE, A RESET");
-        }
-
-        return lines;
+            if (core_.romLabel() != infoRomLabel_ || infoRomLine_.empty()) {
+                infoRomLabel_ = core_.romLabel();
+                infoRomLine_ = "ROM: " + BasenameFromPath(infoRomLabel_);
+            }
+            status.romLine = infoRomLine_;
+        }
+        status.viewMode = viewModeName();
+        status.depthRenderMode = depthRenderModeName();
+        status.screenshotMode = screenshotModeName();
+        status.worldAnchored = isWorldAnchoredMode();
+        status.capturing = capture_.active();
+        if (status.capturing) {
+            const FrameCapture::Stats stats = capture_.stats();
+            status.captureBytes = stats.bytes;
+            status.captureDropped = stats.dropped;
+        }
+        status.screenScale = screenScale_;
+        status.stereoConvergence = stereoConvergence_;
+        BuildInfoPage(infoPage_, status, infoPanel_);
     }
 
     const uint32_t* composeStandbyFrame(int& outWidth, int& outHeight) {
         outWidth = kStandbyFrameWidth;
         outHeight = kStandbyFrameHeight;
-        standbyFrame_.assign(
-            static_cast<size_t>(kStandbyFrameWidth) * static_cast<size_t>(kStandbyFrameHeight),
-            0xFF000000);
+        if (showInfoWindow_) {
+            updateInfoPanel();
+        }
+        // The standby screen only depends on the info window and the panel contents.
+        const uint64_t panelGeneration = showInfoWindow_ ? infoPanel_.generation() : 0;
+        const size_t pixelCount =
+            static_cast<size_t>(kStandbyFrameWidth) * static_cast<size_t>(kStandbyFrameHeight);
+        std::vector<uint32_t>& standbyFrame =
+            core_.framePool().pixels(PooledBuffer::Compose, pixelCount);
+        if (standbyValid_ && standbyShowInfo_ == showInfoWindow_ &&
+            standbyPanelGeneration_ == panelGeneration) {
+            return standbyFrame.data();
+        }
+        standbyValid_ = true;
+        standbyShowInfo_ = showInfoWindow_;
+        standbyPanelGeneration_ = panelGeneration;
+        std::fill(standbyFrame.begin(), standbyFrame.end(), 0xFF000000);
 
         const bool canDrawMonoText = kStandbyFrameWidth > 40 && kStandbyFrameHeight > 40;
         const bool sideBySideStandby = kStandbyFrameWidth >= (kStandbyFrameHeight * 2);
@@ -1052,9 +988,9 @@ private:
         auto drawStandbyText = [&](const char* text, const int x, const int y) {
             if (sideBySideStandby) {
                 DrawText(
-                    standbyFrame_, kStandbyFrameWidth, kStandbyFrameHeight, text, x, y, 2, 0xFFFFFFFF);
+                    standbyFrame, kStandbyFrameWidth, kStandbyFrameHeight, text, x, y, 2, 0xFFFFFFFF);
                 DrawText(
-                    standbyFrame_,
+                    standbyFrame,
                     kStandbyFrameWidth,
                     kStandbyFrameHeight,
                     text,
@@ -1064,7 +1000,7 @@ private:
                     0xFFFFFFFF);
             } else {
                 DrawText(
-                    standbyFrame_, kStandbyFrameWidth, kStandbyFrameHeight, text, x, y, 2, 0xFFFFFFFF);
+                    standbyFrame, kStandbyFrameWidth, kStandbyFrameHeight, text, x, y, 2, 0xFFFFFFFF);
             }
         };
 
@@ -1072,7 +1008,8 @@ private:
             drawStandbyText("NO ROM LOADED", 18, 18);
 
             if (showInfoWindow_) {
-                drawStandbyText("R3: HIDE INFO", 18, 40);
+                drawStandbyText(
+                    infoPage_ == InfoPage::Controls ? "R3: STATS" : "R3: HIDE INFO", 18, 40);
             } else {
                 drawStandbyText("L3: OPEN ROM PICKER", 18, 40);
                 drawStandbyText("R3: SHOW INFO", 18, 62);
@@ -1080,22 +1017,14 @@ private:
         }
 
         if (showInfoWindow_) {
-            const std::vector<std::string> lines = buildInfoLines();
+            infoPanel_.draw(standbyFrame, kStandbyFrameWidth, kStandbyFrameHeight, 0, eyeWidth);
             if (sideBySideStandby) {
-                DrawInfoPanel(standbyFrame_, kStandbyFrameWidth, kStandbyFrameHeight, 0, eyeWidth, lines);
-                DrawInfoPanel(
-                    standbyFrame_,
-                    kStandbyFrameWidth,
-                    kStandbyFrameHeight,
-                    eyeWidth,
-                    eyeWidth,
-                    lines);
-            } else {
-                DrawInfoPanel(standbyFrame_, kStandbyFrameWidth, kStandbyFrameHeight, 0, eyeWidth, lines);
+                infoPanel_.draw(
+                    standbyFrame, kStandbyFrameWidth, kStandbyFrameHeight, eyeWidth, eyeWidth);
             }
         }
 
-        return standbyFrame_.data();
+        return standbyFrame.data();
     }
 
     const uint32_t* composeRenderFrame(
@@ -1104,18 +1033,22 @@ private:
             return sourceFrame.data();
         }
 
-        overlayFrame_ = sourceFrame;
-        const std::vector<std::string> lines = buildInfoLines();
+        // Shares its buffer with the standby screen, which has to be redrawn after this.
+        standbyValid_ = false;
+        std::vector<uint32_t>& overlayFrame =
+            core_.framePool().pixels(PooledBuffer::Compose, sourceFrame.size());
+        std::copy(sourceFrame.begin(), sourceFrame.end(), overlayFrame.begin());
+        updateInfoPanel();
 
         if (width >= (height * 2)) {
             const int eyeWidth = width / 2;
-            DrawInfoPanel(overlayFrame_, width, height, 0, eyeWidth, lines);
-            DrawInfoPanel(overlayFrame_, width, height, eyeWidth, eyeWidth, lines);
+            infoPanel_.draw(overlayFrame, width, height, 0, eyeWidth);
+            infoPanel_.draw(overlayFrame, width, height, eyeWidth, eyeWidth);
         } else {
-            DrawInfoPanel(overlayFrame_, width, height, 0, width, lines);
+            infoPanel_.draw(overlayFrame, width, height, 0, width);
         }
 
-        return overlayFrame_.data();
+        return overlayFrame.data();
     }
 
     void updateDirectionalState() {
@@ -1236,10 +1169,14 @@ private:
     AudioPlayer audioPlayer_;
     GlRenderer renderer_;
     XrStereoRenderer xrRenderer_;
+    SettingsStore settings_;
+    FrameCapture capture_;
+    ScreenshotWriter screenshots_;
     VbInputState input_;
+    // Latest controller sample; key events merge with it when they are queued.
+    XrStereoRenderer::ControllerState xrState_{};
 
-    bool running_ = false;
-    bool resumed_ = false;
+    AppLoop loop_{xrRenderer_};
     int reloadCounter_ = 0;
     bool pickerRequested_ = false;
     bool autoPickerLaunchedForMissingRom_ = false;
@@ -1248,11 +1185,21 @@ private:
     bool prevXrLeftThumbClick_ = false;
     bool prevXrRightThumbClick_ = false;
     bool showInfoWindow_ = true;
+    InfoPage infoPage_ = InfoPage::Controls;
     bool infoToggleHeld_ = false;
-    std::vector<uint32_t> overlayFrame_;
-    std::vector<uint32_t> standbyFrame_;
+    bool standbyValid_ = false;
+    bool standbyShowInfo_ = false;
+    uint64_t standbyPanelGeneration_ = 0;
+    InfoPanel infoPanel_;
+    std::string infoRomLabel_;
+    std::string infoRomLine_;
     int fpsFrameCount_ = 0;
     double fps_ = 0.0;
+    // Emulation thread work per tick, summarized once per FPS window.
+    FrameTimeStats frameWork_;
+    double frameWorkMeanMs_ = 0.0;
+    double frameWorkStddevMs_ = 0.0;
+    PerformanceHintSession perfHint_;
     std::chrono::steady_clock::time_point fpsWindowStart_ = std::chrono::steady_clock::now();
     bool presentationLoaded_ = false;
     float screenScale_ = kDefaultScreenScale;
@@ -1263,7 +1210,11 @@ private:
     bool adjustRightHeld_ = false;
     bool adjustResetHeld_ = false;
     bool depthToggleHeld_ = false;
+    bool captureToggleHeld_ = false;
+    ScreenshotMode screenshotMode_ = ScreenshotMode::Game;
+    bool screenshotRequested_ = false;
     ViewMode viewMode_ = ViewMode::Anchored;
+    XrStereoRenderer::DepthRenderMode depthRenderMode_ = XrStereoRenderer::DepthRenderMode::Layers;
     bool walkResetHeld_ = false;
     float walkOffsetX_ = 0.0f;
     float walkOffsetY_ = 0.0f;
@@ -1350,9 +1301,11 @@ void android_main(struct android_app* app) {
         int events = 0;
         android_poll_source* source = nullptr;
 
-        const int timeoutMs = 0;
-        while (ALooper_pollOnce(timeoutMs, nullptr, &events, reinterpret_cast<void**>(&source)) >=
-               0) {
+        // Block until the next frame is due, or while paused until the next slow XR event poll;
+        // events wake the looper early and the timeout is recomputed after each one.
+        while (ALooper_pollOnce(
+                   LooperTimeoutMs(appInstance.nextTickTime(), std::chrono::steady_clock::now()),
+                   nullptr, &events, reinterpret_cast<void**>(&source)) >= 0) {
             if (source != nullptr) {
                 source->process(app, source);
             }
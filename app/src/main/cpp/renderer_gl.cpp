@@ -1,31 +1,43 @@
 #include "renderer_gl.h"
 
 #include <EGL/egl.h>
-#include <GLES2/gl2.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <cstring>
 
 #include "log.h"
 
 namespace {
 
+#ifndef EGL_OPENGL_ES3_BIT_KHR
+#define EGL_OPENGL_ES3_BIT_KHR 0x0040
+#endif
+
 constexpr char kVertexShader[] =
-    "attribute vec2 aPos;\n"
-    "attribute vec2 aUv;\n"
-    "varying vec2 vUv;\n"
+    "#version 300 es\n"
+    "in vec2 aPos;\n"
+    "in vec2 aUv;\n"
+    "out vec2 vUv;\n"
     "void main() {\n"
     "  vUv = aUv;\n"
     "  gl_Position = vec4(aPos, 0.0, 1.0);\n"
     "}\n";
 
 constexpr char kFragmentShader[] =
+    "#version 300 es\n"
     "precision mediump float;\n"
-    "varying vec2 vUv;\n"
+    "in vec2 vUv;\n"
     "uniform sampler2D uTex;\n"
+    "out vec4 fragColor;\n"
     "void main() {\n"
-    "  vec4 c = texture2D(uTex, vUv);\n"
+    "  vec4 c = texture(uTex, vUv);\n"
     "  float l = dot(c.rgb, vec3(0.299, 0.587, 0.114));\n"
-    "  gl_FragColor = vec4(l, l * 0.08, l * 0.03, 1.0);\n"
+    "  fragColor = vec4(l, l * 0.08, l * 0.03, 1.0);\n"
     "}\n";
 
+PFNEGLPRESENTATIONTIMEANDROIDPROC gPresentationTimeANDROID = nullptr;
+
 GLuint CompileShader(GLenum type, const char* source) {
     const GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, nullptr);
@@ -76,7 +88,7 @@ GLuint CreateProgram(const char* vs, const char* fs) {
 
 }  // namespace
 
-bool GlRenderer::createContext() {
+bool GlRenderer::createContext(const int pbufferWidth, const int pbufferHeight) {
     display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if (display_ == EGL_NO_DISPLAY) {
         LOGE("eglGetDisplay failed");
@@ -90,11 +102,11 @@ bool GlRenderer::createContext() {
         return false;
     }
 
-    constexpr EGLint kConfigAttrs[] = {
+    const EGLint configAttrs[] = {
         EGL_RENDERABLE_TYPE,
-        EGL_OPENGL_ES2_BIT,
+        EGL_OPENGL_ES3_BIT_KHR,
         EGL_SURFACE_TYPE,
-        EGL_WINDOW_BIT,
+        window_ != nullptr ? EGL_WINDOW_BIT : EGL_PBUFFER_BIT,
         EGL_RED_SIZE,
         8,
         EGL_GREEN_SIZE,
@@ -109,24 +121,33 @@ bool GlRenderer::createContext() {
     EGLConfig config = nullptr;
     EGLint count = 0;
     if (!eglChooseConfig(
-            static_cast<EGLDisplay>(display_), kConfigAttrs, &config, 1, &count) ||
+            static_cast<EGLDisplay>(display_), configAttrs, &config, 1, &count) ||
         count < 1) {
         LOGE("eglChooseConfig failed");
         return false;
     }
 
-    surface_ = eglCreateWindowSurface(
-        static_cast<EGLDisplay>(display_), config, static_cast<EGLNativeWindowType>(window_), nullptr);
+    if (window_ != nullptr) {
+        surface_ = eglCreateWindowSurface(
+            static_cast<EGLDisplay>(display_),
+            config,
+            reinterpret_cast<EGLNativeWindowType>(window_),
+            nullptr);
+    } else {
+        const EGLint pbufferAttrs[] = {
+            EGL_WIDTH, pbufferWidth, EGL_HEIGHT, pbufferHeight, EGL_NONE};
+        surface_ = eglCreatePbufferSurface(static_cast<EGLDisplay>(display_), config, pbufferAttrs);
+    }
     if (surface_ == EGL_NO_SURFACE) {
-        LOGE("eglCreateWindowSurface failed");
+        LOGE("eglCreate%sSurface failed", window_ != nullptr ? "Window" : "Pbuffer");
         return false;
     }
 
-    constexpr EGLint kContextAttrs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+    constexpr EGLint kContextAttrs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
     context_ = eglCreateContext(
         static_cast<EGLDisplay>(display_), config, EGL_NO_CONTEXT, kContextAttrs);
     if (context_ == EGL_NO_CONTEXT) {
-        LOGE("eglCreateContext failed");
+        LOGE("eglCreateContext (GLES3) failed");
         return false;
     }
 
@@ -139,6 +160,15 @@ bool GlRenderer::createContext() {
         return false;
     }
 
+    const char* extensions = eglQueryString(static_cast<EGLDisplay>(display_), EGL_EXTENSIONS);
+    if (extensions != nullptr && std::strstr(extensions, "EGL_ANDROID_presentation_time")) {
+        gPresentationTimeANDROID = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+            eglGetProcAddress("eglPresentationTimeANDROID"));
+    }
+    presentationTimeSupported_ = gPresentationTimeANDROID != nullptr;
+    if (!presentationTimeSupported_) {
+        LOGW("EGL_ANDROID_presentation_time unavailable; flat frames show at the next refresh");
+    }
     return true;
 }
 
@@ -152,17 +182,86 @@ bool GlRenderer::createProgram() {
     return true;
 }
 
-bool GlRenderer::ensureTexture() {
-    if (texture_ != 0) {
+bool GlRenderer::createQuad() {
+    constexpr GLfloat kVertices[] = {
+        -1.0f, -1.0f, 0.0f, 1.0f,  // bottom-left
+        1.0f,  -1.0f, 1.0f, 1.0f,  // bottom-right
+        -1.0f, 1.0f,  0.0f, 0.0f,  // top-left
+        1.0f,  1.0f,  1.0f, 0.0f,  // top-right
+    };
+
+    glGenVertexArrays(1, &vertexArray_);
+    glGenBuffers(1, &vertexBuffer_);
+    glBindVertexArray(vertexArray_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kVertices), kVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(
+        1,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        4 * sizeof(GLfloat),
+        reinterpret_cast<const void*>(2 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(kPixelBufferCount, pixelBuffers_.data());
+    return vertexArray_ != 0 && glGetError() == GL_NO_ERROR;
+}
+
+bool GlRenderer::ensureTexture(const int width, const int height) {
+    if (texture_ != 0 && width == textureWidth_ && height == textureHeight_) {
         return true;
     }
 
+    // Immutable storage cannot be resized; a new frame size gets a new texture.
+    destroyTexture();
     glGenTextures(1, &texture_);
     glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    const auto bytes = static_cast<GLsizeiptr>(width) * height * 4;
+    for (const GLuint buffer : pixelBuffers_) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        LOGE("Failed allocating %dx%d frame texture", width, height);
+        destroyTexture();
+        return false;
+    }
+    textureWidth_ = width;
+    textureHeight_ = height;
+    return true;
+}
+
+void GlRenderer::destroyTexture() {
+    if (texture_ != 0) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    textureWidth_ = 0;
+    textureHeight_ = 0;
+}
+
+bool GlRenderer::initializeResources(const int pbufferWidth, const int pbufferHeight) {
+    if (!createContext(pbufferWidth, pbufferHeight) || !createProgram() || !createQuad()) {
+        shutdown();
+        return false;
+    }
+
+    initialized_ = true;
+    LOGI("Renderer initialized (GLES3, presentation time %s)",
+         presentationTimeSupported_ ? "on" : "off");
     return true;
 }
 
@@ -174,107 +273,109 @@ bool GlRenderer::initialize(ANativeWindow* window) {
         return false;
     }
     window_ = window;
+    return initializeResources(0, 0);
+}
 
-    if (!createContext() || !createProgram() || !ensureTexture()) {
-        shutdown();
+bool GlRenderer::initializeOffscreen(const int width, const int height) {
+    shutdown();
+
+    if (width <= 0 || height <= 0) {
+        LOGE("Renderer init failed: bad pbuffer size %dx%d", width, height);
         return false;
     }
-
-    initialized_ = true;
-    LOGI("Renderer initialized");
-    return true;
+    return initializeResources(width, height);
 }
 
 void GlRenderer::updateFrame(const uint32_t* pixels, int width, int height) {
-    if (!initialized_ || pixels == nullptr || width <= 0 || height <= 0) {
+    if (!initialized_ || pixels == nullptr || width <= 0 || height <= 0 ||
+        !ensureTexture(width, height)) {
+        return;
+    }
+
+    // Copy into a pixel buffer and let the driver pull it into the texture asynchronously;
+    // invalidating the buffer means the map never stalls on its previous use.
+    const auto bytes = static_cast<GLsizeiptr>(width) * height * 4;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers_[nextPixelBuffer_]);
+    nextPixelBuffer_ = (nextPixelBuffer_ + 1) % kPixelBufferCount;
+    void* mapped = glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        LOGW("Pixel buffer map failed; frame dropped");
         return;
     }
+    std::memcpy(mapped, pixels, static_cast<size_t>(bytes));
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture_);
-
-    if (width != textureWidth_ || height != textureHeight_) {
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RGBA,
-            width,
-            height,
-            0,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE,
-            pixels);
-        textureWidth_ = width;
-        textureHeight_ = height;
-    } else {
-        glTexSubImage2D(
-            GL_TEXTURE_2D,
-            0,
-            0,
-            0,
-            width,
-            height,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE,
-            pixels);
-    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
-void GlRenderer::render() {
+void GlRenderer::render(const int64_t presentTimeNs) {
     if (!initialized_) {
         return;
     }
 
-    const GLint width = ANativeWindow_getWidth(window_);
-    const GLint height = ANativeWindow_getHeight(window_);
+    const auto display = static_cast<EGLDisplay>(display_);
+    const auto surface = static_cast<EGLSurface>(surface_);
+    EGLint width = 0;
+    EGLint height = 0;
+    eglQuerySurface(display, surface, EGL_WIDTH, &width);
+    eglQuerySurface(display, surface, EGL_HEIGHT, &height);
     glViewport(0, 0, width, height);
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(program_);
-
-    constexpr GLfloat kVertices[] = {
-        -1.0f, -1.0f, 0.0f, 1.0f,  // bottom-left
-        1.0f,  -1.0f, 1.0f, 1.0f,  // bottom-right
-        -1.0f, 1.0f,  0.0f, 0.0f,  // top-left
-        1.0f,  1.0f,  1.0f, 0.0f,  // top-right
-    };
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), kVertices);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(
-        1,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        4 * sizeof(GLfloat),
-        reinterpret_cast<const void*>(kVertices + 2));
-    glEnableVertexAttribArray(1);
+    if (texture_ != 0) {
+        glUseProgram(program_);
+        glBindVertexArray(vertexArray_);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+    }
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    eglSwapBuffers(static_cast<EGLDisplay>(display_), static_cast<EGLSurface>(surface_));
+    // Timestamps on the VB frame clock let the compositor hold each frame for whole refreshes
+    // instead of showing it whenever the swap happens to land.
+    if (presentationTimeSupported_ && presentTimeNs > 0) {
+        gPresentationTimeANDROID(display, surface, presentTimeNs);
+    }
+    eglSwapBuffers(display, surface);
 }
 
 void GlRenderer::shutdown() {
-    if (display_ != nullptr && display_ != EGL_NO_DISPLAY) {
+    const bool hasDisplay = display_ != nullptr && display_ != EGL_NO_DISPLAY;
+    const bool hasContext = context_ != nullptr && context_ != EGL_NO_CONTEXT;
+    // GL objects belong to the context; delete them while it is still current.
+    if (hasDisplay && hasContext &&
+        eglGetCurrentContext() == static_cast<EGLContext>(context_)) {
+        destroyTexture();
+        if (pixelBuffers_[0] != 0) {
+            glDeleteBuffers(kPixelBufferCount, pixelBuffers_.data());
+        }
+        if (vertexArray_ != 0) {
+            glDeleteVertexArrays(1, &vertexArray_);
+        }
+        if (vertexBuffer_ != 0) {
+            glDeleteBuffers(1, &vertexBuffer_);
+        }
+        if (program_ != 0) {
+            glDeleteProgram(program_);
+        }
+    }
+    texture_ = 0;
+    pixelBuffers_ = {};
+    vertexArray_ = 0;
+    vertexBuffer_ = 0;
+    program_ = 0;
+
+    if (hasDisplay) {
         eglMakeCurrent(
             static_cast<EGLDisplay>(display_),
             EGL_NO_SURFACE,
             EGL_NO_SURFACE,
             EGL_NO_CONTEXT);
-    }
-
-    if (texture_ != 0) {
-        glDeleteTextures(1, &texture_);
-        texture_ = 0;
-    }
-    if (program_ != 0) {
-        glDeleteProgram(program_);
-        program_ = 0;
-    }
-
-    if (display_ != nullptr && display_ != EGL_NO_DISPLAY) {
-        if (context_ != nullptr && context_ != EGL_NO_CONTEXT) {
+        if (hasContext) {
             eglDestroyContext(
                 static_cast<EGLDisplay>(display_), static_cast<EGLContext>(context_));
         }
@@ -289,6 +390,8 @@ void GlRenderer::shutdown() {
     surface_ = nullptr;
     display_ = nullptr;
     window_ = nullptr;
+    presentationTimeSupported_ = false;
+    nextPixelBuffer_ = 0;
     textureWidth_ = 0;
     textureHeight_ = 0;
     initialized_ = false;
@@ -1,30 +1,53 @@
 #pragma once
 
 #include <android/native_window.h>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 
 class GlRenderer {
 public:
     bool initialize(ANativeWindow* window);
+    // Renders into a width x height pbuffer instead of a window (host tests).
+    bool initializeOffscreen(int width, int height);
     void shutdown();
 
     void updateFrame(const uint32_t* pixels, int width, int height);
-    void render();
+    // presentTimeNs is the CLOCK_MONOTONIC time the frame should reach the display; 0 shows it
+    // at the next refresh. Ignored without EGL_ANDROID_presentation_time.
+    void render(int64_t presentTimeNs = 0);
 
     [[nodiscard]] bool initialized() const { return initialized_; }
+    [[nodiscard]] bool presentationTimeSupported() const { return presentationTimeSupported_; }
+    // The frame texture plus its pixel unpack buffers.
+    [[nodiscard]] size_t textureBytes() const {
+        return static_cast<size_t>(textureWidth_) * static_cast<size_t>(textureHeight_) * 4 *
+               (1 + kPixelBufferCount);
+    }
 
 private:
-    bool createContext();
+    static constexpr int kPixelBufferCount = 2;
+
+    bool createContext(int pbufferWidth, int pbufferHeight);
     bool createProgram();
-    bool ensureTexture();
+    bool createQuad();
+    bool ensureTexture(int width, int height);
+    bool initializeResources(int pbufferWidth, int pbufferHeight);
+    void destroyTexture();
 
     ANativeWindow* window_ = nullptr;
     void* display_ = nullptr;
     void* surface_ = nullptr;
     void* context_ = nullptr;
+    bool presentationTimeSupported_ = false;
 
     unsigned int program_ = 0;
+    unsigned int vertexArray_ = 0;
+    unsigned int vertexBuffer_ = 0;
     unsigned int texture_ = 0;
+    // Frames stream through these in turn so a map never waits on the previous upload.
+    std::array<unsigned int, kPixelBufferCount> pixelBuffers_{};
+    int nextPixelBuffer_ = 0;
     int textureWidth_ = 0;
     int textureHeight_ = 0;
 
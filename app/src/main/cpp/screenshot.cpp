@@ -0,0 +1,234 @@
+#include "screenshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <zlib.h>
+
+#include "log.h"
+#include "thread_policy.h"
+
+namespace {
+
+constexpr uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+void PutU32Be(std::vector<uint8_t>& out, const uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+// Patches the length of the chunk begun at chunkStart and appends its CRC.
+void FinishPngChunk(std::vector<uint8_t>& out, const size_t chunkStart) {
+    const auto length = static_cast<uint32_t>(out.size() - chunkStart - 8);
+    for (int i = 0; i < 4; ++i) {
+        out[chunkStart + i] = static_cast<uint8_t>(length >> (24 - i * 8));
+    }
+    const uLong crc = crc32(0L, out.data() + chunkStart + 4, length + 4);
+    PutU32Be(out, static_cast<uint32_t>(crc));
+}
+
+size_t BeginPngChunk(std::vector<uint8_t>& out, const char* type) {
+    const size_t chunkStart = out.size();
+    PutU32Be(out, 0);
+    out.insert(out.end(), type, type + 4);
+    return chunkStart;
+}
+
+uint8_t Intensity(const uint32_t pixel) {
+    return static_cast<uint8_t>(
+        std::max({(pixel >> 16) & 0xFFu, (pixel >> 8) & 0xFFu, pixel & 0xFFu}));
+}
+
+}  // namespace
+
+bool EncodePng(const uint32_t* pixels, const int width, const int height, const int stride,
+               std::vector<uint8_t>& out) {
+    // Every row uses filter 0; the VIP's few flat shades deflate well without prediction.
+    const size_t rowBytes = 1 + static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> rows(rowBytes * static_cast<size_t>(height));
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = rows.data() + static_cast<size_t>(y) * rowBytes;
+        const uint32_t* source = pixels + static_cast<size_t>(y) * static_cast<size_t>(stride);
+        row[0] = 0;
+        for (int x = 0; x < width; ++x) {
+            row[1 + x * 3] = static_cast<uint8_t>(source[x] >> 16);
+            row[2 + x * 3] = static_cast<uint8_t>(source[x] >> 8);
+            row[3 + x * 3] = static_cast<uint8_t>(source[x]);
+        }
+    }
+
+    out.assign(kPngSignature, kPngSignature + sizeof(kPngSignature));
+    size_t chunk = BeginPngChunk(out, "IHDR");
+    PutU32Be(out, static_cast<uint32_t>(width));
+    PutU32Be(out, static_cast<uint32_t>(height));
+    // 8-bit RGB, deflate, adaptive filtering, no interlace.
+    const uint8_t format[] = {8, 2, 0, 0, 0};
+    out.insert(out.end(), format, format + sizeof(format));
+    FinishPngChunk(out, chunk);
+
+    chunk = BeginPngChunk(out, "IDAT");
+    const size_t dataStart = out.size();
+    uLongf compressedSize = compressBound(static_cast<uLong>(rows.size()));
+    out.resize(dataStart + compressedSize);
+    if (compress2(out.data() + dataStart, &compressedSize, rows.data(),
+                  static_cast<uLong>(rows.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    out.resize(dataStart + compressedSize);
+    FinishPngChunk(out, chunk);
+
+    chunk = BeginPngChunk(out, "IEND");
+    FinishPngChunk(out, chunk);
+    return true;
+}
+
+bool ScreenshotWriter::start(const std::string& directory, const int maxWidth,
+                             const int maxHeight) {
+    stop();
+    directory_ = directory;
+    capacity_ = static_cast<size_t>(maxWidth) * static_cast<size_t>(maxHeight);
+    for (size_t i = 0; i < kBufferCount; ++i) {
+        shots_[i].pixels.resize(capacity_);
+        freeShots_[i] = i;
+    }
+    freeCount_ = kBufferCount;
+    readyHead_ = 0;
+    readyCount_ = 0;
+    stopWorker_ = false;
+    stats_ = {};
+    stats_.bufferBytes = capacity_ * kBufferCount * sizeof(uint32_t);
+    worker_ = std::thread(&ScreenshotWriter::workerLoop, this);
+    return true;
+}
+
+void ScreenshotWriter::stop() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopWorker_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+bool ScreenshotWriter::capture(const uint32_t* pixels, const int width, const int height,
+                               const ScreenshotLayout layout) {
+    const size_t count = static_cast<size_t>(width) * static_cast<size_t>(height);
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable() || count > capacity_ || freeCount_ == 0) {
+            ++stats_.dropped;
+            return false;
+        }
+        index = freeShots_[--freeCount_];
+    }
+
+    // The buffer belongs to this thread until it is queued.
+    Shot& shot = shots_[index];
+    std::memcpy(shot.pixels.data(), pixels, count * sizeof(uint32_t));
+    shot.width = width;
+    shot.height = height;
+    shot.layout = layout;
+    shot.time = std::time(nullptr);
+    shot.sequence = nextSequence_++;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readyShots_[(readyHead_ + readyCount_) % kBufferCount] = index;
+        ++readyCount_;
+    }
+    cv_.notify_one();
+    return true;
+}
+
+ScreenshotWriter::Stats ScreenshotWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool ScreenshotWriter::writePng(const std::string& path, const uint32_t* pixels, const int width,
+                                const int height, const int stride) {
+    if (!EncodePng(pixels, width, height, stride, png_)) {
+        LOGW("Failed to encode screenshot %s", path.c_str());
+        return false;
+    }
+    // Written under a temporary name so gallery scans never see half a file.
+    const std::string tempPath = path + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        LOGW("Failed to save screenshot %s", path.c_str());
+        return false;
+    }
+    bool ok = std::fwrite(png_.data(), 1, png_.size(), file) == png_.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGW("Failed to save screenshot %s", path.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    LOGI("Screenshot saved: %s", path.c_str());
+    return true;
+}
+
+bool ScreenshotWriter::writeShot(const Shot& shot) {
+    std::tm local{};
+    localtime_r(&shot.time, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    char name[64];
+    std::snprintf(name, sizeof(name), "/vbshot-%s-%u", stamp, shot.sequence);
+    const std::string base = directory_ + name;
+
+    const uint32_t* pixels = shot.pixels.data();
+    const bool sideBySide = shot.width >= shot.height * 2;
+    if (shot.layout == ScreenshotLayout::SideBySide || !sideBySide) {
+        return writePng(base + ".png", pixels, shot.width, shot.height, shot.width);
+    }
+    const int eyeWidth = shot.width / 2;
+    if (shot.layout == ScreenshotLayout::SeparateEyes) {
+        const bool left = writePng(base + "-left.png", pixels, eyeWidth, shot.height, shot.width);
+        const bool right = writePng(base + "-right.png", pixels + eyeWidth, eyeWidth, shot.height,
+                                    shot.width);
+        return left && right;
+    }
+
+    anaglyph_.resize(static_cast<size_t>(eyeWidth) * static_cast<size_t>(shot.height));
+    for (int y = 0; y < shot.height; ++y) {
+        const uint32_t* row = pixels + static_cast<size_t>(y) * static_cast<size_t>(shot.width);
+        uint32_t* out = anaglyph_.data() + static_cast<size_t>(y) * static_cast<size_t>(eyeWidth);
+        for (int x = 0; x < eyeWidth; ++x) {
+            const uint32_t left = Intensity(row[x]);
+            const uint32_t right = Intensity(row[eyeWidth + x]);
+            out[x] = 0xFF000000u | (left << 16) | (right << 8) | right;
+        }
+    }
+    return writePng(base + "-anaglyph.png", anaglyph_.data(), eyeWidth, shot.height, eyeWidth);
+}
+
+void ScreenshotWriter::workerLoop() {
+    ApplyThreadPolicy(ThreadRole::Background);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopWorker_ || readyCount_ > 0; });
+        if (readyCount_ == 0) {
+            return;
+        }
+        const size_t index = readyShots_[readyHead_];
+        readyHead_ = (readyHead_ + 1) % kBufferCount;
+        --readyCount_;
+        lock.unlock();
+
+        const bool ok = writeShot(shots_[index]);
+
+        lock.lock();
+        if (ok) {
+            ++stats_.written;
+        } else {
+            ++stats_.failed;
+        }
+        freeShots_[freeCount_++] = index;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Screenshots taken from the frame loop. capture() copies the frame into one of a few buffers
+// allocated up front and returns; a background thread does the PNG encoding and the write.
+
+enum class ScreenshotLayout {
+    // The frame as given: both eyes side by side, or the single image.
+    SideBySide,
+    // Red/cyan: left eye in red, right eye in green and blue.
+    Anaglyph,
+    // One file per eye.
+    SeparateEyes,
+};
+
+// Encodes width x height XRGB pixels (rows stride pixels apart) as an 8-bit RGB PNG.
+bool EncodePng(const uint32_t* pixels, int width, int height, int stride,
+               std::vector<uint8_t>& out);
+
+class ScreenshotWriter {
+public:
+    struct Stats {
+        uint32_t written = 0;
+        // Captures refused because every buffer was still queued.
+        uint32_t dropped = 0;
+        uint32_t failed = 0;
+        // Memory held by the preallocated frame buffers.
+        size_t bufferBytes = 0;
+    };
+
+    ScreenshotWriter() = default;
+    ScreenshotWriter(const ScreenshotWriter&) = delete;
+    ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+    ~ScreenshotWriter() { stop(); }
+
+    // Allocates the buffers for frames up to maxWidth x maxHeight and starts the worker.
+    bool start(const std::string& directory, int maxWidth, int maxHeight);
+    // Writes what is queued, then stops the worker.
+    void stop();
+
+    // Frame thread. Never allocates or waits on the worker; returns false when the frame is
+    // dropped because the backlog is full or it does not fit the buffers.
+    bool capture(const uint32_t* pixels, int width, int height, ScreenshotLayout layout);
+
+    [[nodiscard]] bool active() const { return worker_.joinable(); }
+    [[nodiscard]] Stats stats() const;
+
+private:
+    static constexpr size_t kBufferCount = 3;
+
+    struct Shot {
+        std::vector<uint32_t> pixels;
+        int width = 0;
+        int height = 0;
+        ScreenshotLayout layout = ScreenshotLayout::SideBySide;
+        std::time_t time = 0;
+        uint32_t sequence = 0;
+    };
+
+    void workerLoop();
+    bool writeShot(const Shot& shot);
+    bool writePng(const std::string& path, const uint32_t* pixels, int width, int height,
+                  int stride);
+
+    std::string directory_;
+    size_t capacity_ = 0;
+    std::array<Shot, kBufferCount> shots_;
+    // Fixed rings of buffer indices, so queueing never allocates.
+    std::array<size_t, kBufferCount> freeShots_{};
+    size_t freeCount_ = 0;
+    std::array<size_t, kBufferCount> readyShots_{};
+    size_t readyHead_ = 0;
+    size_t readyCount_ = 0;
+    uint32_t nextSequence_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopWorker_ = false;
+    Stats stats_;
+    // Worker only.
+    std::vector<uint32_t> anaglyph_;
+    std::vector<uint8_t> png_;
+    std::thread worker_;
+};
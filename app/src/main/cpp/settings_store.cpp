@@ -0,0 +1,234 @@
+#include "settings_store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "log.h"
+#include "thread_policy.h"
+
+namespace {
+
+std::string FormatFloat(const float value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.4f", value);
+    return text;
+}
+
+}  // namespace
+
+SettingsStore::~SettingsStore() { close(); }
+
+bool SettingsStore::open(const std::string& path) {
+    close();
+    path_ = path;
+    entries_.clear();
+    changeSerial_ = 0;
+    writtenSerial_ = 0;
+    writes_ = 0;
+    flushRequested_ = false;
+    stopWriter_ = false;
+    bool loaded = false;
+    if (!path_.empty()) {
+        std::ifstream in(path_);
+        if (in.good()) {
+            std::ostringstream contents;
+            contents << in.rdbuf();
+            std::lock_guard<std::mutex> lock(mutex_);
+            parse(contents.str());
+            loaded = true;
+        }
+        writer_ = std::thread(&SettingsStore::writerLoop, this);
+    }
+    return loaded;
+}
+
+void SettingsStore::close() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopWriter_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+}
+
+void SettingsStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!writer_.joinable()) {
+        return;
+    }
+    const uint64_t target = changeSerial_;
+    flushRequested_ = true;
+    cv_.notify_all();
+    cv_.wait(lock, [this, target] { return writtenSerial_ >= target; });
+}
+
+float SettingsStore::getFloat(const std::string_view key, const float fallback) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string* value = findLocked(key);
+    if (value == nullptr) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const float parsed = std::strtof(value->c_str(), &end);
+    return (end == value->c_str()) ? fallback : parsed;
+}
+
+int SettingsStore::getInt(const std::string_view key, const int fallback) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string* value = findLocked(key);
+    if (value == nullptr) {
+        return fallback;
+    }
+    char* end = nullptr;
+    const long parsed = std::strtol(value->c_str(), &end, 10);
+    return (end == value->c_str()) ? fallback : static_cast<int>(parsed);
+}
+
+uint64_t SettingsStore::writeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writes_;
+}
+
+void SettingsStore::setFloat(const std::string_view key, const float value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    setLocked(key, FormatFloat(value));
+}
+
+void SettingsStore::setInt(const std::string_view key, const int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    setLocked(key, std::to_string(value));
+}
+
+const std::string* SettingsStore::findLocked(const std::string_view key) const {
+    for (const auto& entry : entries_) {
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void SettingsStore::setLocked(const std::string_view key, std::string value) {
+    auto it = std::find_if(
+        entries_.begin(), entries_.end(), [key](const auto& entry) { return entry.first == key; });
+    if (it == entries_.end()) {
+        entries_.emplace_back(std::string(key), std::move(value));
+    } else if (it->second != value) {
+        it->second = std::move(value);
+    } else {
+        return;
+    }
+    ++changeSerial_;
+    lastChange_ = Clock::now();
+    cv_.notify_all();
+}
+
+void SettingsStore::parse(const std::string& contents) {
+    if (contents.find('=') == std::string::npos) {
+        // Legacy whitespace format; queue a rewrite so the file moves to key/value.
+        std::istringstream in(contents);
+        float scale = 0.0f;
+        float convergence = 0.0f;
+        if (!(in >> scale >> convergence)) {
+            return;
+        }
+        entries_.emplace_back("screen_scale", FormatFloat(scale));
+        entries_.emplace_back("stereo_convergence", FormatFloat(convergence));
+        int viewMode = 0;
+        if (in >> viewMode) {
+            entries_.emplace_back("view_mode", std::to_string(viewMode));
+        }
+        ++changeSerial_;
+        LOGI("Migrating legacy settings file %s", path_.c_str());
+        return;
+    }
+
+    std::istringstream in(contents);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, equals);
+        std::string value = line.substr(equals + 1);
+        if (key == "version") {
+            if (std::atoi(value.c_str()) > kVersion) {
+                LOGW("Settings file version %s is newer than %d; reading known keys",
+                     value.c_str(), kVersion);
+            }
+            continue;
+        }
+        entries_.emplace_back(std::move(key), std::move(value));
+    }
+}
+
+bool SettingsStore::writeFile(const Entries& entries) const {
+    const std::string tempPath = path_ + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "w");
+    if (file == nullptr) {
+        LOGW("Failed to save settings: %s", tempPath.c_str());
+        return false;
+    }
+    std::fprintf(file, "version=%d\n", kVersion);
+    for (const auto& entry : entries) {
+        std::fprintf(file, "%s=%s\n", entry.first.c_str(), entry.second.c_str());
+    }
+    // The rename must not become visible before the data it points at.
+    bool ok = std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tempPath.c_str(), path_.c_str()) != 0) {
+        LOGW("Failed to save settings: %s", path_.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SettingsStore::writerLoop() {
+    ApplyThreadPolicy(ThreadRole::Background);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] {
+            return stopWriter_ || flushRequested_ || changeSerial_ != writtenSerial_;
+        });
+        if (changeSerial_ == writtenSerial_) {
+            flushRequested_ = false;
+            if (stopWriter_) {
+                return;
+            }
+            continue;
+        }
+        if (!stopWriter_ && !flushRequested_) {
+            const Clock::time_point due =
+                std::max(lastChange_ + kWriteDebounce, lastWrite_ + kMinWriteInterval);
+            if (Clock::now() < due) {
+                // Woken early by another change, a flush or a stop; all re-evaluate.
+                cv_.wait_until(lock, due);
+                continue;
+            }
+        }
+
+        const Entries snapshot = entries_;
+        const uint64_t serial = changeSerial_;
+        flushRequested_ = false;
+        lock.unlock();
+        writeFile(snapshot);
+        lock.lock();
+        // A failed write is logged and not retried until the next change.
+        writtenSerial_ = serial;
+        ++writes_;
+        lastWrite_ = Clock::now();
+        cv_.notify_all();
+    }
+}
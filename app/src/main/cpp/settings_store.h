@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Key/value settings kept in memory and persisted by a background writer. Setters only mark
+// the store dirty; the writer coalesces changes into one write-temp-then-rename per burst, at
+// most every kMinWriteInterval, so calibration steps never touch flash on the frame thread.
+//
+// File format, one entry per line:
+//   version=1
+//   screen_scale=0.6200
+// The legacy single line "<scale> <convergence> [<view mode>]" is read as those three keys.
+class SettingsStore {
+public:
+    static constexpr int kVersion = 1;
+    // A burst of changes is written once it has been quiet this long...
+    static constexpr auto kWriteDebounce = std::chrono::milliseconds(500);
+    // ...but never sooner than this after the previous write.
+    static constexpr auto kMinWriteInterval = std::chrono::seconds(2);
+
+    SettingsStore() = default;
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+    ~SettingsStore();
+
+    // Loads path if it exists and starts the writer. Returns whether a file was read.
+    bool open(const std::string& path);
+    // Writes pending changes and stops the writer.
+    void close();
+    // Writes pending changes now and waits for them to reach the file (e.g. on pause).
+    void flush();
+
+    [[nodiscard]] float getFloat(std::string_view key, float fallback) const;
+    [[nodiscard]] int getInt(std::string_view key, int fallback) const;
+    void setFloat(std::string_view key, float value);
+    void setInt(std::string_view key, int value);
+
+    // Files written since open(), failed attempts included.
+    [[nodiscard]] uint64_t writeCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Entries = std::vector<std::pair<std::string, std::string>>;
+
+    const std::string* findLocked(std::string_view key) const;
+    void setLocked(std::string_view key, std::string value);
+    void parse(const std::string& contents);
+    bool writeFile(const Entries& entries) const;
+    void writerLoop();
+
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread writer_;
+    Entries entries_;
+    uint64_t changeSerial_ = 0;
+    uint64_t writtenSerial_ = 0;
+    uint64_t writes_ = 0;
+    Clock::time_point lastChange_{};
+    Clock::time_point lastWrite_{};
+    bool flushRequested_ = false;
+    bool stopWriter_ = false;
+};
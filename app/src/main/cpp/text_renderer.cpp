@@ -0,0 +1,278 @@
+#include "text_renderer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <utility>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr char kGlyphChars[] = " :.-+/()0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+constexpr size_t kGlyphCount = sizeof(kGlyphChars) - 1;
+
+// Same order as kGlyphChars; entry 0 is the blank every other character maps to.
+constexpr std::array<Glyph, kGlyphCount> kGlyphs = {
+    Glyph{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+    Glyph{0x00, 0x04, 0x00, 0x00, 0x04, 0x00, 0x00},  // ':'
+    Glyph{0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06},  // '.'
+    Glyph{0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},  // '-'
+    Glyph{0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},  // '+'
+    Glyph{0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00},  // '/'
+    Glyph{0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},  // '('
+    Glyph{0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},  // ')'
+    Glyph{0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},  // '0'
+    Glyph{0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},  // '1'
+    Glyph{0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},  // '2'
+    Glyph{0x1E, 0x01, 0x01, 0x0E, 0x01, 0x01, 0x1E},  // '3'
+    Glyph{0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},  // '4'
+    Glyph{0x1F, 0x10, 0x10, 0x1E, 0x01, 0x01, 0x1E},  // '5'
+    Glyph{0x0E, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x0E},  // '6'
+    Glyph{0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},  // '7'
+    Glyph{0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},  // '8'
+    Glyph{0x0E, 0x11, 0x11, 0x0F, 0x01, 0x01, 0x0E},  // '9'
+    Glyph{0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // 'A'
+    Glyph{0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},  // 'B'
+    Glyph{0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},  // 'C'
+    Glyph{0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E},  // 'D'
+    Glyph{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // 'E'
+    Glyph{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},  // 'F'
+    Glyph{0x0E, 0x11, 0x10, 0x10, 0x13, 0x11, 0x0F},  // 'G'
+    Glyph{0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // 'H'
+    Glyph{0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // 'I'
+    Glyph{0x01, 0x01, 0x01, 0x01, 0x11, 0x11, 0x0E},  // 'J'
+    Glyph{0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},  // 'K'
+    Glyph{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},  // 'L'
+    Glyph{0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},  // 'M'
+    Glyph{0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x11},  // 'N'
+    Glyph{0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // 'O'
+    Glyph{0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},  // 'P'
+    Glyph{0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},  // 'Q'
+    Glyph{0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},  // 'R'
+    Glyph{0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},  // 'S'
+    Glyph{0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // 'T'
+    Glyph{0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // 'U'
+    Glyph{0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},  // 'V'
+    Glyph{0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},  // 'W'
+    Glyph{0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},  // 'X'
+    Glyph{0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04},  // 'Y'
+    Glyph{0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},  // 'Z'
+};
+
+constexpr std::array<uint8_t, 256> BuildGlyphIndex() {
+    std::array<uint8_t, 256> index{};
+    for (size_t i = 0; i < kGlyphCount; ++i) {
+        const auto ch = static_cast<unsigned char>(kGlyphChars[i]);
+        index[ch] = static_cast<uint8_t>(i);
+        if (ch >= 'A' && ch <= 'Z') {
+            index[ch - 'A' + 'a'] = static_cast<uint8_t>(i);
+        }
+    }
+    return index;
+}
+
+constexpr std::array<uint8_t, 256> kGlyphIndex = BuildGlyphIndex();
+
+constexpr int kScaledGlyphWidth = kGlyphWidth * kTextScale;
+static_assert(kScaledGlyphWidth <= 32, "scaled glyph rows must fit a 32-bit mask");
+
+// Glyph rows at kTextScale as pixel masks; bit i lights the i-th pixel from the left edge.
+using ScaledGlyph = std::array<uint32_t, kGlyphHeight>;
+
+constexpr std::array<ScaledGlyph, kGlyphCount> BuildScaledGlyphs() {
+    std::array<ScaledGlyph, kGlyphCount> scaled{};
+    for (size_t g = 0; g < kGlyphCount; ++g) {
+        for (int row = 0; row < kGlyphHeight; ++row) {
+            uint32_t mask = 0;
+            for (int col = 0; col < kGlyphWidth; ++col) {
+                if ((kGlyphs[g][row] & (1u << (kGlyphWidth - 1 - col))) == 0) {
+                    continue;
+                }
+                for (int s = 0; s < kTextScale; ++s) {
+                    mask |= 1u << ((col * kTextScale) + s);
+                }
+            }
+            scaled[g][row] = mask;
+        }
+    }
+    return scaled;
+}
+
+constexpr std::array<ScaledGlyph, kGlyphCount> kScaledGlyphs = BuildScaledGlyphs();
+
+size_t GlyphIndex(const char ch) { return kGlyphIndex[static_cast<unsigned char>(ch)]; }
+
+// Writes color to the pixels of dst selected by mask, four at a time where SIMD is available.
+void BlitMaskedSpan(uint32_t* dst, uint32_t mask, const uint32_t color) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    static constexpr uint32_t kLaneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t laneBits = vld1q_u32(kLaneBits);
+    const uint32x4_t colorVec = vdupq_n_u32(color);
+    for (; x + 4 <= kScaledGlyphWidth; x += 4, mask >>= 4) {
+        const uint32_t nibble = mask & 0xFu;
+        if (nibble == 0xFu) {
+            vst1q_u32(dst + x, colorVec);
+        } else if (nibble != 0) {
+            const uint32x4_t select = vtstq_u32(vdupq_n_u32(nibble), laneBits);
+            vst1q_u32(dst + x, vbslq_u32(select, colorVec, vld1q_u32(dst + x)));
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i laneBits = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i colorVec = _mm_set1_epi32(static_cast<int>(color));
+    for (; x + 4 <= kScaledGlyphWidth; x += 4, mask >>= 4) {
+        const uint32_t nibble = mask & 0xFu;
+        auto* lanes = reinterpret_cast<__m128i*>(dst + x);
+        if (nibble == 0xFu) {
+            _mm_storeu_si128(lanes, colorVec);
+        } else if (nibble != 0) {
+            const __m128i select = _mm_cmpeq_epi32(
+                _mm_and_si128(_mm_set1_epi32(static_cast<int>(nibble)), laneBits), laneBits);
+            const __m128i blended = _mm_or_si128(
+                _mm_and_si128(select, colorVec), _mm_andnot_si128(select, _mm_loadu_si128(lanes)));
+            _mm_storeu_si128(lanes, blended);
+        }
+    }
+#endif
+    for (; mask != 0; ++x, mask >>= 1) {
+        if ((mask & 1u) != 0) {
+            dst[x] = color;
+        }
+    }
+}
+
+}  // namespace
+
+const Glyph& GetGlyph(const char ch) { return kGlyphs[GlyphIndex(ch)]; }
+
+int TextWidthPixels(const std::string& text, const int scale) {
+    if (text.empty()) {
+        return 0;
+    }
+    const int charWidth = (kGlyphWidth * scale) + (kTextSpacing * scale);
+    return static_cast<int>(text.size()) * charWidth - (kTextSpacing * scale);
+}
+
+std::string ToUpperAscii(std::string text) {
+    for (char& ch : text) {
+        ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+    }
+    return text;
+}
+
+std::string FitTextToWidth(std::string text, const int maxWidthPx, const int scale) {
+    if (maxWidthPx <= 0 || scale <= 0) {
+        return {};
+    }
+    // Every glyph advances by the same amount, so the prefix widths are n * advance - spacing
+    // and the longest fitting prefix follows directly.
+    const int advance = (kGlyphWidth * scale) + (kTextSpacing * scale);
+    const auto fits = static_cast<size_t>((maxWidthPx + (kTextSpacing * scale)) / advance);
+    if (text.size() > fits) {
+        text.resize(fits);
+    }
+    return ToUpperAscii(std::move(text));
+}
+
+void FillRect(
+    std::vector<uint32_t>& frame,
+    const int frameWidth,
+    const int frameHeight,
+    int x,
+    int y,
+    int width,
+    int height,
+    const uint32_t color) {
+    if (frameWidth <= 0 || frameHeight <= 0 || frame.empty() || width <= 0 || height <= 0) {
+        return;
+    }
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (x + width > frameWidth) {
+        width = frameWidth - x;
+    }
+    if (y + height > frameHeight) {
+        height = frameHeight - y;
+    }
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    for (int row = 0; row < height; ++row) {
+        uint32_t* dst = frame.data() + static_cast<size_t>(y + row) * frameWidth + x;
+        std::fill(dst, dst + width, color);
+    }
+}
+
+void DrawText(
+    std::vector<uint32_t>& frame,
+    const int frameWidth,
+    const int frameHeight,
+    const std::string& text,
+    int x,
+    const int y,
+    const int scale,
+    const uint32_t color) {
+    if (frameWidth <= 0 || frameHeight <= 0 ||
+        frame.size() < static_cast<size_t>(frameWidth) * static_cast<size_t>(frameHeight)) {
+        return;
+    }
+    const int advance = (kGlyphWidth * scale) + (kTextSpacing * scale);
+    const bool rowsInside = y >= 0 && y + (kGlyphHeight * scale) <= frameHeight;
+    for (const char ch : text) {
+        const size_t glyphIndex = GlyphIndex(ch);
+        if (scale == kTextScale && rowsInside && x >= 0 && x + kScaledGlyphWidth <= frameWidth) {
+            // Whole glyph on screen: one masked span per output row, no clipping.
+            const ScaledGlyph& rows = kScaledGlyphs[glyphIndex];
+            uint32_t* origin = frame.data() + static_cast<size_t>(y) * frameWidth + x;
+            for (int row = 0; row < kGlyphHeight; ++row) {
+                if (rows[row] == 0) {
+                    continue;
+                }
+                for (int s = 0; s < kTextScale; ++s) {
+                    const int py = (row * kTextScale) + s;
+                    BlitMaskedSpan(origin + static_cast<size_t>(py) * frameWidth, rows[row], color);
+                }
+            }
+        } else {
+            // Clipped or unusual scale: one clipped fill per run of lit columns.
+            const Glyph& glyph = kGlyphs[glyphIndex];
+            for (int row = 0; row < kGlyphHeight; ++row) {
+                const uint8_t bits = glyph[row];
+                int col = 0;
+                while (col < kGlyphWidth) {
+                    if ((bits & (1u << (kGlyphWidth - 1 - col))) == 0) {
+                        ++col;
+                        continue;
+                    }
+                    const int runStart = col;
+                    while (col < kGlyphWidth && (bits & (1u << (kGlyphWidth - 1 - col))) != 0) {
+                        ++col;
+                    }
+                    FillRect(
+                        frame,
+                        frameWidth,
+                        frameHeight,
+                        x + (runStart * scale),
+                        y + (row * scale),
+                        (col - runStart) * scale,
+                        scale,
+                        color);
+                }
+            }
+        }
+        x += advance;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 5x7 bitmap font for the info panel and standby screen, drawn into 0xAARRGGBB frames.
+// Lowercase letters use the uppercase glyphs; unknown characters draw as blanks.
+
+constexpr int kGlyphWidth = 5;
+constexpr int kGlyphHeight = 7;
+constexpr int kTextScale = 2;
+constexpr int kTextSpacing = 1;
+
+using Glyph = std::array<uint8_t, kGlyphHeight>;
+
+// Rows top first; bit 4 is the leftmost column.
+const Glyph& GetGlyph(char ch);
+
+int TextWidthPixels(const std::string& text, int scale);
+std::string ToUpperAscii(std::string text);
+// Uppercases text and drops trailing characters until it fits maxWidthPx.
+std::string FitTextToWidth(std::string text, int maxWidthPx, int scale);
+
+// Both clip to the frame.
+void FillRect(
+    std::vector<uint32_t>& frame,
+    int frameWidth,
+    int frameHeight,
+    int x,
+    int y,
+    int width,
+    int height,
+    uint32_t color);
+void DrawText(
+    std::vector<uint32_t>& frame,
+    int frameWidth,
+    int frameHeight,
+    const std::string& text,
+    int x,
+    int y,
+    int scale,
+    uint32_t color);
@@ -0,0 +1,234 @@
+#include "thread_policy.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+constexpr int kMaxCpus = 64;
+
+enum class CoreSet {
+    Big,
+    Little,
+    All,
+};
+
+struct RolePolicy {
+    CoreSet cores;
+    int niceLevel;
+};
+
+// Android's THREAD_PRIORITY_VIDEO, THREAD_PRIORITY_URGENT_DISPLAY and THREAD_PRIORITY_BACKGROUND.
+// The render thread gets the most: a late xrEndFrame costs a whole display refresh.
+// Threads inherit their creator's affinity and android_main is pinned before any worker
+// starts, so every role sets its own cores: writers keep off the emulation thread's cluster.
+RolePolicy PolicyFor(const ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Emulation:
+            return {CoreSet::Big, -8};
+        case ThreadRole::Render:
+            return {CoreSet::All, -10};
+        case ThreadRole::Background:
+            break;
+    }
+    return {CoreSet::Little, 10};
+}
+
+// Parses the first range of a sysfs CPU list such as "0-7"; later ranges are ignored.
+int ReadPossibleCpuCount(const char* sysfsRoot) {
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s/possible", sysfsRoot);
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    int first = 0;
+    int last = 0;
+    const int fields = std::fscanf(file, "%d-%d", &first, &last);
+    std::fclose(file);
+    if (fields < 1 || first != 0) {
+        return 0;
+    }
+    return std::min((fields == 2 ? last : first) + 1, kMaxCpus);
+}
+
+uint64_t ReadMaxFrequencyKhz(const char* sysfsRoot, const int cpu) {
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s/cpu%d/cpufreq/cpuinfo_max_freq", sysfsRoot, cpu);
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long long khz = 0;
+    if (std::fscanf(file, "%llu", &khz) != 1) {
+        khz = 0;
+    }
+    std::fclose(file);
+    return khz;
+}
+
+#if defined(__ANDROID__)
+struct HintApi {
+    using GetManagerFn = void* (*)();
+    using CreateSessionFn = void* (*)(void*, const int32_t*, size_t, int64_t);
+    using ReportWorkFn = int (*)(void*, int64_t);
+    using CloseSessionFn = void (*)(void*);
+
+    GetManagerFn getManager = nullptr;
+    CreateSessionFn createSession = nullptr;
+    ReportWorkFn reportWork = nullptr;
+    CloseSessionFn closeSession = nullptr;
+
+    [[nodiscard]] bool available() const {
+        return getManager != nullptr && createSession != nullptr && reportWork != nullptr &&
+               closeSession != nullptr;
+    }
+};
+
+const HintApi& GetHintApi() {
+    static const HintApi api = [] {
+        HintApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+        if (library == nullptr) {
+            return loaded;
+        }
+        loaded.getManager =
+            reinterpret_cast<HintApi::GetManagerFn>(dlsym(library, "APerformanceHint_getManager"));
+        loaded.createSession = reinterpret_cast<HintApi::CreateSessionFn>(
+            dlsym(library, "APerformanceHint_createSession"));
+        loaded.reportWork = reinterpret_cast<HintApi::ReportWorkFn>(
+            dlsym(library, "APerformanceHint_reportActualWorkDuration"));
+        loaded.closeSession = reinterpret_cast<HintApi::CloseSessionFn>(
+            dlsym(library, "APerformanceHint_closeSession"));
+        return loaded;
+    }();
+    return api;
+}
+#endif
+
+}  // namespace
+
+CpuTopology ReadCpuTopology(const char* sysfsRoot) {
+    CpuTopology topology;
+    topology.cpuCount = ReadPossibleCpuCount(sysfsRoot);
+    std::vector<uint64_t> frequencies(static_cast<size_t>(topology.cpuCount));
+    uint64_t slowest = 0;
+    uint64_t fastest = 0;
+    for (int cpu = 0; cpu < topology.cpuCount; ++cpu) {
+        const uint64_t khz = ReadMaxFrequencyKhz(sysfsRoot, cpu);
+        frequencies[cpu] = khz;
+        if (khz == 0) {
+            continue;
+        }
+        slowest = (slowest == 0) ? khz : std::min(slowest, khz);
+        fastest = std::max(fastest, khz);
+    }
+    if (slowest == fastest) {
+        return topology;
+    }
+    for (int cpu = 0; cpu < topology.cpuCount; ++cpu) {
+        if (frequencies[cpu] > slowest) {
+            topology.bigCoreMask |= uint64_t{1} << cpu;
+        }
+    }
+    return topology;
+}
+
+uint64_t ThreadRoleCoreMask(const ThreadRole role, const CpuTopology& topology) {
+    // With all cores alike nothing was ever pinned, so there is nothing to undo either.
+    if (topology.bigCoreMask == 0) {
+        return 0;
+    }
+    const uint64_t allCores = topology.cpuCount >= kMaxCpus
+                                  ? ~uint64_t{0}
+                                  : (uint64_t{1} << topology.cpuCount) - 1;
+    switch (PolicyFor(role).cores) {
+        case CoreSet::Big:
+            return topology.bigCoreMask;
+        case CoreSet::Little:
+            return allCores & ~topology.bigCoreMask;
+        case CoreSet::All:
+            break;
+    }
+    return allCores;
+}
+
+pid_t CurrentThreadId() { return static_cast<pid_t>(syscall(SYS_gettid)); }
+
+ThreadPolicyResult ApplyThreadPolicy(const ThreadRole role) {
+    static const CpuTopology topology = ReadCpuTopology();
+    return ApplyThreadPolicy(role, topology);
+}
+
+ThreadPolicyResult ApplyThreadPolicy(const ThreadRole role, const CpuTopology& topology) {
+    const RolePolicy policy = PolicyFor(role);
+    ThreadPolicyResult result;
+    const uint64_t mask = ThreadRoleCoreMask(role, topology);
+    if (mask != 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < topology.cpuCount; ++cpu) {
+            if ((mask >> cpu) & 1u) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        // pid 0 is the calling thread, not the whole process.
+        result.pinned = sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+    }
+
+    const auto tid = static_cast<id_t>(CurrentThreadId());
+    result.prioritized = setpriority(PRIO_PROCESS, tid, policy.niceLevel) == 0;
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, tid);
+    result.niceLevel = (errno == 0) ? nice : 0;
+    return result;
+}
+
+bool PerformanceHintSession::open(const int64_t targetWorkNs) {
+    close();
+#if defined(__ANDROID__)
+    const HintApi& api = GetHintApi();
+    if (!api.available()) {
+        return false;
+    }
+    void* manager = api.getManager();
+    if (manager == nullptr) {
+        return false;
+    }
+    const int32_t tid = CurrentThreadId();
+    session_ = api.createSession(manager, &tid, 1, targetWorkNs);
+    return session_ != nullptr;
+#else
+    (void)targetWorkNs;
+    return false;
+#endif
+}
+
+void PerformanceHintSession::close() {
+#if defined(__ANDROID__)
+    if (session_ != nullptr) {
+        GetHintApi().closeSession(session_);
+    }
+#endif
+    session_ = nullptr;
+}
+
+void PerformanceHintSession::reportWork(const int64_t workNs) {
+#if defined(__ANDROID__)
+    if (session_ != nullptr && workNs > 0) {
+        GetHintApi().reportWork(session_, workNs);
+    }
+#else
+    (void)workNs;
+#endif
+}
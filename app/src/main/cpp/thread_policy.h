@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+// Scheduling policy for the app's threads. Cores are ranked by cpuinfo_max_freq so the
+// emulation thread can be kept off the little cluster on big.LITTLE SoCs; priorities are the
+// Android nice levels an app may take for its own threads without privileges.
+
+enum class ThreadRole {
+    // android_main: emulation, audio writes and the flat renderer.
+    Emulation,
+    // XR render and frame-wait threads.
+    Render,
+    // Log, settings, capture and screenshot writers.
+    Background,
+};
+
+struct CpuTopology {
+    int cpuCount = 0;
+    // CPUs faster than the slowest cluster; 0 when all cores are alike or unreadable.
+    uint64_t bigCoreMask = 0;
+};
+
+// Reads <sysfsRoot>/cpuN/cpufreq/cpuinfo_max_freq for every configured CPU.
+CpuTopology ReadCpuTopology(const char* sysfsRoot = "/sys/devices/system/cpu");
+
+struct ThreadPolicyResult {
+    // Affinity set to the role's cores: big for Emulation, little for Background, all for Render.
+    bool pinned = false;
+    // Nice level applied; refused without privileges on desktop Linux.
+    bool prioritized = false;
+    int niceLevel = 0;
+};
+
+// CPUs the role's threads run on; 0 leaves the affinity alone, as on SoCs with uniform cores.
+uint64_t ThreadRoleCoreMask(ThreadRole role, const CpuTopology& topology);
+
+pid_t CurrentThreadId();
+// Applies role's policy to the calling thread. Steps the system refuses are skipped.
+ThreadPolicyResult ApplyThreadPolicy(ThreadRole role);
+// As above with the core ranking given rather than read from sysfs.
+ThreadPolicyResult ApplyThreadPolicy(ThreadRole role, const CpuTopology& topology);
+
+// Android performance hint session (API 33+), loaded at runtime so older systems and hosts
+// run without it. Reporting per-frame work lets the governor raise clocks before frames miss.
+class PerformanceHintSession {
+public:
+    PerformanceHintSession() = default;
+    PerformanceHintSession(const PerformanceHintSession&) = delete;
+    PerformanceHintSession& operator=(const PerformanceHintSession&) = delete;
+    ~PerformanceHintSession() { close(); }
+
+    // Covers the calling thread. Returns false when the API is unavailable.
+    bool open(int64_t targetWorkNs);
+    void close();
+    void reportWork(int64_t workNs);
+
+    [[nodiscard]] bool active() const { return session_ != nullptr; }
+
+private:
+    void* session_ = nullptr;
+};
@@ -3,13 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <utility>
 
 #include <EGL/eglext.h>
 #include <GLES2/gl2ext.h>
 
 #include "log.h"
+#include "mat4.h"
+#include "thread_policy.h"
 
 namespace {
 
@@ -22,38 +26,83 @@ namespace {
 #ifndef GL_SRGB8_ALPHA8
 #define GL_SRGB8_ALPHA8 0x8C43
 #endif
+#ifndef XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME
+#define XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME "XR_KHR_composition_layer_depth"
+#endif
+
+// Per-draw parameters shared by both programs through one std140 uniform block (binding 0).
+// uUvTransform: xy scale, zw offset. uDepthRange: near z, far z, screen scale.
+// uWorldMask: x enables the world mask, y is the layer's world id. Members are highp so the
+// vertex and fragment declarations match.
+#define XR_DRAW_PARAMS_BLOCK                \
+    "layout(std140) uniform DrawParams {\n" \
+    "  highp mat4 uMvp;\n"                  \
+    "  highp vec4 uUvTransform;\n"          \
+    "  highp vec4 uDepthRange;\n"           \
+    "  highp vec4 uWorldMask;\n"            \
+    "};\n"
 
 constexpr char kVertexShader[] =
-    "attribute vec3 aPos;\n"
-    "attribute vec2 aUv;\n"
-    "uniform mat4 uMvp;\n"
-    "varying vec2 vUv;\n"
+    "#version 300 es\n"
+    XR_DRAW_PARAMS_BLOCK
+    "layout(location = 0) in vec3 aPos;\n"
+    "layout(location = 1) in vec2 aUv;\n"
+    "out vec2 vUv;\n"
     "void main() {\n"
-    "  vUv = aUv;\n"
+    "  vUv = aUv * uUvTransform.xy + uUvTransform.zw;\n"
     "  gl_Position = uMvp * vec4(aPos, 1.0);\n"
     "}\n";
 
 constexpr char kFragmentShader[] =
+    "#version 300 es\n"
     "precision mediump float;\n"
+    XR_DRAW_PARAMS_BLOCK
     "uniform sampler2D uTex;\n"
-    "uniform sampler2D uWorldTex;\n"
-    "uniform vec2 uUvScale;\n"
-    "uniform vec2 uUvOffset;\n"
-    "uniform float uUseWorldMask;\n"
-    "uniform float uLayerWorld;\n"
-    "varying vec2 vUv;\n"
+    "uniform sampler2D uMetadataTex;\n"
+    "in vec2 vUv;\n"
+    "out vec4 fragColor;\n"
     "void main() {\n"
-    "  vec2 uv = vUv * uUvScale + uUvOffset;\n"
-    "  uv = clamp(uv, vec2(0.0), vec2(1.0));\n"
-    "  if (uUseWorldMask > 0.5) {\n"
-    "    float worldV = floor(texture2D(uWorldTex, uv).r * 255.0 + 0.5);\n"
-    "    if (abs(worldV - uLayerWorld) > 0.5) {\n"
+    "  vec2 uv = clamp(vUv, vec2(0.0), vec2(1.0));\n"
+    "  if (uWorldMask.x > 0.5) {\n"
+    "    float worldV = floor(texture(uMetadataTex, uv).r * 255.0 + 0.5);\n"
+    "    if (abs(worldV - uWorldMask.y) > 0.5) {\n"
     "      discard;\n"
     "    }\n"
     "  }\n"
-    "  vec4 c = texture2D(uTex, uv);\n"
+    "  vec4 c = texture(uTex, uv);\n"
+    "  float l = dot(c.rgb, vec3(0.299, 0.587, 0.114));\n"
+    "  fragColor = vec4(l, l * 0.08, l * 0.03, 1.0);\n"
+    "}\n";
+
+// Displaced-mesh path: a grid over one eye whose vertices are pushed to the per-pixel depth
+// that the layered path would assign to the whole world.
+constexpr char kMeshVertexShader[] =
+    "#version 300 es\n"
+    XR_DRAW_PARAMS_BLOCK
+    "layout(location = 0) in vec2 aGrid;\n"
+    "uniform sampler2D uMetadataTex;\n"
+    "out vec2 vUv;\n"
+    "void main() {\n"
+    "  vec2 uv = clamp(aGrid * uUvTransform.xy + uUvTransform.zw, vec2(0.0), vec2(1.0));\n"
+    "  float raw = floor(texture(uMetadataTex, uv).g * 255.0 + 0.5);\n"
+    "  float disparity = raw > 127.5 ? raw - 256.0 : raw;\n"
+    "  float closeness = clamp(abs(disparity) / 127.0, 0.0, 1.0);\n"
+    "  float z = mix(uDepthRange.y, uDepthRange.x, closeness);\n"
+    "  vec2 xy = vec2(aGrid.x * 2.0 - 1.0, 1.0 - aGrid.y * 2.0) * (uDepthRange.z * z);\n"
+    "  vUv = uv;\n"
+    "  gl_Position = uMvp * vec4(xy, -z, 1.0);\n"
+    "}\n";
+
+constexpr char kMeshFragmentShader[] =
+    "#version 300 es\n"
+    "precision mediump float;\n"
+    "uniform sampler2D uTex;\n"
+    "in vec2 vUv;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "  vec4 c = texture(uTex, vUv);\n"
     "  float l = dot(c.rgb, vec3(0.299, 0.587, 0.114));\n"
-    "  gl_FragColor = vec4(l, l * 0.08, l * 0.03, 1.0);\n"
+    "  fragColor = vec4(l, l * 0.08, l * 0.03, 1.0);\n"
     "}\n";
 
 constexpr float kMinScreenScale = 0.20f;
@@ -66,71 +115,26 @@ constexpr float kLayerNearZ = 1.2f;
 constexpr float kLayerFarZ = 3.8f;
 constexpr float kDepthFallbackZ = 2.2f;
 constexpr float kClassicAnchoredZ = 2.2f;
-
-struct Mat4 {
-    float m[16] = {};
-};
-
-Mat4 Mat4Identity() {
-    Mat4 out{};
-    out.m[0] = 1.0f;
-    out.m[5] = 1.0f;
-    out.m[10] = 1.0f;
-    out.m[15] = 1.0f;
-    return out;
-}
-
-Mat4 Mat4Multiply(const Mat4& a, const Mat4& b) {
-    Mat4 out{};
-    for (int c = 0; c < 4; ++c) {
-        for (int r = 0; r < 4; ++r) {
-            out.m[(c * 4) + r] = a.m[(0 * 4) + r] * b.m[(c * 4) + 0] +
-                                 a.m[(1 * 4) + r] * b.m[(c * 4) + 1] +
-                                 a.m[(2 * 4) + r] * b.m[(c * 4) + 2] +
-                                 a.m[(3 * 4) + r] * b.m[(c * 4) + 3];
-        }
-    }
-    return out;
-}
-
-Mat4 Mat4Translation(const float x, const float y, const float z) {
-    Mat4 out = Mat4Identity();
-    out.m[12] = x;
-    out.m[13] = y;
-    out.m[14] = z;
-    return out;
-}
-
-Mat4 Mat4Scale(const float x, const float y, const float z) {
-    Mat4 out{};
-    out.m[0] = x;
-    out.m[5] = y;
-    out.m[10] = z;
-    out.m[15] = 1.0f;
-    return out;
-}
-
-Mat4 Mat4RotationX(const float radians) {
-    Mat4 out = Mat4Identity();
-    const float c = std::cos(radians);
-    const float s = std::sin(radians);
-    out.m[5] = c;
-    out.m[6] = s;
-    out.m[9] = -s;
-    out.m[10] = c;
-    return out;
-}
-
-Mat4 Mat4RotationY(const float radians) {
-    Mat4 out = Mat4Identity();
-    const float c = std::cos(radians);
-    const float s = std::sin(radians);
-    out.m[0] = c;
-    out.m[2] = -s;
-    out.m[8] = s;
-    out.m[10] = c;
-    return out;
-}
+constexpr float kProjectionNearZ = 0.05f;
+constexpr float kProjectionFarZ = 100.0f;
+constexpr float kLayerDepthSmoothing = 0.2f;
+constexpr float kLayerDepthHysteresis = 0.05f;
+constexpr int kLayerHoldFrames = 8;
+constexpr int kDepthMeshCols = kVipEyeWidth / 4;
+constexpr int kDepthMeshRows = kVipEyeHeight / 4;
+constexpr float kTimeSmoothing = 0.1f;
+constexpr float kMinResolutionScale = 0.5f;
+constexpr float kMaxResolutionScale = 1.0f;
+constexpr float kResolutionStep = 0.05f;
+// Target share of the display period for eye rendering; raise only well below it.
+constexpr float kGpuBudgetFraction = 0.8f;
+constexpr float kResolutionRaiseThreshold = 0.6f;
+constexpr int kResolutionSettleFrames = 30;
+// Head motion below these thresholds (meters / quaternion components) reuses the last frame.
+constexpr float kStaticPositionEpsilon = 1.0e-4f;
+constexpr float kStaticOrientationEpsilon = 1.0e-5f;
+
+PFNGLGETQUERYOBJECTUI64VEXTPROC gGetQueryObjectui64vEXT = nullptr;
 
 Mat4 Mat4PerspectiveFromFov(const XrFovf& fov, const float nearZ, const float farZ) {
     const float tanLeft = std::tan(fov.angleLeft);
@@ -252,6 +256,76 @@ GLuint CreateProgram(const char* vertex, const char* fragment) {
     return program;
 }
 
+// Samplers never change: uTex on unit 0, uMetadataTex on unit 1, DrawParams on binding 0.
+void BindProgramResources(const GLuint program) {
+    glUseProgram(program);
+    const GLint texture = glGetUniformLocation(program, "uTex");
+    if (texture >= 0) {
+        glUniform1i(texture, 0);
+    }
+    const GLint metadataTexture = glGetUniformLocation(program, "uMetadataTex");
+    if (metadataTexture >= 0) {
+        glUniform1i(metadataTexture, 1);
+    }
+    const GLuint block = glGetUniformBlockIndex(program, "DrawParams");
+    if (block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, block, 0);
+    }
+    glUseProgram(0);
+}
+
+XrExtent2Di ScaledExtent(const int32_t width, const int32_t height, const float scale) {
+    XrExtent2Di extent{};
+    extent.width = std::clamp(
+        static_cast<int32_t>(std::lround(static_cast<float>(width) * scale)), 1, width);
+    extent.height = std::clamp(
+        static_cast<int32_t>(std::lround(static_cast<float>(height) * scale)), 1, height);
+    return extent;
+}
+
+uint64_t HashWords(const void* data, const size_t bytes) {
+    // FNV-1a over 64-bit words; only used to spot repeated emulator frames.
+    uint64_t hash = 1469598103934665603ull;
+    const auto* bytePtr = static_cast<const uint8_t*>(data);
+    const size_t wordCount = bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < wordCount; ++i) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytePtr + i * sizeof(uint64_t), sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (size_t i = wordCount * sizeof(uint64_t); i < bytes; ++i) {
+        hash = (hash ^ bytePtr[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool NearlyEqual(const float a, const float b, const float epsilon) {
+    return std::abs(a - b) <= epsilon;
+}
+
+bool SamePose(const XrPosef& a, const XrPosef& b) {
+    return NearlyEqual(a.position.x, b.position.x, kStaticPositionEpsilon) &&
+           NearlyEqual(a.position.y, b.position.y, kStaticPositionEpsilon) &&
+           NearlyEqual(a.position.z, b.position.z, kStaticPositionEpsilon) &&
+           NearlyEqual(a.orientation.x, b.orientation.x, kStaticOrientationEpsilon) &&
+           NearlyEqual(a.orientation.y, b.orientation.y, kStaticOrientationEpsilon) &&
+           NearlyEqual(a.orientation.z, b.orientation.z, kStaticOrientationEpsilon) &&
+           NearlyEqual(a.orientation.w, b.orientation.w, kStaticOrientationEpsilon);
+}
+
+bool SameFov(const XrFovf& a, const XrFovf& b) {
+    return a.angleLeft == b.angleLeft && a.angleRight == b.angleRight &&
+           a.angleUp == b.angleUp && a.angleDown == b.angleDown;
+}
+
+bool SameVector(const XrVector3f& a, const XrVector3f& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+void SmoothTimeMs(float& target, const float sampleMs) {
+    target = (target <= 0.0f) ? sampleMs : target + (sampleMs - target) * kTimeSmoothing;
+}
+
 XrPosef IdentityPose() {
     XrPosef pose{};
     pose.orientation.w = 1.0f;
@@ -263,52 +337,90 @@ XrPosef IdentityPose() {
 bool XrStereoRenderer::setError(const char* context, const XrResult result) {
     char buffer[256] = {};
     std::snprintf(buffer, sizeof(buffer), "%s failed (XrResult=%d)", context, result);
+    std::lock_guard<std::mutex> lock(errorMutex_);
     lastError_ = buffer;
     LOGE("%s", lastError_.c_str());
     return false;
 }
 
 bool XrStereoRenderer::setErrorMessage(const char* message) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
     lastError_ = message;
     LOGE("%s", lastError_.c_str());
     return false;
 }
 
 void XrStereoRenderer::setPresentationConfig(const float screenScale, const float stereoConvergence) {
-    screenScale_ = std::clamp(screenScale, kMinScreenScale, kMaxScreenScale);
-    stereoConvergence_ =
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.screenScale = std::clamp(screenScale, kMinScreenScale, kMaxScreenScale);
+    renderInputs_.stereoConvergence =
         std::clamp(stereoConvergence, kMinStereoConvergence, kMaxStereoConvergence);
 }
 
 void XrStereoRenderer::setDepthMetadataEnabled(const bool enabled) {
-    if (enabled && !depthMetadataEnabled_) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (enabled && !renderInputs_.depthMetadataEnabled) {
         // Re-capture world anchor at next frame when entering depth mode.
-        headOriginSet_ = false;
+        renderInputs_.resetAnchor = true;
     }
-    depthMetadataEnabled_ = enabled;
+    renderInputs_.depthMetadataEnabled = enabled;
+}
+
+void XrStereoRenderer::setDepthRenderMode(const DepthRenderMode mode) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.depthRenderMode = mode;
+}
+
+void XrStereoRenderer::setDynamicResolutionEnabled(const bool enabled) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.dynamicResolution = enabled;
 }
 
 void XrStereoRenderer::setWorldAnchoredEnabled(const bool enabled) {
-    if (enabled && !worldAnchoredEnabled_) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (enabled && !renderInputs_.worldAnchoredEnabled) {
         // Re-capture world anchor at next frame when entering anchored mode.
-        headOriginSet_ = false;
+        renderInputs_.resetAnchor = true;
     }
-    worldAnchoredEnabled_ = enabled;
+    renderInputs_.worldAnchoredEnabled = enabled;
 }
 
 void XrStereoRenderer::resetWorldAnchor() {
-    headOriginSet_ = false;
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.resetAnchor = true;
+}
+
+void XrStereoRenderer::setOverlayVisible(const bool visible) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.overlayVisible = visible;
 }
 
 void XrStereoRenderer::setWalkthroughOffset(const float x, const float y, const float z) {
-    walkThroughOffset_.x = std::clamp(x, -30.0f, 30.0f);
-    walkThroughOffset_.y = std::clamp(y, -30.0f, 30.0f);
-    walkThroughOffset_.z = std::clamp(z, -30.0f, 30.0f);
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.walkThroughOffset.x = std::clamp(x, -30.0f, 30.0f);
+    renderInputs_.walkThroughOffset.y = std::clamp(y, -30.0f, 30.0f);
+    renderInputs_.walkThroughOffset.z = std::clamp(z, -30.0f, 30.0f);
 }
 
 void XrStereoRenderer::setWalkthroughRotation(const float yaw, const float pitch) {
-    walkThroughYaw_ = yaw;
-    walkThroughPitch_ = std::clamp(pitch, -1.2f, 1.2f);
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    renderInputs_.walkThroughYaw = yaw;
+    renderInputs_.walkThroughPitch = std::clamp(pitch, -1.2f, 1.2f);
+}
+
+XrStereoRenderer::RenderDebugState XrStereoRenderer::renderDebugState() const {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    return renderDebugState_;
+}
+
+size_t XrStereoRenderer::textureBytes() const {
+    size_t bytes = 0;
+    for (const FrameSlot& slot : frameSlots_) {
+        bytes += static_cast<size_t>(slot.width) * static_cast<size_t>(slot.height) * 4;
+        bytes += static_cast<size_t>(slot.metadataTextureWidth) *
+                 static_cast<size_t>(slot.metadataTextureHeight) * 2;
+    }
+    return bytes;
 }
 
 bool XrStereoRenderer::makeCurrent() {
@@ -319,6 +431,17 @@ bool XrStereoRenderer::makeCurrent() {
     return eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_) == EGL_TRUE;
 }
 
+bool XrStereoRenderer::makeUploadCurrent() {
+    if (eglDisplay_ == EGL_NO_DISPLAY || uploadContext_ == EGL_NO_CONTEXT ||
+        uploadSurface_ == EGL_NO_SURFACE) {
+        return false;
+    }
+    if (eglGetCurrentContext() == uploadContext_) {
+        return true;
+    }
+    return eglMakeCurrent(eglDisplay_, uploadSurface_, uploadSurface_, uploadContext_) == EGL_TRUE;
+}
+
 bool XrStereoRenderer::initializeLoader() {
     PFN_xrInitializeLoaderKHR initializeLoader = nullptr;
     xrGetInstanceProcAddr(
@@ -366,6 +489,23 @@ bool XrStereoRenderer::createInstance() {
         XR_KHR_ANDROID_CREATE_INSTANCE_EXTENSION_NAME,
         XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME,
     };
+    depthLayerSupported_ = hasExtension(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+    if (depthLayerSupported_) {
+        enabledExtensions.push_back(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+    }
+    refreshRateSupported_ = hasExtension(XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME);
+    if (refreshRateSupported_) {
+        enabledExtensions.push_back(XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME);
+    }
+    const bool timespecSupported = hasExtension(XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME);
+    if (timespecSupported) {
+        enabledExtensions.push_back(XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME);
+    }
+    const bool threadSettingsSupported =
+        hasExtension(XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME);
+    if (threadSettingsSupported) {
+        enabledExtensions.push_back(XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME);
+    }
 
     XrInstanceCreateInfoAndroidKHR androidInfo{XR_TYPE_INSTANCE_CREATE_INFO_ANDROID_KHR};
     androidInfo.applicationVM = activity_->vm;
@@ -388,6 +528,19 @@ bool XrStereoRenderer::createInstance() {
     if (XR_FAILED(result)) {
         return setError("xrCreateInstance", result);
     }
+    if (timespecSupported) {
+        // Only used to report input-to-photon latency; missing is not an error.
+        xrGetInstanceProcAddr(
+            instance_,
+            "xrConvertTimeToTimespecTimeKHR",
+            reinterpret_cast<PFN_xrVoidFunction*>(&convertTimeToTimespec_));
+    }
+    if (threadSettingsSupported) {
+        xrGetInstanceProcAddr(
+            instance_,
+            "xrSetAndroidApplicationThreadKHR",
+            reinterpret_cast<PFN_xrVoidFunction*>(&setAndroidThread_));
+    }
     return true;
 }
 
@@ -460,6 +613,17 @@ bool XrStereoRenderer::createEglContext() {
         return setErrorMessage("eglCreateContext failed");
     }
 
+    // The emulation thread uploads frames through a second context in the same share group,
+    // leaving eglContext_ to the render thread.
+    uploadSurface_ = eglCreatePbufferSurface(eglDisplay_, eglConfig_, pbufferAttrs.data());
+    if (uploadSurface_ == EGL_NO_SURFACE) {
+        return setErrorMessage("eglCreatePbufferSurface(upload) failed");
+    }
+    uploadContext_ = eglCreateContext(eglDisplay_, eglConfig_, eglContext_, ctxAttrs.data());
+    if (uploadContext_ == EGL_NO_CONTEXT) {
+        return setErrorMessage("eglCreateContext(upload) failed");
+    }
+
     if (!makeCurrent()) {
         return setErrorMessage("eglMakeCurrent failed");
     }
@@ -498,9 +662,92 @@ bool XrStereoRenderer::createSession() {
     if (XR_FAILED(createResult)) {
         return setError("xrCreateSession", createResult);
     }
+    // Sessions are created from the emulation thread.
+    registerCurrentThread(XR_ANDROID_THREAD_TYPE_APPLICATION_MAIN_KHR);
     return true;
 }
 
+void XrStereoRenderer::registerCurrentThread(const XrAndroidThreadTypeKHR type) {
+    if (setAndroidThread_ == nullptr || session_ == XR_NULL_HANDLE) {
+        return;
+    }
+    const XrResult result =
+        setAndroidThread_(session_, type, static_cast<uint32_t>(CurrentThreadId()));
+    if (XR_FAILED(result)) {
+        LOGW("xrSetAndroidApplicationThreadKHR(%d) failed (XrResult=%d)", type, result);
+    }
+}
+
+void XrStereoRenderer::selectDisplayRefreshRate() {
+    if (!refreshRateSupported_) {
+        return;
+    }
+
+    PFN_xrEnumerateDisplayRefreshRatesFB enumerateRates = nullptr;
+    PFN_xrRequestDisplayRefreshRateFB requestRate = nullptr;
+    PFN_xrGetDisplayRefreshRateFB getRate = nullptr;
+    xrGetInstanceProcAddr(
+        instance_,
+        "xrEnumerateDisplayRefreshRatesFB",
+        reinterpret_cast<PFN_xrVoidFunction*>(&enumerateRates));
+    xrGetInstanceProcAddr(
+        instance_,
+        "xrRequestDisplayRefreshRateFB",
+        reinterpret_cast<PFN_xrVoidFunction*>(&requestRate));
+    xrGetInstanceProcAddr(
+        instance_, "xrGetDisplayRefreshRateFB", reinterpret_cast<PFN_xrVoidFunction*>(&getRate));
+    if (enumerateRates == nullptr || requestRate == nullptr || getRate == nullptr) {
+        LOGW("XR_FB_display_refresh_rate advertised but entry points are missing");
+        return;
+    }
+
+    uint32_t rateCount = 0;
+    XrResult result = enumerateRates(session_, 0, &rateCount, nullptr);
+    std::vector<float> rates(rateCount);
+    if (XR_SUCCEEDED(result) && rateCount > 0) {
+        result = enumerateRates(session_, rateCount, &rateCount, rates.data());
+    }
+    if (XR_FAILED(result) || rateCount == 0) {
+        LOGW("xrEnumerateDisplayRefreshRatesFB failed (XrResult=%d)", result);
+        return;
+    }
+
+    float currentRate = 0.0f;
+    getRate(session_, &currentRate);
+    const float selectedRate = SelectDisplayRefreshRate(rates.data(), rateCount, kVbRefreshHz);
+    if (selectedRate > 0.0f && selectedRate != currentRate) {
+        result = requestRate(session_, selectedRate);
+        if (XR_SUCCEEDED(result)) {
+            currentRate = selectedRate;
+        } else {
+            LOGW("xrRequestDisplayRefreshRateFB(%.1f) failed (XrResult=%d)", selectedRate, result);
+        }
+    }
+    displayRefreshHz_ = currentRate;
+    LOGI("Display refresh %.1f Hz (cadence error %.3f against %.2f Hz source, %u rates)",
+         currentRate,
+         CadenceError(currentRate, kVbRefreshHz),
+         kVbRefreshHz,
+         rateCount);
+}
+
+int64_t XrStereoRenderer::steadyTimeFromXrTime(const XrTime time) const {
+    timespec monotonic{};
+    if (convertTimeToTimespec_ == nullptr ||
+        XR_FAILED(convertTimeToTimespec_(instance_, time, &monotonic))) {
+        return 0;
+    }
+    // steady_clock is CLOCK_MONOTONIC, the clock the extension converts to.
+    return static_cast<int64_t>(monotonic.tv_sec) * 1000000000LL + monotonic.tv_nsec;
+}
+
+DisplayPhase XrStereoRenderer::displayPhase() const {
+    DisplayPhase phase;
+    phase.vsyncNs = displayVsyncNs_.load();
+    phase.periodNs = displayPeriodNs_.load();
+    return phase;
+}
+
 bool XrStereoRenderer::createInputActions() {
     if (instance_ == XR_NULL_HANDLE || session_ == XR_NULL_HANDLE) {
         return setErrorMessage("OpenXR input setup requires instance and session");
@@ -781,6 +1028,25 @@ bool XrStereoRenderer::createSwapchains() {
         }
     }
 
+    int64_t depthFormat = 0;
+    if (depthLayerSupported_) {
+        constexpr std::array<int64_t, 4> kDepthFormats = {
+            GL_DEPTH_COMPONENT24,
+            GL_DEPTH24_STENCIL8,
+            GL_DEPTH_COMPONENT32F,
+            GL_DEPTH_COMPONENT16,
+        };
+        for (const int64_t candidate : kDepthFormats) {
+            if (std::find(formats.begin(), formats.end(), candidate) != formats.end()) {
+                depthFormat = candidate;
+                break;
+            }
+        }
+        if (depthFormat == 0) {
+            LOGW("XR_KHR_composition_layer_depth enabled but no depth swapchain format offered");
+        }
+    }
+
     for (uint32_t i = 0; i < viewCount; ++i) {
         XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
         createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
@@ -816,11 +1082,49 @@ bool XrStereoRenderer::createSwapchains() {
         if (XR_FAILED(result)) {
             return setError("xrEnumerateSwapchainImages(data)", result);
         }
+
+        if (depthFormat != 0 && !createDepthSwapchain(eyeSwapchains_[i], createInfo, depthFormat)) {
+            // Depth submission is an optional quality improvement; keep rendering without it.
+            LOGW("Depth swapchain creation failed for eye %u; submitting color only", i);
+        }
     }
 
     return true;
 }
 
+bool XrStereoRenderer::createDepthSwapchain(
+    EyeSwapchain& eye, const XrSwapchainCreateInfo& colorInfo, const int64_t depthFormat) {
+    XrSwapchainCreateInfo createInfo = colorInfo;
+    createInfo.usageFlags = XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    createInfo.format = depthFormat;
+
+    XrResult result = xrCreateSwapchain(session_, &createInfo, &eye.depthHandle);
+    if (XR_FAILED(result)) {
+        eye.depthHandle = XR_NULL_HANDLE;
+        return false;
+    }
+
+    uint32_t imageCount = 0;
+    result = xrEnumerateSwapchainImages(eye.depthHandle, 0, &imageCount, nullptr);
+    if (XR_SUCCEEDED(result) && imageCount > 0) {
+        eye.depthImages.assign(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR});
+        result = xrEnumerateSwapchainImages(
+            eye.depthHandle,
+            imageCount,
+            &imageCount,
+            reinterpret_cast<XrSwapchainImageBaseHeader*>(eye.depthImages.data()));
+    }
+    if (XR_FAILED(result) || eye.depthImages.empty()) {
+        xrDestroySwapchain(eye.depthHandle);
+        eye.depthHandle = XR_NULL_HANDLE;
+        eye.depthImages.clear();
+        return false;
+    }
+
+    eye.depthHasStencil = depthFormat == GL_DEPTH24_STENCIL8;
+    return true;
+}
+
 bool XrStereoRenderer::createGlResources() {
     if (!makeCurrent()) {
         return setErrorMessage("XR GL context not current");
@@ -831,33 +1135,277 @@ bool XrStereoRenderer::createGlResources() {
         return setErrorMessage("Failed creating XR GL program");
     }
 
-    uniformTexture_ = glGetUniformLocation(program_, "uTex");
-    uniformWorldTexture_ = glGetUniformLocation(program_, "uWorldTex");
-    uniformUvScale_ = glGetUniformLocation(program_, "uUvScale");
-    uniformUvOffset_ = glGetUniformLocation(program_, "uUvOffset");
-    uniformMvp_ = glGetUniformLocation(program_, "uMvp");
-    uniformUseWorldMask_ = glGetUniformLocation(program_, "uUseWorldMask");
-    uniformLayerWorld_ = glGetUniformLocation(program_, "uLayerWorld");
+    BindProgramResources(program_);
+
+    // Unit quad in a VAO; every flat path draws it with a per-draw transform.
+    const GLfloat quadVertices[] = {
+        -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+        1.0f,  -1.0f, 0.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,  0.0f, 0.0f, 0.0f,
+        1.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+    };
+    glGenVertexArrays(1, &quadVertexArray_);
+    glGenBuffers(1, &quadVertexBuffer_);
+    glBindVertexArray(quadVertexArray_);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(
+        1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat),
+        reinterpret_cast<const void*>(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLint uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    uniformAlignment = std::max(uniformAlignment, 16);
+    drawUniformStride_ =
+        (static_cast<GLsizeiptr>(sizeof(DrawUniforms)) + uniformAlignment - 1) /
+        uniformAlignment * uniformAlignment;
+
+    for (auto& slot : frameSlots_) {
+        if (!createFrameSlot(slot)) {
+            return setErrorMessage("Failed creating XR frame slot textures");
+        }
+    }
+
+    glGenRenderbuffers(1, &depthRenderbuffer_);
+    glGenFramebuffers(1, &framebuffer_);
 
-    glGenTextures(1, &emuTexture_);
-    glBindTexture(GL_TEXTURE_2D, emuTexture_);
+    if (!createDepthMesh()) {
+        // Not fatal: depth mode falls back to masked layers.
+        LOGW("Displaced depth mesh unavailable; using layered depth rendering");
+    }
+
+    const char* glExtensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (glExtensions != nullptr && std::strstr(glExtensions, "GL_EXT_disjoint_timer_query")) {
+        gGetQueryObjectui64vEXT = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+            eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    }
+    if (gGetQueryObjectui64vEXT != nullptr) {
+        glGenQueries(GpuFrameTimer::kQueryCount, gpuTimer_.queries.data());
+        gpuTimer_.available = true;
+    }
+    return true;
+}
+
+bool XrStereoRenderer::createFrameSlot(FrameSlot& slot) {
+    glGenTextures(1, &slot.texture);
+    glBindTexture(GL_TEXTURE_2D, slot.texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return slot.texture != 0 && glGetError() == GL_NO_ERROR;
+}
 
-    glGenTextures(1, &worldTexture_);
-    glBindTexture(GL_TEXTURE_2D, worldTexture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+bool XrStereoRenderer::createDepthMesh() {
+    meshProgram_ = CreateProgram(kMeshVertexShader, kMeshFragmentShader);
+    if (meshProgram_ == 0) {
+        return false;
+    }
 
-    glGenRenderbuffers(1, &depthRenderbuffer_);
-    glGenFramebuffers(1, &framebuffer_);
+    BindProgramResources(meshProgram_);
+
+    constexpr int kColumnVertices = kDepthMeshCols + 1;
+    constexpr int kRowVertices = kDepthMeshRows + 1;
+    static_assert(kColumnVertices * kRowVertices <= 0xFFFF, "depth mesh exceeds 16-bit indices");
+
+    std::vector<GLfloat> vertices;
+    vertices.reserve(static_cast<size_t>(kColumnVertices) * kRowVertices * 2);
+    for (int row = 0; row < kRowVertices; ++row) {
+        for (int col = 0; col < kColumnVertices; ++col) {
+            vertices.push_back(static_cast<float>(col) / static_cast<float>(kDepthMeshCols));
+            vertices.push_back(static_cast<float>(row) / static_cast<float>(kDepthMeshRows));
+        }
+    }
+
+    std::vector<GLushort> indices;
+    indices.reserve(static_cast<size_t>(kDepthMeshCols) * kDepthMeshRows * 6);
+    for (int row = 0; row < kDepthMeshRows; ++row) {
+        for (int col = 0; col < kDepthMeshCols; ++col) {
+            const auto topLeft = static_cast<GLushort>(row * kColumnVertices + col);
+            const auto topRight = static_cast<GLushort>(topLeft + 1);
+            const auto bottomLeft = static_cast<GLushort>(topLeft + kColumnVertices);
+            const auto bottomRight = static_cast<GLushort>(bottomLeft + 1);
+            indices.insert(
+                indices.end(), {topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight});
+        }
+    }
+
+    glGenVertexArrays(1, &meshVertexArray_);
+    glGenBuffers(1, &meshVertexBuffer_);
+    glGenBuffers(1, &meshIndexBuffer_);
+    glBindVertexArray(meshVertexArray_);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVertexBuffer_);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(vertices.size() * sizeof(GLfloat)),
+        vertices.data(),
+        GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+    glEnableVertexAttribArray(0);
+    // The element array binding is VAO state, so it is bound while the VAO is.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshIndexBuffer_);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(indices.size() * sizeof(GLushort)),
+        indices.data(),
+        GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    meshIndexCount_ = static_cast<GLsizei>(indices.size());
     return true;
 }
 
+const Mat4& XrStereoRenderer::eyeProjection(EyeSwapchain& eye, const XrFovf& fov) {
+    if (!eye.projectionValid || !SameFov(eye.projectionFov, fov)) {
+        eye.projection = Mat4PerspectiveFromFov(fov, kProjectionNearZ, kProjectionFarZ);
+        eye.projectionFov = fov;
+        eye.projectionValid = true;
+    }
+    return eye.projection;
+}
+
+void XrStereoRenderer::beginDrawUniforms() {
+    drawUniformCount_ = 0;
+}
+
+void XrStereoRenderer::addDrawUniforms(const DrawUniforms& draw) {
+    const size_t offset = drawUniformCount_ * static_cast<size_t>(drawUniformStride_);
+    if (drawUniformStaging_.size() < offset + drawUniformStride_) {
+        drawUniformStaging_.resize(offset + drawUniformStride_);
+    }
+    static_assert(sizeof(DrawUniforms) == 112, "DrawUniforms must match the DrawParams block");
+    std::memcpy(drawUniformStaging_.data() + offset, &draw, sizeof(draw));
+    ++drawUniformCount_;
+}
+
+void XrStereoRenderer::uploadDrawUniforms(EyeSwapchain& eye) {
+    if (eye.drawUniformBuffer == 0) {
+        glGenBuffers(1, &eye.drawUniformBuffer);
+    }
+    // Re-specifying the whole store lets the driver orphan the copy the GPU may still read.
+    glBindBuffer(GL_UNIFORM_BUFFER, eye.drawUniformBuffer);
+    glBufferData(
+        GL_UNIFORM_BUFFER,
+        static_cast<GLsizeiptr>(drawUniformCount_) * drawUniformStride_,
+        drawUniformStaging_.data(),
+        GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void XrStereoRenderer::bindDrawUniforms(const EyeSwapchain& eye, const size_t index) {
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER,
+        0,
+        eye.drawUniformBuffer,
+        static_cast<GLintptr>(index) * drawUniformStride_,
+        sizeof(DrawUniforms));
+}
+
+void XrStereoRenderer::beginGpuTimer(const GpuTimedPath path) {
+    if (!gpuTimer_.available || gpuTimer_.active) {
+        return;
+    }
+    const int slot = gpuTimer_.next;
+    if (gpuTimer_.pending[slot]) {
+        // Result still in flight; skip timing this frame rather than stall.
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED_EXT, gpuTimer_.queries[slot]);
+    gpuTimer_.paths[slot] = path;
+    gpuTimer_.scales[slot] = resolutionScale_;
+    gpuTimer_.active = true;
+}
+
+void XrStereoRenderer::tagGpuTimer(const GpuTimedPath path) {
+    if (gpuTimer_.active) {
+        gpuTimer_.paths[gpuTimer_.next] = path;
+    }
+}
+
+void XrStereoRenderer::endGpuTimer() {
+    if (!gpuTimer_.active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    gpuTimer_.pending[gpuTimer_.next] = true;
+    gpuTimer_.next = (gpuTimer_.next + 1) % GpuFrameTimer::kQueryCount;
+    gpuTimer_.active = false;
+}
+
+void XrStereoRenderer::collectGpuTimers() {
+    if (!gpuTimer_.available) {
+        return;
+    }
+
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    for (int slot = 0; slot < GpuFrameTimer::kQueryCount; ++slot) {
+        if (!gpuTimer_.pending[slot]) {
+            continue;
+        }
+        GLuint ready = 0;
+        glGetQueryObjectuiv(gpuTimer_.queries[slot], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (ready == 0) {
+            continue;
+        }
+        GLuint64 elapsedNs = 0;
+        gGetQueryObjectui64vEXT(gpuTimer_.queries[slot], GL_QUERY_RESULT, &elapsedNs);
+        gpuTimer_.pending[slot] = false;
+        if (disjoint != 0) {
+            continue;
+        }
+
+        const float elapsedMs = static_cast<float>(elapsedNs) * 1.0e-6f;
+        SmoothTimeMs(frameDebug_.frameGpuTimeMs, elapsedMs);
+        if (gpuTimer_.paths[slot] == GpuTimedPath::Layers) {
+            SmoothTimeMs(frameDebug_.layerGpuTimeMs, elapsedMs);
+        } else if (gpuTimer_.paths[slot] == GpuTimedPath::DisplacedMesh) {
+            SmoothTimeMs(frameDebug_.meshGpuTimeMs, elapsedMs);
+        }
+        if (gpuTimer_.scales[slot] == resolutionScale_) {
+            SmoothTimeMs(scaledGpuTimeMs_, elapsedMs);
+        }
+    }
+}
+
+void XrStereoRenderer::updateResolutionScale(const XrDuration displayPeriod) {
+    if (!gpuTimer_.available || scaledGpuTimeMs_ <= 0.0f || displayPeriod <= 0) {
+        return;
+    }
+    if (++resolutionSettleFrames_ < kResolutionSettleFrames) {
+        return;
+    }
+    // Decide at most once per settle window, whether or not the scale moves.
+    resolutionSettleFrames_ = 0;
+
+    const float budgetMs = static_cast<float>(displayPeriod) * 1.0e-6f * kGpuBudgetFraction;
+    const float gpuMs = scaledGpuTimeMs_;
+    float scale = resolutionScale_;
+    if (gpuMs > budgetMs) {
+        // Fill cost tracks area, so the square root of the overshoot sizes the drop per axis.
+        scale = std::min(scale - kResolutionStep, scale * std::sqrt(budgetMs / gpuMs));
+    } else if (gpuMs < budgetMs * kResolutionRaiseThreshold) {
+        scale += kResolutionStep;
+    } else {
+        return;
+    }
+
+    scale = std::clamp(scale, kMinResolutionScale, kMaxResolutionScale);
+    if (std::abs(scale - resolutionScale_) < 0.01f) {
+        return;
+    }
+    resolutionScale_ = scale;
+    // The next decision only sees queries issued at the new size.
+    scaledGpuTimeMs_ = 0.0f;
+}
+
 bool XrStereoRenderer::getBooleanActionState(XrAction action, XrPath subactionPath) const {
     if (session_ == XR_NULL_HANDLE || action == XR_NULL_HANDLE) {
         return false;
@@ -1040,17 +1588,29 @@ bool XrStereoRenderer::beginSession() {
     if (XR_FAILED(result)) {
         return setError("xrBeginSession", result);
     }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        renderInputs_.resetAnchor = true;
+        renderInputs_.walkThroughOffset = {};
+        renderInputs_.walkThroughYaw = 0.0f;
+        renderInputs_.walkThroughPitch = 0.0f;
+        renderDebugState_ = {};
+        renderDebugState_.xrActive = true;
+    }
     headOriginSet_ = false;
     headOrigin_ = {};
-    walkThroughOffset_ = {};
-    walkThroughYaw_ = 0.0f;
-    walkThroughPitch_ = 0.0f;
-    layerDataReady_ = false;
-    eyeLayers_[0].clear();
-    eyeLayers_[1].clear();
-    renderDebugState_ = {};
-    renderDebugState_.xrActive = true;
+    frameDebug_ = {};
+    resolutionScale_ = kMaxResolutionScale;
+    scaledGpuTimeMs_ = 0.0f;
+    resolutionSettleFrames_ = 0;
+    staticFrame_ = {};
+    cadenceStats_ = {};
+    cadenceRefreshHz_ = 0.0f;
+    droppedSourceFrames_ = 0;
+    metadataFrameId_ = 0;
+    resetLayerDepthState();
     sessionRunning_ = true;
+    startFramePipeline();
     return true;
 }
 
@@ -1058,18 +1618,148 @@ void XrStereoRenderer::endSession() {
     if (!sessionRunning_) {
         return;
     }
+    // Every begun frame is ended by the render thread before it exits, so xrEndSession is safe.
+    stopFramePipeline();
     xrEndSession(session_);
     sessionRunning_ = false;
+    std::lock_guard<std::mutex> lock(stateMutex_);
     renderDebugState_.xrActive = false;
 }
 
+void XrStereoRenderer::startFramePipeline() {
+    stopFramePipeline();
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        stopPipeline_ = false;
+        frameWaited_ = false;
+    }
+    // eglContext_ may be current on only one thread; the render thread owns it from here.
+    makeUploadCurrent();
+    frameWaitThread_ = std::thread(&XrStereoRenderer::frameWaitLoop, this);
+    renderThread_ = std::thread(&XrStereoRenderer::renderLoop, this);
+}
+
+void XrStereoRenderer::stopFramePipeline() {
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        stopPipeline_ = true;
+    }
+    pipelineCv_.notify_all();
+    if (frameWaitThread_.joinable()) {
+        frameWaitThread_.join();
+    }
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+    presenting_ = false;
+    displayVsyncNs_ = 0;
+    displayPeriodNs_ = 0;
+}
+
+void XrStereoRenderer::setFramePipelinePaused(const bool paused) {
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex_);
+        pipelinePaused_ = paused;
+    }
+    pipelineCv_.notify_all();
+}
+
+void XrStereoRenderer::frameWaitLoop() {
+    // Its wake-up time is the vsync phase the emulation pacer locks to.
+    ApplyThreadPolicy(ThreadRole::Render);
+    registerCurrentThread(XR_ANDROID_THREAD_TYPE_RENDERER_WORKER_KHR);
+    while (true) {
+        {
+            // xrWaitFrame for frame N+1 may only start once frame N has been begun. Paused, the
+            // render thread ends the waited frame and then both threads block here and below.
+            std::unique_lock<std::mutex> lock(pipelineMutex_);
+            pipelineCv_.wait(
+                lock, [this] { return stopPipeline_ || (!frameWaited_ && !pipelinePaused_); });
+            if (stopPipeline_) {
+                return;
+            }
+        }
+
+        XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
+        XrFrameState frameState{XR_TYPE_FRAME_STATE};
+        const XrResult result = xrWaitFrame(session_, &waitInfo, &frameState);
+        if (XR_FAILED(result)) {
+            setError("xrWaitFrame", result);
+            presenting_ = false;
+            return;
+        }
+        // xrWaitFrame returns at the start of a display refresh; the emulation pacer locks
+        // its phase to this.
+        displayVsyncNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        displayPeriodNs_ = frameState.predictedDisplayPeriod;
+
+        {
+            std::lock_guard<std::mutex> lock(pipelineMutex_);
+            waitedFrameState_ = frameState;
+            frameWaited_ = true;
+        }
+        pipelineCv_.notify_all();
+    }
+}
+
+void XrStereoRenderer::renderLoop() {
+    const ThreadPolicyResult policy = ApplyThreadPolicy(ThreadRole::Render);
+    LOGI("XR render thread: nice %d", policy.niceLevel);
+    registerCurrentThread(XR_ANDROID_THREAD_TYPE_RENDERER_MAIN_KHR);
+    if (!makeCurrent()) {
+        setErrorMessage("Render thread could not bind the XR EGL context");
+        return;
+    }
+
+    while (true) {
+        XrFrameState frameState{XR_TYPE_FRAME_STATE};
+        {
+            std::unique_lock<std::mutex> lock(pipelineMutex_);
+            pipelineCv_.wait(lock, [this] { return stopPipeline_ || frameWaited_; });
+            if (stopPipeline_) {
+                break;
+            }
+            frameState = waitedFrameState_;
+        }
+
+        XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+        const XrResult result = xrBeginFrame(session_, &beginInfo);
+        {
+            std::lock_guard<std::mutex> lock(pipelineMutex_);
+            frameWaited_ = false;
+        }
+        // Lets the wait thread pace frame N+1 while this thread records and submits frame N.
+        pipelineCv_.notify_all();
+        if (XR_FAILED(result)) {
+            setError("xrBeginFrame", result);
+            presenting_ = false;
+            continue;
+        }
+
+        presenting_ = renderXrFrame(frameState);
+    }
+
+    eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
 void XrStereoRenderer::destroySwapchains() {
     for (auto& eye : eyeSwapchains_) {
         if (eye.handle != XR_NULL_HANDLE) {
             xrDestroySwapchain(eye.handle);
             eye.handle = XR_NULL_HANDLE;
         }
+        if (eye.depthHandle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(eye.depthHandle);
+            eye.depthHandle = XR_NULL_HANDLE;
+        }
+        if (eye.drawUniformBuffer != 0) {
+            glDeleteBuffers(1, &eye.drawUniformBuffer);
+            eye.drawUniformBuffer = 0;
+        }
         eye.images.clear();
+        eye.depthImages.clear();
     }
     eyeSwapchains_.clear();
 }
@@ -1087,6 +1777,12 @@ bool XrStereoRenderer::initialize(ANativeActivity* activity) {
         shutdown();
         return false;
     }
+    selectDisplayRefreshRate();
+    if (!makeUploadCurrent()) {
+        setErrorMessage("eglMakeCurrent(upload) failed");
+        shutdown();
+        return false;
+    }
 
     initialized_ = true;
     lastError_.clear();
@@ -1120,34 +1816,115 @@ void XrStereoRenderer::pollEvents() {
                 default:
                     break;
             }
+        } else if (eventBuffer.type == XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB) {
+            const auto* rateChanged =
+                reinterpret_cast<const XrEventDataDisplayRefreshRateChangedFB*>(&eventBuffer);
+            displayRefreshHz_ = rateChanged->toDisplayRefreshRate;
+            LOGI("Display refresh changed %.1f -> %.1f Hz",
+                 rateChanged->fromDisplayRefreshRate,
+                 rateChanged->toDisplayRefreshRate);
         }
         eventBuffer = XrEventDataBuffer{XR_TYPE_EVENT_DATA_BUFFER};
     }
+}
+
+XrStereoRenderer::FrameSlot* XrStereoRenderer::acquireStagingSlot() {
+    if (stagingSlot_ >= 0) {
+        return &frameSlots_[stagingSlot_];
+    }
+    if (!makeUploadCurrent()) {
+        return nullptr;
+    }
 
-    syncInput();
+    GLsync releaseFence = nullptr;
+    GLsync staleUploadFence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        for (int i = 0; i < kFrameSlotCount; ++i) {
+            if (i != publishedSlot_ && i != renderSlot_) {
+                stagingSlot_ = i;
+                break;
+            }
+        }
+        auto& slot = frameSlots_[stagingSlot_];
+        releaseFence = std::exchange(slot.releaseFence, nullptr);
+        // A slot superseded before the render thread picked it up still owns its upload fence.
+        staleUploadFence = std::exchange(slot.uploadFence, nullptr);
+    }
+
+    if (releaseFence != nullptr) {
+        // Server-side wait: the upload queues behind the render thread's last read of this slot
+        // without blocking the emulation thread.
+        glWaitSync(releaseFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(releaseFence);
+    }
+    if (staleUploadFence != nullptr) {
+        // Published but superseded before any refresh showed it.
+        droppedSourceFrames_++;
+        glDeleteSync(staleUploadFence);
+    }
+
+    auto& slot = frameSlots_[stagingSlot_];
+    slot.frameReady = false;
+    slot.metadataReady = false;
+    slot.layerDataReady = false;
+    return &slot;
 }
 
 void XrStereoRenderer::updateFrame(const uint32_t* pixels, int width, int height) {
     if (!initialized_ || pixels == nullptr || width <= 0 || height <= 0) {
         return;
     }
-    if (!makeCurrent()) {
+    FrameSlot* slot = acquireStagingSlot();
+    if (slot == nullptr) {
         return;
     }
 
-    frameWidth_ = width;
-    frameHeight_ = height;
-    frameReady_ = true;
-    sideBySideFrame_ = width >= (height * 2);
+    glBindTexture(GL_TEXTURE_2D, slot->texture);
+    if (slot->width == width && slot->height == height) {
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    } else {
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        slot->width = width;
+        slot->height = height;
+    }
+    slot->frameReady = true;
+    slot->sideBySide = width >= (height * 2);
+    slot->pixelHash = HashWords(
+        pixels, static_cast<size_t>(width) * static_cast<size_t>(height) * sizeof(uint32_t));
+}
+
+bool XrStereoRenderer::submitFrame(const int64_t inputSampleNs) {
+    if (!initialized_) {
+        return false;
+    }
+
+    pollEvents();
+    if (stagingSlot_ >= 0 && makeUploadCurrent()) {
+        GLsync uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // The render context waits on this fence, so it has to reach the GPU queue now.
+        glFlush();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            frameSlots_[stagingSlot_].uploadFence = uploadFence;
+            frameSlots_[stagingSlot_].inputSampleNs = inputSampleNs;
+            publishedSlot_ = stagingSlot_;
+        }
+        stagingSlot_ = -1;
+    }
 
-    glBindTexture(GL_TEXTURE_2D, emuTexture_);
-    glTexImage2D(
-        GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (!sessionRunning_) {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        renderDebugState_.xrActive = false;
+        return false;
+    }
+    return presenting_;
 }
 
 void XrStereoRenderer::updateDepthMetadata(
-    const int8_t* disparity,
-    const uint8_t* worldIds,
+    const uint8_t* depthPlane,
     const int16_t* sourceX,
     const int16_t* sourceY,
     const int width,
@@ -1155,123 +1932,314 @@ void XrStereoRenderer::updateDepthMetadata(
     const uint32_t frameId) {
     (void)sourceX;
     (void)sourceY;
-    if (!initialized_ || disparity == nullptr || worldIds == nullptr || width <= 0 || height <= 0 ||
-        !makeCurrent()) {
-        metadataReady_ = false;
-        layerDataReady_ = false;
+    if (!initialized_) {
+        return;
+    }
+    if (depthPlane == nullptr || width <= 0 || height <= 0) {
+        // The staging slot keeps metadataReady == false, so this frame renders without depth.
         metadataWidth_ = 0;
         metadataHeight_ = 0;
-        disparityUpload_.clear();
-        eyeLayers_[0].clear();
-        eyeLayers_[1].clear();
+        metadataFrameId_ = 0;
+        resetLayerDepthState();
+        return;
+    }
+    FrameSlot* slot = acquireStagingSlot();
+    if (slot == nullptr) {
         return;
     }
 
+    const bool slotCurrent = frameId != 0 && slot->metadataFrameId == frameId &&
+                             slot->metadataWidth == width && slot->metadataHeight == height;
+    if (!slotCurrent) {
+        if (!ensureMetadataTexture(*slot, width, height)) {
+            return;
+        }
+        // The core already stores world id (R) and signed disparity (G) interleaved, so the
+        // plane goes to the GPU as-is with no staging copy.
+        glBindTexture(GL_TEXTURE_2D, slot->metadataTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RG, GL_UNSIGNED_BYTE, depthPlane);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        slot->metadataWidth = width;
+        slot->metadataHeight = height;
+        slot->metadataFrameId = frameId;
+        slot->metadataHash = HashWords(
+            depthPlane, static_cast<size_t>(width) * static_cast<size_t>(height) * 2);
+    }
+    slot->metadataReady = true;
+    slot->layerDataReady = width >= (kVipEyeWidth * 2) && height >= kVipEyeHeight;
+
+    const bool sameFrame = frameId != 0 && frameId == metadataFrameId_ &&
+                           width == metadataWidth_ && height == metadataHeight_;
     metadataWidth_ = width;
     metadataHeight_ = height;
     metadataFrameId_ = frameId;
-    metadataReady_ = true;
-    layerDataReady_ = width >= (kVipEyeWidth * 2) && height >= kVipEyeHeight;
-
-    const size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
-    disparityUpload_.assign(disparity, disparity + pixelCount);
-    worldUpload_.assign(worldIds, worldIds + pixelCount);
-    glBindTexture(GL_TEXTURE_2D, worldTexture_);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_LUMINANCE,
-        width,
-        height,
-        0,
-        GL_LUMINANCE,
-        GL_UNSIGNED_BYTE,
-        worldUpload_.data());
-
-    eyeLayers_[0].clear();
-    eyeLayers_[1].clear();
-    if (!layerDataReady_) {
-        return;
+    if (!slot->layerDataReady) {
+        resetLayerDepthState();
+    } else if (!sameFrame) {
+        // A repeated core frame leaves the smoothed layer depths as they are.
+        updateLayerDepths(depthPlane, width);
     }
+    slot->eyeLayers = eyeLayers_;
+}
 
+void XrStereoRenderer::updateLayerDepths(const uint8_t* depthPlane, const int width) {
     for (int eye = 0; eye < 2; ++eye) {
-        std::array<int64_t, 32> disparitySum{};
-        std::array<int32_t, 32> disparityCount{};
+        std::array<int64_t, kVipWorldCount> disparitySum{};
+        std::array<int32_t, kVipWorldCount> disparityCount{};
         for (int y = 0; y < kVipEyeHeight; ++y) {
             const size_t rowOffset = static_cast<size_t>(y) * static_cast<size_t>(width);
             const size_t eyeOffset = static_cast<size_t>(eye * kVipEyeWidth);
             for (int x = 0; x < kVipEyeWidth; ++x) {
                 const size_t index = rowOffset + eyeOffset + static_cast<size_t>(x);
-                const uint8_t worldId = worldIds[index];
-                if (worldId >= 32) {
+                const uint8_t worldId = depthPlane[index * 2];
+                if (worldId >= kVipWorldCount) {
                     continue;
                 }
-                const int depthAbs = std::abs(static_cast<int>(disparity[index]));
+                const auto disparity = static_cast<int8_t>(depthPlane[index * 2 + 1]);
+                const int depthAbs = std::abs(static_cast<int>(disparity));
                 disparitySum[worldId] += depthAbs;
                 disparityCount[worldId]++;
             }
         }
 
+        auto& worlds = worldDepth_[eye];
+        for (uint8_t worldId = 0; worldId < kVipWorldCount; ++worldId) {
+            auto& world = worlds[worldId];
+            if (disparityCount[worldId] > 0) {
+                const float avgDisp = static_cast<float>(disparitySum[worldId]) /
+                                      static_cast<float>(disparityCount[worldId]);
+                const float closeness = std::clamp(avgDisp / 127.0f, 0.0f, 1.0f);
+                const float measuredZ = kLayerFarZ - closeness * (kLayerFarZ - kLayerNearZ);
+                if (!world.visible) {
+                    // A world that (re)appears starts at its measured depth instead of easing in.
+                    world.z = measuredZ;
+                    world.targetZ = measuredZ;
+                    world.visible = true;
+                } else if (std::abs(measuredZ - world.targetZ) > kLayerDepthHysteresis) {
+                    world.targetZ = measuredZ;
+                }
+                world.absentFrames = 0;
+            } else if (world.visible && ++world.absentFrames > kLayerHoldFrames) {
+                world.visible = false;
+            }
+            world.z += (world.targetZ - world.z) * kLayerDepthSmoothing;
+        }
+
+        // Update the existing painter list in place so its order carries over between frames.
         auto& layers = eyeLayers_[eye];
-        for (uint8_t worldId = 0; worldId < 32; ++worldId) {
-            if (disparityCount[worldId] <= 0) {
+        std::array<bool, kVipWorldCount> listed{};
+        size_t kept = 0;
+        for (const auto& layer : layers) {
+            if (!worlds[layer.worldId].visible) {
                 continue;
             }
-            const float avgDisp =
-                static_cast<float>(disparitySum[worldId]) / static_cast<float>(disparityCount[worldId]);
-            const float closeness = std::clamp(avgDisp / 127.0f, 0.0f, 1.0f);
-            const float z = kLayerFarZ - closeness * (kLayerFarZ - kLayerNearZ);
-            layers.push_back({worldId, z});
+            listed[layer.worldId] = true;
+            layers[kept++] = {layer.worldId, worlds[layer.worldId].z};
+        }
+        layers.resize(kept);
+        for (uint8_t worldId = 0; worldId < kVipWorldCount; ++worldId) {
+            if (worlds[worldId].visible && !listed[worldId]) {
+                layers.push_back({worldId, worlds[worldId].z});
+            }
         }
 
-        std::sort(layers.begin(), layers.end(), [](const LayerInfo& a, const LayerInfo& b) {
-            return a.z > b.z;  // far-to-near painter order
-        });
+        if (!std::is_sorted(layers.begin(), layers.end(), LayerFarToNear)) {
+            // Smoothed depths drift slowly, so the list is almost always nearly sorted.
+            for (size_t i = 1; i < layers.size(); ++i) {
+                const LayerInfo layer = layers[i];
+                size_t j = i;
+                while (j > 0 && LayerFarToNear(layer, layers[j - 1])) {
+                    layers[j] = layers[j - 1];
+                    --j;
+                }
+                layers[j] = layer;
+            }
+        }
     }
 }
 
-bool XrStereoRenderer::renderFrame() {
-    if (!initialized_) {
+bool XrStereoRenderer::ensureMetadataTexture(
+    FrameSlot& slot, const int width, const int height) {
+    if (slot.metadataTexture != 0 && slot.metadataTextureWidth == width &&
+        slot.metadataTextureHeight == height) {
+        return true;
+    }
+
+    // Immutable storage cannot be resized, so a geometry change recreates the texture.
+    if (slot.metadataTexture != 0) {
+        glDeleteTextures(1, &slot.metadataTexture);
+        slot.metadataTexture = 0;
+    }
+    slot.metadataTextureWidth = 0;
+    slot.metadataTextureHeight = 0;
+    slot.metadataFrameId = 0;
+
+    glGenTextures(1, &slot.metadataTexture);
+    glBindTexture(GL_TEXTURE_2D, slot.metadataTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (glGetError() != GL_NO_ERROR) {
+        LOGE("Failed allocating %dx%d RG8 metadata texture", width, height);
+        glDeleteTextures(1, &slot.metadataTexture);
+        slot.metadataTexture = 0;
         return false;
     }
 
-    pollEvents();
-    if (!sessionRunning_) {
-        renderDebugState_.xrActive = false;
+    slot.metadataTextureWidth = width;
+    slot.metadataTextureHeight = height;
+    return true;
+}
+
+void XrStereoRenderer::resetLayerDepthState() {
+    eyeLayers_[0].clear();
+    eyeLayers_[1].clear();
+    for (auto& worlds : worldDepth_) {
+        worlds.fill(WorldDepthState{});
+    }
+}
+
+bool XrStereoRenderer::SameRenderInputs(const RenderInputs& a, const RenderInputs& b) {
+    return a.screenScale == b.screenScale && a.stereoConvergence == b.stereoConvergence &&
+           a.depthMetadataEnabled == b.depthMetadataEnabled &&
+           a.depthRenderMode == b.depthRenderMode &&
+           a.dynamicResolution == b.dynamicResolution &&
+           a.worldAnchoredEnabled == b.worldAnchoredEnabled &&
+           a.overlayVisible == b.overlayVisible &&
+           SameVector(a.walkThroughOffset, b.walkThroughOffset) &&
+           a.walkThroughYaw == b.walkThroughYaw && a.walkThroughPitch == b.walkThroughPitch;
+}
+
+bool XrStereoRenderer::SameLayers(
+    const std::vector<LayerInfo>& a, const std::vector<LayerInfo>& b) {
+    if (a.size() != b.size()) {
         return false;
     }
-    renderDebugState_.xrActive = true;
-    renderDebugState_.depthModeEnabled = depthMetadataEnabled_;
-    renderDebugState_.overlayVisible = overlayVisible_;
-    renderDebugState_.headOriginSet = headOriginSet_;
-    renderDebugState_.usedLayerRendering = false;
-    renderDebugState_.usedDepthFallback = false;
-    renderDebugState_.usedClassic = false;
-    renderDebugState_.frameShouldRender = false;
-    renderDebugState_.metadataAligned = false;
-    renderDebugState_.layerDataReady = layerDataReady_;
-    renderDebugState_.relativeX = 0.0f;
-    renderDebugState_.relativeY = 0.0f;
-    renderDebugState_.relativeZ = 0.0f;
-
-    XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
-    XrFrameState frameState{XR_TYPE_FRAME_STATE};
-    XrResult result = xrWaitFrame(session_, &waitInfo, &frameState);
-    if (XR_FAILED(result)) {
-        setError("xrWaitFrame", result);
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].worldId != b[i].worldId || a[i].z != b[i].z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool XrStereoRenderer::matchesStaticFrame(
+    const RenderInputs& inputs, const FrameSlot* slot, const uint32_t viewCount) const {
+    const StaticFrameCache& cache = staticFrame_;
+    if (!cache.valid || inputs.resetAnchor || cache.views.size() != viewCount ||
+        cache.resolutionScale != resolutionScale_ || !SameVector(cache.headOrigin, headOrigin_) ||
+        !SameRenderInputs(cache.inputs, inputs)) {
         return false;
     }
 
-    XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-    result = xrBeginFrame(session_, &beginInfo);
-    if (XR_FAILED(result)) {
-        setError("xrBeginFrame", result);
+    const bool frameReady = slot != nullptr && slot->frameReady;
+    if (frameReady != cache.frameReady) {
         return false;
     }
+    if (frameReady) {
+        if (slot->pixelHash != cache.pixelHash || slot->width != cache.width ||
+            slot->height != cache.height || slot->metadataReady != cache.metadataReady ||
+            slot->layerDataReady != cache.layerDataReady) {
+            return false;
+        }
+        if (slot->metadataReady && slot->metadataHash != cache.metadataHash) {
+            return false;
+        }
+        for (size_t eye = 0; eye < slot->eyeLayers.size(); ++eye) {
+            if (!SameLayers(slot->eyeLayers[eye], cache.eyeLayers[eye])) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < viewCount; ++i) {
+        if (!SamePose(views_[i].pose, cache.views[i].pose) ||
+            !SameFov(views_[i].fov, cache.views[i].fov)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void XrStereoRenderer::storeStaticFrame(
+    const RenderInputs& inputs,
+    const FrameSlot* slot,
+    const std::vector<XrCompositionLayerProjectionView>& projectionViews,
+    const std::vector<XrCompositionLayerDepthInfoKHR>& depthInfos) {
+    StaticFrameCache& cache = staticFrame_;
+    cache.valid = true;
+    cache.inputs = inputs;
+    cache.resolutionScale = resolutionScale_;
+    cache.headOrigin = headOrigin_;
+    cache.frameReady = slot != nullptr && slot->frameReady;
+    if (cache.frameReady) {
+        cache.pixelHash = slot->pixelHash;
+        cache.metadataHash = slot->metadataHash;
+        cache.width = slot->width;
+        cache.height = slot->height;
+        cache.metadataReady = slot->metadataReady;
+        cache.layerDataReady = slot->layerDataReady;
+        cache.eyeLayers = slot->eyeLayers;
+    }
+    cache.views = projectionViews;
+    cache.depthInfos = depthInfos;
+    cache.debug = frameDebug_;
+}
 
+bool XrStereoRenderer::renderXrFrame(const XrFrameState& frameState) {
+    RenderInputs inputs;
+    FrameSlot* slot = nullptr;
+    GLsync uploadFence = nullptr;
+    bool newSourceFrame = false;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        inputs = renderInputs_;
+        renderInputs_.resetAnchor = false;
+        if (publishedSlot_ >= 0) {
+            newSourceFrame = true;
+            renderSlot_ = publishedSlot_;
+            publishedSlot_ = -1;
+        }
+        if (renderSlot_ >= 0) {
+            slot = &frameSlots_[renderSlot_];
+            uploadFence = std::exchange(slot->uploadFence, nullptr);
+        }
+    }
+    if (inputs.resetAnchor) {
+        headOriginSet_ = false;
+    }
+    if (uploadFence != nullptr) {
+        glWaitSync(uploadFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(uploadFence);
+    }
+    const bool frameReady = slot != nullptr && slot->frameReady;
+
+    frameDebug_.xrActive = true;
+    frameDebug_.depthModeEnabled = inputs.depthMetadataEnabled;
+    frameDebug_.overlayVisible = inputs.overlayVisible;
+    frameDebug_.headOriginSet = headOriginSet_;
+    frameDebug_.usedLayerRendering = false;
+    frameDebug_.usedDepthFallback = false;
+    frameDebug_.usedClassic = false;
+    frameDebug_.usedDisplacedMesh = false;
+    frameDebug_.depthSubmitted = false;
+    frameDebug_.gpuTimerAvailable = gpuTimer_.available;
+    frameDebug_.frameShouldRender = false;
+    frameDebug_.metadataAligned = false;
+    frameDebug_.layerDataReady = slot != nullptr && slot->layerDataReady;
+    frameDebug_.relativeX = 0.0f;
+    frameDebug_.relativeY = 0.0f;
+    frameDebug_.relativeZ = 0.0f;
+
+    XrResult result = XR_SUCCESS;
     std::vector<XrCompositionLayerProjectionView> projectionViews;
+    std::vector<XrCompositionLayerDepthInfoKHR> depthInfos;
     XrCompositionLayerProjection projectionLayer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
-    renderDebugState_.frameShouldRender = frameState.shouldRender;
+    frameDebug_.frameShouldRender = frameState.shouldRender;
 
     if (frameState.shouldRender) {
         XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO};
@@ -1291,17 +2259,24 @@ bool XrStereoRenderer::renderFrame() {
 
         if (viewCount > 0) {
             projectionViews.resize(viewCount, {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW});
+            depthInfos.assign(viewCount, {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR});
+            const bool submitDepth = inputs.worldAnchoredEnabled || inputs.depthMetadataEnabled;
+            if (makeCurrent()) {
+                collectGpuTimers();
+                if (inputs.dynamicResolution) {
+                    updateResolutionScale(frameState.predictedDisplayPeriod);
+                } else if (resolutionScale_ != kMaxResolutionScale) {
+                    resolutionScale_ = kMaxResolutionScale;
+                    scaledGpuTimeMs_ = 0.0f;
+                    resolutionSettleFrames_ = 0;
+                }
+            }
+            frameDebug_.resolutionScale = resolutionScale_;
 
-            const float screenScale = std::clamp(screenScale_, kMinScreenScale, kMaxScreenScale);
+            const float screenScale =
+                std::clamp(inputs.screenScale, kMinScreenScale, kMaxScreenScale);
             const float stereoConvergence =
-                std::clamp(stereoConvergence_, kMinStereoConvergence, kMaxStereoConvergence);
-            const GLfloat quadVertices[] = {
-                -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
-                1.0f,  -1.0f, 0.0f, 1.0f, 1.0f,
-                -1.0f, 1.0f,  0.0f, 0.0f, 0.0f,
-                1.0f,  1.0f,  0.0f, 1.0f, 0.0f,
-            };
-
+                std::clamp(inputs.stereoConvergence, kMinStereoConvergence, kMaxStereoConvergence);
             if (!headOriginSet_) {
                 XrVector3f headCenter = views_[0].pose.position;
                 if (viewCount > 1) {
@@ -1311,16 +2286,59 @@ bool XrStereoRenderer::renderFrame() {
                 }
                 headOrigin_ = headCenter;
                 headOriginSet_ = true;
-                renderDebugState_.headOriginSet = true;
+                frameDebug_.headOriginSet = true;
             }
 
             const XrVector3f worldAnchor = headOrigin_;
-            renderDebugState_.relativeX = walkThroughOffset_.x;
-            renderDebugState_.relativeY = walkThroughOffset_.y;
-            renderDebugState_.relativeZ = walkThroughOffset_.z;
+            frameDebug_.relativeX = inputs.walkThroughOffset.x;
+            frameDebug_.relativeY = inputs.walkThroughOffset.y;
+            frameDebug_.relativeZ = inputs.walkThroughOffset.z;
+
+            // Nothing that feeds the eye images changed: resubmit the last released swapchain
+            // images with the poses they were rendered at and skip acquire/draw/release.
+            const bool reuseFrame = matchesStaticFrame(inputs, slot, viewCount);
+            frameDebug_.reusedPreviousFrame = reuseFrame;
+            if (reuseFrame) {
+                projectionViews = staticFrame_.views;
+                depthInfos = staticFrame_.depthInfos;
+                for (uint32_t i = 0; i < viewCount; ++i) {
+                    if (projectionViews[i].next != nullptr) {
+                        projectionViews[i].next = &depthInfos[i];
+                    }
+                }
+                frameDebug_.metadataAligned = staticFrame_.debug.metadataAligned;
+                frameDebug_.usedLayerRendering = staticFrame_.debug.usedLayerRendering;
+                frameDebug_.usedDepthFallback = staticFrame_.debug.usedDepthFallback;
+                frameDebug_.usedClassic = staticFrame_.debug.usedClassic;
+                frameDebug_.usedDisplacedMesh = staticFrame_.debug.usedDisplacedMesh;
+                frameDebug_.depthSubmitted = staticFrame_.debug.depthSubmitted;
+                ++frameDebug_.reusedFrameCount;
+            }
+            const uint32_t renderViewCount = reuseFrame ? 0 : viewCount;
+            uint32_t renderedViews = 0;
+
+            // Shared by both eyes: the world transform and the source textures.
+            const Mat4 navigation = Mat4Multiply(
+                Mat4Translation(worldAnchor.x, worldAnchor.y, worldAnchor.z),
+                Mat4Multiply(
+                    Mat4Multiply(
+                        Mat4RotationY(-inputs.walkThroughYaw),
+                        Mat4RotationX(-inputs.walkThroughPitch)),
+                    Mat4Translation(
+                        -inputs.walkThroughOffset.x,
+                        -inputs.walkThroughOffset.y,
+                        -inputs.walkThroughOffset.z)));
+            if (frameReady && renderViewCount > 0 && makeCurrent()) {
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, slot->metadataTexture);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, slot->texture);
+            }
 
-            for (uint32_t i = 0; i < viewCount && i < eyeSwapchains_.size(); ++i) {
+            for (uint32_t i = 0; i < renderViewCount && i < eyeSwapchains_.size(); ++i) {
                 auto& eye = eyeSwapchains_[i];
+                const XrExtent2Di renderExtent =
+                    ScaledExtent(eye.width, eye.height, resolutionScale_);
 
                 XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
                 uint32_t imageIndex = 0;
@@ -1338,6 +2356,26 @@ bool XrStereoRenderer::renderFrame() {
                     continue;
                 }
 
+                // Head-locked classic content never submits depth, so it keeps the
+                // renderbuffer and leaves the depth swapchain alone.
+                uint32_t depthImageIndex = 0;
+                bool depthAcquired = false;
+                if (submitDepth && eye.depthHandle != XR_NULL_HANDLE) {
+                    result =
+                        xrAcquireSwapchainImage(eye.depthHandle, &acquireInfo, &depthImageIndex);
+                    if (XR_FAILED(result)) {
+                        setError("xrAcquireSwapchainImage(depth)", result);
+                    } else {
+                        // Only a waited image may be released; after a failed wait it stays
+                        // acquired and this eye falls back to the renderbuffer.
+                        result = xrWaitSwapchainImage(eye.depthHandle, &waitImageInfo);
+                        depthAcquired = XR_SUCCEEDED(result);
+                        if (!depthAcquired) {
+                            setError("xrWaitSwapchainImage(depth)", result);
+                        }
+                    }
+                }
+
                 if (makeCurrent()) {
                     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
                     glFramebufferTexture2D(
@@ -1347,7 +2385,14 @@ bool XrStereoRenderer::renderFrame() {
                         eye.images[imageIndex].image,
                         0);
 
-                    if (depthRenderbuffer_ != 0 &&
+                    if (depthAcquired) {
+                        glFramebufferTexture2D(
+                            GL_FRAMEBUFFER,
+                            eye.depthHasStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                            GL_TEXTURE_2D,
+                            eye.depthImages[depthImageIndex].image,
+                            0);
+                    } else if (depthRenderbuffer_ != 0 &&
                         (depthBufferWidth_ != eye.width || depthBufferHeight_ != eye.height)) {
                         glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer_);
                         glRenderbufferStorage(
@@ -1355,7 +2400,7 @@ bool XrStereoRenderer::renderFrame() {
                         depthBufferWidth_ = eye.width;
                         depthBufferHeight_ = eye.height;
                     }
-                    if (depthRenderbuffer_ != 0) {
+                    if (!depthAcquired && depthRenderbuffer_ != 0) {
                         glFramebufferRenderbuffer(
                             GL_FRAMEBUFFER,
                             GL_DEPTH_ATTACHMENT,
@@ -1363,148 +2408,196 @@ bool XrStereoRenderer::renderFrame() {
                             depthRenderbuffer_);
                     }
 
-                    glViewport(0, 0, eye.width, eye.height);
+                    if (i == 0) {
+                        beginGpuTimer(GpuTimedPath::None);
+                    }
+
+                    // Only the scaled sub-rect is cleared and drawn; the compositor samples
+                    // just that region via imageRect.
+                    glViewport(0, 0, renderExtent.width, renderExtent.height);
+                    glEnable(GL_SCISSOR_TEST);
+                    glScissor(0, 0, renderExtent.width, renderExtent.height);
                     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                    glDepthMask(GL_TRUE);
+                    glClearDepthf(1.0f);
                     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    // With a depth swapchain every path writes real depth so the compositor
+                    // can reproject positionally; layers still draw far-to-near.
+                    if (depthAcquired) {
+                        glEnable(GL_DEPTH_TEST);
+                        glDepthFunc(GL_LEQUAL);
+                    } else {
+                        glDisable(GL_DEPTH_TEST);
+                    }
 
-                    if (frameReady_) {
+                    if (frameReady) {
                         glUseProgram(program_);
                         const bool metadataAligned =
-                            metadataReady_ && metadataWidth_ == frameWidth_ &&
-                            metadataHeight_ == frameHeight_;
-                        renderDebugState_.metadataAligned = metadataAligned;
+                            slot->metadataReady && slot->metadataWidth == slot->width &&
+                            slot->metadataHeight == slot->height;
+                        frameDebug_.metadataAligned = metadataAligned;
+                        const bool depthSceneReady = inputs.depthMetadataEnabled &&
+                                                     metadataAligned && slot->layerDataReady &&
+                                                     slot->sideBySide && !inputs.overlayVisible;
+                        const bool useDisplacedMesh =
+                            depthSceneReady &&
+                            inputs.depthRenderMode == DepthRenderMode::DisplacedMesh &&
+                            meshProgram_ != 0;
                         const bool useLayerRendering =
-                            depthMetadataEnabled_ && metadataAligned && layerDataReady_ &&
-                            sideBySideFrame_ && !overlayVisible_ &&
-                            i < eyeLayers_.size() && !eyeLayers_[i].empty();
-
-                        glActiveTexture(GL_TEXTURE0);
-                        glBindTexture(GL_TEXTURE_2D, emuTexture_);
-                        glUniform1i(uniformTexture_, 0);
-                        glActiveTexture(GL_TEXTURE1);
-                        glBindTexture(GL_TEXTURE_2D, worldTexture_);
-                        glUniform1i(uniformWorldTexture_, 1);
-                        glActiveTexture(GL_TEXTURE0);
-
-                        glVertexAttribPointer(
-                            0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), quadVertices);
-                        glEnableVertexAttribArray(0);
-                        glVertexAttribPointer(
-                            1,
-                            2,
-                            GL_FLOAT,
-                            GL_FALSE,
-                            5 * sizeof(GLfloat),
-                            reinterpret_cast<const void*>(quadVertices + 3));
-                        glEnableVertexAttribArray(1);
-
-                        const Mat4 projection =
-                            Mat4PerspectiveFromFov(views_[i].fov, 0.05f, 100.0f);
-                        const Mat4 view = Mat4ViewFromPose(views_[i].pose);
-                        const Mat4 walkRotation = Mat4Multiply(
-                            Mat4RotationY(-walkThroughYaw_), Mat4RotationX(-walkThroughPitch_));
-                        const Mat4 navigation = Mat4Multiply(
-                            Mat4Translation(worldAnchor.x, worldAnchor.y, worldAnchor.z),
-                            Mat4Multiply(
-                                walkRotation,
-                                Mat4Translation(
-                                    -walkThroughOffset_.x,
-                                    -walkThroughOffset_.y,
-                                    -walkThroughOffset_.z)));
-
-                        if (useLayerRendering) {
+                            depthSceneReady && !useDisplacedMesh && i < slot->eyeLayers.size() &&
+                            !slot->eyeLayers[i].empty();
+                        if (i == 0 && (useDisplacedMesh || useLayerRendering)) {
+                            tagGpuTimer(
+                                useDisplacedMesh ? GpuTimedPath::DisplacedMesh
+                                                 : GpuTimedPath::Layers);
+                        }
+
+                        const Mat4 projectionViewNavigation = Mat4Multiply(
+                            eyeProjection(eye, views_[i].fov),
+                            Mat4Multiply(Mat4ViewFromPose(views_[i].pose), navigation));
+                        const float eyeUvOffset = i == 0 ? 0.0f : 0.5f;
+
+                        DrawUniforms draw;
+                        beginDrawUniforms();
+                        if (useDisplacedMesh) {
                             if (i == 0) {
-                                renderDebugState_.usedLayerRendering = true;
+                                frameDebug_.usedDisplacedMesh = true;
                             }
-                            glDisable(GL_DEPTH_TEST);
-                            glUniform2f(uniformUvScale_, 0.5f, 1.0f);
-                            glUniform2f(uniformUvOffset_, i == 0 ? 0.0f : 0.5f, 0.0f);
-                            glUniform1f(uniformUseWorldMask_, 1.0f);
-
-                            for (const auto& layer : eyeLayers_[i]) {
-                                const float halfSize = screenScale * layer.z;
-                                const Mat4 model = Mat4Multiply(
-                                    navigation,
-                                    Mat4Multiply(
-                                        Mat4Translation(0.0f, 0.0f, -layer.z),
-                                        Mat4Scale(halfSize, halfSize, 1.0f)));
-                                const Mat4 viewModel = Mat4Multiply(view, model);
-                                const Mat4 mvp = Mat4Multiply(projection, viewModel);
-                                glUniformMatrix4fv(uniformMvp_, 1, GL_FALSE, mvp.m);
-                                glUniform1f(uniformLayerWorld_, static_cast<float>(layer.worldId));
-                                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                            draw.mvp = projectionViewNavigation;
+                            draw.uvTransform[0] = 0.5f;
+                            draw.uvTransform[2] = eyeUvOffset;
+                            draw.depthRange[0] = kLayerNearZ;
+                            draw.depthRange[1] = kLayerFarZ;
+                            draw.depthRange[2] = screenScale;
+                            addDrawUniforms(draw);
+                        } else if (useLayerRendering) {
+                            if (i == 0) {
+                                frameDebug_.usedLayerRendering = true;
+                            }
+                            draw.uvTransform[0] = 0.5f;
+                            draw.uvTransform[2] = eyeUvOffset;
+                            draw.worldMask[0] = 1.0f;
+                            for (const auto& layer : slot->eyeLayers[i]) {
+                                draw.mvp = Mat4MultiplyQuadPlacement(
+                                    projectionViewNavigation, -layer.z, screenScale * layer.z);
+                                draw.worldMask[1] = static_cast<float>(layer.worldId);
+                                addDrawUniforms(draw);
                             }
-                        } else if (depthMetadataEnabled_) {
+                        } else if (inputs.depthMetadataEnabled) {
                             if (i == 0) {
-                                renderDebugState_.usedDepthFallback = true;
+                                frameDebug_.usedDepthFallback = true;
                             }
-                            glDisable(GL_DEPTH_TEST);
-                            const float halfSize = screenScale * kDepthFallbackZ;
-                            const Mat4 model = Mat4Multiply(
-                                navigation,
-                                Mat4Multiply(
-                                    Mat4Translation(0.0f, 0.0f, -kDepthFallbackZ),
-                                    Mat4Scale(halfSize, halfSize, 1.0f)));
-                            const Mat4 mvp = Mat4Multiply(projection, Mat4Multiply(view, model));
-                            glUniformMatrix4fv(uniformMvp_, 1, GL_FALSE, mvp.m);
-                            glUniform1f(uniformUseWorldMask_, 0.0f);
-                            glUniform1f(uniformLayerWorld_, -1.0f);
-                            if (sideBySideFrame_) {
-                                glUniform2f(uniformUvScale_, 0.5f, 1.0f);
-                                glUniform2f(uniformUvOffset_, i == 0 ? 0.0f : 0.5f, 0.0f);
-                            } else {
-                                glUniform2f(uniformUvScale_, 1.0f, 1.0f);
-                                glUniform2f(uniformUvOffset_, 0.0f, 0.0f);
+                            draw.mvp = Mat4MultiplyQuadPlacement(
+                                projectionViewNavigation,
+                                -kDepthFallbackZ,
+                                screenScale * kDepthFallbackZ);
+                            if (slot->sideBySide) {
+                                draw.uvTransform[0] = 0.5f;
+                                draw.uvTransform[2] = eyeUvOffset;
                             }
-                            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                            addDrawUniforms(draw);
                         } else {
                             if (i == 0) {
-                                renderDebugState_.usedClassic = true;
+                                frameDebug_.usedClassic = true;
                             }
-                            glDisable(GL_DEPTH_TEST);
-                            if (worldAnchoredEnabled_) {
-                                const float halfSize = screenScale * kClassicAnchoredZ;
-                                const Mat4 model = Mat4Multiply(
-                                    navigation,
-                                    Mat4Multiply(
-                                        Mat4Translation(0.0f, 0.0f, -kClassicAnchoredZ),
-                                        Mat4Scale(halfSize, halfSize, 1.0f)));
-                                const Mat4 mvp =
-                                    Mat4Multiply(projection, Mat4Multiply(view, model));
-                                glUniformMatrix4fv(uniformMvp_, 1, GL_FALSE, mvp.m);
-                            } else {
-                                const Mat4 modelScale = Mat4Scale(screenScale, screenScale, 1.0f);
-                                glUniformMatrix4fv(uniformMvp_, 1, GL_FALSE, modelScale.m);
-                            }
-                            glUniform1f(uniformUseWorldMask_, 0.0f);
-                            glUniform1f(uniformLayerWorld_, -1.0f);
-                            if (sideBySideFrame_) {
+                            draw.mvp = inputs.worldAnchoredEnabled
+                                           ? Mat4MultiplyQuadPlacement(
+                                                 projectionViewNavigation,
+                                                 -kClassicAnchoredZ,
+                                                 screenScale * kClassicAnchoredZ)
+                                           : Mat4Scale(screenScale, screenScale, 1.0f);
+                            if (slot->sideBySide) {
                                 const float leftOffset = stereoConvergence;
                                 const float rightOffset = 0.5f - stereoConvergence;
-                                glUniform2f(uniformUvScale_, 0.5f, 1.0f);
-                                glUniform2f(
-                                    uniformUvOffset_, i == 0 ? leftOffset : rightOffset, 0.0f);
-                            } else {
-                                glUniform2f(uniformUvScale_, 1.0f, 1.0f);
-                                glUniform2f(uniformUvOffset_, 0.0f, 0.0f);
+                                draw.uvTransform[0] = 0.5f;
+                                draw.uvTransform[2] = i == 0 ? leftOffset : rightOffset;
+                            }
+                            addDrawUniforms(draw);
+                        }
+                        uploadDrawUniforms(eye);
+
+                        if (useDisplacedMesh) {
+                            // One draw replaces the per-world layer stack; the depth test
+                            // resolves folds where nearer pixels overlap farther ones.
+                            glEnable(GL_DEPTH_TEST);
+                            glDepthFunc(GL_LEQUAL);
+                            glUseProgram(meshProgram_);
+                            bindDrawUniforms(eye, 0);
+                            glBindVertexArray(meshVertexArray_);
+                            glDrawElements(
+                                GL_TRIANGLES, meshIndexCount_, GL_UNSIGNED_SHORT, nullptr);
+                        } else {
+                            glBindVertexArray(quadVertexArray_);
+                            for (size_t d = 0; d < drawUniformCount_; ++d) {
+                                bindDrawUniforms(eye, d);
+                                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
                             }
-                            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
                         }
+                        glBindVertexArray(0);
                     }
 
+                    glDisable(GL_SCISSOR_TEST);
+                    if (depthAcquired) {
+                        glFramebufferTexture2D(
+                            GL_FRAMEBUFFER,
+                            eye.depthHasStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                            GL_TEXTURE_2D,
+                            0,
+                            0);
+                    }
                     glBindFramebuffer(GL_FRAMEBUFFER, 0);
                 }
 
                 XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
                 xrReleaseSwapchainImage(eye.handle, &releaseInfo);
+                if (depthAcquired) {
+                    xrReleaseSwapchainImage(eye.depthHandle, &releaseInfo);
+                }
 
                 projectionViews[i].pose = views_[i].pose;
                 projectionViews[i].fov = views_[i].fov;
                 projectionViews[i].subImage.swapchain = eye.handle;
                 projectionViews[i].subImage.imageRect.offset = {0, 0};
-                projectionViews[i].subImage.imageRect.extent = {eye.width, eye.height};
+                projectionViews[i].subImage.imageRect.extent = renderExtent;
+
+                if (depthAcquired) {
+                    auto& depthInfo = depthInfos[i];
+                    depthInfo.subImage.swapchain = eye.depthHandle;
+                    depthInfo.subImage.imageRect = projectionViews[i].subImage.imageRect;
+                    depthInfo.subImage.imageArrayIndex = 0;
+                    depthInfo.minDepth = 0.0f;
+                    depthInfo.maxDepth = 1.0f;
+                    depthInfo.nearZ = kProjectionNearZ;
+                    depthInfo.farZ = kProjectionFarZ;
+                    projectionViews[i].next = &depthInfo;
+                    if (i == 0) {
+                        frameDebug_.depthSubmitted = true;
+                    }
+                }
+                ++renderedViews;
             }
 
+            endGpuTimer();
+            if (!reuseFrame) {
+                if (renderedViews == viewCount) {
+                    storeStaticFrame(inputs, slot, projectionViews, depthInfos);
+                } else {
+                    staticFrame_.valid = false;
+                }
+            }
+            if (frameReady && !reuseFrame) {
+                // Fence the reads of this slot so the upload context can safely overwrite it.
+                GLsync releaseFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                glFlush();
+                GLsync previousFence = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex_);
+                    previousFence = std::exchange(slot->releaseFence, releaseFence);
+                }
+                if (previousFence != nullptr) {
+                    glDeleteSync(previousFence);
+                }
+            }
             projectionLayer.space = appSpace_;
             projectionLayer.viewCount = static_cast<uint32_t>(projectionViews.size());
             projectionLayer.views = projectionViews.data();
@@ -1526,6 +2619,34 @@ bool XrStereoRenderer::renderFrame() {
     }
 
     result = xrEndFrame(session_, &endInfo);
+
+    float refreshHz = displayRefreshHz_.load();
+    if (refreshHz <= 0.0f && frameState.predictedDisplayPeriod > 0) {
+        refreshHz = 1.0e9f / static_cast<float>(frameState.predictedDisplayPeriod);
+    }
+    if (std::abs(refreshHz - cadenceRefreshHz_) > 0.5f) {
+        cadenceStats_.reset(refreshHz, kVbRefreshHz);
+        cadenceRefreshHz_ = refreshHz;
+    }
+    if (XR_SUCCEEDED(result) && frameState.shouldRender) {
+        cadenceStats_.recordDisplayFrame(newSourceFrame);
+        if (newSourceFrame && slot != nullptr && slot->inputSampleNs > 0) {
+            const int64_t displayNs = steadyTimeFromXrTime(frameState.predictedDisplayTime);
+            if (displayNs > slot->inputSampleNs) {
+                SmoothTimeMs(
+                    inputLatencyMs_, static_cast<float>(displayNs - slot->inputSampleNs) / 1.0e6f);
+            }
+        }
+    }
+    frameDebug_.displayRefreshHz = refreshHz;
+    frameDebug_.cadenceRepeats = cadenceStats_.expectedRepeats();
+    frameDebug_.judderPercent = cadenceStats_.judderPercent();
+    frameDebug_.droppedSourceFrames = droppedSourceFrames_.load();
+    frameDebug_.inputLatencyMs = inputLatencyMs_;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        renderDebugState_ = frameDebug_;
+    }
     if (XR_FAILED(result)) {
         setError("xrEndFrame", result);
         return false;
@@ -1538,21 +2659,59 @@ void XrStereoRenderer::shutdown() {
     if (sessionRunning_) {
         endSession();
     }
+    stopFramePipeline();
 
     destroyInputActions();
 
+    // The render thread has released eglContext_; take it back to delete its objects.
+    makeCurrent();
     if (framebuffer_ != 0) {
         glDeleteFramebuffers(1, &framebuffer_);
         framebuffer_ = 0;
     }
-    if (emuTexture_ != 0) {
-        glDeleteTextures(1, &emuTexture_);
-        emuTexture_ = 0;
+    for (auto& slot : frameSlots_) {
+        if (slot.texture != 0) {
+            glDeleteTextures(1, &slot.texture);
+        }
+        if (slot.metadataTexture != 0) {
+            glDeleteTextures(1, &slot.metadataTexture);
+        }
+        if (slot.uploadFence != nullptr) {
+            glDeleteSync(slot.uploadFence);
+        }
+        if (slot.releaseFence != nullptr) {
+            glDeleteSync(slot.releaseFence);
+        }
+        slot = FrameSlot{};
+    }
+    stagingSlot_ = -1;
+    publishedSlot_ = -1;
+    renderSlot_ = -1;
+    if (quadVertexArray_ != 0) {
+        glDeleteVertexArrays(1, &quadVertexArray_);
+        quadVertexArray_ = 0;
+    }
+    if (quadVertexBuffer_ != 0) {
+        glDeleteBuffers(1, &quadVertexBuffer_);
+        quadVertexBuffer_ = 0;
+    }
+    if (meshVertexArray_ != 0) {
+        glDeleteVertexArrays(1, &meshVertexArray_);
+        meshVertexArray_ = 0;
+    }
+    if (meshVertexBuffer_ != 0) {
+        glDeleteBuffers(1, &meshVertexBuffer_);
+        meshVertexBuffer_ = 0;
     }
-    if (worldTexture_ != 0) {
-        glDeleteTextures(1, &worldTexture_);
-        worldTexture_ = 0;
+    if (meshIndexBuffer_ != 0) {
+        glDeleteBuffers(1, &meshIndexBuffer_);
+        meshIndexBuffer_ = 0;
     }
+    meshIndexCount_ = 0;
+    if (gpuTimer_.available) {
+        glDeleteQueries(GpuFrameTimer::kQueryCount, gpuTimer_.queries.data());
+    }
+    gpuTimer_ = {};
     if (depthRenderbuffer_ != 0) {
         glDeleteRenderbuffers(1, &depthRenderbuffer_);
         depthRenderbuffer_ = 0;
@@ -1561,6 +2720,10 @@ void XrStereoRenderer::shutdown() {
         glDeleteProgram(program_);
         program_ = 0;
     }
+    if (meshProgram_ != 0) {
+        glDeleteProgram(meshProgram_);
+        meshProgram_ = 0;
+    }
 
     destroySwapchains();
 
@@ -1579,6 +2742,12 @@ void XrStereoRenderer::shutdown() {
 
     if (eglDisplay_ != EGL_NO_DISPLAY) {
         eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (uploadContext_ != EGL_NO_CONTEXT) {
+            eglDestroyContext(eglDisplay_, uploadContext_);
+        }
+        if (uploadSurface_ != EGL_NO_SURFACE) {
+            eglDestroySurface(eglDisplay_, uploadSurface_);
+        }
         if (eglContext_ != EGL_NO_CONTEXT) {
             eglDestroyContext(eglDisplay_, eglContext_);
         }
@@ -1592,37 +2761,48 @@ void XrStereoRenderer::shutdown() {
     eglContext_ = EGL_NO_CONTEXT;
     eglSurface_ = EGL_NO_SURFACE;
     eglConfig_ = nullptr;
+    uploadContext_ = EGL_NO_CONTEXT;
+    uploadSurface_ = EGL_NO_SURFACE;
 
     configViews_.clear();
     views_.clear();
-    lastError_.clear();
+    {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        lastError_.clear();
+    }
 
     initialized_ = false;
     sessionRunning_ = false;
-    frameReady_ = false;
-    metadataReady_ = false;
-    depthMetadataEnabled_ = false;
-    worldAnchoredEnabled_ = false;
-    sideBySideFrame_ = false;
     exitRequested_ = false;
-    frameWidth_ = 0;
-    frameHeight_ = 0;
+    depthLayerSupported_ = false;
+    refreshRateSupported_ = false;
+    convertTimeToTimespec_ = nullptr;
+    inputLatencyMs_ = 0.0f;
+    displayRefreshHz_ = 0.0f;
     metadataWidth_ = 0;
     metadataHeight_ = 0;
     metadataFrameId_ = 0;
-    layerDataReady_ = false;
     depthBufferWidth_ = 0;
     depthBufferHeight_ = 0;
     headOriginSet_ = false;
     headOrigin_ = {};
-    walkThroughOffset_ = {};
-    walkThroughYaw_ = 0.0f;
-    walkThroughPitch_ = 0.0f;
-    worldUpload_.clear();
-    disparityUpload_.clear();
-    eyeLayers_[0].clear();
-    eyeLayers_[1].clear();
-    renderDebugState_ = {};
+    frameDebug_ = {};
+    resolutionScale_ = kMaxResolutionScale;
+    scaledGpuTimeMs_ = 0.0f;
+    resolutionSettleFrames_ = 0;
+    staticFrame_ = {};
+    resetLayerDepthState();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        renderInputs_.depthMetadataEnabled = false;
+        renderInputs_.depthRenderMode = DepthRenderMode::Layers;
+        renderInputs_.worldAnchoredEnabled = false;
+        renderInputs_.resetAnchor = true;
+        renderInputs_.walkThroughOffset = {};
+        renderInputs_.walkThroughYaw = 0.0f;
+        renderInputs_.walkThroughPitch = 0.0f;
+        renderDebugState_ = {};
+    }
     controllerState_ = ControllerState{};
 }
 
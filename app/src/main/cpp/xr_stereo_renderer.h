@@ -2,12 +2,17 @@
 
 #include <android/native_activity.h>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <EGL/egl.h>
-#include <GLES2/gl2.h>
+#include <GLES3/gl3.h>
 
 #ifndef XR_USE_PLATFORM_ANDROID
 #define XR_USE_PLATFORM_ANDROID
@@ -15,9 +20,16 @@
 #ifndef XR_USE_GRAPHICS_API_OPENGL_ES
 #define XR_USE_GRAPHICS_API_OPENGL_ES
 #endif
+#ifndef XR_USE_TIMESPEC
+#define XR_USE_TIMESPEC
+#endif
+#include <time.h>
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
 
+#include "display_timing.h"
+#include "mat4.h"
+
 class XrStereoRenderer {
 public:
     struct ControllerState {
@@ -53,37 +65,79 @@ public:
         bool usedLayerRendering = false;
         bool usedDepthFallback = false;
         bool usedClassic = false;
+        bool usedDisplacedMesh = false;
+        bool depthSubmitted = false;
         bool headOriginSet = false;
         float relativeX = 0.0f;
         float relativeY = 0.0f;
         float relativeZ = 0.0f;
+        bool gpuTimerAvailable = false;
+        float layerGpuTimeMs = 0.0f;
+        float meshGpuTimeMs = 0.0f;
+        float frameGpuTimeMs = 0.0f;
+        // Fraction of the recommended eye size currently rendered (imageRect extent).
+        float resolutionScale = 1.0f;
+        bool reusedPreviousFrame = false;
+        uint32_t reusedFrameCount = 0;
+        float displayRefreshHz = 0.0f;
+        // Refreshes each source frame should stay up for, and how often it did not.
+        int cadenceRepeats = 1;
+        float judderPercent = 0.0f;
+        uint32_t droppedSourceFrames = 0;
+        // Smoothed time from the input sample a source frame saw to its predicted display time;
+        // zero until measured (needs XR_KHR_convert_timespec_time).
+        float inputLatencyMs = 0.0f;
+    };
+
+    enum class DepthRenderMode : int {
+        Layers = 0,
+        DisplacedMesh = 1,
     };
 
     bool initialize(ANativeActivity* activity);
     void shutdown();
 
     void pollEvents();
+    // Parks the frame-wait and render threads while the app is paused: the frame in flight is
+    // ended, then neither calls xrWaitFrame until unpaused. Sticks across session restarts.
+    void setFramePipelinePaused(bool paused);
+    // updateFrame/updateDepthMetadata stage one emulator frame on the upload context;
+    // submitFrame hands it to the render thread. Call all three from the emulation thread.
     void updateFrame(const uint32_t* pixels, int width, int height);
+    // depthPlane: width*height RG byte pairs (world id, signed disparity), see
+    // LibretroVbCore::metadataDepthPlane().
     void updateDepthMetadata(
-        const int8_t* disparity,
-        const uint8_t* worldIds,
+        const uint8_t* depthPlane,
         const int16_t* sourceX,
         const int16_t* sourceY,
         int width,
         int height,
         uint32_t frameId);
-    bool renderFrame();
+    // Returns false when XR is not presenting so the caller can use its fallback renderer.
+    // inputSampleNs is the steady-clock time the staged frame's input was read (0: unknown).
+    bool submitFrame(int64_t inputSampleNs = 0);
+    // Re-reads the controller actions; cheap enough to call right before the core polls input.
+    // pollEvents does not sync, so callers sync exactly where they read. Main thread only.
+    void syncInput();
     bool getControllerState(ControllerState& outState) const;
     void setPresentationConfig(float screenScale, float stereoConvergence);
     void setDepthMetadataEnabled(bool enabled);
+    void setDepthRenderMode(DepthRenderMode mode);
+    // On by default; off pins the eye images at the recommended size (reproducible captures).
+    void setDynamicResolutionEnabled(bool enabled);
     void setWorldAnchoredEnabled(bool enabled);
     void resetWorldAnchor();
-    void setOverlayVisible(bool visible) { overlayVisible_ = visible; }
+    void setOverlayVisible(bool visible);
     void setWalkthroughOffset(float x, float y, float z);
     void setWalkthroughRotation(float yaw, float pitch);
-    [[nodiscard]] float screenScale() const { return screenScale_; }
-    [[nodiscard]] float stereoConvergence() const { return stereoConvergence_; }
-    [[nodiscard]] RenderDebugState renderDebugState() const { return renderDebugState_; }
+    [[nodiscard]] float screenScale() const { return renderInputs_.screenScale; }
+    [[nodiscard]] float stereoConvergence() const { return renderInputs_.stereoConvergence; }
+    [[nodiscard]] DepthRenderMode depthRenderMode() const { return renderInputs_.depthRenderMode; }
+    [[nodiscard]] RenderDebugState renderDebugState() const;
+    // Latest display refresh phase; zero while no XR session is running.
+    [[nodiscard]] DisplayPhase displayPhase() const;
+    // Bytes of frame and metadata textures across the frame slots. Upload thread.
+    [[nodiscard]] size_t textureBytes() const;
 
     [[nodiscard]] bool initialized() const { return initialized_; }
     [[nodiscard]] bool sessionRunning() const { return sessionRunning_; }
@@ -91,16 +145,127 @@ public:
     [[nodiscard]] const char* lastError() const { return lastError_.c_str(); }
 
 private:
+    static constexpr int kVipWorldCount = 32;
+
     struct LayerInfo {
         uint8_t worldId = 0xFF;
         float z = 2.0f;
     };
 
+    static bool LayerFarToNear(const LayerInfo& a, const LayerInfo& b) { return a.z > b.z; }
+
+    // Per-world depth carried across frames so layers ease instead of popping.
+    struct WorldDepthState {
+        float z = 0.0f;
+        float targetZ = 0.0f;
+        int absentFrames = 0;
+        bool visible = false;
+    };
+
+    enum class GpuTimedPath : uint8_t {
+        None = 0,
+        Layers,
+        DisplacedMesh,
+    };
+
+    // Ring of GL_EXT_disjoint_timer_query objects, read back a few frames late to avoid stalls.
+    struct GpuFrameTimer {
+        static constexpr int kQueryCount = 4;
+        std::array<GLuint, kQueryCount> queries{};
+        std::array<GpuTimedPath, kQueryCount> paths{};
+        // Resolution scale each query measured; results from an older scale are stale.
+        std::array<float, kQueryCount> scales{};
+        std::array<bool, kQueryCount> pending{};
+        int next = 0;
+        bool active = false;
+        bool available = false;
+    };
+
+    // Presentation settings written by the emulation thread and copied by the render thread
+    // once per frame under stateMutex_.
+    struct RenderInputs {
+        float screenScale = 0.68f;
+        float stereoConvergence = 0.016f;
+        bool depthMetadataEnabled = false;
+        DepthRenderMode depthRenderMode = DepthRenderMode::Layers;
+        bool dynamicResolution = true;
+        bool worldAnchoredEnabled = false;
+        bool overlayVisible = false;
+        bool resetAnchor = true;
+        XrVector3f walkThroughOffset{};
+        float walkThroughYaw = 0.0f;
+        float walkThroughPitch = 0.0f;
+    };
+
+    // One emulator frame in flight between the upload context and the render thread.
+    // uploadFence orders the upload before sampling; releaseFence orders sampling before the
+    // slot is overwritten again.
+    struct FrameSlot {
+        GLuint texture = 0;
+        GLuint metadataTexture = 0;
+        GLsync uploadFence = nullptr;
+        GLsync releaseFence = nullptr;
+        int width = 0;
+        int height = 0;
+        int metadataTextureWidth = 0;
+        int metadataTextureHeight = 0;
+        int metadataWidth = 0;
+        int metadataHeight = 0;
+        uint32_t metadataFrameId = 0;
+        uint64_t pixelHash = 0;
+        uint64_t metadataHash = 0;
+        int64_t inputSampleNs = 0;
+        bool frameReady = false;
+        bool sideBySide = false;
+        bool metadataReady = false;
+        bool layerDataReady = false;
+        std::array<std::vector<LayerInfo>, 2> eyeLayers;
+    };
+
+    // Triple buffering keeps one slot staging, one published and one being rendered.
+    static constexpr int kFrameSlotCount = 3;
+
+    // Everything the last fully rendered frame depended on, plus what was submitted for it.
+    struct StaticFrameCache {
+        bool valid = false;
+        RenderInputs inputs{};
+        float resolutionScale = 1.0f;
+        XrVector3f headOrigin{};
+        bool frameReady = false;
+        uint64_t pixelHash = 0;
+        uint64_t metadataHash = 0;
+        int width = 0;
+        int height = 0;
+        bool metadataReady = false;
+        bool layerDataReady = false;
+        std::array<std::vector<LayerInfo>, 2> eyeLayers;
+        std::vector<XrCompositionLayerProjectionView> views;
+        std::vector<XrCompositionLayerDepthInfoKHR> depthInfos;
+        RenderDebugState debug{};
+    };
+
     struct EyeSwapchain {
         XrSwapchain handle = XR_NULL_HANDLE;
+        XrSwapchain depthHandle = XR_NULL_HANDLE;
         int32_t width = 0;
         int32_t height = 0;
+        bool depthHasStencil = false;
         std::vector<XrSwapchainImageOpenGLESKHR> images;
+        std::vector<XrSwapchainImageOpenGLESKHR> depthImages;
+        // Per-eye DrawParams buffer, re-specified once per rendered eye.
+        GLuint drawUniformBuffer = 0;
+        // Projection depends only on the FOV, which rarely changes between frames.
+        XrFovf projectionFov{};
+        Mat4 projection{};
+        bool projectionValid = false;
+    };
+
+    // std140 image of the DrawParams uniform block.
+    struct DrawUniforms {
+        Mat4 mvp;
+        float uvTransform[4] = {1.0f, 1.0f, 0.0f, 0.0f};
+        float depthRange[4] = {};
+        float worldMask[4] = {0.0f, -1.0f, 0.0f, 0.0f};
     };
 
     bool setError(const char* context, XrResult result);
@@ -111,18 +276,55 @@ private:
     bool createSystem();
     bool createEglContext();
     bool createSession();
+    void selectDisplayRefreshRate();
     bool createInputActions();
     bool suggestInteractionBindings();
     bool createReferenceSpace();
     bool createSwapchains();
+    bool createDepthSwapchain(
+        EyeSwapchain& eye, const XrSwapchainCreateInfo& colorInfo, int64_t depthFormat);
     bool createGlResources();
+    bool createFrameSlot(FrameSlot& slot);
+    bool createDepthMesh();
+    const Mat4& eyeProjection(EyeSwapchain& eye, const XrFovf& fov);
+    void beginDrawUniforms();
+    void addDrawUniforms(const DrawUniforms& draw);
+    void uploadDrawUniforms(EyeSwapchain& eye);
+    void bindDrawUniforms(const EyeSwapchain& eye, size_t index);
+    void beginGpuTimer(GpuTimedPath path);
+    void tagGpuTimer(GpuTimedPath path);
+    void endGpuTimer();
+    void collectGpuTimers();
+    void updateResolutionScale(XrDuration displayPeriod);
     bool beginSession();
     void endSession();
     void destroySwapchains();
     void destroyInputActions();
-    void syncInput();
+    int64_t steadyTimeFromXrTime(XrTime time) const;
+    void resetLayerDepthState();
+    void updateLayerDepths(const uint8_t* depthPlane, int width);
+    bool ensureMetadataTexture(FrameSlot& slot, int width, int height);
+    FrameSlot* acquireStagingSlot();
+    void startFramePipeline();
+    void stopFramePipeline();
+    // Tells the runtime which threads make frames so it can schedule them; no-op without
+    // XR_KHR_android_thread_settings.
+    void registerCurrentThread(XrAndroidThreadTypeKHR type);
+    void frameWaitLoop();
+    void renderLoop();
+    bool renderXrFrame(const XrFrameState& frameState);
+    static bool SameRenderInputs(const RenderInputs& a, const RenderInputs& b);
+    static bool SameLayers(const std::vector<LayerInfo>& a, const std::vector<LayerInfo>& b);
+    bool matchesStaticFrame(
+        const RenderInputs& inputs, const FrameSlot* slot, uint32_t viewCount) const;
+    void storeStaticFrame(
+        const RenderInputs& inputs,
+        const FrameSlot* slot,
+        const std::vector<XrCompositionLayerProjectionView>& projectionViews,
+        const std::vector<XrCompositionLayerDepthInfoKHR>& depthInfos);
 
     bool makeCurrent();
+    bool makeUploadCurrent();
 
     bool getBooleanActionState(XrAction action, XrPath subactionPath = XR_NULL_PATH) const;
     float getFloatActionState(XrAction action, XrPath subactionPath = XR_NULL_PATH) const;
@@ -163,50 +365,81 @@ private:
     EGLContext eglContext_ = EGL_NO_CONTEXT;
     EGLSurface eglSurface_ = EGL_NO_SURFACE;
     EGLConfig eglConfig_ = nullptr;
+    EGLContext uploadContext_ = EGL_NO_CONTEXT;
+    EGLSurface uploadSurface_ = EGL_NO_SURFACE;
 
     GLuint framebuffer_ = 0;
-    GLuint emuTexture_ = 0;
-    GLuint worldTexture_ = 0;
     GLuint depthRenderbuffer_ = 0;
     GLuint program_ = 0;
+    GLuint meshProgram_ = 0;
+    GLuint meshVertexBuffer_ = 0;
+    GLuint meshIndexBuffer_ = 0;
+    GLsizei meshIndexCount_ = 0;
 
-    GLint uniformTexture_ = -1;
-    GLint uniformWorldTexture_ = -1;
-    GLint uniformUvScale_ = -1;
-    GLint uniformUvOffset_ = -1;
-    GLint uniformMvp_ = -1;
-    GLint uniformUseWorldMask_ = -1;
-    GLint uniformLayerWorld_ = -1;
+    GLuint quadVertexArray_ = 0;
+    GLuint quadVertexBuffer_ = 0;
+    GLuint meshVertexArray_ = 0;
+    // Draws of the eye being rendered, packed at drawUniformStride_ (the UBO offset alignment).
+    std::vector<uint8_t> drawUniformStaging_;
+    size_t drawUniformCount_ = 0;
+    GLsizeiptr drawUniformStride_ = 0;
 
     bool initialized_ = false;
     bool sessionRunning_ = false;
-    bool frameReady_ = false;
-    bool metadataReady_ = false;
     bool exitRequested_ = false;
-    bool sideBySideFrame_ = false;
-    int frameWidth_ = 0;
-    int frameHeight_ = 0;
+    bool depthLayerSupported_ = false;
+    bool refreshRateSupported_ = false;
+    PFN_xrConvertTimeToTimespecTimeKHR convertTimeToTimespec_ = nullptr;
+    PFN_xrSetAndroidApplicationThreadKHR setAndroidThread_ = nullptr;
+    ControllerState controllerState_{};
+
+    // Emulation-thread state.
+    int stagingSlot_ = -1;
     int metadataWidth_ = 0;
     int metadataHeight_ = 0;
     uint32_t metadataFrameId_ = 0;
-    float screenScale_ = 0.68f;
-    float stereoConvergence_ = 0.016f;
-    bool depthMetadataEnabled_ = false;
-    bool worldAnchoredEnabled_ = false;
-    bool overlayVisible_ = false;
-    bool layerDataReady_ = false;
+    std::array<std::vector<LayerInfo>, 2> eyeLayers_;
+    std::array<std::array<WorldDepthState, kVipWorldCount>, 2> worldDepth_{};
+
+    // Render-thread state.
     int depthBufferWidth_ = 0;
     int depthBufferHeight_ = 0;
     bool headOriginSet_ = false;
     XrVector3f headOrigin_{};
-    XrVector3f walkThroughOffset_{};
-    float walkThroughYaw_ = 0.0f;
-    float walkThroughPitch_ = 0.0f;
-    ControllerState controllerState_{};
-    std::vector<uint8_t> worldUpload_;
-    std::vector<int8_t> disparityUpload_;
-    std::array<std::vector<LayerInfo>, 2> eyeLayers_;
+    GpuFrameTimer gpuTimer_{};
+    RenderDebugState frameDebug_{};
+    float resolutionScale_ = 1.0f;
+    // GPU time averaged over frames rendered at resolutionScale_ only; restarts on each change.
+    float scaledGpuTimeMs_ = 0.0f;
+    int resolutionSettleFrames_ = 0;
+    StaticFrameCache staticFrame_{};
+    CadenceStats cadenceStats_{};
+    float cadenceRefreshHz_ = 0.0f;
+    float inputLatencyMs_ = 0.0f;
+
+    // Shared between threads, guarded by stateMutex_.
+    mutable std::mutex stateMutex_;
+    RenderInputs renderInputs_{};
+    std::array<FrameSlot, kFrameSlotCount> frameSlots_{};
+    int publishedSlot_ = -1;
+    int renderSlot_ = -1;
     RenderDebugState renderDebugState_{};
 
+    // Frame pacing handoff between the xrWaitFrame thread and the render thread.
+    std::mutex pipelineMutex_;
+    std::condition_variable pipelineCv_;
+    bool stopPipeline_ = false;
+    bool pipelinePaused_ = false;
+    bool frameWaited_ = false;
+    XrFrameState waitedFrameState_{XR_TYPE_FRAME_STATE};
+    std::atomic<bool> presenting_{false};
+    std::atomic<float> displayRefreshHz_{0.0f};
+    std::atomic<int64_t> displayVsyncNs_{0};
+    std::atomic<int64_t> displayPeriodNs_{0};
+    std::atomic<uint32_t> droppedSourceFrames_{0};
+    std::thread frameWaitThread_;
+    std::thread renderThread_;
+
+    std::mutex errorMutex_;
     std::string lastError_;
 };
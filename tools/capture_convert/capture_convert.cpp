@@ -0,0 +1,223 @@
+// Converts a .vbcap gameplay capture (see frame_capture.h) into a standard video: frames are
+// piped to ffmpeg as raw BGRX and the audio goes through a temporary WAV file. Frames the
+// headset dropped repeat the previous picture so audio and video stay in step. Without an
+// output path it only prints the capture's statistics.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame_capture.h"
+
+namespace {
+
+struct Options {
+    std::string inputPath;
+    std::string outputPath;
+    std::string ffmpeg = "ffmpeg";
+};
+
+struct CaptureInfo {
+    int width = 0;
+    int height = 0;
+    uint32_t frames = 0;
+    uint32_t dropped = 0;
+    uint64_t audioFrames = 0;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: capture_convert <capture.vbcap> [<output.mp4>] [--ffmpeg PATH]\n");
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--ffmpeg") {
+            if (i + 1 >= argc) {
+                PrintUsage();
+                return false;
+            }
+            options.ffmpeg = argv[++i];
+        } else if (options.inputPath.empty()) {
+            options.inputPath = arg;
+        } else if (options.outputPath.empty()) {
+            options.outputPath = arg;
+        } else {
+            PrintUsage();
+            return false;
+        }
+    }
+    if (options.inputPath.empty()) {
+        PrintUsage();
+        return false;
+    }
+    return true;
+}
+
+void PutLe(std::vector<uint8_t>& out, const uint32_t value, const int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+std::vector<uint8_t> WavHeader(const int sampleRate, const uint64_t frames) {
+    const auto dataSize = static_cast<uint32_t>(frames * 4);
+    std::vector<uint8_t> header;
+    const char* riff = "RIFF";
+    header.insert(header.end(), riff, riff + 4);
+    PutLe(header, 36 + dataSize, 4);
+    const char* format = "WAVEfmt ";
+    header.insert(header.end(), format, format + 8);
+    PutLe(header, 16, 4);
+    PutLe(header, 1, 2);  // PCM
+    PutLe(header, 2, 2);
+    PutLe(header, static_cast<uint32_t>(sampleRate), 4);
+    PutLe(header, static_cast<uint32_t>(sampleRate) * 4, 4);
+    PutLe(header, 4, 2);
+    PutLe(header, 16, 2);
+    const char* data = "data";
+    header.insert(header.end(), data, data + 4);
+    PutLe(header, dataSize, 4);
+    return header;
+}
+
+// First pass: statistics, and the audio track when wav is not null.
+bool Scan(const std::string& path, FILE* wav, CaptureInfo& info) {
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        std::fprintf(stderr, "%s\n", reader.lastError().c_str());
+        return false;
+    }
+    if (wav != nullptr) {
+        const std::vector<uint8_t> header = WavHeader(reader.audioSampleRate(), 0);
+        std::fwrite(header.data(), 1, header.size(), wav);
+    }
+    int64_t lastIndex = -1;
+    while (true) {
+        const CaptureReader::Item item = reader.next();
+        if (item == CaptureReader::Item::End) {
+            break;
+        }
+        if (item == CaptureReader::Item::Error) {
+            // Keep what decoded; a capture cut short by a crash is still worth watching.
+            std::fprintf(stderr, "stopping at a damaged chunk: %s\n", reader.lastError().c_str());
+            break;
+        }
+        if (item == CaptureReader::Item::Audio) {
+            const auto& samples = reader.audioSamples();
+            info.audioFrames += samples.size() / 2;
+            if (wav != nullptr) {
+                std::fwrite(samples.data(), sizeof(int16_t), samples.size(), wav);
+            }
+            continue;
+        }
+        if (info.frames == 0) {
+            info.width = reader.frameWidth();
+            info.height = reader.frameHeight();
+        }
+        ++info.frames;
+        info.dropped += static_cast<uint32_t>(reader.frameIndex() - lastIndex - 1);
+        lastIndex = reader.frameIndex();
+    }
+    if (wav != nullptr) {
+        const std::vector<uint8_t> header = WavHeader(reader.audioSampleRate(), info.audioFrames);
+        std::fseek(wav, 0, SEEK_SET);
+        std::fwrite(header.data(), 1, header.size(), wav);
+    }
+    std::printf("%s: %dx%d at %.2f Hz, %u frames (%u dropped), %.1f s of %d Hz audio\n",
+                path.c_str(), info.width, info.height, reader.frameRateHz(), info.frames,
+                info.dropped, static_cast<double>(info.audioFrames) / reader.audioSampleRate(),
+                reader.audioSampleRate());
+    return info.frames > 0;
+}
+
+// Second pass: every frame slot of the capture, at the first frame's size.
+bool PipeVideo(const std::string& path, const CaptureInfo& info, FILE* pipe) {
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    std::vector<uint32_t> canvas(static_cast<size_t>(info.width) * info.height, 0xFF000000u);
+    int64_t lastIndex = -1;
+    uint32_t written = 0;
+    while (written < info.frames) {
+        const CaptureReader::Item item = reader.next();
+        if (item == CaptureReader::Item::End || item == CaptureReader::Item::Error) {
+            break;
+        }
+        if (item != CaptureReader::Item::Frame) {
+            continue;
+        }
+        for (int64_t i = lastIndex + 1; i < reader.frameIndex() && lastIndex >= 0; ++i) {
+            std::fwrite(canvas.data(), sizeof(uint32_t), canvas.size(), pipe);
+        }
+        const int copyWidth = std::min(info.width, reader.frameWidth());
+        const int copyHeight = std::min(info.height, reader.frameHeight());
+        for (int y = 0; y < copyHeight; ++y) {
+            std::memcpy(canvas.data() + static_cast<size_t>(y) * info.width,
+                        reader.framePixels().data() + static_cast<size_t>(y) * reader.frameWidth(),
+                        static_cast<size_t>(copyWidth) * sizeof(uint32_t));
+        }
+        if (std::fwrite(canvas.data(), sizeof(uint32_t), canvas.size(), pipe) != canvas.size()) {
+            std::fprintf(stderr, "ffmpeg stopped reading\n");
+            return false;
+        }
+        lastIndex = reader.frameIndex();
+        ++written;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    CaptureInfo info;
+    if (options.outputPath.empty()) {
+        return Scan(options.inputPath, nullptr, info) ? 0 : 1;
+    }
+
+    const std::string wavPath = options.outputPath + ".audio.wav";
+    FILE* wav = std::fopen(wavPath.c_str(), "wb");
+    if (wav == nullptr) {
+        std::fprintf(stderr, "cannot create %s\n", wavPath.c_str());
+        return 1;
+    }
+    const bool scanned = Scan(options.inputPath, wav, info);
+    std::fclose(wav);
+    if (!scanned) {
+        std::remove(wavPath.c_str());
+        return 1;
+    }
+
+    CaptureReader header;
+    header.open(options.inputPath);
+    char command[1024];
+    std::snprintf(command, sizeof(command),
+                  "\"%s\" -loglevel error -y -f rawvideo -pix_fmt bgr0 -video_size %dx%d "
+                  "-framerate %.3f -i - -i \"%s\" -c:v libx264 -preset veryfast -crf 16 "
+                  "-pix_fmt yuv420p -c:a aac \"%s\"",
+                  options.ffmpeg.c_str(), info.width, info.height, header.frameRateHz(),
+                  wavPath.c_str(), options.outputPath.c_str());
+    FILE* pipe = popen(command, "w");
+    if (pipe == nullptr) {
+        std::fprintf(stderr, "cannot run %s\n", options.ffmpeg.c_str());
+        std::remove(wavPath.c_str());
+        return 1;
+    }
+    const bool piped = PipeVideo(options.inputPath, info, pipe);
+    const int status = pclose(pipe);
+    std::remove(wavPath.c_str());
+    if (!piped || status != 0) {
+        std::fprintf(stderr, "ffmpeg failed (status %d)\n", status);
+        return 1;
+    }
+    std::printf("wrote %s\n", options.outputPath.c_str());
+    return 0;
+}
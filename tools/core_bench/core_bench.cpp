@@ -0,0 +1,186 @@
+// Headless Beetle VB runner: replays an input movie through LibretroVbCore with no video or
+// audio output and reports emulated frames per second. tools/pgo/pgo.sh uses it both to train
+// PGO profiles and to benchmark the optimized core against the plain one; golden_suite.sh uses
+// --trace and --golden to prove core changes bit-exact. It also reports the bytes each holder
+// keeps in the frame buffer pool.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "frame_trace.h"
+#include "input_movie.h"
+#include "libretro_vb_core.h"
+#include "log.h"
+#include "thread_policy.h"
+#include "xxhash64.h"
+
+namespace {
+
+constexpr uint32_t kDefaultFrames = 3000;
+constexpr uint32_t kDefaultWarmupFrames = 120;
+constexpr double kVbFrameRate = 50.27;
+constexpr size_t kAudioDrainFrames = 4096;
+
+struct Options {
+    std::string romPath;
+    std::string moviePath;
+    uint32_t frames = kDefaultFrames;
+    uint32_t warmupFrames = kDefaultWarmupFrames;
+    // Per-frame hashes are written to tracePath and/or checked against goldenPath.
+    std::string tracePath;
+    std::string goldenPath;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: core_bench --rom <file.vb> [--movie <movie.txt>] [--frames N] "
+                 "[--warmup N] [--trace <out.trace>] [--golden <golden.trace>]\n");
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--rom") {
+            options.romPath = value;
+        } else if (arg == "--movie") {
+            options.moviePath = value;
+        } else if (arg == "--frames") {
+            options.frames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--warmup") {
+            options.warmupFrames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--trace") {
+            options.tracePath = value;
+        } else if (arg == "--golden") {
+            options.goldenPath = value;
+        } else {
+            PrintUsage();
+            return false;
+        }
+    }
+    if (options.romPath.empty() || options.frames <= options.warmupFrames) {
+        PrintUsage();
+        return false;
+    }
+    return true;
+}
+
+uint64_t HashFrame(const LibretroVbCore& core) {
+    if (!core.hasFrame()) {
+        return 0;
+    }
+    const std::vector<uint32_t>& pixels = core.framePixels();
+    return XxHash64(pixels.data(), pixels.size() * sizeof(uint32_t));
+}
+
+std::string Basename(const std::string& path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    InputMovie movie;
+    std::string error;
+    if (!options.moviePath.empty() && !movie.load(options.moviePath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    // Same placement as the app's emulation thread, so device numbers match what it sees.
+    ApplyThreadPolicy(ThreadRole::Emulation);
+
+    LibretroVbCore core;
+    uint32_t frame = 0;
+    core.initialize();
+    core.setInputPoller([&movie, &frame] { return movie.stateAt(frame); });
+    if (!core.loadRomFromFile(options.romPath)) {
+        FlushLog();
+        std::fprintf(stderr, "%s\n", core.lastError().c_str());
+        return 1;
+    }
+
+    FrameTrace golden;
+    if (!options.goldenPath.empty() && !golden.load(options.goldenPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    const bool tracing = !options.tracePath.empty() || !options.goldenPath.empty();
+    FrameTrace trace;
+    std::vector<int16_t> frameAudio;
+
+    std::vector<int16_t> audio(kAudioDrainFrames * 2);
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point timedStart{};
+    for (frame = 0; frame < options.frames; ++frame) {
+        if (frame == options.warmupFrames) {
+            timedStart = Clock::now();
+        }
+        core.runFrame();
+        // The app drains audio every frame too; an undrained queue would trim itself instead.
+        frameAudio.clear();
+        while (true) {
+            const size_t drained = core.drainAudioFrames(audio.data(), kAudioDrainFrames);
+            if (tracing) {
+                frameAudio.insert(frameAudio.end(), audio.begin(), audio.begin() + drained * 2);
+            }
+            if (drained < kAudioDrainFrames) {
+                break;
+            }
+        }
+        if (tracing) {
+            trace.add(HashFrame(core),
+                      XxHash64(frameAudio.data(), frameAudio.size() * sizeof(int16_t)));
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - timedStart).count();
+    const uint32_t timedFrames = options.frames - options.warmupFrames;
+    const double fps = timedFrames / seconds;
+    const uint64_t hash = HashFrame(core);
+    const FrameBufferPool& pool = core.framePool();
+    const FrameBufferPool::Usage memory = pool.usage();
+    core.shutdown();
+    FlushLog();
+
+    std::printf("%u frames in %.1f ms: %.1f frames/s (%.1fx real time)\n", timedFrames,
+                seconds * 1000.0, fps, fps / kVbFrameRate);
+    // Stable lines for scripts.
+    std::printf("fps %.1f\n", fps);
+    std::printf("hash %016llx\n", static_cast<unsigned long long>(hash));
+    std::printf("frame buffers: %.2f MB for %dx%d frames, %u growths\n",
+                static_cast<double>(memory.totalBytes) / (1024.0 * 1024.0), pool.maxWidth(),
+                pool.maxHeight(), memory.growths);
+    for (size_t i = 0; i < kFrameBufferUseCount; ++i) {
+        std::printf("mem %s %zu\n", FrameBufferUseName(static_cast<FrameBufferUse>(i)),
+                    memory.bytes[i]);
+    }
+
+    if (!options.tracePath.empty()) {
+        const std::string comment = "rom " + Basename(options.romPath) + " movie " +
+                                    (options.moviePath.empty() ? "-" : Basename(options.moviePath));
+        if (!trace.save(options.tracePath, comment, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    if (!options.goldenPath.empty()) {
+        const std::string difference = trace.compare(golden);
+        std::printf("golden %s\n", difference.empty() ? "match" : difference.c_str());
+        return difference.empty() ? 0 : 1;
+    }
+    return 0;
+}
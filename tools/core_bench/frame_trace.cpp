@@ -0,0 +1,81 @@
+#include "frame_trace.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+bool FrameTrace::load(const std::string& path, std::string& outError) {
+    entries_.clear();
+    std::ifstream in(path);
+    if (!in.good()) {
+        outError = "cannot read trace " + path;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        uint32_t frame = 0;
+        Entry entry;
+        if (std::sscanf(line.c_str(), "%" SCNu32 " %" SCNx64 " %" SCNx64, &frame, &entry.video,
+                        &entry.audio) != 3 ||
+            frame != entries_.size()) {
+            outError = path + ":" + std::to_string(lineNumber) + ": bad trace line";
+            return false;
+        }
+        entries_.push_back(entry);
+    }
+    return true;
+}
+
+bool FrameTrace::save(const std::string& path, const std::string& comment,
+                      std::string& outError) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        outError = "cannot write trace " + path;
+        return false;
+    }
+    std::fprintf(file, "# %s\n", comment.c_str());
+    for (size_t frame = 0; frame < entries_.size(); ++frame) {
+        std::fprintf(file, "%zu %016" PRIx64 " %016" PRIx64 "\n", frame, entries_[frame].video,
+                     entries_[frame].audio);
+    }
+    if (std::fclose(file) != 0) {
+        outError = "cannot write trace " + path;
+        return false;
+    }
+    return true;
+}
+
+std::string FrameTrace::compare(const FrameTrace& golden) const {
+    const auto& expected = golden.entries();
+    if (entries_.size() < expected.size()) {
+        return "ran " + std::to_string(entries_.size()) + " frames, golden has " +
+               std::to_string(expected.size());
+    }
+    size_t mismatches = 0;
+    std::string first;
+    for (size_t frame = 0; frame < expected.size(); ++frame) {
+        const bool video = entries_[frame].video != expected[frame].video;
+        const bool audio = entries_[frame].audio != expected[frame].audio;
+        if (!video && !audio) {
+            continue;
+        }
+        if (mismatches++ == 0) {
+            const char* what = video && audio ? "video and audio differ"
+                               : video        ? "video differs"
+                                              : "audio differs";
+            first = "frame " + std::to_string(frame) + ": " + what;
+        }
+    }
+    if (mismatches == 0) {
+        return {};
+    }
+    std::ostringstream out;
+    out << first << " (" << mismatches << " of " << expected.size() << " frames differ)";
+    return out.str();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-frame XXH64 hashes of the core's video frame and of the audio drained during that frame.
+// Text, so a changed golden diffs readably:
+//   # comment lines (ROM, movie)
+//   <frame> <video hash> <audio hash>
+class FrameTrace {
+public:
+    struct Entry {
+        uint64_t video = 0;
+        uint64_t audio = 0;
+    };
+
+    void clear() { entries_.clear(); }
+    void add(const uint64_t video, const uint64_t audio) { entries_.push_back({video, audio}); }
+    bool load(const std::string& path, std::string& outError);
+    bool save(const std::string& path, const std::string& comment, std::string& outError) const;
+
+    // Describes the first difference from golden, or returns an empty string when the traces
+    // match over golden's length.
+    [[nodiscard]] std::string compare(const FrameTrace& golden) const;
+
+    [[nodiscard]] const std::vector<Entry>& entries() const { return entries_; }
+
+private:
+    std::vector<Entry> entries_;
+};
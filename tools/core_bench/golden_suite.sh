@@ -0,0 +1,79 @@
+#!/usr/bin/env bash
+# Golden frame-hash suite: replays every movie in tools/core_bench/movies on each ROM through
+# core_bench and compares per-frame hashes of the video frame and the drained audio with the
+# stored traces. The libretro core is process-global, so runs go to one core_bench process
+# each, JOBS at a time.
+#
+#   tools/core_bench/golden_suite.sh [--update] <rom.vb>...
+#
+# Traces are <rom>.<movie>.trace in GOLDEN_DIR (default tools/core_bench/golden); --update
+# rewrites them from the current build, so run it on a known-good tree. Environment:
+# CORE_BENCH (default build/core_bench/core_bench, rebuilt first so the traces check the tree
+# as it is; a binary given here is used as is), FRAMES (default 1800), JOBS (default: all CPUs).
+set -euo pipefail
+
+update=0
+if [[ ${1:-} == --update ]]; then
+    update=1
+    shift
+fi
+if [[ $# -eq 0 ]]; then
+    sed -n '2,13p' "$0" >&2
+    exit 2
+fi
+
+repo=$(cd "$(dirname "$0")/../.." && pwd)
+bench=${CORE_BENCH:-$repo/build/core_bench/core_bench}
+golden_dir=${GOLDEN_DIR:-$repo/tools/core_bench/golden}
+frames=${FRAMES:-1800}
+jobs=${JOBS:-$(nproc)}
+
+if [[ -z ${CORE_BENCH:-} ]]; then
+    # Incremental: a no-op when nothing changed, and never a stale binary after a core change.
+    if [[ ! -f $repo/build/core_bench/CMakeCache.txt ]]; then
+        cmake -S "$repo/tools/core_bench" -B "$repo/build/core_bench" \
+            -DCMAKE_BUILD_TYPE=Release >/dev/null
+    fi
+    cmake --build "$repo/build/core_bench" -j >/dev/null
+fi
+mkdir -p "$golden_dir"
+
+run_one() {
+    local rom=$1 movie=$2
+    local name
+    name="$(basename "$rom" .vb).$(basename "$movie" .txt)"
+    local trace="$golden_dir/$name.trace"
+    local args=(--rom "$rom" --movie "$movie" --frames "$frames" --warmup 0)
+    if [[ $update == 1 ]]; then
+        "$bench" "${args[@]}" --trace "$trace" >/dev/null
+        echo "updated $name"
+        return
+    fi
+    if [[ ! -f $trace ]]; then
+        echo "FAIL $name: no golden trace (run with --update)"
+        return 1
+    fi
+    local result
+    result=$("$bench" "${args[@]}" --golden "$trace" | sed -n 's/^golden //p' || true)
+    if [[ $result == match ]]; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name: ${result:-core_bench failed}"
+        return 1
+    fi
+}
+export -f run_one
+export bench golden_dir frames update
+
+runs=()
+for rom in "$@"; do
+    for movie in "$repo"/tools/core_bench/movies/*.txt; do
+        runs+=("$rom" "$movie")
+    done
+done
+if printf '%s\0' "${runs[@]}" | xargs -0 -n 2 -P "$jobs" bash -c 'run_one "$0" "$1"'; then
+    echo "$(( ${#runs[@]} / 2 )) runs $([[ $update == 1 ]] && echo updated || echo match)"
+else
+    echo "golden mismatch" >&2
+    exit 1
+fi
@@ -0,0 +1,101 @@
+#include "input_movie.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+bool SetButton(VbInputState& state, const std::string& name) {
+    if (name == "LEFT") {
+        state.left = true;
+    } else if (name == "RIGHT") {
+        state.right = true;
+    } else if (name == "UP") {
+        state.up = true;
+    } else if (name == "DOWN") {
+        state.down = true;
+    } else if (name == "A") {
+        state.a = true;
+    } else if (name == "B") {
+        state.b = true;
+    } else if (name == "L") {
+        state.l = true;
+    } else if (name == "R") {
+        state.r = true;
+    } else if (name == "START") {
+        state.start = true;
+    } else if (name == "SELECT") {
+        state.select = true;
+    } else {
+        return name == "-";
+    }
+    return true;
+}
+
+}  // namespace
+
+bool InputMovie::load(const std::string& path, std::string& outError) {
+    std::ifstream in(path);
+    if (!in.good()) {
+        outError = "cannot read movie " + path;
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    if (!parse(contents.str(), outError)) {
+        outError = path + ": " + outError;
+        return false;
+    }
+    return true;
+}
+
+bool InputMovie::parse(const std::string_view text, std::string& outError) {
+    changes_.clear();
+    std::istringstream in{std::string(text)};
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string frameText;
+        if (!(fields >> frameText)) {
+            continue;
+        }
+        char* end = nullptr;
+        const unsigned long frame = std::strtoul(frameText.c_str(), &end, 10);
+        if (end == frameText.c_str() || *end != '\0' ||
+            (!changes_.empty() && frame <= changes_.back().first)) {
+            outError = "line " + std::to_string(lineNumber) + ": bad or non-increasing frame";
+            return false;
+        }
+        VbInputState state;
+        std::string button;
+        while (fields >> button) {
+            std::transform(button.begin(), button.end(), button.begin(),
+                           [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+            if (!SetButton(state, button)) {
+                outError = "line " + std::to_string(lineNumber) + ": unknown button " + button;
+                return false;
+            }
+        }
+        changes_.emplace_back(static_cast<uint32_t>(frame), state);
+    }
+    return true;
+}
+
+VbInputState InputMovie::stateAt(const uint32_t frame) const {
+    // Last change at or before frame.
+    const auto next = std::upper_bound(
+        changes_.begin(), changes_.end(), frame,
+        [](const uint32_t value, const auto& change) { return value < change.first; });
+    return next == changes_.begin() ? VbInputState{} : std::prev(next)->second;
+}
+
+uint32_t InputMovie::lastChangeFrame() const {
+    return changes_.empty() ? 0 : changes_.back().first;
+}
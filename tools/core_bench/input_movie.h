@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "libretro_vb_core.h"
+
+// Scripted joypad input for headless runs. Text, one change per line:
+//   <frame> <button>...
+// lists the buttons held from that frame on (LEFT RIGHT UP DOWN A B L R START SELECT, or '-'
+// for none) until the next line. Frames must increase; '#' starts a comment. Movies name no
+// game, so any ROM can replay them.
+class InputMovie {
+public:
+    bool load(const std::string& path, std::string& outError);
+    bool parse(std::string_view text, std::string& outError);
+
+    [[nodiscard]] VbInputState stateAt(uint32_t frame) const;
+    // Frame of the last change; the state after it holds forever.
+    [[nodiscard]] uint32_t lastChangeFrame() const;
+
+private:
+    std::vector<std::pair<uint32_t, VbInputState>> changes_;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// XXH64 (https://github.com/Cyan4973/xxHash), bit-compatible with the reference, so hashes in
+// golden traces can be checked with any xxhsum. Four independent 64-bit lanes keep several
+// multiplies in flight per cycle; it hashes a VIP frame in a few tens of microseconds.
+uint64_t XxHash64(const void* data, size_t size, uint64_t seed = 0);
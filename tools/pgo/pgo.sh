@@ -0,0 +1,126 @@
+#!/usr/bin/env bash
+# Profile-guided build of the Beetle VB core: builds an instrumented core_bench, replays every
+# movie in tools/core_bench/movies on every given ROM to collect profiles, rebuilds with
+# ThinLTO + PGO and compares frames/s against the plain build. Both builds must end on the
+# same frame hash.
+#
+#   tools/pgo/pgo.sh host <rom.vb>...     host clang; writes build/pgo/host.profdata
+#   tools/pgo/pgo.sh device <rom.vb>...   NDK arm64 build run through adb; writes
+#                                         build/pgo/vbcore.profdata for assembleReleasePgo
+#
+# Environment: ANDROID_NDK (device mode), LLVM_PROFDATA (host mode, default llvm-profdata),
+# FRAMES per run (default 3000), CC/CXX (host mode, must be clang).
+set -euo pipefail
+
+usage() {
+    sed -n '2,14p' "$0" >&2
+    exit 2
+}
+
+[[ $# -ge 2 ]] || usage
+mode=$1
+shift
+roms=("$@")
+repo=$(cd "$(dirname "$0")/../.." && pwd)
+out="$repo/build/pgo"
+frames=${FRAMES:-3000}
+movies=("$repo"/tools/core_bench/movies/*.txt)
+device_dir=/data/local/tmp/vrboy-pgo
+
+case "$mode" in
+    host)
+        export CC=${CC:-clang} CXX=${CXX:-clang++}
+        profdata_tool=${LLVM_PROFDATA:-llvm-profdata}
+        cmake_args=()
+        profile="$out/host.profdata"
+        ;;
+    device)
+        : "${ANDROID_NDK:?set ANDROID_NDK to the NDK root}"
+        # The NDK's own llvm-profdata, so the profile format matches its clang.
+        profdata_tool=$(echo "$ANDROID_NDK"/toolchains/llvm/prebuilt/*/bin/llvm-profdata)
+        cmake_args=(
+            "-DCMAKE_TOOLCHAIN_FILE=$ANDROID_NDK/build/cmake/android.toolchain.cmake"
+            -DANDROID_ABI=arm64-v8a
+            -DANDROID_PLATFORM=android-29
+        )
+        profile="$out/vbcore.profdata"
+        adb shell "rm -rf $device_dir && mkdir -p $device_dir/raw"
+        for file in "${roms[@]}" "${movies[@]}"; do
+            adb push "$file" "$device_dir/" >/dev/null
+        done
+        ;;
+    *)
+        usage
+        ;;
+esac
+
+build() {
+    local name=$1
+    shift
+    cmake -S "$repo/tools/core_bench" -B "$out/$mode-$name" -DCMAKE_BUILD_TYPE=Release \
+        "${cmake_args[@]}" "$@" >/dev/null
+    cmake --build "$out/$mode-$name" -j >/dev/null
+    if [[ $mode == device ]]; then
+        adb push "$out/$mode-$name/core_bench" "$device_dir/core_bench-$name" >/dev/null
+    fi
+}
+
+# run <build> <rom> <movie> [profile pattern]: prints core_bench's output.
+run() {
+    local name=$1 rom=$2 movie=$3 raw=${4:-}
+    local args=(--rom "$rom" --movie "$movie" --frames "$frames")
+    if [[ $mode == host ]]; then
+        LLVM_PROFILE_FILE=${raw:-/dev/null} "$out/$mode-$name/core_bench" "${args[@]}"
+    else
+        args=(--rom "$(basename "$rom")" --movie "$(basename "$movie")" --frames "$frames")
+        adb shell "cd $device_dir && LLVM_PROFILE_FILE=${raw:-/dev/null} \
+            ./core_bench-$name ${args[*]}"
+    fi
+}
+
+field() {
+    awk -v key="$1" '$1 == key { print $2 }'
+}
+
+echo "building instrumented core_bench ($mode)"
+build instrumented -DVRBOY_PGO=GENERATE
+rm -rf "$out/raw-$mode"
+mkdir -p "$out/raw-$mode"
+for rom in "${roms[@]}"; do
+    for movie in "${movies[@]}"; do
+        echo "  training: $(basename "$rom") / $(basename "$movie")"
+        if [[ $mode == host ]]; then
+            run instrumented "$rom" "$movie" "$out/raw-$mode/%p.profraw" >/dev/null
+        else
+            run instrumented "$rom" "$movie" "$device_dir/raw/%p.profraw" >/dev/null
+        fi
+    done
+done
+if [[ $mode == device ]]; then
+    adb pull "$device_dir/raw/." "$out/raw-$mode" >/dev/null
+fi
+"$profdata_tool" merge -o "$profile" "$out/raw-$mode"/*.profraw
+echo "profile: $profile"
+
+echo "building plain and ThinLTO + PGO core_bench"
+build plain
+build optimized -DVRBOY_LTO=ON -DVRBOY_PGO=USE "-DVRBOY_PGO_PROFILE=$profile"
+
+status=0
+printf '%-32s %-14s %10s %10s %8s\n' rom movie plain pgo+lto speedup
+for rom in "${roms[@]}"; do
+    for movie in "${movies[@]}"; do
+        plain=$(run plain "$rom" "$movie")
+        optimized=$(run optimized "$rom" "$movie")
+        plain_fps=$(field fps <<<"$plain")
+        optimized_fps=$(field fps <<<"$optimized")
+        printf '%-32s %-14s %10s %10s %7.2fx\n' "$(basename "$rom")" "$(basename "$movie")" \
+            "$plain_fps" "$optimized_fps" "$(awk -v a="$optimized_fps" -v b="$plain_fps" \
+            'BEGIN { print a / b }')"
+        if [[ $(field hash <<<"$plain") != $(field hash <<<"$optimized") ]]; then
+            echo "  output differs between plain and optimized builds" >&2
+            status=1
+        fi
+    done
+done
+exit $status
@@ -0,0 +1,90 @@
+#include "v810_assembler.h"
+
+namespace {
+
+uint16_t FormatI(const V810Op op, const int reg1, const int reg2) {
+    return static_cast<uint16_t>((static_cast<unsigned>(op) << 10) | ((reg2 & 0x1F) << 5) |
+                                 (reg1 & 0x1F));
+}
+
+}  // namespace
+
+V810Assembler::Label V810Assembler::newLabel() {
+    labels_.push_back(-1);
+    return labels_.size() - 1;
+}
+
+void V810Assembler::bind(const Label label) { labels_[label] = static_cast<int64_t>(code_.size()); }
+
+uint32_t V810Assembler::address() const {
+    return origin_ + static_cast<uint32_t>(code_.size() * 2);
+}
+
+void V810Assembler::reg(const V810Op op, const int reg1, const int reg2) {
+    emit(FormatI(op, reg1, reg2));
+}
+
+void V810Assembler::imm5(const V810Op op, const int imm, const int reg2) {
+    emit(FormatI(op, imm, reg2));
+}
+
+void V810Assembler::imm16(const V810Op op, const uint16_t imm, const int reg1, const int reg2) {
+    emit(FormatI(op, reg1, reg2));
+    emit(imm);
+}
+
+void V810Assembler::memory(const V810Op op, const int16_t disp, const int reg1, const int reg2) {
+    emit(FormatI(op, reg1, reg2));
+    emit(static_cast<uint16_t>(disp));
+}
+
+void V810Assembler::fpu(const V810FpuOp op, const int reg1, const int reg2) {
+    emit(static_cast<uint16_t>((0x3Eu << 10) | ((reg2 & 0x1F) << 5) | (reg1 & 0x1F)));
+    emit(static_cast<uint16_t>(static_cast<unsigned>(op) << 10));
+}
+
+void V810Assembler::branch(const V810Cond cond, const Label target) {
+    fixups_.push_back({FixupKind::Branch, code_.size(), target});
+    emit(static_cast<uint16_t>((0x4u << 13) | (static_cast<unsigned>(cond) << 9)));
+}
+
+void V810Assembler::jr(const Label target) {
+    fixups_.push_back({FixupKind::Jump, code_.size(), target});
+    emit(static_cast<uint16_t>(0x2Au << 10));
+    emit(0);
+}
+
+void V810Assembler::halt() { emit(FormatI(V810Op::Halt, 0, 0)); }
+
+void V810Assembler::reti() { emit(FormatI(V810Op::Reti, 0, 0)); }
+
+void V810Assembler::loadConstant(const uint32_t value, const int reg) {
+    // movea sign-extends, so the high half absorbs the borrow of a negative low half.
+    const auto low = static_cast<uint16_t>(value);
+    const auto high = static_cast<uint16_t>((value >> 16) + ((low & 0x8000u) != 0 ? 1 : 0));
+    imm16(V810Op::Movhi, high, 0, reg);
+    imm16(V810Op::Movea, low, reg, reg);
+}
+
+bool V810Assembler::finish(std::vector<uint16_t>& outCode, std::string& outError) const {
+    outCode = code_;
+    for (const Fixup& fixup : fixups_) {
+        if (labels_[fixup.label] < 0) {
+            outError = "unbound label";
+            return false;
+        }
+        const int64_t disp = (labels_[fixup.label] - static_cast<int64_t>(fixup.index)) * 2;
+        if (fixup.kind == FixupKind::Branch) {
+            if (disp < -256 || disp > 254) {
+                outError = "branch out of range";
+                return false;
+            }
+            outCode[fixup.index] |= static_cast<uint16_t>(disp & 0x1FF);
+        } else {
+            const auto bits = static_cast<uint32_t>(disp) & 0x3FFFFFF;
+            outCode[fixup.index] |= static_cast<uint16_t>(bits >> 16);
+            outCode[fixup.index + 1] = static_cast<uint16_t>(bits);
+        }
+    }
+    return true;
+}
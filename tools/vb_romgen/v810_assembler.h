@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal V810 assembler for generated test programs: one method per instruction format,
+// labels for branches, and 32-bit constants through movhi/movea. Registers are plain numbers
+// (r0 reads as zero, r30 takes mul/div high words, r1 is free for the caller).
+
+// 6-bit major opcodes, bits 15-10 of the first halfword.
+enum class V810Op : uint8_t {
+    // Format I: reg1, reg2.
+    Mov = 0x00,
+    Add = 0x01,
+    Sub = 0x02,
+    Cmp = 0x03,
+    Shl = 0x04,
+    Shr = 0x05,
+    Jmp = 0x06,
+    Sar = 0x07,
+    Mul = 0x08,
+    Div = 0x09,
+    Mulu = 0x0A,
+    Divu = 0x0B,
+    Or = 0x0C,
+    And = 0x0D,
+    Xor = 0x0E,
+    Not = 0x0F,
+    // Format II: imm5, reg2.
+    MovImm = 0x10,
+    AddImm = 0x11,
+    CmpImm = 0x13,
+    ShlImm = 0x14,
+    ShrImm = 0x15,
+    SarImm = 0x17,
+    Reti = 0x19,
+    Halt = 0x1A,
+    Sei = 0x1E,
+    // Format V: imm16, reg1, reg2.
+    Movea = 0x28,
+    Addi = 0x29,
+    Ori = 0x2C,
+    Andi = 0x2D,
+    Xori = 0x2E,
+    Movhi = 0x2F,
+    // Format VI: disp16[reg1], reg2.
+    LdB = 0x30,
+    LdH = 0x31,
+    LdW = 0x33,
+    StB = 0x34,
+    StH = 0x35,
+    StW = 0x37,
+};
+
+// Format VII sub-opcodes, bits 15-10 of the second halfword.
+enum class V810FpuOp : uint8_t {
+    CmpfS = 0x00,
+    CvtWs = 0x02,
+    CvtSw = 0x03,
+    AddfS = 0x04,
+    SubfS = 0x05,
+    MulfS = 0x06,
+    DivfS = 0x07,
+    TrncSw = 0x0B,
+};
+
+enum class V810Cond : uint8_t {
+    Overflow = 0x0,
+    Carry = 0x1,
+    Zero = 0x2,
+    NotHigher = 0x3,
+    Negative = 0x4,
+    Always = 0x5,
+    Less = 0x6,
+    LessEqual = 0x7,
+    NotOverflow = 0x8,
+    NotCarry = 0x9,
+    NotZero = 0xA,
+    Higher = 0xB,
+    Positive = 0xC,
+    Never = 0xD,
+    GreaterEqual = 0xE,
+    Greater = 0xF,
+};
+
+class V810Assembler {
+public:
+    using Label = size_t;
+
+    explicit V810Assembler(uint32_t origin) : origin_(origin) {}
+
+    Label newLabel();
+    // Binds label to the current address.
+    void bind(Label label);
+    [[nodiscard]] uint32_t address() const;
+
+    // reg2 = reg2 op reg1 (mov: reg2 = reg1; jmp: pc = reg1).
+    void reg(V810Op op, int reg1, int reg2);
+    // reg2 = reg2 op sign-extended imm (shifts take imm as a 5-bit count).
+    void imm5(V810Op op, int imm, int reg2);
+    // reg2 = reg1 op imm (movea/addi sign-extend, ori/andi/xori zero-extend, movhi shifts 16).
+    void imm16(V810Op op, uint16_t imm, int reg1, int reg2);
+    // Loads: reg2 = [reg1 + disp]. Stores: [reg1 + disp] = reg2.
+    void memory(V810Op op, int16_t disp, int reg1, int reg2);
+    // reg2 = reg2 op reg1 (cvt/trnc convert reg1 into reg2).
+    void fpu(V810FpuOp op, int reg1, int reg2);
+    // Conditional branch within +-256 bytes.
+    void branch(V810Cond cond, Label target);
+    // PC-relative jump anywhere in the 64 MB window.
+    void jr(Label target);
+    void halt();
+    void reti();
+    void loadConstant(uint32_t value, int reg);
+
+    // Resolves branches. Fails when a target is unbound or out of range.
+    bool finish(std::vector<uint16_t>& outCode, std::string& outError) const;
+
+private:
+    enum class FixupKind {
+        Branch,
+        Jump,
+    };
+
+    struct Fixup {
+        FixupKind kind;
+        size_t index;
+        Label label;
+    };
+
+    void emit(uint16_t halfword) { code_.push_back(halfword); }
+
+    uint32_t origin_;
+    std::vector<uint16_t> code_;
+    std::vector<int64_t> labels_;
+    std::vector<Fixup> fixups_;
+};
@@ -0,0 +1,753 @@
+// Generates small Virtual Boy ROM images that each load one part of the machine: integer or FPU
+// loops on the V810, stacks of normal, H-bias or affine worlds, a screen full of objects, or all
+// six VSU channels. They give core_bench, the PGO training runs and the golden suite workloads
+// with known content and no licensing strings attached.
+//
+// Each ROM copies its tables from ROM into VRAM and the registers at reset, turns the display
+// on and then runs its loop forever; the loops only depend on their own state, so a ROM plays
+// the same on every run.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "v810_assembler.h"
+
+namespace {
+
+constexpr uint32_t kRomBase = 0x07000000;
+constexpr uint32_t kResetVector = 0xFFFFFFF0;
+constexpr size_t kMinRomSize = 0x10000;
+// Code sits at the start of the ROM and the tables it copies follow.
+constexpr size_t kDataOffset = 0x1000;
+constexpr size_t kHeaderOffsetFromEnd = 0x220;
+constexpr size_t kVectorsOffsetFromEnd = 0x200;
+
+constexpr uint32_t kChrBase = 0x00078000;
+constexpr uint32_t kBgMapBase = 0x00020000;
+constexpr uint32_t kParamBase = 0x00030000;
+constexpr uint32_t kWorldBase = 0x0003D800;
+constexpr uint32_t kWorldSize = 0x20;
+constexpr uint32_t kOamBase = 0x0003E000;
+constexpr uint32_t kVipRegs = 0x0005F800;
+constexpr uint32_t kVsuWaveBase = 0x01000000;
+constexpr uint32_t kVsuModBase = 0x01000280;
+constexpr uint32_t kVsuChannelBase = 0x01000400;
+constexpr uint32_t kVsuChannelStride = 0x40;
+constexpr uint32_t kVsuStop = 0x01000580;
+
+constexpr int kScreenWidth = 384;
+constexpr int kScreenHeight = 224;
+constexpr int kBgMapCells = 64;
+constexpr int kMaxWorlds = 31;
+// Affine parameter tables take 16 bytes a line; thirteen fit between kParamBase and the worlds.
+constexpr int kMaxAffineWorlds = 13;
+constexpr uint32_t kAffineTableStride = 0x1000;
+constexpr uint32_t kHbiasTableStride = 0x400;
+constexpr int kMaxObjects = 1023;
+// Main-loop iterations between animation steps; a few steps per 50 Hz frame.
+constexpr uint32_t kAnimationDelay = 20000;
+
+// World attribute fields, in halfwords.
+constexpr int kWorldGp = 2;
+constexpr int kWorldMx = 4;
+constexpr int kWorldMy = 6;
+constexpr int kWorldW = 7;
+constexpr int kWorldH = 8;
+constexpr int kWorldParamBase = 9;
+constexpr uint16_t kWorldBothEyes = 0xC000;
+constexpr uint16_t kWorldEnd = 0x0040;
+
+// VIP register offsets.
+constexpr uint32_t kDpctrl = 0x22;
+constexpr uint32_t kBrta = 0x24;
+constexpr uint32_t kBrtb = 0x26;
+constexpr uint32_t kBrtc = 0x28;
+constexpr uint32_t kFrmcyc = 0x2E;
+constexpr uint32_t kXpctrl = 0x42;
+constexpr uint32_t kSpt0 = 0x48;
+constexpr uint32_t kGplt0 = 0x60;
+constexpr uint32_t kJplt0 = 0x68;
+constexpr uint32_t kBkcol = 0x70;
+
+enum class Workload {
+    CpuInt,
+    CpuFpu,
+    VipWorlds,
+    VipHbias,
+    VipAffine,
+    VipObjects,
+    Vsu,
+};
+
+struct WorkloadInfo {
+    Workload workload;
+    const char* name;
+    const char* description;
+};
+
+constexpr WorkloadInfo kWorkloads[] = {
+    {Workload::CpuInt, "cpu-int", "xorshift, mul and divu loop drawing into a BG map"},
+    {Workload::CpuFpu, "cpu-fpu", "addf/mulf/divf/trnc loop drawing into a BG map"},
+    {Workload::VipWorlds, "vip-worlds", "--worlds full-screen normal worlds, scrolling"},
+    {Workload::VipHbias, "vip-hbias", "--worlds full-screen H-bias worlds with per-line waves"},
+    {Workload::VipAffine, "vip-affine", "--worlds rotated and scaled affine worlds"},
+    {Workload::VipObjects, "vip-obj", "--objects objects in one OBJ world, all moving"},
+    {Workload::Vsu, "vsu", "all six VSU channels, sweep/modulation and noise"},
+};
+
+struct Options {
+    std::string workload;
+    std::string outputPath;
+    std::string allDirectory;
+    int worlds = 8;
+    int objects = kMaxObjects;
+    bool list = false;
+};
+
+// Halfwords copied from ROM to a VIP address at reset.
+struct Block {
+    uint32_t destination = 0;
+    std::vector<uint16_t> halfwords;
+};
+
+struct RegisterWrite {
+    uint32_t address;
+    uint16_t value;
+};
+
+// Halfwords stepped by the main loop: count fields stride bytes apart, each += step.
+struct Animation {
+    uint32_t address = 0;
+    int count = 0;
+    int stride = 0;
+    int step = 0;
+};
+
+struct Program {
+    std::string title;
+    std::vector<Block> blocks;
+    // Written in order after the blocks; the VSU takes byte writes, the VIP halfwords.
+    std::vector<RegisterWrite> vipWrites;
+    std::vector<RegisterWrite> vsuWrites;
+    Workload workload = Workload::VipWorlds;
+    Animation animation;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: vb_romgen <workload> <output.vb> [--worlds N] [--objects N]\n"
+                 "       vb_romgen --all <directory>\n"
+                 "       vb_romgen --list\n");
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--list") {
+            options.list = true;
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            positional.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--all") {
+            options.allDirectory = value;
+        } else if (arg == "--worlds") {
+            options.worlds = std::atoi(value);
+        } else if (arg == "--objects") {
+            options.objects = std::atoi(value);
+        } else {
+            PrintUsage();
+            return false;
+        }
+    }
+    if (options.list) {
+        return true;
+    }
+    if (options.allDirectory.empty()) {
+        if (positional.size() != 2) {
+            PrintUsage();
+            return false;
+        }
+        options.workload = positional[0];
+        options.outputPath = positional[1];
+    } else if (!positional.empty()) {
+        PrintUsage();
+        return false;
+    }
+    if (options.worlds < 1 || options.worlds > kMaxWorlds || options.objects < 1 ||
+        options.objects > kMaxObjects) {
+        std::fprintf(stderr, "--worlds takes 1-%d and --objects 1-%d\n", kMaxWorlds, kMaxObjects);
+        return false;
+    }
+    return true;
+}
+
+uint16_t Fixed(const double value, const int fractionBits) {
+    return static_cast<uint16_t>(static_cast<int16_t>(std::lround(value * (1 << fractionBits))));
+}
+
+// Four 8x8 characters, two bits a pixel: clear, solid shade 1, solid shade 2 and 3/1 stripes.
+Block Characters() {
+    Block block{kChrBase, {}};
+    const uint16_t rows[4][2] = {{0x0000, 0x0000}, {0x5555, 0x5555}, {0xAAAA, 0xAAAA},
+                                 {0xFFFF, 0x5555}};
+    for (const auto& character : rows) {
+        for (int row = 0; row < 8; ++row) {
+            block.halfwords.push_back(character[row & 1]);
+        }
+    }
+    return block;
+}
+
+// BG map 0: diagonal bands of the four characters, so a quarter of every world is transparent
+// and the worlds below it stay visible.
+Block DiagonalMap() {
+    Block block{kBgMapBase, {}};
+    for (int y = 0; y < kBgMapCells; ++y) {
+        for (int x = 0; x < kBgMapCells; ++x) {
+            block.halfwords.push_back(static_cast<uint16_t>(((x + y) / 2) & 3));
+        }
+    }
+    return block;
+}
+
+std::vector<uint16_t> World(const uint16_t mode, const int index) {
+    std::vector<uint16_t> world(kWorldSize / 2, 0);
+    world[0] = static_cast<uint16_t>(kWorldBothEyes | (mode << 12));
+    world[kWorldGp] = static_cast<uint16_t>((index % 7) - 3);
+    world[kWorldMx] = static_cast<uint16_t>(index * 13);
+    world[kWorldMy] = static_cast<uint16_t>(index * 7);
+    world[kWorldW] = kScreenWidth - 1;
+    world[kWorldH] = kScreenHeight - 1;
+    return world;
+}
+
+// The first world goes in world 31, the one the VIP draws first; an END world follows the last.
+Block WorldTable(const std::vector<std::vector<uint16_t>>& worlds) {
+    const int first = kMaxWorlds - static_cast<int>(worlds.size()) + 1;
+    Block block{kWorldBase + static_cast<uint32_t>(first - 1) * kWorldSize, {}};
+    block.halfwords.resize(kWorldSize / 2, 0);
+    block.halfwords[0] = kWorldEnd;
+    for (auto it = worlds.rbegin(); it != worlds.rend(); ++it) {
+        block.halfwords.insert(block.halfwords.end(), it->begin(), it->end());
+    }
+    return block;
+}
+
+uint32_t WorldAddress(const int index) {
+    return kWorldBase + static_cast<uint32_t>(index) * kWorldSize;
+}
+
+void AddDisplayRegisters(Program& program) {
+    auto vip = [&program](const uint32_t offset, const uint16_t value) {
+        program.vipWrites.push_back({kVipRegs + offset, value});
+    };
+    vip(kBrta, 32);
+    vip(kBrtb, 64);
+    vip(kBrtc, 32);
+    for (uint32_t i = 0; i < 4; ++i) {
+        vip(kGplt0 + i * 2, 0xE4);
+        vip(kJplt0 + i * 2, 0xE4);
+    }
+    vip(kBkcol, 0);
+    vip(kFrmcyc, 0);
+}
+
+void EnableDisplay(Program& program) {
+    // DISP | RE | SYNCE, then XPEN.
+    program.vipWrites.push_back({kVipRegs + kDpctrl, 0x0302});
+    program.vipWrites.push_back({kVipRegs + kXpctrl, 0x0002});
+}
+
+void BuildBgWorkload(Program& program, const Workload workload, const int count) {
+    program.workload = workload;
+    program.blocks.push_back(Characters());
+    program.blocks.push_back(DiagonalMap());
+    std::vector<std::vector<uint16_t>> worlds;
+    for (int k = 0; k < count; ++k) {
+        uint16_t mode = 0;
+        if (workload == Workload::VipHbias) {
+            mode = 1;
+        } else if (workload == Workload::VipAffine) {
+            mode = 2;
+        }
+        worlds.push_back(World(mode, k));
+        std::vector<uint16_t>& world = worlds.back();
+        if (workload == Workload::VipHbias) {
+            const uint32_t table = kParamBase + static_cast<uint32_t>(k) * kHbiasTableStride;
+            world[kWorldParamBase] = static_cast<uint16_t>((table - kBgMapBase) / 2);
+            Block params{table, {}};
+            for (int y = 0; y < kScreenHeight; ++y) {
+                const double wave = std::sin(y / 9.0 + k) * (6 + k);
+                params.halfwords.push_back(Fixed(wave, 0));
+                params.halfwords.push_back(Fixed(-wave, 0));
+            }
+            program.blocks.push_back(std::move(params));
+        } else if (workload == Workload::VipAffine) {
+            const uint32_t table = kParamBase + static_cast<uint32_t>(k) * kAffineTableStride;
+            world[kWorldParamBase] = static_cast<uint16_t>((table - kBgMapBase) / 2);
+            const double angle = 0.25 + k * 0.3;
+            const double scale = 1.0 + k * 0.1;
+            const double dx = std::cos(angle) / scale;
+            const double dy = std::sin(angle) / scale;
+            Block params{table, {}};
+            for (int y = 0; y < kScreenHeight; ++y) {
+                // Source point of the line's left edge, rotated about the map centre.
+                const double ly = y - kScreenHeight / 2.0;
+                const double lx = -kScreenWidth / 2.0;
+                params.halfwords.push_back(Fixed(256 + lx * dx - ly * dy, 3));
+                params.halfwords.push_back(0);
+                params.halfwords.push_back(Fixed(256 + lx * dy + ly * dx, 3));
+                params.halfwords.push_back(Fixed(dx, 9));
+                params.halfwords.push_back(Fixed(dy, 9));
+                params.halfwords.insert(params.halfwords.end(), 3, 0);
+            }
+            program.blocks.push_back(std::move(params));
+        }
+    }
+    program.blocks.push_back(WorldTable(worlds));
+    AddDisplayRegisters(program);
+    EnableDisplay(program);
+
+    if (workload == Workload::VipAffine) {
+        // Affine worlds ignore MX; scroll world 31 through its parameter table instead.
+        program.animation = {kParamBase, kScreenHeight, 16, 8};
+    } else if (workload != Workload::CpuInt && workload != Workload::CpuFpu) {
+        program.animation = {WorldAddress(kMaxWorlds) + kWorldMx * 2, 1, 0, 1};
+    }
+}
+
+void BuildObjectWorkload(Program& program, const int count) {
+    program.workload = Workload::VipObjects;
+    program.blocks.push_back(Characters());
+    // Object 0 is left out: the lone OBJ world draws SPT3 down to SPT2 + 1.
+    Block oam{kOamBase + 8, {}};
+    for (int i = 1; i <= count; ++i) {
+        oam.halfwords.push_back(static_cast<uint16_t>((i * 37) % (kScreenWidth + 8) - 8));
+        oam.halfwords.push_back(static_cast<uint16_t>(kWorldBothEyes | ((i & 1) ? 2 : 0x3FE)));
+        oam.halfwords.push_back(static_cast<uint16_t>((i * 23) % (kScreenHeight - 8)));
+        oam.halfwords.push_back(static_cast<uint16_t>(1 + i % 3));
+    }
+    program.blocks.push_back(std::move(oam));
+    std::vector<uint16_t> world(kWorldSize / 2, 0);
+    world[0] = static_cast<uint16_t>(kWorldBothEyes | 0x3000);
+    program.blocks.push_back(WorldTable({world}));
+    AddDisplayRegisters(program);
+    for (uint32_t i = 0; i < 3; ++i) {
+        program.vipWrites.push_back({kVipRegs + kSpt0 + i * 2, 0});
+    }
+    program.vipWrites.push_back({kVipRegs + kSpt0 + 6, static_cast<uint16_t>(count)});
+    EnableDisplay(program);
+    program.animation = {kOamBase + 8, count, 8, 1};
+}
+
+void BuildVsuWorkload(Program& program) {
+    BuildBgWorkload(program, Workload::VipWorlds, 1);
+    program.workload = Workload::Vsu;
+    auto vsu = [&program](const uint32_t address, const int value) {
+        program.vsuWrites.push_back({address, static_cast<uint16_t>(value)});
+    };
+    // Wave and modulation RAM only take writes while every channel is stopped.
+    vsu(kVsuStop, 1);
+    constexpr double kPi = 3.14159265358979323846;
+    for (int i = 0; i < 32; ++i) {
+        const double phase = i * 2 * kPi / 32;
+        const int samples[5] = {
+            static_cast<int>(std::lround(31.5 + 31.5 * std::sin(phase))),
+            i < 16 ? i * 4 : (31 - i) * 4,
+            i * 2,
+            i < 16 ? 63 : 0,
+            static_cast<int>(std::lround(31.5 + 21 * std::sin(phase) + 10 * std::sin(3 * phase))),
+        };
+        for (uint32_t wave = 0; wave < 5; ++wave) {
+            vsu(kVsuWaveBase + wave * 0x80 + static_cast<uint32_t>(i) * 4, samples[wave]);
+        }
+        vsu(kVsuModBase + static_cast<uint32_t>(i) * 4,
+            static_cast<int>(std::lround(8 * std::sin(phase))) & 0xFF);
+    }
+    const int frequencies[6] = {0x600, 0x680, 0x6C0, 0x720, 0x500, 0x700};
+    for (uint32_t channel = 0; channel < 6; ++channel) {
+        const uint32_t base = kVsuChannelBase + channel * kVsuChannelStride;
+        vsu(base + 0x04, channel % 2 == 0 ? 0xA6 : 0x6A);
+        vsu(base + 0x08, frequencies[channel] & 0xFF);
+        vsu(base + 0x0C, frequencies[channel] >> 8);
+        vsu(base + 0x10, 0xF0);
+        if (channel == 4) {
+            // Modulation on, repeating, stepping every 1 x 1 ms.
+            vsu(base + 0x14, 0x70);
+            vsu(base + 0x1C, 0x10);
+        } else if (channel == 5) {
+            // Noise tap 3.
+            vsu(base + 0x14, 0x30);
+        } else {
+            vsu(base + 0x14, 0x00);
+        }
+        if (channel < 5) {
+            vsu(base + 0x18, static_cast<int>(channel));
+        }
+        vsu(base + 0x00, 0x80);
+    }
+}
+
+bool BuildProgram(const Workload workload, const Options& options, Program& program) {
+    switch (workload) {
+        case Workload::CpuInt:
+        case Workload::CpuFpu:
+            BuildBgWorkload(program, workload, 1);
+            break;
+        case Workload::VipWorlds:
+        case Workload::VipHbias:
+            BuildBgWorkload(program, workload, options.worlds);
+            break;
+        case Workload::VipAffine:
+            if (options.worlds > kMaxAffineWorlds) {
+                std::fprintf(stderr, "vip-affine takes at most %d worlds\n", kMaxAffineWorlds);
+                return false;
+            }
+            BuildBgWorkload(program, workload, options.worlds);
+            break;
+        case Workload::VipObjects:
+            BuildObjectWorkload(program, options.objects);
+            break;
+        case Workload::Vsu:
+            BuildVsuWorkload(program);
+            break;
+    }
+    return true;
+}
+
+// r11 source, r12 destination, r14 count; r13 carries the data.
+void EmitCopy(V810Assembler& as, const uint32_t source, const Block& block) {
+    as.loadConstant(source, 11);
+    as.loadConstant(block.destination, 12);
+    as.loadConstant(static_cast<uint32_t>(block.halfwords.size()), 14);
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    as.memory(V810Op::LdH, 0, 11, 13);
+    as.memory(V810Op::StH, 0, 12, 13);
+    as.imm5(V810Op::AddImm, 2, 11);
+    as.imm5(V810Op::AddImm, 2, 12);
+    as.imm5(V810Op::AddImm, -1, 14);
+    as.branch(V810Cond::NotZero, loop);
+}
+
+// Table entries are 8 bytes: address word, value halfword, padding.
+void EmitRegisterWrites(V810Assembler& as, const uint32_t source, const size_t count,
+                        const V810Op store) {
+    as.loadConstant(source, 11);
+    as.loadConstant(static_cast<uint32_t>(count), 14);
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    as.memory(V810Op::LdW, 0, 11, 12);
+    as.memory(V810Op::LdH, 4, 11, 13);
+    as.memory(store, 0, 12, 13);
+    as.imm5(V810Op::AddImm, 8, 11);
+    as.imm5(V810Op::AddImm, -1, 14);
+    as.branch(V810Cond::NotZero, loop);
+}
+
+// Stores char (r13 & 3) at the BG map cell r15 bytes in and moves r15 on; r16 holds the map.
+void EmitPlotCell(V810Assembler& as) {
+    as.imm16(V810Op::Andi, 3, 13, 13);
+    as.reg(V810Op::Mov, 15, 18);
+    as.reg(V810Op::Add, 16, 18);
+    as.memory(V810Op::StH, 0, 18, 13);
+    as.imm5(V810Op::AddImm, 2, 15);
+    as.imm16(V810Op::Andi, kBgMapCells * kBgMapCells * 2 - 1, 15, 15);
+}
+
+void EmitCpuIntLoop(V810Assembler& as) {
+    as.loadConstant(0x2545F491, 10);
+    as.loadConstant(0x9E3779B9, 17);
+    as.reg(V810Op::Mov, 0, 15);
+    as.loadConstant(kBgMapBase, 16);
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    // xorshift32
+    as.reg(V810Op::Mov, 10, 11);
+    as.imm5(V810Op::ShlImm, 13, 11);
+    as.reg(V810Op::Xor, 11, 10);
+    as.reg(V810Op::Mov, 10, 11);
+    as.imm5(V810Op::ShrImm, 17, 11);
+    as.reg(V810Op::Xor, 11, 10);
+    as.reg(V810Op::Mov, 10, 11);
+    as.imm5(V810Op::ShlImm, 5, 11);
+    as.reg(V810Op::Xor, 11, 10);
+    // Multiply-accumulate and an unsigned divide by a never-zero divisor.
+    as.reg(V810Op::Mov, 10, 12);
+    as.reg(V810Op::Mul, 17, 12);
+    as.imm16(V810Op::Ori, 1, 10, 19);
+    as.imm16(V810Op::Andi, 0x7FF, 19, 19);
+    as.reg(V810Op::Mov, 12, 13);
+    as.reg(V810Op::Divu, 19, 13);
+    as.reg(V810Op::Add, 30, 13);
+    as.reg(V810Op::Sub, 12, 13);
+    as.reg(V810Op::Sar, 19, 13);
+    EmitPlotCell(as);
+    as.branch(V810Cond::Always, loop);
+}
+
+void EmitCpuFpuLoop(V810Assembler& as) {
+    // r20 = 1.0, r21 = x, r22 = 3.0, r23 = 1.0001
+    as.imm5(V810Op::MovImm, 1, 20);
+    as.fpu(V810FpuOp::CvtWs, 20, 20);
+    as.fpu(V810FpuOp::CvtWs, 0, 21);
+    as.imm5(V810Op::MovImm, 3, 22);
+    as.fpu(V810FpuOp::CvtWs, 22, 22);
+    as.imm16(V810Op::Movea, 10001, 0, 23);
+    as.fpu(V810FpuOp::CvtWs, 23, 23);
+    as.imm16(V810Op::Movea, 10000, 0, 24);
+    as.fpu(V810FpuOp::CvtWs, 24, 24);
+    as.fpu(V810FpuOp::DivfS, 24, 23);
+    as.reg(V810Op::Mov, 0, 15);
+    as.loadConstant(kBgMapBase, 16);
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    as.fpu(V810FpuOp::AddfS, 20, 21);
+    as.reg(V810Op::Mov, 21, 24);
+    as.fpu(V810FpuOp::MulfS, 23, 24);
+    as.fpu(V810FpuOp::DivfS, 22, 24);
+    // Stays near 1/3, so the conversion below never overflows into an exception.
+    as.reg(V810Op::Mov, 24, 25);
+    as.fpu(V810FpuOp::DivfS, 21, 25);
+    as.fpu(V810FpuOp::SubfS, 20, 25);
+    as.fpu(V810FpuOp::MulfS, 24, 25);
+    as.fpu(V810FpuOp::CmpfS, 21, 25);
+    as.fpu(V810FpuOp::TrncSw, 24, 13);
+    as.fpu(V810FpuOp::CvtSw, 25, 12);
+    as.reg(V810Op::Xor, 12, 13);
+    EmitPlotCell(as);
+    as.branch(V810Cond::Always, loop);
+}
+
+void EmitDelay(V810Assembler& as) {
+    as.loadConstant(kAnimationDelay, 19);
+    const V810Assembler::Label wait = as.newLabel();
+    as.bind(wait);
+    as.imm5(V810Op::AddImm, -1, 19);
+    as.branch(V810Cond::NotZero, wait);
+}
+
+void EmitAnimationLoop(V810Assembler& as, const Animation& animation) {
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    EmitDelay(as);
+    as.loadConstant(animation.address, 11);
+    as.loadConstant(static_cast<uint32_t>(animation.count), 14);
+    as.loadConstant(static_cast<uint32_t>(animation.stride), 17);
+    const V810Assembler::Label step = as.newLabel();
+    as.bind(step);
+    as.memory(V810Op::LdH, 0, 11, 13);
+    as.imm5(V810Op::AddImm, animation.step, 13);
+    as.memory(V810Op::StH, 0, 11, 13);
+    as.reg(V810Op::Add, 17, 11);
+    as.imm5(V810Op::AddImm, -1, 14);
+    as.branch(V810Cond::NotZero, step);
+    as.jr(loop);
+}
+
+// Retunes the four wave channels a semitone-ish step at a time.
+void EmitVsuLoop(V810Assembler& as) {
+    as.reg(V810Op::Mov, 0, 10);
+    const V810Assembler::Label loop = as.newLabel();
+    as.bind(loop);
+    EmitDelay(as);
+    as.imm5(V810Op::AddImm, 7, 10);
+    as.imm16(V810Op::Andi, 0xFF, 10, 10);
+    as.loadConstant(kVsuChannelBase + 0x08, 11);
+    for (int channel = 0; channel < 4; ++channel) {
+        as.imm16(V810Op::Addi, static_cast<uint16_t>(channel * 29), 10, 13);
+        as.memory(V810Op::StB, static_cast<int16_t>(channel * kVsuChannelStride), 11, 13);
+    }
+    as.jr(loop);
+}
+
+struct DataLayout {
+    std::vector<uint32_t> blockOffsets;
+    size_t vipTableOffset = 0;
+    size_t vsuTableOffset = 0;
+    size_t end = 0;
+};
+
+DataLayout LayOutData(const Program& program) {
+    DataLayout layout;
+    size_t offset = kDataOffset;
+    for (const Block& block : program.blocks) {
+        layout.blockOffsets.push_back(static_cast<uint32_t>(offset));
+        offset += (block.halfwords.size() * 2 + 3) & ~size_t{3};
+    }
+    layout.vipTableOffset = offset;
+    offset += program.vipWrites.size() * 8;
+    layout.vsuTableOffset = offset;
+    offset += program.vsuWrites.size() * 8;
+    layout.end = offset;
+    return layout;
+}
+
+void PutHalfword(std::vector<uint8_t>& rom, const size_t offset, const uint16_t value) {
+    rom[offset] = static_cast<uint8_t>(value);
+    rom[offset + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutWrites(std::vector<uint8_t>& rom, size_t offset, const std::vector<RegisterWrite>& writes) {
+    for (const RegisterWrite& write : writes) {
+        PutHalfword(rom, offset, static_cast<uint16_t>(write.address));
+        PutHalfword(rom, offset + 2, static_cast<uint16_t>(write.address >> 16));
+        PutHalfword(rom, offset + 4, write.value);
+        offset += 8;
+    }
+}
+
+bool AssembleRom(const Program& program, std::vector<uint8_t>& rom, std::string& error) {
+    const DataLayout layout = LayOutData(program);
+    size_t size = kMinRomSize;
+    while (size < layout.end + kHeaderOffsetFromEnd) {
+        size *= 2;
+    }
+    rom.assign(size, 0);
+
+    V810Assembler as(kRomBase);
+    for (size_t i = 0; i < program.blocks.size(); ++i) {
+        EmitCopy(as, kRomBase + layout.blockOffsets[i], program.blocks[i]);
+    }
+    EmitRegisterWrites(as, kRomBase + static_cast<uint32_t>(layout.vipTableOffset),
+                       program.vipWrites.size(), V810Op::StH);
+    if (!program.vsuWrites.empty()) {
+        EmitRegisterWrites(as, kRomBase + static_cast<uint32_t>(layout.vsuTableOffset),
+                           program.vsuWrites.size(), V810Op::StB);
+    }
+    switch (program.workload) {
+        case Workload::CpuInt:
+            EmitCpuIntLoop(as);
+            break;
+        case Workload::CpuFpu:
+            EmitCpuFpuLoop(as);
+            break;
+        case Workload::Vsu:
+            EmitVsuLoop(as);
+            break;
+        default:
+            EmitAnimationLoop(as, program.animation);
+            break;
+    }
+    std::vector<uint16_t> code;
+    if (!as.finish(code, error)) {
+        return false;
+    }
+    if (code.size() * 2 > kDataOffset) {
+        error = "code does not fit below the data";
+        return false;
+    }
+    for (size_t i = 0; i < code.size(); ++i) {
+        PutHalfword(rom, i * 2, code[i]);
+    }
+    for (size_t i = 0; i < program.blocks.size(); ++i) {
+        const std::vector<uint16_t>& halfwords = program.blocks[i].halfwords;
+        for (size_t j = 0; j < halfwords.size(); ++j) {
+            PutHalfword(rom, layout.blockOffsets[i] + j * 2, halfwords[j]);
+        }
+    }
+    PutWrites(rom, layout.vipTableOffset, program.vipWrites);
+    PutWrites(rom, layout.vsuTableOffset, program.vsuWrites);
+
+    // Header: 20-byte title, 5 reserved, maker, game code, version.
+    const size_t header = size - kHeaderOffsetFromEnd;
+    std::fill(rom.begin() + static_cast<std::ptrdiff_t>(header),
+              rom.begin() + static_cast<std::ptrdiff_t>(header + 20), ' ');
+    std::copy_n(program.title.begin(), std::min<size_t>(program.title.size(), 20),
+                rom.begin() + static_cast<std::ptrdiff_t>(header));
+    const char ids[] = "ZZVSYN";
+    std::copy_n(ids, 6, rom.begin() + static_cast<std::ptrdiff_t>(header + 25));
+
+    // Interrupts stay disabled, but every vector returns in case one is taken anyway.
+    for (size_t vector = size - kVectorsOffsetFromEnd; vector < size - 0x10; vector += 0x10) {
+        V810Assembler stub(0);
+        stub.reti();
+        std::vector<uint16_t> reti;
+        stub.finish(reti, error);
+        PutHalfword(rom, vector, reti[0]);
+    }
+    V810Assembler reset(kResetVector);
+    reset.loadConstant(kRomBase, 1);
+    reset.reg(V810Op::Jmp, 1, 0);
+    std::vector<uint16_t> resetCode;
+    reset.finish(resetCode, error);
+    for (size_t i = 0; i < resetCode.size(); ++i) {
+        PutHalfword(rom, size - 0x10 + i * 2, resetCode[i]);
+    }
+    return true;
+}
+
+bool WriteRom(const WorkloadInfo& info, const Options& options, const std::string& path) {
+    Program program;
+    if (!BuildProgram(info.workload, options, program)) {
+        return false;
+    }
+    program.title = std::string("SYNTH ") + info.name;
+    std::vector<uint8_t> rom;
+    std::string error;
+    if (!AssembleRom(program, rom, error)) {
+        std::fprintf(stderr, "%s: %s\n", info.name, error.c_str());
+        return false;
+    }
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::fprintf(stderr, "cannot create %s\n", path.c_str());
+        return false;
+    }
+    bool ok = std::fwrite(rom.data(), 1, rom.size(), file) == rom.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::fprintf(stderr, "failed to write %s\n", path.c_str());
+        return false;
+    }
+    std::printf("%s: %s (%zu KB)\n", path.c_str(), info.description, rom.size() / 1024);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (options.list) {
+        for (const WorkloadInfo& info : kWorkloads) {
+            std::printf("%-11s %s\n", info.name, info.description);
+        }
+        return 0;
+    }
+    if (!options.allDirectory.empty()) {
+        bool ok = true;
+        for (const WorkloadInfo& info : kWorkloads) {
+            Options defaults = options;
+            if (info.workload == Workload::VipAffine) {
+                defaults.worlds = std::min(options.worlds, kMaxAffineWorlds);
+            }
+            ok = WriteRom(info, defaults,
+                          options.allDirectory + "/synth-" + info.name + ".vb") && ok;
+        }
+        return ok ? 0 : 1;
+    }
+    for (const WorkloadInfo& info : kWorkloads) {
+        if (options.workload == info.name) {
+            return WriteRom(info, options, options.outputPath) ? 0 : 1;
+        }
+    }
+    std::fprintf(stderr, "unknown workload %s (see --list)\n", options.workload.c_str());
+    return 2;
+}
@@ -0,0 +1,1557 @@
+// Headless harness for XrStereoRenderer: runs the real renderer against the mock OpenXR runtime
+// on a software EGL device, compares captured eye images with goldens and reports CPU time per
+// XR frame. The flat-screen GlRenderer gets the same treatment on a pbuffer.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <GLES3/gl3.h>
+#include <zlib.h>
+
+#include "app_loop.h"
+#include "display_timing.h"
+#include "frame_buffer_pool.h"
+#include "frame_capture.h"
+#include "info_pages.h"
+#include "info_panel.h"
+#include "log.h"
+#include "mock_runtime.h"
+#include "renderer_gl.h"
+#include "screenshot.h"
+#include "settings_store.h"
+#include "text_renderer.h"
+#include "thread_policy.h"
+#include "xr_stereo_renderer.h"
+
+namespace {
+
+constexpr int kVipEyeWidth = 384;
+constexpr int kVipEyeHeight = 224;
+constexpr int kSourceWidth = kVipEyeWidth * 2;
+constexpr int kSourceHeight = kVipEyeHeight;
+constexpr int kThumbnailSize = 64;
+// llvmpipe output shifts slightly between Mesa releases; compare thumbnails with slack.
+constexpr int kChannelTolerance = 6;
+constexpr double kMaxMismatchFraction = 0.01;
+constexpr int kFrameTimeoutMs = 5000;
+// Frames between the last source frame and the capture, covering the upload/render pipeline.
+constexpr int kSettleFrames = 4;
+// Shortest measure phase: every script reaches its last keyframe (1.2 s) within it at 90 Hz.
+constexpr int kMinMeasureFrames = 120;
+constexpr int kFlatWidth = 640;
+constexpr int kFlatHeight = 360;
+constexpr int kTextBenchIterations = 400;
+constexpr auto kLoopPausedTime = std::chrono::milliseconds(300);
+constexpr auto kLoopPauseSettleTime = std::chrono::milliseconds(50);
+constexpr int kLoopActiveFrames = 25;
+// A paused process that blocks costs microseconds; one whose loop or XR threads keep running
+// burns milliseconds every display frame.
+constexpr double kMaxPausedCpuMs = 5.0;
+constexpr double kMaxActiveCpuFraction = 0.25;
+constexpr int kPolicyFrames = 50;
+constexpr uint32_t kPolicyWorkIterations = 1500000;
+constexpr int kCaptureFrames = 150;
+// Raw frame with more colors than the palette holds.
+constexpr int kCaptureRawFrame = 60;
+constexpr size_t kCaptureAudioFrames = 877;
+// The frame loop hands frames over faster than a real VIP frame so the worker is stressed.
+constexpr auto kCaptureFrameInterval = std::chrono::milliseconds(3);
+constexpr double kMaxCaptureSubmitMs = 0.2;
+constexpr int kScreenshotBurst = 8;
+constexpr std::array<float, 4> kMockRefreshRates = {72.0f, 80.0f, 90.0f, 120.0f};
+
+struct Options {
+    std::string goldenDir = XR_HARNESS_GOLDEN_DIR;
+    std::string outputDir;
+    bool updateGoldens = false;
+    bool throttle = true;
+    int measureFrames = kMinMeasureFrames;
+};
+
+struct Scenario {
+    const char* name;
+    bool worldAnchored;
+    bool depthMetadata;
+    XrStereoRenderer::DepthRenderMode depthMode;
+    // Head motion during the measured frames; every script holds its last pose by the capture.
+    const char* script;
+};
+
+// The opening hold keeps the world anchor independent of which frame picks up the reset.
+constexpr char kLookAroundScript[] =
+    "0.0 head=0,0,0 yaw=0 pitch=0\n"
+    "0.1 head=0,0,0 yaw=0 pitch=0\n"
+    "0.4 head=0.05,0.02,-0.05 yaw=8 pitch=-4\n"
+    "0.8 head=-0.04,0,0.03 yaw=-6 pitch=3\n"
+    "1.2 head=0.02,0,-0.02 yaw=4 pitch=0\n";
+
+constexpr char kInputScript[] =
+    "0.0 head=0,0,0 yaw=0 pitch=0\n"
+    "0.2 /user/hand/right/input/a/click=1 /user/hand/left/input/thumbstick=-0.9,0\n"
+    "0.6 /user/hand/right/input/a/click=0 /user/hand/left/input/thumbstick=0,0\n";
+
+const Scenario kScenarios[] = {
+    {"classic", false, false, XrStereoRenderer::DepthRenderMode::Layers, kInputScript},
+    {"anchored", true, false, XrStereoRenderer::DepthRenderMode::Layers, kLookAroundScript},
+    {"depth_layers", true, true, XrStereoRenderer::DepthRenderMode::Layers, kLookAroundScript},
+    {"depth_mesh", true, true, XrStereoRenderer::DepthRenderMode::DisplacedMesh,
+     kLookAroundScript},
+};
+
+struct Rect {
+    int x0, y0, x1, y1;
+    uint8_t worldId;
+    int8_t disparity;
+    uint8_t red;
+};
+
+// A stand-in for one VIP frame: checkered backdrop, a far panel and a near sprite, each with
+// its own world id and disparity. motion slides the sprite so consecutive frames differ.
+void BuildSourceFrame(const int motion, std::vector<uint32_t>& pixels,
+                      std::vector<uint8_t>& depthPlane) {
+    const Rect rects[] = {
+        {40, 30, 200, 120, 5, -6, 0x90},
+        {220 + motion, 110, 330 + motion, 190, 9, 10, 0xFF},
+    };
+    pixels.assign(static_cast<size_t>(kSourceWidth) * kSourceHeight, 0);
+    depthPlane.assign(static_cast<size_t>(kSourceWidth) * kSourceHeight * 2, 0);
+    for (int eye = 0; eye < 2; ++eye) {
+        for (int y = 0; y < kVipEyeHeight; ++y) {
+            for (int x = 0; x < kVipEyeWidth; ++x) {
+                uint8_t red = ((x / 16 + y / 16) & 1) != 0 ? 0x50 : 0x30;
+                uint8_t worldId = 2;
+                int8_t disparity = 0;
+                for (const Rect& rect : rects) {
+                    // Each eye sees the object shifted by half its disparity.
+                    const int shift = eye == 0 ? rect.disparity / 2 : -rect.disparity / 2;
+                    if (x >= rect.x0 + shift && x < rect.x1 + shift && y >= rect.y0 &&
+                        y < rect.y1) {
+                        red = rect.red;
+                        worldId = rect.worldId;
+                        disparity = rect.disparity;
+                    }
+                }
+                const size_t index = static_cast<size_t>(y) * kSourceWidth +
+                                     static_cast<size_t>(eye * kVipEyeWidth + x);
+                pixels[index] = 0xFF000000u | red;
+                depthPlane[index * 2] = worldId;
+                depthPlane[index * 2 + 1] = static_cast<uint8_t>(disparity);
+            }
+        }
+    }
+}
+
+bool SubmitSourceFrame(XrStereoRenderer& renderer, const int motion, const uint32_t frameId,
+                       const int64_t inputSampleNs = 0) {
+    static std::vector<uint32_t> pixels;
+    static std::vector<uint8_t> depthPlane;
+    BuildSourceFrame(motion, pixels, depthPlane);
+    renderer.updateFrame(pixels.data(), kSourceWidth, kSourceHeight);
+    renderer.updateDepthMetadata(depthPlane.data(), nullptr, nullptr, kSourceWidth,
+                                 kSourceHeight, frameId);
+    return renderer.submitFrame(inputSampleNs);
+}
+
+bool WaitFrames(const int count) {
+    return MockXrWaitForEndedFrames(MockXrEndedFrameCount() + static_cast<uint64_t>(count),
+                                    kFrameTimeoutMs);
+}
+
+// Box-filters the capture down to a fixed thumbnail so goldens do not depend on the
+// dynamic-resolution scale the renderer picked.
+std::vector<uint8_t> Thumbnail(const MockXrImage& image) {
+    std::vector<uint8_t> rgb(static_cast<size_t>(kThumbnailSize) * kThumbnailSize * 3);
+    for (int ty = 0; ty < kThumbnailSize; ++ty) {
+        const int y0 = ty * image.height / kThumbnailSize;
+        const int y1 = std::max(y0 + 1, (ty + 1) * image.height / kThumbnailSize);
+        for (int tx = 0; tx < kThumbnailSize; ++tx) {
+            const int x0 = tx * image.width / kThumbnailSize;
+            const int x1 = std::max(x0 + 1, (tx + 1) * image.width / kThumbnailSize);
+            uint32_t sum[3] = {};
+            for (int y = y0; y < y1; ++y) {
+                const uint8_t* row = image.rgba + static_cast<size_t>(y) * image.width * 4;
+                for (int x = x0; x < x1; ++x) {
+                    for (int c = 0; c < 3; ++c) {
+                        sum[c] += row[x * 4 + c];
+                    }
+                }
+            }
+            const uint32_t area = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+            for (int c = 0; c < 3; ++c) {
+                rgb[(static_cast<size_t>(ty) * kThumbnailSize + tx) * 3 + c] =
+                    static_cast<uint8_t>((sum[c] + area / 2) / area);
+            }
+        }
+    }
+    return rgb;
+}
+
+bool WritePpm(const std::string& path, const int width, const int height,
+              const std::vector<uint8_t>& rgb) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    return static_cast<bool>(file);
+}
+
+bool ReadPpm(const std::string& path, int& width, int& height, std::vector<uint8_t>& rgb) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    if (!(file >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255) {
+        return false;
+    }
+    file.get();
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    file.read(reinterpret_cast<char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    return static_cast<bool>(file);
+}
+
+std::vector<uint8_t> DropAlpha(const MockXrImage& image) {
+    std::vector<uint8_t> rgb(static_cast<size_t>(image.width) * image.height * 3);
+    for (size_t i = 0; i < static_cast<size_t>(image.width) * image.height; ++i) {
+        std::memcpy(&rgb[i * 3], &image.rgba[i * 4], 3);
+    }
+    return rgb;
+}
+
+bool CompareWithGolden(const Options& options, const std::string& name,
+                       const std::vector<uint8_t>& thumbnail) {
+    const std::string goldenPath = options.goldenDir + "/" + name + ".ppm";
+    if (options.updateGoldens) {
+        if (!WritePpm(goldenPath, kThumbnailSize, kThumbnailSize, thumbnail)) {
+            std::fprintf(stderr, "  %s: could not write %s\n", name.c_str(), goldenPath.c_str());
+            return false;
+        }
+        std::printf("  %s: golden updated\n", name.c_str());
+        return true;
+    }
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> golden;
+    if (!ReadPpm(goldenPath, width, height, golden) || width != kThumbnailSize ||
+        height != kThumbnailSize) {
+        std::fprintf(stderr, "  %s: missing or malformed golden %s\n", name.c_str(),
+                     goldenPath.c_str());
+        return false;
+    }
+    size_t mismatched = 0;
+    int worstDiff = 0;
+    for (size_t pixel = 0; pixel < golden.size() / 3; ++pixel) {
+        int diff = 0;
+        for (int c = 0; c < 3; ++c) {
+            diff = std::max(diff, std::abs(golden[pixel * 3 + c] - thumbnail[pixel * 3 + c]));
+        }
+        worstDiff = std::max(worstDiff, diff);
+        mismatched += diff > kChannelTolerance ? 1 : 0;
+    }
+    const double fraction = static_cast<double>(mismatched) / (golden.size() / 3.0);
+    const bool pass = fraction <= kMaxMismatchFraction;
+    std::printf("  %s: %s (%.2f%% pixels off, worst channel diff %d)\n", name.c_str(),
+                pass ? "match" : "MISMATCH", fraction * 100.0, worstDiff);
+    return pass;
+}
+
+void PrintCpuTimes(const char* label, std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for (const double t : times) {
+        sum += t;
+    }
+    auto percentile = [&times](const double p) {
+        return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+    };
+    std::printf("  cpu per %s (ms): mean %.3f  p50 %.3f  p95 %.3f  max %.3f\n", label,
+                sum / static_cast<double>(times.size()), percentile(0.5), percentile(0.95),
+                times.back());
+}
+
+void ReportCpuTimes(std::vector<double> times, const uint64_t resubmitted) {
+    if (times.empty()) {
+        std::printf("  cpu: no rendered frames recorded (%llu resubmitted)\n",
+                    static_cast<unsigned long long>(resubmitted));
+        return;
+    }
+    const size_t rendered = times.size();
+    PrintCpuTimes("rendered XR frame", std::move(times));
+    std::printf("  %zu frames rendered, %llu resubmitted\n", rendered,
+                static_cast<unsigned long long>(resubmitted));
+}
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+double ThreadCpuMs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1.0e3 + static_cast<double>(ts.tv_nsec) * 1.0e-6;
+}
+
+double ProcessCpuMs() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1.0e3 + static_cast<double>(ts.tv_nsec) * 1.0e-6;
+}
+
+// Flat-screen fallback on a pbuffer: streams moving frames with presentation times on the VB
+// clock, then captures a fixed frame. Runs after the XR renderer has released EGL.
+bool RunFlatRenderer(const Options& options) {
+    FlushLog();
+    std::printf("flat\n");
+    GlRenderer renderer;
+    if (!renderer.initializeOffscreen(kFlatWidth, kFlatHeight)) {
+        std::fprintf(stderr, "  flat renderer failed to initialize\n");
+        return false;
+    }
+
+    std::vector<uint32_t> pixels;
+    std::vector<uint8_t> depthPlane;
+    EmulationPacer pacer(kVbRefreshHz);
+    std::vector<double> times;
+    for (int i = 0; i <= options.measureFrames; ++i) {
+        // The last frame is the fixed capture frame.
+        BuildSourceFrame(i < options.measureFrames ? i % 40 : 0, pixels, depthPlane);
+        pacer.nextFrameStart(std::chrono::steady_clock::now(), DisplayPhase{});
+        const double start = ThreadCpuMs();
+        renderer.updateFrame(pixels.data(), kSourceWidth, kSourceHeight);
+        renderer.render(pacer.presentTimeNs());
+        times.push_back(ThreadCpuMs() - start);
+    }
+    PrintCpuTimes("flat frame", std::move(times));
+    std::printf("  presentation time: %s\n",
+                renderer.presentationTimeSupported() ? "supported" : "unsupported");
+
+    // The pbuffer keeps its contents across eglSwapBuffers; GL rows run bottom-up.
+    std::vector<uint8_t> rgba(static_cast<size_t>(kFlatWidth) * kFlatHeight * 4);
+    glReadPixels(0, 0, kFlatWidth, kFlatHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    const bool readOk = glGetError() == GL_NO_ERROR;
+    renderer.shutdown();
+    if (!readOk) {
+        std::fprintf(stderr, "  flat readback failed\n");
+        return false;
+    }
+    const size_t rowBytes = static_cast<size_t>(kFlatWidth) * 4;
+    for (int y = 0; y < kFlatHeight / 2; ++y) {
+        std::swap_ranges(rgba.begin() + static_cast<std::ptrdiff_t>(y * rowBytes),
+                         rgba.begin() + static_cast<std::ptrdiff_t>((y + 1) * rowBytes),
+                         rgba.begin() +
+                             static_cast<std::ptrdiff_t>((kFlatHeight - 1 - y) * rowBytes));
+    }
+    const MockXrImage image{kFlatWidth, kFlatHeight, rgba.data()};
+    if (!options.outputDir.empty()) {
+        WritePpm(options.outputDir + "/flat.ppm", image.width, image.height, DropAlpha(image));
+    }
+    return CompareWithGolden(options, "flat", Thumbnail(image));
+}
+
+bool RunScenario(XrStereoRenderer& renderer, const Scenario& scenario, const Options& options) {
+    FlushLog();
+    std::printf("%s\n", scenario.name);
+    renderer.setWorldAnchoredEnabled(scenario.worldAnchored);
+    renderer.setDepthMetadataEnabled(scenario.depthMetadata);
+    renderer.setDepthRenderMode(scenario.depthMode);
+    renderer.setDynamicResolutionEnabled(true);
+    renderer.resetWorldAnchor();
+    if (!MockXrSetScript(scenario.script)) {
+        return false;
+    }
+
+    std::vector<double> discarded(4096);
+    MockXrTakeFrameCpuTimes(discarded.data(), discarded.size());
+    const uint64_t resubmittedBefore = MockXrResubmittedFrameCount();
+    const uint64_t depthAcquiresBefore = MockXrDepthImagesAcquired();
+    const uint64_t syncsBefore = MockXrSyncActionsCount();
+    bool sawButtonA = false;
+    bool sawStickLeft = false;
+    uint32_t frameId = 1;
+    for (int i = 0; i < options.measureFrames; ++i) {
+        // Late-latched like the app: input is read right before the frame is produced.
+        const int64_t inputSampleNs = SteadyNowNs();
+        renderer.syncInput();
+        XrStereoRenderer::ControllerState controller{};
+        renderer.getControllerState(controller);
+        sawButtonA |= controller.a;
+        sawStickLeft |= controller.left;
+        SubmitSourceFrame(renderer, i % 40, frameId++, inputSampleNs);
+        if (!WaitFrames(1)) {
+            std::fprintf(stderr, "  timed out waiting for XR frames\n");
+            return false;
+        }
+    }
+    // The late sync above is the only one per frame; submitFrame must not sync again.
+    const uint64_t syncs = MockXrSyncActionsCount() - syncsBefore;
+    std::vector<double> times(static_cast<size_t>(options.measureFrames) * 4);
+    times.resize(MockXrTakeFrameCpuTimes(times.data(), times.size()));
+    const uint64_t resubmitted = MockXrResubmittedFrameCount() - resubmittedBefore;
+
+    // Capture a fixed source frame at the full eye size so the result is reproducible; the
+    // scale dynamic resolution settles on depends on llvmpipe timing.
+    const XrStereoRenderer::RenderDebugState measured = renderer.renderDebugState();
+    renderer.setDynamicResolutionEnabled(false);
+    SubmitSourceFrame(renderer, 0, frameId);
+    if (!WaitFrames(kSettleFrames)) {
+        std::fprintf(stderr, "  timed out settling before capture\n");
+        return false;
+    }
+    MockXrCaptureNextFrame();
+    if (!MockXrWaitForCapture(kFrameTimeoutMs)) {
+        std::fprintf(stderr, "  capture timed out\n");
+        return false;
+    }
+
+    const XrStereoRenderer::RenderDebugState debug = renderer.renderDebugState();
+    ReportCpuTimes(std::move(times), resubmitted);
+    std::printf("  path: %s  depth layer: %s  dynamic resolution %.2f  refresh %.1f Hz\n",
+                debug.usedDisplacedMesh    ? "displaced mesh"
+                : debug.usedLayerRendering ? "layers"
+                : debug.usedDepthFallback  ? "depth fallback"
+                                           : "classic",
+                debug.depthSubmitted ? "yes" : "no", measured.resolutionScale,
+                debug.displayRefreshHz);
+    std::printf("  input to photon: %.1f ms\n", measured.inputLatencyMs);
+
+    bool pass = true;
+    if (scenario.script == kInputScript && (!sawButtonA || !sawStickLeft)) {
+        std::fprintf(stderr, "  scripted input not seen (A %d, stick left %d)\n", sawButtonA,
+                     sawStickLeft);
+        pass = false;
+    }
+    if (syncs != static_cast<uint64_t>(options.measureFrames)) {
+        std::fprintf(stderr, "  %llu input syncs for %d frames\n",
+                     static_cast<unsigned long long>(syncs), options.measureFrames);
+        pass = false;
+    }
+    // Head-locked content submits no depth, so it must not touch the depth swapchains.
+    const uint64_t depthAcquires = MockXrDepthImagesAcquired() - depthAcquiresBefore;
+    if (!scenario.worldAnchored && !scenario.depthMetadata && depthAcquires != 0) {
+        std::fprintf(stderr, "  %llu depth images acquired for head-locked content\n",
+                     static_cast<unsigned long long>(depthAcquires));
+        pass = false;
+    }
+    const bool wantMesh = scenario.depthMetadata &&
+                          scenario.depthMode == XrStereoRenderer::DepthRenderMode::DisplacedMesh;
+    if (wantMesh != debug.usedDisplacedMesh) {
+        std::fprintf(stderr, "  expected %s path\n", wantMesh ? "displaced mesh" : "non-mesh");
+        pass = false;
+    }
+    for (uint32_t eye = 0; eye < 2; ++eye) {
+        MockXrImage image{};
+        if (!MockXrCapturedEye(eye, &image)) {
+            return false;
+        }
+        const std::string name = std::string(scenario.name) + (eye == 0 ? "_left" : "_right");
+        if (!options.outputDir.empty()) {
+            WritePpm(options.outputDir + "/" + name + ".ppm", image.width, image.height,
+                     DropAlpha(image));
+        }
+        pass &= CompareWithGolden(options, name, Thumbnail(image));
+    }
+    return pass;
+}
+
+bool WaitForSession(XrStereoRenderer& renderer, const bool running) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        renderer.pollEvents();
+        if (running ? renderer.sessionRunning() : renderer.exitRequested()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// The text path before the glyph blitter: one clipped FillRect per lit glyph pixel.
+void DrawTextPerPixel(std::vector<uint32_t>& frame, const int frameWidth, const int frameHeight,
+                      const std::string& text, int x, const int y, const int scale,
+                      const uint32_t color) {
+    const int advance = (kGlyphWidth * scale) + (kTextSpacing * scale);
+    for (const char ch : ToUpperAscii(text)) {
+        const Glyph& glyph = GetGlyph(ch);
+        for (int row = 0; row < kGlyphHeight; ++row) {
+            for (int col = 0; col < kGlyphWidth; ++col) {
+                if ((glyph[row] & (1u << (kGlyphWidth - 1 - col))) != 0) {
+                    FillRect(frame, frameWidth, frameHeight, x + (col * scale), y + (row * scale),
+                             scale, scale, color);
+                }
+            }
+        }
+        x += advance;
+    }
+}
+
+// The info panel before it was retained: rebuilt, fitted a character at a time and drawn
+// from scratch for every eye of every frame.
+void DrawInfoPanelReference(std::vector<uint32_t>& frame, const int frameWidth,
+                            const int frameHeight, const int eyeOffsetX, const int eyeWidth,
+                            const std::vector<std::string>& lines) {
+    const int lineHeight = (kGlyphHeight * kTextScale) + 1;
+    const int padding = 6;
+    const int panelWidth = std::min(eyeWidth - 12, 360);
+    const int panelHeight = (padding * 2) + (lineHeight * static_cast<int>(lines.size()));
+    const int panelX = eyeOffsetX + ((eyeWidth - panelWidth) / 2);
+    const int panelY = (frameHeight - panelHeight) / 2;
+    FillRect(frame, frameWidth, frameHeight, panelX, panelY, panelWidth, panelHeight, 0xFF080808);
+    FillRect(frame, frameWidth, frameHeight, panelX, panelY, panelWidth, 2, 0xFFFFFFFF);
+    FillRect(frame, frameWidth, frameHeight, panelX, panelY + panelHeight - 2, panelWidth, 2,
+             0xFFFFFFFF);
+    FillRect(frame, frameWidth, frameHeight, panelX, panelY, 2, panelHeight, 0xFFFFFFFF);
+    FillRect(frame, frameWidth, frameHeight, panelX + panelWidth - 2, panelY, 2, panelHeight,
+             0xFFFFFFFF);
+    const int maxTextWidth = panelWidth - (padding * 2);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::string fitted = ToUpperAscii(lines[i]);
+        while (!fitted.empty() && TextWidthPixels(fitted, kTextScale) > maxTextWidth) {
+            fitted.pop_back();
+        }
+        DrawTextPerPixel(frame, frameWidth, frameHeight, fitted, panelX + padding,
+                         panelY + padding + (static_cast<int>(i) * lineHeight), kTextScale,
+                         0xFFFFFFFF);
+    }
+}
+
+// Per-frame cost of the info panel when only the FPS line changes, against the old rebuild,
+// on both eyes of a source frame. The retained panel must draw the same pixels.
+bool RunInfoPanelBench(std::vector<std::string> lines) {
+    lines.push_back("a line far too long for the panel, cut to fit its width at the right edge");
+    std::vector<uint32_t> reference(static_cast<size_t>(kSourceWidth) * kSourceHeight, 0xFF202020);
+    std::vector<uint32_t> retained = reference;
+    InfoPanel panel;
+    const uint64_t firstGeneration = panel.generation();
+    char fps[32];
+    auto timeFrames = [&](auto&& drawFrame) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kTextBenchIterations; ++i) {
+            std::snprintf(fps, sizeof(fps), "FPS: %.1f", 50.0 + (i % 4) * 0.1);
+            lines[1] = fps;
+            drawFrame();
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / kTextBenchIterations;
+    };
+    const double referenceUs = timeFrames([&] {
+        for (int eye = 0; eye < 2; ++eye) {
+            DrawInfoPanelReference(reference, kSourceWidth, kSourceHeight, eye * kVipEyeWidth,
+                                   kVipEyeWidth, lines);
+        }
+    });
+    const double retainedUs = timeFrames([&] {
+        for (size_t i = 0; i < lines.size(); ++i) {
+            panel.setLine(i, lines[i]);
+        }
+        panel.setLineCount(lines.size());
+        for (int eye = 0; eye < 2; ++eye) {
+            panel.draw(retained, kSourceWidth, kSourceHeight, eye * kVipEyeWidth, kVipEyeWidth);
+        }
+    });
+    std::printf("  info panel per frame (us): rebuilt %.1f  retained %.1f  (%.1fx)\n",
+                referenceUs, retainedUs, referenceUs / std::max(retainedUs, 1.0e-3));
+
+    // Setting identical lines must not bump the generation.
+    const uint64_t generation = panel.generation();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        panel.setLine(i, lines[i]);
+    }
+    panel.setLineCount(lines.size());
+    const bool stable = panel.generation() == generation && generation != firstGeneration;
+    const bool same = reference == retained;
+    std::printf("  info panel: %s, generation %s\n", same ? "identical" : "DIFFERS",
+                stable ? "stable" : "UNSTABLE");
+    return same && stable;
+}
+
+// Every info panel page, with each optional line present and the widest values, must fit
+// the 224-line VIP frame it is drawn over, and each line must fit an eye-wide panel.
+bool RunInfoPages() {
+    FlushLog();
+    std::printf("info pages\n");
+    InfoPanelStatus status;
+    status.fps = 50.3;
+    status.frameWorkMeanMs = 100.0;
+    status.frameWorkStddevMs = 10.0;
+    constexpr size_t kWideBytes = 100 * 1024 * 1024;
+    status.memory.bytes.fill(kWideBytes);
+    status.memory.totalBytes = kWideBytes * 10;
+    status.memory.growths = 999;
+    status.xrSession = true;
+    status.displayRefreshHz = 120.0f;
+    status.cadenceRepeats = 12;
+    status.judderPercent = 100.0f;
+    status.gpuTimerAvailable = true;
+    status.frameGpuTimeMs = 100.0f;
+    status.layerGpuTimeMs = 100.0f;
+    status.meshGpuTimeMs = 100.0f;
+    status.inputLatencyMs = 100.0f;
+    status.hasMetadata = true;
+    status.romLine = "ROM: NONE";
+    status.viewMode = "ANCHORED";
+    status.depthRenderMode = "LAYERS";
+    status.screenshotMode = "ANAGLYPH";
+    status.capturing = true;
+    status.captureBytes = uint64_t{999} * 1024 * 1024;
+    status.captureDropped = 99999;
+    status.screenScale = 1.0f;
+    status.stereoConvergence = -0.125f;
+
+    const int maxTextWidth = InfoPanel::TextWidthFor(kVipEyeWidth);
+    bool pass = true;
+    for (const bool anchored : {false, true}) {
+        status.worldAnchored = anchored;
+        for (const InfoPage page : {InfoPage::Controls, InfoPage::Stats}) {
+            const char* name = page == InfoPage::Controls ? "controls" : "stats";
+            InfoPanel panel;
+            BuildInfoPage(page, status, panel);
+            const int height = InfoPanel::HeightFor(panel.lineCount());
+            std::printf("  %s %s: %zu lines, %d of %d px\n", name,
+                        anchored ? "anchored" : "classic", panel.lineCount(), height,
+                        kVipEyeHeight);
+            if (height > kVipEyeHeight) {
+                std::fprintf(stderr, "  %s page does not fit the frame\n", name);
+                pass = false;
+            }
+            for (size_t i = 0; i < panel.lineCount(); ++i) {
+                if (TextWidthPixels(ToUpperAscii(panel.line(i)), kTextScale) > maxTextWidth) {
+                    std::fprintf(stderr, "  cut off: \"%s\"\n", panel.line(i).c_str());
+                    pass = false;
+                }
+            }
+        }
+    }
+    return pass;
+}
+
+std::mutex gLogLinesMutex;
+std::vector<std::string> gLogLines;
+
+void CaptureLogLine(const LogLevel level, const char* line) {
+    // Only the harness's own "log:" lines; the renderer keeps logging in the background.
+    if (level == LogLevel::Warn && std::strncmp(line, "log:", 4) == 0) {
+        std::lock_guard<std::mutex> lock(gLogLinesMutex);
+        gLogLines.emplace_back(line);
+    }
+}
+
+// One LOGW call site for every format, so at most kSiteBurst calls per second.
+template <typename... Args>
+void LogAndExpect(std::vector<std::string>& expected, const char* format, const Args&... args) {
+    LOGW(format, args...);
+    char line[512];
+    std::snprintf(line, sizeof(line), format, args...);
+    expected.emplace_back(line);
+}
+
+// The logger formats on its writer thread from captured arguments; its output must match
+// snprintf's for the conversions the app uses, including '*' widths. Long string arguments
+// are truncated to the record's text budget, and a site over its budget reports the
+// suppressed count with its next message.
+bool RunLogFormat() {
+    FlushLog();
+    std::printf("log format\n");
+    // log.cpp's kTextBytes: a copied string keeps at most this minus its terminator.
+    constexpr size_t kLogTextBytes = 320;
+    std::vector<std::string> expected;
+    SetLogSink(CaptureLogLine);
+    LogAndExpect(expected, "log: %d %u %x %lld %zu %c", -42, 42u, -1, 1LL << 40, size_t{7}, 'k');
+    LogAndExpect(expected, "log: %5.2f|%-8s|%08.3e|%g|%%", 3.14159, "ab", 12345.678, 0.0001);
+    LogAndExpect(expected, "log: %*d|%-*d|%.*s|%*.1f", 6, 42, 4, 7, 3, "abcdef", 9, 2.5);
+    LogAndExpect(expected, "log: %.*s|%+05d|%#x|%.3s|%10.4s|", -1, "all", 7, 255u, "truncate",
+                 "string");
+    LogAndExpect(expected, "log: %s %hu %lu", std::string("temporary").c_str(),
+                 static_cast<unsigned short>(65535), 1UL << 33);
+    const std::string longText(kLogTextBytes + 80, 'x');
+    LOGW("log: %s", longText.c_str());
+    expected.push_back("log: " + longText.substr(0, kLogTextBytes - 1));
+    // Burst over the site's budget, then a message in the next window.
+    for (uint32_t i = 0; i <= log_detail::kSiteBurst + 4; ++i) {
+        if (i == log_detail::kSiteBurst + 4) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(log_detail::kSiteWindowNs));
+        }
+        LOGW("log: burst %u", i);
+        if (i < log_detail::kSiteBurst) {
+            expected.push_back("log: burst " + std::to_string(i));
+        }
+    }
+    expected.push_back("log: burst " + std::to_string(log_detail::kSiteBurst + 4) +
+                       " (4 similar suppressed)");
+    FlushLog();
+    SetLogSink(nullptr);
+
+    std::lock_guard<std::mutex> lock(gLogLinesMutex);
+    bool pass = gLogLines.size() == expected.size();
+    for (size_t i = 0; i < std::max(gLogLines.size(), expected.size()); ++i) {
+        const char* got = i < gLogLines.size() ? gLogLines[i].c_str() : "(missing)";
+        const char* want = i < expected.size() ? expected[i].c_str() : "(none)";
+        if (std::strcmp(got, want) != 0) {
+            std::fprintf(stderr, "  logged \"%s\"\n  wanted \"%s\"\n", got, want);
+            pass = false;
+        }
+    }
+    std::printf("  %zu lines %s snprintf\n", gLogLines.size(), pass ? "match" : "DIFFER from");
+    gLogLines.clear();
+    return pass;
+}
+
+// Microbenchmark of DrawText against the per-pixel path on an info-panel sized block of text,
+// including lines clipped at each frame edge; both must produce the same pixels.
+bool RunTextBench() {
+    std::printf("text\n");
+    const std::vector<std::string> lines = {
+        "push right stick to close", "FPS: 50.3", "REFRESH: 90.0 HZ X2 JUDDER 0.4%",
+        "LATENCY: 21.7 MS", "ROM: WARIO LAND (JAPAN).VB", "VIEW: ANCHORED (TOGGLE \"B\")",
+        "  L-STICK: MOVE", "  R-STICK: LOOK", "SCREEN SIZE: 0.62", "STEREO: -0.040 (L+R)",
+        "CALIBRATE: HOLD L+R", "  +/- 1234567890"};
+    const int lineHeight = (kGlyphHeight * kTextScale) + 1;
+    using DrawFn = void (*)(std::vector<uint32_t>&, int, int, const std::string&, int, int, int,
+                            uint32_t);
+    auto drawPanel = [&](DrawFn draw, std::vector<uint32_t>& frame) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const int y = 6 + static_cast<int>(i) * lineHeight;
+            draw(frame, kSourceWidth, kSourceHeight, lines[i], 12, y, kTextScale, 0xFFFFFFFF);
+        }
+        draw(frame, kSourceWidth, kSourceHeight, lines[2], -7, kSourceHeight - 9, kTextScale,
+             0xFF00FF00);
+        draw(frame, kSourceWidth, kSourceHeight, lines[4], kSourceWidth - 150, -5, kTextScale,
+             0xFF00FF00);
+        draw(frame, kSourceWidth, kSourceHeight, lines[5], 400, 200, 1, 0xFF0000FF);
+    };
+    auto timePanels = [&](DrawFn draw, std::vector<uint32_t>& frame) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kTextBenchIterations; ++i) {
+            drawPanel(draw, frame);
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / kTextBenchIterations;
+    };
+
+    std::vector<uint32_t> reference(static_cast<size_t>(kSourceWidth) * kSourceHeight, 0xFF080808);
+    std::vector<uint32_t> blitted = reference;
+    const double referenceUs = timePanels(DrawTextPerPixel, reference);
+    const double blittedUs = timePanels(DrawText, blitted);
+    std::printf("  per panel (us): per-pixel fills %.1f  glyph blitter %.1f  (%.1fx)\n",
+                referenceUs, blittedUs, referenceUs / std::max(blittedUs, 1.0e-3));
+    const bool same = reference == blitted;
+    std::printf("  output: %s\n", same ? "identical" : "DIFFERS");
+    return same && RunInfoPanelBench(lines);
+}
+
+// AppLoop, android_main's schedule, with a pipe standing in for the ALooper and its lifecycle
+// commands. Paused, the XR frame threads must go idle and the loop may only wake for the slow
+// XR event poll; resumed, frames must flow again without the loop busy-waiting; and an exit
+// the runtime requests while the app is paused must still end the session.
+bool RunAppLoop(XrStereoRenderer& renderer) {
+    FlushLog();
+    std::printf("app loop\n");
+    int fds[2] = {-1, -1};
+    if (pipe(fds) != 0) {
+        std::fprintf(stderr, "  pipe failed\n");
+        return false;
+    }
+    using Clock = std::chrono::steady_clock;
+    AppLoop loop(renderer);
+    uint32_t frameId = 1;
+    int framesRun = 0;
+    double frameCpuMs = 0.0;
+    auto frame = [&] {
+        const double startMs = ThreadCpuMs();
+        SubmitSourceFrame(renderer, framesRun % 40, frameId++, SteadyNowNs());
+        frameCpuMs += ThreadCpuMs() - startMs;
+        ++framesRun;
+    };
+    // One pass of android_main: handle lifecycle commands until the next wake-up is due.
+    auto iterate = [&] {
+        pollfd looper{fds[0], POLLIN, 0};
+        while (poll(&looper, 1, LooperTimeoutMs(loop.nextWakeTime(), Clock::now())) > 0) {
+            char command = 0;
+            if (read(fds[0], &command, 1) == 1) {
+                loop.setResumed(command == 'r');
+            }
+        }
+        loop.tick(frame);
+    };
+    auto send = [&fds](const char command) { (void)!write(fds[1], &command, 1); };
+    auto runFrames = [&](const int count) {
+        const int target = framesRun + count;
+        while (framesRun < target) {
+            iterate();
+        }
+    };
+
+    loop.setRunning(true);
+    send('r');
+    const uint64_t endedBeforeActive = MockXrEndedFrameCount();
+    const double activeStartMs = ThreadCpuMs();
+    const auto activeStart = Clock::now();
+    runFrames(kLoopActiveFrames);
+    // Only the loop's own cost; the frame work is measured elsewhere.
+    const double activeCpuMs = ThreadCpuMs() - activeStartMs - frameCpuMs;
+    const double activeWallMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - activeStart).count();
+    const uint64_t activeXrFrames = MockXrEndedFrameCount() - endedBeforeActive;
+
+    send('p');
+    while (loop.active()) {
+        iterate();
+    }
+    // The frame the XR threads had in flight still ends.
+    std::this_thread::sleep_for(kLoopPauseSettleTime);
+    const uint64_t endedBeforePause = MockXrEndedFrameCount();
+    const double pausedStartMs = ProcessCpuMs();
+    uint64_t pausedXrFrames = 0;
+    double pausedCpuMs = 0.0;
+    std::thread lifecycle([&] {
+        std::this_thread::sleep_for(kLoopPausedTime);
+        pausedXrFrames = MockXrEndedFrameCount() - endedBeforePause;
+        pausedCpuMs = ProcessCpuMs() - pausedStartMs;
+        send('r');
+    });
+    int pausedWakeups = 0;
+    while (!loop.active()) {
+        iterate();
+        ++pausedWakeups;
+    }
+    lifecycle.join();
+
+    const uint64_t endedBeforeResume = MockXrEndedFrameCount();
+    runFrames(kLoopActiveFrames);
+    const uint64_t resumedXrFrames = MockXrEndedFrameCount() - endedBeforeResume;
+
+    send('p');
+    while (loop.active()) {
+        iterate();
+    }
+    MockXrRequestExit();
+    const auto exitStart = Clock::now();
+    while (!renderer.exitRequested() && Clock::now() - exitStart < std::chrono::seconds(5)) {
+        iterate();
+    }
+    const double exitMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - exitStart).count();
+    close(fds[0]);
+    close(fds[1]);
+
+    std::printf("  running %d frames in %.0f ms: loop cpu %.2f ms, %llu XR frames\n",
+                kLoopActiveFrames, activeWallMs, activeCpuMs,
+                static_cast<unsigned long long>(activeXrFrames));
+    std::printf("  paused %lld ms: process cpu %.2f ms, %d wakeups, %llu XR frames\n",
+                static_cast<long long>(kLoopPausedTime.count()), pausedCpuMs, pausedWakeups,
+                static_cast<unsigned long long>(pausedXrFrames));
+    std::printf("  resumed: %llu XR frames; exit while paused handled in %.0f ms\n",
+                static_cast<unsigned long long>(resumedXrFrames), exitMs);
+
+    bool pass = true;
+    if (activeCpuMs > activeWallMs * kMaxActiveCpuFraction) {
+        std::fprintf(stderr, "  main loop is busy-waiting\n");
+        pass = false;
+    }
+    const int maxPausedWakeups =
+        static_cast<int>(kLoopPausedTime / AppLoop::kPausedEventPollInterval) + 2;
+    if (pausedXrFrames != 0 || pausedCpuMs > kMaxPausedCpuMs ||
+        pausedWakeups > maxPausedWakeups) {
+        std::fprintf(stderr, "  paused app is not idle\n");
+        pass = false;
+    }
+    if (activeXrFrames == 0 || resumedXrFrames == 0) {
+        std::fprintf(stderr, "  XR frames did not run while resumed\n");
+        pass = false;
+    }
+    if (!renderer.exitRequested() || renderer.sessionRunning()) {
+        std::fprintf(stderr, "  session did not exit cleanly\n");
+        pass = false;
+    }
+    return pass;
+}
+
+// Writes a fake cpufreq tree with the given per-core maximum frequencies.
+CpuTopology FakeTopology(const std::filesystem::path& root, const std::vector<int>& khz) {
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    std::ofstream(root / "possible") << "0-" << khz.size() - 1 << "\n";
+    for (size_t cpu = 0; cpu < khz.size(); ++cpu) {
+        const auto dir = root / ("cpu" + std::to_string(cpu)) / "cpufreq";
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir / "cpuinfo_max_freq") << khz[cpu] << "\n";
+    }
+    const CpuTopology topology = ReadCpuTopology(root.c_str());
+    std::filesystem::remove_all(root);
+    return topology;
+}
+
+struct PacedRun {
+    FrameTimeStats work;
+    FrameTimeStats lateness;
+};
+
+// Paced emulation-sized frames of synthetic work on the calling thread.
+PacedRun RunPacedFrames() {
+    using Clock = std::chrono::steady_clock;
+    PacedRun run;
+    EmulationPacer pacer(kVbRefreshHz);
+    Clock::time_point deadline = pacer.nextFrameStart(Clock::now(), DisplayPhase{});
+    volatile uint32_t sink = 0;
+    for (int frame = 0; frame < kPolicyFrames; ++frame) {
+        std::this_thread::sleep_until(deadline);
+        const auto start = Clock::now();
+        uint32_t x = 2463534242u + static_cast<uint32_t>(frame);
+        for (uint32_t i = 0; i < kPolicyWorkIterations; ++i) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+        }
+        sink = x;
+        const auto end = Clock::now();
+        run.lateness.add(std::chrono::duration<double, std::milli>(start - deadline).count());
+        run.work.add(std::chrono::duration<double, std::milli>(end - start).count());
+        deadline = pacer.nextFrameStart(end, DisplayPhase{});
+    }
+    (void)sink;
+    return run;
+}
+
+// Big-core detection against fake sysfs trees, then frame-time variance of a paced workload
+// before and after the emulation policy is applied to its thread.
+uint64_t CurrentAffinityMask() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+        return 0;
+    }
+    uint64_t mask = 0;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (CPU_ISSET(cpu, &cpus)) {
+            mask |= uint64_t{1} << cpu;
+        }
+    }
+    return mask;
+}
+
+// Pins a thread as the emulation thread on a topology whose big cores are the upper half of
+// the CPUs this process may use, then checks what threads it spawns end up on once they
+// apply their own roles. Returns false when the host has a single CPU to split.
+bool CheckInheritedAffinity(bool& ok) {
+    const uint64_t allowed = CurrentAffinityMask();
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if ((allowed >> cpu) & 1u) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.size() < 2) {
+        return false;
+    }
+    CpuTopology topology;
+    topology.cpuCount = cpus.back() + 1;
+    for (size_t i = cpus.size() / 2; i < cpus.size(); ++i) {
+        topology.bigCoreMask |= uint64_t{1} << cpus[i];
+    }
+    uint64_t emulationMask = 0;
+    uint64_t renderMask = 0;
+    uint64_t backgroundMask = 0;
+    std::thread([&] {
+        ApplyThreadPolicy(ThreadRole::Emulation, topology);
+        emulationMask = CurrentAffinityMask();
+        std::thread([&] {
+            ApplyThreadPolicy(ThreadRole::Render, topology);
+            renderMask = CurrentAffinityMask();
+        }).join();
+        std::thread([&] {
+            ApplyThreadPolicy(ThreadRole::Background, topology);
+            backgroundMask = CurrentAffinityMask();
+        }).join();
+    }).join();
+    std::printf("  spawned after emulation 0x%llx: render 0x%llx, background 0x%llx\n",
+                static_cast<unsigned long long>(emulationMask),
+                static_cast<unsigned long long>(renderMask),
+                static_cast<unsigned long long>(backgroundMask));
+    // Render may also get CPUs a launcher's taskset left out; it must have all the others.
+    ok = emulationMask == topology.bigCoreMask && (renderMask & allowed) == allowed &&
+         backgroundMask != 0 && (backgroundMask & topology.bigCoreMask) == 0;
+    return true;
+}
+
+bool RunThreadPolicy() {
+    FlushLog();
+    std::printf("threads\n");
+    const auto root = std::filesystem::temp_directory_path() /
+                      ("xr_harness_cpus_" + std::to_string(CurrentThreadId()));
+    const CpuTopology bigLittle = FakeTopology(
+        root, {1804800, 1804800, 1804800, 1804800, 2419200, 2419200, 2419200, 2841600});
+    const CpuTopology uniform = FakeTopology(root, {2000000, 2000000, 2000000, 2000000});
+    const bool topologyOk = bigLittle.cpuCount == 8 && bigLittle.bigCoreMask == 0xF0 &&
+                            uniform.cpuCount == 4 && uniform.bigCoreMask == 0;
+    std::printf("  big cores: 1+3+4 layout 0x%llx, uniform 0x%llx, this host 0x%llx\n",
+                static_cast<unsigned long long>(bigLittle.bigCoreMask),
+                static_cast<unsigned long long>(uniform.bigCoreMask),
+                static_cast<unsigned long long>(ReadCpuTopology().bigCoreMask));
+    // Every role names its cores, so nothing depends on what its creator was pinned to.
+    const bool rolesOk = ThreadRoleCoreMask(ThreadRole::Emulation, bigLittle) == 0xF0 &&
+                         ThreadRoleCoreMask(ThreadRole::Render, bigLittle) == 0xFF &&
+                         ThreadRoleCoreMask(ThreadRole::Background, bigLittle) == 0x0F &&
+                         ThreadRoleCoreMask(ThreadRole::Render, uniform) == 0;
+    bool inheritedOk = true;
+    if (!CheckInheritedAffinity(inheritedOk)) {
+        std::printf("  spawned thread affinity: skipped, one CPU\n");
+    }
+
+    PacedRun before;
+    PacedRun after;
+    ThreadPolicyResult policy;
+    bool backgroundOk = false;
+    std::thread([&] {
+        before = RunPacedFrames();
+        policy = ApplyThreadPolicy(ThreadRole::Emulation);
+        after = RunPacedFrames();
+    }).join();
+    // Lowering priority needs no privileges, so the background policy must always apply.
+    std::thread([&] { backgroundOk = ApplyThreadPolicy(ThreadRole::Background).prioritized; })
+        .join();
+
+    auto report = [](const char* label, const PacedRun& run) {
+        std::printf("  %s: work mean %.2f ms sd %.3f max %.2f, start lateness sd %.3f ms\n",
+                    label, run.work.meanMs(), run.work.stddevMs(), run.work.maxMs(),
+                    run.lateness.stddevMs());
+    };
+    report("default", before);
+    std::printf("  emulation policy: %s, nice %d%s\n", policy.pinned ? "big cores" : "all cores",
+                policy.niceLevel, policy.prioritized ? "" : " (raise refused)");
+    report("with policy", after);
+    if (!topologyOk) {
+        std::fprintf(stderr, "  big-core detection misclassified the fake topologies\n");
+    }
+    if (!backgroundOk) {
+        std::fprintf(stderr, "  background nice level was refused\n");
+    }
+    if (!rolesOk || !inheritedOk) {
+        std::fprintf(stderr, "  a thread role does not set its own cores\n");
+    }
+    return topologyOk && backgroundOk && rolesOk && inheritedOk;
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// SettingsStore against a temp directory: a legacy file is rewritten as key=value, a newer
+// version is read but left alone, a burst of setters is written once and flush() returns with
+// the change already in the file.
+bool RunSettingsStore() {
+    FlushLog();
+    std::printf("settings\n");
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("xr_harness_settings_" + std::to_string(CurrentThreadId()));
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "presentation_settings.cfg";
+    bool pass = true;
+    auto expect = [&pass](const bool ok, const char* what) {
+        if (!ok) {
+            std::fprintf(stderr, "  %s\n", what);
+            pass = false;
+        }
+    };
+
+    std::ofstream(path) << "0.7500 0.0200 1\n";
+    {
+        SettingsStore store;
+        expect(store.open(path.string()), "legacy file not read");
+        store.flush();
+        expect(ReadFile(path) ==
+                   "version=1\nscreen_scale=0.7500\nstereo_convergence=0.0200\nview_mode=1\n",
+               "legacy file not rewritten as key=value");
+        expect(store.getFloat("stereo_convergence", 0.0f) == 0.02f &&
+                   store.getInt("view_mode", 0) == 1,
+               "legacy values lost");
+        expect(store.writeCount() == 1, "legacy migration not written once");
+
+        // Calibration steps arrive a frame or so apart.
+        const uint64_t writesBefore = store.writeCount();
+        const auto burstStart = std::chrono::steady_clock::now();
+        for (int step = 1; step <= 20; ++step) {
+            store.setFloat("screen_scale", 0.75f + static_cast<float>(step) * 0.01f);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        while (store.writeCount() == writesBefore &&
+               std::chrono::steady_clock::now() - burstStart < std::chrono::seconds(5)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        const double burstMs = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - burstStart)
+                                   .count();
+        // Long enough for a second, stray write to land.
+        std::this_thread::sleep_for(SettingsStore::kWriteDebounce * 2);
+        const uint64_t burstWrites = store.writeCount() - writesBefore;
+        std::printf("  20 setters: %llu write after %.0f ms\n",
+                    static_cast<unsigned long long>(burstWrites), burstMs);
+        expect(burstWrites == 1, "setter burst not coalesced into one write");
+        expect(ReadFile(path).find("screen_scale=0.9500\n") != std::string::npos,
+               "setter burst not persisted");
+
+        store.setInt("view_mode", 0);
+        store.flush();
+        expect(ReadFile(path).find("view_mode=0\n") != std::string::npos,
+               "flush returned before the file was written");
+        expect(!std::filesystem::exists(path.string() + ".tmp"), "temp file left behind");
+    }
+
+    std::ofstream(path) << "version=99\nscreen_scale=0.6000\nfuture_key=abc\n";
+    {
+        SettingsStore store;
+        expect(store.open(path.string()) && store.getFloat("screen_scale", 0.0f) == 0.6f,
+               "newer version not read");
+        store.flush();
+        expect(store.writeCount() == 0 && ReadFile(path).rfind("version=99\n", 0) == 0,
+               "newer version file rewritten without a change");
+    }
+    std::filesystem::remove_all(dir);
+    return pass;
+}
+
+void BuildCaptureFrame(const int frame, std::vector<uint32_t>& pixels) {
+    if (frame == kCaptureRawFrame) {
+        pixels.resize(static_cast<size_t>(kSourceWidth) * kSourceHeight);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = 0xFF000000u | static_cast<uint32_t>(i % kSourceWidth) << 8 |
+                        static_cast<uint32_t>(i / kSourceWidth);
+        }
+        return;
+    }
+    std::vector<uint8_t> depthPlane;
+    BuildSourceFrame(frame % 100, pixels, depthPlane);
+}
+
+// Records synthetic frames and audio through FrameCapture, timing the frame-loop side, then
+// decodes the file and checks every frame that was not dropped and all of the audio.
+bool RunCapture() {
+    FlushLog();
+    std::printf("capture\n");
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("xr_harness_capture_" + std::to_string(CurrentThreadId()) + ".vbcap");
+    FrameCapture capture;
+    if (!capture.start(path.string(), kVbRefreshHz, 44100)) {
+        return false;
+    }
+    std::vector<uint32_t> pixels;
+    std::vector<int16_t> audio(kCaptureAudioFrames * 2);
+    std::vector<int16_t> sentAudio;
+    std::vector<double> submitMs;
+    for (int frame = 0; frame < kCaptureFrames; ++frame) {
+        BuildCaptureFrame(frame, pixels);
+        for (size_t i = 0; i < audio.size(); ++i) {
+            audio[i] = static_cast<int16_t>(frame * 131 + static_cast<int>(i) * 7);
+        }
+        sentAudio.insert(sentAudio.end(), audio.begin(), audio.end());
+        const auto start = std::chrono::steady_clock::now();
+        capture.submitAudio(audio.data(), kCaptureAudioFrames);
+        capture.submitFrame(pixels.data(), kSourceWidth, kSourceHeight);
+        submitMs.push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count());
+        std::this_thread::sleep_for(kCaptureFrameInterval);
+    }
+    capture.stop();
+    const FrameCapture::Stats stats = capture.stats();
+
+    CaptureReader reader;
+    bool decodedOk = reader.open(path.string());
+    uint32_t decoded = 0;
+    std::vector<int16_t> receivedAudio;
+    while (decodedOk) {
+        const CaptureReader::Item item = reader.next();
+        if (item == CaptureReader::Item::End) {
+            break;
+        }
+        if (item == CaptureReader::Item::Error) {
+            std::fprintf(stderr, "  decode failed: %s\n", reader.lastError().c_str());
+            decodedOk = false;
+        } else if (item == CaptureReader::Item::Audio) {
+            receivedAudio.insert(receivedAudio.end(), reader.audioSamples().begin(),
+                                 reader.audioSamples().end());
+        } else {
+            BuildCaptureFrame(static_cast<int>(reader.frameIndex()), pixels);
+            for (uint32_t& pixel : pixels) {
+                pixel |= 0xFF000000u;
+            }
+            if (reader.framePixels() != pixels) {
+                std::fprintf(stderr, "  frame %u differs\n", reader.frameIndex());
+                decodedOk = false;
+            }
+            ++decoded;
+        }
+    }
+    std::filesystem::remove(path);
+
+    const double rawBytes = static_cast<double>(kCaptureFrames) * kSourceWidth * kSourceHeight * 4;
+    // The median: on a single-core host the worker preempts a few submissions.
+    std::sort(submitMs.begin(), submitMs.end());
+    const double medianMs = submitMs[submitMs.size() / 2];
+    std::printf("  frame loop cost (ms): median %.3f max %.3f\n", medianMs, submitMs.back());
+    std::printf("  %u frames, %u dropped, %.1f KB per frame (%.0fx smaller than XRGB)\n",
+                stats.frames, stats.dropped,
+                static_cast<double>(stats.bytes) / 1024.0 / kCaptureFrames,
+                rawBytes / static_cast<double>(std::max<uint64_t>(stats.bytes, 1)));
+    const bool countsOk = decoded + stats.dropped == kCaptureFrames;
+    const bool audioOk = receivedAudio == sentAudio;
+    const bool fast = medianMs <= kMaxCaptureSubmitMs;
+    if (!countsOk || !audioOk) {
+        std::fprintf(stderr, "  decoded %u frames, audio %s\n", decoded,
+                     audioOk ? "intact" : "DIFFERS");
+    }
+    if (!fast) {
+        std::fprintf(stderr, "  capture costs the frame loop over %.1f ms\n", kMaxCaptureSubmitMs);
+    }
+    return decodedOk && countsOk && audioOk && fast;
+}
+
+// Reads back an 8-bit RGB PNG as written by EncodePng (filter 0 on every row).
+bool ReadPng(const std::filesystem::path& path, int& width, int& height,
+             std::vector<uint8_t>& rgb) {
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+    auto u32 = [&](const size_t offset) {
+        return (static_cast<uint32_t>(file[offset]) << 24) | (file[offset + 1] << 16) |
+               (file[offset + 2] << 8) | file[offset + 3];
+    };
+    std::vector<uint8_t> compressed;
+    size_t offset = 8;
+    while (offset + 12 <= file.size()) {
+        const uint32_t length = u32(offset);
+        const std::string type(file.begin() + offset + 4, file.begin() + offset + 8);
+        if (offset + 12 + length > file.size() ||
+            crc32(0L, file.data() + offset + 4, length + 4) != u32(offset + 8 + length)) {
+            return false;
+        }
+        if (type == "IHDR") {
+            width = static_cast<int>(u32(offset + 8));
+            height = static_cast<int>(u32(offset + 12));
+        } else if (type == "IDAT") {
+            compressed.insert(compressed.end(), file.begin() + offset + 8,
+                              file.begin() + offset + 8 + length);
+        }
+        offset += 12 + length;
+    }
+    const size_t rowBytes = 1 + static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> rows(rowBytes * height);
+    uLongf size = rows.size();
+    if (uncompress(rows.data(), &size, compressed.data(), compressed.size()) != Z_OK ||
+        size != rows.size()) {
+        return false;
+    }
+    rgb.clear();
+    for (int y = 0; y < height; ++y) {
+        if (rows[y * rowBytes] != 0) {
+            return false;
+        }
+        rgb.insert(rgb.end(), rows.begin() + y * rowBytes + 1, rows.begin() + (y + 1) * rowBytes);
+    }
+    return true;
+}
+
+std::vector<uint8_t> CropRgb(const std::vector<uint32_t>& pixels, const int x0, const int width,
+                             const bool anaglyph) {
+    std::vector<uint8_t> rgb;
+    for (int y = 0; y < kSourceHeight; ++y) {
+        for (int x = x0; x < x0 + width; ++x) {
+            const uint32_t pixel = pixels[static_cast<size_t>(y) * kSourceWidth + x];
+            if (anaglyph) {
+                // The frame is red only, so each eye's intensity is its red channel.
+                const uint32_t rightPixel =
+                    pixels[static_cast<size_t>(y) * kSourceWidth + x + kVipEyeWidth];
+                const auto left = static_cast<uint8_t>(pixel >> 16);
+                const auto right = static_cast<uint8_t>(rightPixel >> 16);
+                rgb.insert(rgb.end(), {left, right, right});
+            } else {
+                rgb.insert(rgb.end(), {static_cast<uint8_t>(pixel >> 16),
+                                       static_cast<uint8_t>(pixel >> 8),
+                                       static_cast<uint8_t>(pixel)});
+            }
+        }
+    }
+    return rgb;
+}
+
+// Each screenshot layout must decode to the frame it was taken from; a burst larger than the
+// buffer pool must be refused rather than wait on the writer.
+bool RunScreenshots() {
+    FlushLog();
+    std::printf("screenshots\n");
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("xr_harness_shots_" + std::to_string(CurrentThreadId()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    ScreenshotWriter writer;
+    writer.start(dir.string(), kSourceWidth, kSourceHeight);
+
+    std::vector<uint32_t> pixels;
+    std::vector<uint8_t> depthPlane;
+    BuildSourceFrame(7, pixels, depthPlane);
+    // Moves the stand-in frame's shades into the red channel, as the VIP's output has them.
+    for (uint32_t& pixel : pixels) {
+        pixel = 0xFF000000u | ((pixel & 0xFFu) << 16);
+    }
+    std::vector<double> captureMs;
+    auto timedCapture = [&](const ScreenshotLayout layout) {
+        const auto start = std::chrono::steady_clock::now();
+        const bool accepted = writer.capture(pixels.data(), kSourceWidth, kSourceHeight, layout);
+        captureMs.push_back(std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count());
+        return accepted;
+    };
+    bool layoutsAccepted = timedCapture(ScreenshotLayout::SideBySide);
+    layoutsAccepted &= timedCapture(ScreenshotLayout::Anaglyph);
+    layoutsAccepted &= timedCapture(ScreenshotLayout::SeparateEyes);
+    writer.stop();
+
+    // Named vbshot-<time>-<sequence><suffix>; the three captures are sequences 0 to 2.
+    struct Expected {
+        const char* suffix;
+        int x0;
+        int width;
+        bool anaglyph;
+    };
+    const Expected expected[] = {
+        {"-0.png", 0, kSourceWidth, false},
+        {"-1-anaglyph.png", 0, kVipEyeWidth, true},
+        {"-2-left.png", 0, kVipEyeWidth, false},
+        {"-2-right.png", kVipEyeWidth, kVipEyeWidth, false},
+    };
+    bool imagesOk = layoutsAccepted;
+    for (const Expected& image : expected) {
+        bool found = false;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            const std::string name = entry.path().filename().string();
+            const size_t suffixLength = std::strlen(image.suffix);
+            if (name.size() < suffixLength ||
+                name.compare(name.size() - suffixLength, suffixLength, image.suffix) != 0) {
+                continue;
+            }
+            int width = 0;
+            int height = 0;
+            std::vector<uint8_t> rgb;
+            found = ReadPng(entry.path(), width, height, rgb) && width == image.width &&
+                    height == kSourceHeight;
+            found = found && rgb == CropRgb(pixels, image.x0, image.width, image.anaglyph);
+        }
+        std::printf("  %-16s %s\n", image.suffix, found ? "match" : "MISSING OR DIFFERS");
+        imagesOk &= found;
+    }
+
+    // A burst from one frame: the pool takes three, the rest are refused immediately.
+    writer.start(dir.string(), kSourceWidth, kSourceHeight);
+    int accepted = 0;
+    for (int i = 0; i < kScreenshotBurst; ++i) {
+        accepted += timedCapture(ScreenshotLayout::SideBySide) ? 1 : 0;
+    }
+    writer.stop();
+    const ScreenshotWriter::Stats stats = writer.stats();
+    std::filesystem::remove_all(dir);
+
+    std::sort(captureMs.begin(), captureMs.end());
+    const double medianMs = captureMs[captureMs.size() / 2];
+    std::printf("  capture cost (ms): median %.3f max %.3f; burst of %d: %d written, %u refused\n",
+                medianMs, captureMs.back(), kScreenshotBurst, accepted, stats.dropped);
+    const bool burstOk = accepted >= 1 && stats.written == static_cast<uint32_t>(accepted) &&
+                         stats.dropped == static_cast<uint32_t>(kScreenshotBurst - accepted);
+    const bool fast = medianMs <= kMaxCaptureSubmitMs;
+    if (!burstOk || !fast) {
+        std::fprintf(stderr, "  screenshot burst or capture cost out of bounds\n");
+    }
+    return imagesOk && burstOk && fast;
+}
+
+// The app's frame buffer pool: sized once, reused without reallocating, and accounting for
+// every holder, including the XR renderer's textures after the scenarios.
+bool RunFramePool(const XrStereoRenderer& renderer) {
+    FlushLog();
+    std::printf("frame buffer pool\n");
+    bool pass = true;
+    auto check = [&pass](const bool ok, const char* what) {
+        if (!ok) {
+            std::fprintf(stderr, "frame buffer pool: %s\n", what);
+            pass = false;
+        }
+    };
+
+    constexpr size_t kStandbyPixels = static_cast<size_t>(kSourceWidth) * 384;
+    constexpr size_t kFramePixels = static_cast<size_t>(kSourceWidth) * kSourceHeight;
+    FrameBufferPool pool;
+    pool.reserve(PooledBuffer::Compose, kStandbyPixels);
+    pool.configure(kSourceWidth, kSourceHeight);
+    const uint32_t* core = pool.pixels(PooledBuffer::CoreFrame, kFramePixels).data();
+    const uint32_t* standby = pool.pixels(PooledBuffer::Compose, kStandbyPixels).data();
+    for (int i = 0; i < 10; ++i) {
+        check(pool.pixels(PooledBuffer::CoreFrame, i % 2 == 0 ? kFramePixels : 0).data() == core,
+              "core frame moved");
+        check(pool.pixels(PooledBuffer::Compose, kFramePixels).data() == standby,
+              "overlay did not reuse the standby buffer");
+    }
+    FrameBufferPool::Usage usage = pool.usage();
+    check(usage.growths == 0, "grew inside its reservation");
+    check(usage.bytes[static_cast<size_t>(FrameBufferUse::CoreFrame)] == kFramePixels * 4,
+          "core frame bytes");
+    check(usage.bytes[static_cast<size_t>(FrameBufferUse::Compose)] == kStandbyPixels * 4,
+          "compose bytes");
+
+    ScreenshotWriter screenshots;
+    screenshots.start(std::filesystem::temp_directory_path().string(), kSourceWidth,
+                      kSourceHeight);
+    pool.reportBytes(FrameBufferUse::Screenshots, screenshots.stats().bufferBytes);
+    screenshots.stop();
+    const size_t textureBytes = renderer.textureBytes();
+    pool.reportBytes(FrameBufferUse::Textures, textureBytes);
+    check(textureBytes >= kFramePixels * 4 * 3, "textures not reported for every frame slot");
+    pool.pixels(PooledBuffer::CoreFrame, kFramePixels * 2);
+    usage = pool.usage();
+    check(usage.growths == 1, "growth past the reservation not counted");
+    check(usage.totalBytes == (kFramePixels * 2 + kStandbyPixels) * 4 + kFramePixels * 4 * 3 +
+                                  textureBytes,
+          "total does not add up");
+    std::printf("  %.2f MB held: core %zu compose %zu textures %zu screenshots %zu\n",
+                static_cast<double>(usage.totalBytes) / (1024.0 * 1024.0),
+                usage.bytes[static_cast<size_t>(FrameBufferUse::CoreFrame)],
+                usage.bytes[static_cast<size_t>(FrameBufferUse::Compose)], textureBytes,
+                usage.bytes[static_cast<size_t>(FrameBufferUse::Screenshots)]);
+    return pass;
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&](const char* flag) -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", flag);
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        if (arg == "--golden-dir") {
+            const char* v = value("--golden-dir");
+            if (v == nullptr) {
+                return false;
+            }
+            options.goldenDir = v;
+        } else if (arg == "--output-dir") {
+            const char* v = value("--output-dir");
+            if (v == nullptr) {
+                return false;
+            }
+            options.outputDir = v;
+        } else if (arg == "--frames") {
+            const char* v = value("--frames");
+            if (v == nullptr) {
+                return false;
+            }
+            options.measureFrames = std::max(kMinMeasureFrames, std::atoi(v));
+        } else if (arg == "--update-goldens") {
+            options.updateGoldens = true;
+        } else if (arg == "--unthrottled") {
+            options.throttle = false;
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--golden-dir DIR] [--output-dir DIR] [--frames N] "
+                         "[--update-goldens] [--unthrottled]\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    // The renderer's log lines reach stdout from the logger thread; line buffering keeps them
+    // whole, and FlushLog() before each report section keeps them in order.
+    std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    // GPU-less CI: Mesa's surfaceless platform with llvmpipe.
+    setenv("EGL_PLATFORM", "surfaceless", 0);
+
+    MockXrSetRefreshRates(kMockRefreshRates.data(), kMockRefreshRates.size());
+    MockXrSetThrottle(options.throttle);
+
+    ANativeActivity activity{};
+    XrStereoRenderer renderer;
+    if (!renderer.initialize(&activity)) {
+        std::fprintf(stderr, "initialize failed: %s\n", renderer.lastError());
+        return 1;
+    }
+    if (!WaitForSession(renderer, true)) {
+        std::fprintf(stderr, "session never started: %s\n", renderer.lastError());
+        renderer.shutdown();
+        return 1;
+    }
+
+    bool pass = RunLogFormat();
+    pass &= RunTextBench();
+    pass &= RunInfoPages();
+    pass &= RunThreadPolicy();
+    pass &= RunSettingsStore();
+    pass &= RunCapture();
+    pass &= RunScreenshots();
+    const float expectedRate = SelectDisplayRefreshRate(
+        kMockRefreshRates.data(), kMockRefreshRates.size(), kVbRefreshHz);
+    if (MockXrDisplayRefreshRate() != expectedRate) {
+        std::fprintf(stderr, "refresh rate %.1f Hz, expected %.1f Hz\n",
+                     MockXrDisplayRefreshRate(), expectedRate);
+        pass = false;
+    }
+
+    for (const Scenario& scenario : kScenarios) {
+        pass &= RunScenario(renderer, scenario, options);
+    }
+    pass &= RunFramePool(renderer);
+    // Ends the session.
+    pass &= RunAppLoop(renderer);
+    if (renderer.lastError()[0] != '\0') {
+        std::fprintf(stderr, "renderer error: %s\n", renderer.lastError());
+        pass = false;
+    }
+    renderer.shutdown();
+    pass &= RunFlatRenderer(options);
+
+    // Main from createSession, render and frame-wait threads from each session begin.
+    constexpr uint32_t kExpectedThreadTypes = (1u << XR_ANDROID_THREAD_TYPE_APPLICATION_MAIN_KHR) |
+                                              (1u << XR_ANDROID_THREAD_TYPE_RENDERER_MAIN_KHR) |
+                                              (1u << XR_ANDROID_THREAD_TYPE_RENDERER_WORKER_KHR);
+    if (MockXrAndroidThreadTypes() != kExpectedThreadTypes) {
+        std::fprintf(stderr, "registered XR thread types 0x%x, expected 0x%x\n",
+                     MockXrAndroidThreadTypes(), kExpectedThreadTypes);
+        pass = false;
+    }
+
+    const uint32_t validationErrors = MockXrValidationErrors();
+    if (validationErrors > 0) {
+        std::fprintf(stderr, "%u OpenXR validation errors\n", validationErrors);
+        pass = false;
+    }
+    FlushLog();
+    std::printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,1782 @@
+#include "mock_runtime.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#ifndef XR_USE_PLATFORM_ANDROID
+#define XR_USE_PLATFORM_ANDROID
+#endif
+#ifndef XR_USE_GRAPHICS_API_OPENGL_ES
+#define XR_USE_GRAPHICS_API_OPENGL_ES
+#endif
+#ifndef XR_USE_TIMESPEC
+#define XR_USE_TIMESPEC
+#endif
+// JNI types for openxr_platform.h, pulled in the same way as on device.
+#include <android/native_activity.h>
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+#if __has_include(<openxr/openxr_loader_negotiation.h>)
+#include <openxr/openxr_loader_negotiation.h>
+#define MOCK_XR_LOADER_NEGOTIATION 1
+#endif
+
+#define MOCK_XR_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace {
+
+constexpr XrSystemId kSystemId = 1;
+constexpr uint32_t kViewCount = 2;
+constexpr uint32_t kRecommendedEyeSize = 640;
+constexpr uint32_t kMaxEyeSize = 2048;
+constexpr uint32_t kSwapchainImageCount = 3;
+constexpr float kIpd = 0.063f;
+constexpr float kHalfFov = 0.785398f;
+constexpr std::array<float, 4> kDefaultRefreshRates = {72.0f, 80.0f, 90.0f, 120.0f};
+constexpr size_t kMaxFrameTimes = 100000;
+
+constexpr std::array<const char*, 6> kExtensions = {
+    XR_KHR_ANDROID_CREATE_INSTANCE_EXTENSION_NAME,
+    XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME,
+    XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME,
+    XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME,
+    XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME,
+    XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME,
+};
+
+constexpr std::array<int64_t, 6> kSwapchainFormats = {
+    GL_RGBA8,
+    GL_SRGB8_ALPHA8,
+    GL_DEPTH_COMPONENT24,
+    GL_DEPTH24_STENCIL8,
+    GL_DEPTH_COMPONENT32F,
+    GL_DEPTH_COMPONENT16,
+};
+
+bool IsDepthFormat(const int64_t format) {
+    return format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH24_STENCIL8 ||
+           format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH_COMPONENT16;
+}
+
+struct Keyframe {
+    double time = 0.0;
+    bool hasHead = false;
+    bool hasYaw = false;
+    bool hasPitch = false;
+    XrVector3f head{};
+    float yawDeg = 0.0f;
+    float pitchDeg = 0.0f;
+    std::map<std::string, XrVector2f> inputs;
+};
+
+struct ScriptSample {
+    XrVector3f head{};
+    float yawDeg = 0.0f;
+    float pitchDeg = 0.0f;
+    std::map<std::string, XrVector2f> inputs;
+};
+
+struct InputState {
+    XrVector2f value{};
+    XrTime lastChangeTime = 0;
+    bool changed = false;
+};
+
+}  // namespace
+
+struct XrInstance_T {
+    bool depthEnabled = false;
+    bool refreshRateEnabled = false;
+    bool timespecEnabled = false;
+    bool threadSettingsEnabled = false;
+    bool graphicsRequirementsQueried = false;
+    std::map<XrPath, std::vector<XrActionSuggestedBinding>> suggestedBindings;
+};
+
+struct XrSwapchain_T {
+    int64_t format = 0;
+    bool depth = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<GLuint> images;
+    uint32_t nextImage = 0;
+    std::deque<uint32_t> acquired;
+    bool oldestWaited = false;
+    int lastReleased = -1;
+};
+
+struct XrSpace_T {
+    XrReferenceSpaceType type = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    XrPosef pose{};
+};
+
+struct XrAction_T;
+
+struct XrActionSet_T {
+    std::string name;
+    bool attached = false;
+    std::vector<XrAction_T*> actions;
+};
+
+struct XrAction_T {
+    XrActionSet_T* set = nullptr;
+    std::string name;
+    XrActionType type = XR_ACTION_TYPE_BOOLEAN_INPUT;
+    std::vector<XrPath> subactionPaths;
+};
+
+struct XrSession_T {
+    XrSessionState state = XR_SESSION_STATE_IDLE;
+    bool running = false;
+    bool exitRequested = false;
+    XrPath activeProfile = XR_NULL_PATH;
+    std::vector<XrActionSet_T*> attachedSets;
+    std::map<std::string, InputState> inputs;
+};
+
+namespace {
+
+struct Runtime {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSession session = XR_NULL_HANDLE;
+    std::deque<XrEventDataBuffer> events;
+    std::vector<std::string> paths;
+
+    std::vector<float> refreshRates{kDefaultRefreshRates.begin(), kDefaultRefreshRates.end()};
+    float refreshRate = kDefaultRefreshRates[0];
+    bool throttle = true;
+
+    std::vector<Keyframe> script;
+    bool restartScript = true;
+    XrTime scriptStart = 0;
+
+    uint64_t waitedFrames = 0;
+    uint64_t begunFrames = 0;
+    uint64_t endedFrames = 0;
+    XrTime nextDisplayTime = 0;
+    XrTime lastDisplayTime = 0;
+    std::chrono::steady_clock::time_point nextWake{};
+    double beginCpuMs = 0.0;
+    std::vector<double> frameCpuMs;
+    uint32_t releasesThisFrame = 0;
+    uint64_t resubmittedFrames = 0;
+
+    bool captureRequested = false;
+    bool captureReady = false;
+    std::array<std::vector<uint8_t>, kViewCount> capture;
+    std::array<int, kViewCount> captureWidth{};
+    std::array<int, kViewCount> captureHeight{};
+
+    // Bit n set once a thread of XrAndroidThreadTypeKHR n was registered.
+    uint32_t androidThreadTypes = 0;
+    uint32_t validationErrors = 0;
+    uint64_t depthImagesAcquired = 0;
+    uint64_t syncedActions = 0;
+};
+
+Runtime& GetRuntime() {
+    static Runtime runtime;
+    return runtime;
+}
+
+// Logs a spec violation; the caller returns the matching XrResult.
+XrResult Invalid(Runtime& rt, const XrResult result, const char* what) {
+    rt.validationErrors++;
+    std::fprintf(stderr, "mock-xr: validation error: %s (XrResult=%d)\n", what, result);
+    return result;
+}
+
+double ThreadCpuMs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000.0 + static_cast<double>(ts.tv_nsec) / 1.0e6;
+}
+
+XrTime SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+XrDuration PeriodNs(const float rate) {
+    return static_cast<XrDuration>(1.0e9 / static_cast<double>(rate));
+}
+
+template <typename T>
+XrResult TwoCall(
+    const uint32_t capacity, uint32_t* countOutput, T* output, const T* source, const uint32_t n) {
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = n;
+    if (capacity == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity < n) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        output[i] = source[i];
+    }
+    return XR_SUCCESS;
+}
+
+void QueueStateChange(Runtime& rt, const XrSessionState state) {
+    XrEventDataSessionStateChanged event{XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED};
+    event.session = rt.session;
+    event.state = state;
+    event.time = SteadyNowNs();
+    XrEventDataBuffer buffer{XR_TYPE_EVENT_DATA_BUFFER};
+    std::memcpy(&buffer, &event, sizeof(event));
+    rt.events.push_back(buffer);
+    rt.session->state = state;
+}
+
+const std::string* PathString(const Runtime& rt, const XrPath path) {
+    if (path == XR_NULL_PATH || path > rt.paths.size()) {
+        return nullptr;
+    }
+    return &rt.paths[path - 1];
+}
+
+bool ParseFloats(const std::string& text, float* out, const int count) {
+    std::istringstream stream(text);
+    std::string part;
+    int parsed = 0;
+    while (parsed < count && std::getline(stream, part, ',')) {
+        char* end = nullptr;
+        out[parsed] = std::strtof(part.c_str(), &end);
+        if (end == part.c_str()) {
+            return false;
+        }
+        parsed++;
+    }
+    return parsed > 0;
+}
+
+bool ParseScript(const char* text, std::vector<Keyframe>& outScript) {
+    std::vector<Keyframe> script;
+    std::istringstream lines(text != nullptr ? text : "");
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string token;
+        if (!(tokens >> token)) {
+            continue;
+        }
+        Keyframe key{};
+        char* end = nullptr;
+        key.time = std::strtod(token.c_str(), &end);
+        if (end == token.c_str() || (!script.empty() && key.time < script.back().time)) {
+            std::fprintf(stderr, "mock-xr: script line %d: bad time '%s'\n", lineNumber,
+                         token.c_str());
+            return false;
+        }
+        while (tokens >> token) {
+            const size_t eq = token.find('=');
+            if (eq == std::string::npos) {
+                std::fprintf(stderr, "mock-xr: script line %d: expected key=value\n", lineNumber);
+                return false;
+            }
+            const std::string name = token.substr(0, eq);
+            const std::string value = token.substr(eq + 1);
+            float values[3] = {};
+            if (!ParseFloats(value, values, 3)) {
+                std::fprintf(stderr, "mock-xr: script line %d: bad value for %s\n", lineNumber,
+                             name.c_str());
+                return false;
+            }
+            if (name == "head") {
+                key.hasHead = true;
+                key.head = {values[0], values[1], values[2]};
+            } else if (name == "yaw") {
+                key.hasYaw = true;
+                key.yawDeg = values[0];
+            } else if (name == "pitch") {
+                key.hasPitch = true;
+                key.pitchDeg = values[0];
+            } else if (name.rfind("/user/", 0) == 0) {
+                key.inputs[name] = {values[0], values[1]};
+            } else {
+                std::fprintf(stderr, "mock-xr: script line %d: unknown key %s\n", lineNumber,
+                             name.c_str());
+                return false;
+            }
+        }
+        script.push_back(std::move(key));
+    }
+    outScript = std::move(script);
+    return true;
+}
+
+// Poses interpolate between the keyframes that set them; inputs hold their last value.
+ScriptSample SampleScript(const std::vector<Keyframe>& script, const double time) {
+    ScriptSample sample{};
+    auto interpolate = [&script, time](auto has, auto get, auto& out) {
+        const Keyframe* before = nullptr;
+        const Keyframe* after = nullptr;
+        for (const auto& key : script) {
+            if (!has(key)) {
+                continue;
+            }
+            if (key.time <= time) {
+                before = &key;
+            } else {
+                after = &key;
+                break;
+            }
+        }
+        if (before == nullptr && after == nullptr) {
+            return;
+        }
+        if (before == nullptr || after == nullptr) {
+            out = get(before != nullptr ? *before : *after);
+            return;
+        }
+        const float t = static_cast<float>((time - before->time) / (after->time - before->time));
+        out = get(*before) + (get(*after) - get(*before)) * t;
+    };
+    interpolate([](const Keyframe& k) { return k.hasHead; },
+                [](const Keyframe& k) { return k.head.x; }, sample.head.x);
+    interpolate([](const Keyframe& k) { return k.hasHead; },
+                [](const Keyframe& k) { return k.head.y; }, sample.head.y);
+    interpolate([](const Keyframe& k) { return k.hasHead; },
+                [](const Keyframe& k) { return k.head.z; }, sample.head.z);
+    interpolate([](const Keyframe& k) { return k.hasYaw; },
+                [](const Keyframe& k) { return k.yawDeg; }, sample.yawDeg);
+    interpolate([](const Keyframe& k) { return k.hasPitch; },
+                [](const Keyframe& k) { return k.pitchDeg; }, sample.pitchDeg);
+    for (const auto& key : script) {
+        if (key.time > time) {
+            break;
+        }
+        for (const auto& [path, value] : key.inputs) {
+            sample.inputs[path] = value;
+        }
+    }
+    return sample;
+}
+
+double ScriptTime(const Runtime& rt, const XrTime displayTime) {
+    return std::max(0.0, static_cast<double>(displayTime - rt.scriptStart) / 1.0e9);
+}
+
+XrQuaternionf QuatMul(const XrQuaternionf& a, const XrQuaternionf& b) {
+    return {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+
+XrVector3f QuatRotate(const XrQuaternionf& q, const XrVector3f& v) {
+    const XrQuaternionf p{v.x, v.y, v.z, 0.0f};
+    const XrQuaternionf r = QuatMul(QuatMul(q, p), {-q.x, -q.y, -q.z, q.w});
+    return {r.x, r.y, r.z};
+}
+
+XrPosef InversePose(const XrPosef& pose) {
+    const XrQuaternionf inverse{
+        -pose.orientation.x, -pose.orientation.y, -pose.orientation.z, pose.orientation.w};
+    const XrVector3f p = QuatRotate(inverse, pose.position);
+    return {inverse, {-p.x, -p.y, -p.z}};
+}
+
+XrPosef ComposePose(const XrPosef& a, const XrPosef& b) {
+    const XrVector3f p = QuatRotate(a.orientation, b.position);
+    return {
+        QuatMul(a.orientation, b.orientation),
+        {a.position.x + p.x, a.position.y + p.y, a.position.z + p.z},
+    };
+}
+
+XrPosef HeadPose(const ScriptSample& sample) {
+    constexpr float kDegToRad = 3.14159265f / 180.0f;
+    const float yaw = sample.yawDeg * kDegToRad * 0.5f;
+    const float pitch = sample.pitchDeg * kDegToRad * 0.5f;
+    const XrQuaternionf qYaw{0.0f, std::sin(yaw), 0.0f, std::cos(yaw)};
+    const XrQuaternionf qPitch{std::sin(pitch), 0.0f, 0.0f, std::cos(pitch)};
+    return {QuatMul(qYaw, qPitch), sample.head};
+}
+
+bool ReadImage(const GLuint texture, const XrRect2Di& rect, std::vector<uint8_t>& outRgba) {
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    const bool complete =
+        glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    const size_t rowBytes = static_cast<size_t>(rect.extent.width) * 4;
+    std::vector<uint8_t> bottomUp(rowBytes * static_cast<size_t>(rect.extent.height));
+    if (complete) {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(rect.offset.x, rect.offset.y, rect.extent.width, rect.extent.height,
+                     GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    glDeleteFramebuffers(1, &framebuffer);
+    if (!complete) {
+        return false;
+    }
+
+    // GL rows run bottom-up; captures are stored top row first.
+    outRgba.resize(bottomUp.size());
+    for (int y = 0; y < rect.extent.height; ++y) {
+        std::memcpy(outRgba.data() + static_cast<size_t>(y) * rowBytes,
+                    bottomUp.data() +
+                        static_cast<size_t>(rect.extent.height - 1 - y) * rowBytes,
+                    rowBytes);
+    }
+    return true;
+}
+
+XrResult ValidateSubImage(
+    Runtime& rt, const XrSwapchainSubImage& subImage, const bool depth, const char* what) {
+    const XrSwapchain swapchain = subImage.swapchain;
+    if (swapchain == XR_NULL_HANDLE) {
+        return Invalid(rt, XR_ERROR_HANDLE_INVALID, what);
+    }
+    if (IsDepthFormat(swapchain->format) != depth) {
+        return Invalid(rt, XR_ERROR_LAYER_INVALID, what);
+    }
+    if (swapchain->lastReleased < 0) {
+        return Invalid(rt, XR_ERROR_LAYER_INVALID, "swapchain submitted before any release");
+    }
+    const XrRect2Di& rect = subImage.imageRect;
+    if (rect.offset.x < 0 || rect.offset.y < 0 || rect.extent.width <= 0 ||
+        rect.extent.height <= 0 ||
+        rect.offset.x + rect.extent.width > static_cast<int32_t>(swapchain->width) ||
+        rect.offset.y + rect.extent.height > static_cast<int32_t>(swapchain->height)) {
+        return Invalid(rt, XR_ERROR_SWAPCHAIN_RECT_INVALID, what);
+    }
+    return XR_SUCCESS;
+}
+
+XrResult ValidateProjection(Runtime& rt, const XrCompositionLayerProjection& layer) {
+    if (layer.viewCount != kViewCount || layer.views == nullptr || layer.space == nullptr) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "projection layer view count/space");
+    }
+    for (uint32_t i = 0; i < layer.viewCount; ++i) {
+        const XrCompositionLayerProjectionView& view = layer.views[i];
+        XrResult result = ValidateSubImage(rt, view.subImage, false, "projection view");
+        if (XR_FAILED(result)) {
+            return result;
+        }
+        for (auto* next = static_cast<const XrBaseInStructure*>(view.next); next != nullptr;
+             next = next->next) {
+            if (next->type != XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR) {
+                continue;
+            }
+            if (!rt.instance->depthEnabled) {
+                return Invalid(rt, XR_ERROR_VALIDATION_FAILURE,
+                               "depth info chained without XR_KHR_composition_layer_depth");
+            }
+            const auto* depth = reinterpret_cast<const XrCompositionLayerDepthInfoKHR*>(next);
+            result = ValidateSubImage(rt, depth->subImage, true, "depth info");
+            if (XR_FAILED(result)) {
+                return result;
+            }
+            if (depth->minDepth < 0.0f || depth->maxDepth > 1.0f ||
+                depth->minDepth > depth->maxDepth || depth->nearZ == depth->farZ) {
+                return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "depth info range");
+            }
+        }
+    }
+    return XR_SUCCESS;
+}
+
+void LoadEnvironment(Runtime& rt) {
+    if (const char* rates = std::getenv("XR_MOCK_REFRESH_RATES")) {
+        std::vector<float> parsed;
+        std::istringstream stream(rates);
+        std::string part;
+        while (std::getline(stream, part, ',')) {
+            const float rate = std::strtof(part.c_str(), nullptr);
+            if (rate > 0.0f) {
+                parsed.push_back(rate);
+            }
+        }
+        if (!parsed.empty()) {
+            rt.refreshRates = parsed;
+            rt.refreshRate = parsed.front();
+        }
+    }
+    if (const char* unthrottled = std::getenv("XR_MOCK_UNTHROTTLED")) {
+        rt.throttle = std::strcmp(unthrottled, "0") == 0;
+    }
+    if (const char* scriptPath = std::getenv("XR_MOCK_SCRIPT")) {
+        std::ifstream file(scriptPath);
+        std::stringstream text;
+        text << file.rdbuf();
+        if (!file || !ParseScript(text.str().c_str(), rt.script)) {
+            std::fprintf(stderr, "mock-xr: ignoring script %s\n", scriptPath);
+        }
+    }
+}
+
+}  // namespace
+
+MOCK_XR_EXPORT XrResult xrEnumerateApiLayerProperties(
+    uint32_t capacity, uint32_t* countOutput, XrApiLayerProperties* properties) {
+    (void)capacity;
+    (void)properties;
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = 0;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrEnumerateInstanceExtensionProperties(
+    const char* layerName,
+    uint32_t capacity,
+    uint32_t* countOutput,
+    XrExtensionProperties* properties) {
+    if (layerName != nullptr) {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = static_cast<uint32_t>(kExtensions.size());
+    if (capacity == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity < kExtensions.size()) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (size_t i = 0; i < kExtensions.size(); ++i) {
+        std::snprintf(properties[i].extensionName, XR_MAX_EXTENSION_NAME_SIZE, "%s",
+                      kExtensions[i]);
+        properties[i].extensionVersion = 1;
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo,
+                                         XrInstance* instance) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (createInfo == nullptr || instance == nullptr ||
+        createInfo->type != XR_TYPE_INSTANCE_CREATE_INFO) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "xrCreateInstance arguments");
+    }
+    if (rt.instance != XR_NULL_HANDLE) {
+        return XR_ERROR_LIMIT_REACHED;
+    }
+
+    auto* created = new XrInstance_T{};
+    for (uint32_t i = 0; i < createInfo->enabledExtensionCount; ++i) {
+        const char* name = createInfo->enabledExtensionNames[i];
+        const bool known = std::any_of(kExtensions.begin(), kExtensions.end(),
+                                       [name](const char* ext) {
+                                           return std::strcmp(ext, name) == 0;
+                                       });
+        if (!known) {
+            delete created;
+            return XR_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        created->depthEnabled |=
+            std::strcmp(name, XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME) == 0;
+        created->refreshRateEnabled |=
+            std::strcmp(name, XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME) == 0;
+        created->timespecEnabled |=
+            std::strcmp(name, XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME) == 0;
+        created->threadSettingsEnabled |=
+            std::strcmp(name, XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME) == 0;
+    }
+
+    LoadEnvironment(rt);
+    rt.instance = created;
+    *instance = created;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroyInstance(XrInstance instance) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance == XR_NULL_HANDLE || instance != rt.instance) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    delete instance;
+    rt.instance = XR_NULL_HANDLE;
+    rt.events.clear();
+    rt.paths.clear();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo,
+                                    XrSystemId* systemId) {
+    if (instance == XR_NULL_HANDLE || getInfo == nullptr || systemId == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+        return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+    }
+    *systemId = kSystemId;
+    return XR_SUCCESS;
+}
+
+namespace {
+
+XrResult MockGetOpenGLESGraphicsRequirementsKHR(
+    XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsOpenGLESKHR* requirements) {
+    if (instance == XR_NULL_HANDLE || requirements == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (systemId != kSystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    std::lock_guard<std::mutex> lock(GetRuntime().mutex);
+    instance->graphicsRequirementsQueried = true;
+    requirements->minApiVersionSupported = XR_MAKE_VERSION(3, 0, 0);
+    requirements->maxApiVersionSupported = XR_MAKE_VERSION(3, 2, 0);
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+MOCK_XR_EXPORT XrResult xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo,
+                                        XrSession* session) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || createInfo == nullptr || session == nullptr) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "xrCreateSession arguments");
+    }
+    if (!instance->graphicsRequirementsQueried) {
+        return Invalid(rt, XR_ERROR_GRAPHICS_REQUIREMENTS_CALL_MISSING,
+                       "xrGetOpenGLESGraphicsRequirementsKHR not called");
+    }
+    const auto* binding =
+        static_cast<const XrGraphicsBindingOpenGLESAndroidKHR*>(createInfo->next);
+    if (binding == nullptr || binding->type != XR_TYPE_GRAPHICS_BINDING_OPENGL_ES_ANDROID_KHR ||
+        binding->context == EGL_NO_CONTEXT) {
+        return Invalid(rt, XR_ERROR_GRAPHICS_DEVICE_INVALID, "missing GLES graphics binding");
+    }
+    if (rt.session != XR_NULL_HANDLE) {
+        return XR_ERROR_LIMIT_REACHED;
+    }
+
+    rt.session = new XrSession_T{};
+    rt.waitedFrames = 0;
+    rt.begunFrames = 0;
+    rt.endedFrames = 0;
+    QueueStateChange(rt, XR_SESSION_STATE_IDLE);
+    QueueStateChange(rt, XR_SESSION_STATE_READY);
+    *session = rt.session;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroySession(XrSession session) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session == XR_NULL_HANDLE || session != rt.session) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    delete session;
+    rt.session = XR_NULL_HANDLE;
+    rt.cv.notify_all();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || beginInfo == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    if (session->running) {
+        return Invalid(rt, XR_ERROR_SESSION_RUNNING, "xrBeginSession while running");
+    }
+    if (session->state != XR_SESSION_STATE_READY) {
+        return Invalid(rt, XR_ERROR_SESSION_NOT_READY, "xrBeginSession before READY");
+    }
+    session->running = true;
+    rt.waitedFrames = 0;
+    rt.begunFrames = 0;
+    rt.endedFrames = 0;
+    rt.nextDisplayTime = 0;
+    rt.restartScript = true;
+    QueueStateChange(rt, XR_SESSION_STATE_SYNCHRONIZED);
+    QueueStateChange(rt, XR_SESSION_STATE_VISIBLE);
+    QueueStateChange(rt, XR_SESSION_STATE_FOCUSED);
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrEndSession(XrSession session) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (!session->running) {
+        return Invalid(rt, XR_ERROR_SESSION_NOT_RUNNING, "xrEndSession while not running");
+    }
+    if (session->state != XR_SESSION_STATE_STOPPING) {
+        return Invalid(rt, XR_ERROR_SESSION_NOT_STOPPING, "xrEndSession before STOPPING");
+    }
+    if (rt.begunFrames != rt.endedFrames) {
+        Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "xrEndSession with a frame still begun");
+    }
+    session->running = false;
+    QueueStateChange(rt, XR_SESSION_STATE_IDLE);
+    if (session->exitRequested) {
+        QueueStateChange(rt, XR_SESSION_STATE_EXITING);
+    }
+    rt.cv.notify_all();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || eventData == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (rt.events.empty()) {
+        return XR_EVENT_UNAVAILABLE;
+    }
+    *eventData = rt.events.front();
+    rt.events.pop_front();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrStringToPath(XrInstance instance, const char* pathString,
+                                       XrPath* path) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || pathString == nullptr || path == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const std::string value(pathString);
+    if (value.empty() || value.front() != '/' || value.back() == '/') {
+        return XR_ERROR_PATH_FORMAT_INVALID;
+    }
+    const auto found = std::find(rt.paths.begin(), rt.paths.end(), value);
+    if (found != rt.paths.end()) {
+        *path = static_cast<XrPath>(found - rt.paths.begin()) + 1;
+        return XR_SUCCESS;
+    }
+    rt.paths.push_back(value);
+    *path = static_cast<XrPath>(rt.paths.size());
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrCreateActionSet(XrInstance instance,
+                                          const XrActionSetCreateInfo* createInfo,
+                                          XrActionSet* actionSet) {
+    if (instance == XR_NULL_HANDLE || createInfo == nullptr || actionSet == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    auto* created = new XrActionSet_T{};
+    created->name = createInfo->actionSetName;
+    *actionSet = created;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroyActionSet(XrActionSet actionSet) {
+    if (actionSet == XR_NULL_HANDLE) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    std::lock_guard<std::mutex> lock(GetRuntime().mutex);
+    for (XrAction_T* action : actionSet->actions) {
+        action->set = nullptr;
+    }
+    delete actionSet;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrCreateAction(XrActionSet actionSet,
+                                       const XrActionCreateInfo* createInfo, XrAction* action) {
+    if (actionSet == XR_NULL_HANDLE || createInfo == nullptr || action == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    std::lock_guard<std::mutex> lock(GetRuntime().mutex);
+    if (actionSet->attached) {
+        return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+    }
+    auto* created = new XrAction_T{};
+    created->set = actionSet;
+    created->name = createInfo->actionName;
+    created->type = createInfo->actionType;
+    created->subactionPaths.assign(
+        createInfo->subactionPaths, createInfo->subactionPaths + createInfo->countSubactionPaths);
+    actionSet->actions.push_back(created);
+    *action = created;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroyAction(XrAction action) {
+    if (action == XR_NULL_HANDLE) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    std::lock_guard<std::mutex> lock(GetRuntime().mutex);
+    if (action->set != nullptr) {
+        auto& actions = action->set->actions;
+        actions.erase(std::remove(actions.begin(), actions.end(), action), actions.end());
+    }
+    delete action;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrSuggestInteractionProfileBindings(
+    XrInstance instance, const XrInteractionProfileSuggestedBinding* suggestedBindings) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || suggestedBindings == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const std::string* profile = PathString(rt, suggestedBindings->interactionProfile);
+    if (profile == nullptr || (*profile != "/interaction_profiles/oculus/touch_controller" &&
+                               *profile != "/interaction_profiles/khr/simple_controller")) {
+        return XR_ERROR_PATH_UNSUPPORTED;
+    }
+    std::vector<XrActionSuggestedBinding> bindings;
+    for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; ++i) {
+        const XrActionSuggestedBinding& binding = suggestedBindings->suggestedBindings[i];
+        const std::string* path = PathString(rt, binding.binding);
+        const bool handInput = path != nullptr && (path->rfind("/user/hand/left/input/", 0) == 0 ||
+                                                   path->rfind("/user/hand/right/input/", 0) == 0);
+        if (!handInput || binding.action == XR_NULL_HANDLE) {
+            return XR_ERROR_PATH_UNSUPPORTED;
+        }
+        if (binding.action->set != nullptr && binding.action->set->attached) {
+            return XR_ERROR_ACTIONSETS_ALREADY_ATTACHED;
+        }
+        bindings.push_back(binding);
+    }
+    // Each call replaces the previous suggestion for the profile.
+    instance->suggestedBindings[suggestedBindings->interactionProfile] = std::move(bindings);
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrAttachSessionActionSets(XrSession session,
+                                                  const XrSessionActionSetsAttachInfo* attachInfo) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || attachInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (!session->attachedSets.empty()) {
+        return Invalid(rt, XR_ERROR_ACTIONSETS_ALREADY_ATTACHED, "action sets attached twice");
+    }
+    for (uint32_t i = 0; i < attachInfo->countActionSets; ++i) {
+        attachInfo->actionSets[i]->attached = true;
+        session->attachedSets.push_back(attachInfo->actionSets[i]);
+    }
+    // Like a Touch-controller headset: prefer that profile when the app suggested it.
+    for (const auto& [profile, bindings] : rt.instance->suggestedBindings) {
+        const std::string* name = PathString(rt, profile);
+        if (session->activeProfile == XR_NULL_PATH ||
+            (name != nullptr && name->find("oculus") != std::string::npos)) {
+            session->activeProfile = profile;
+        }
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || syncInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    ++rt.syncedActions;
+    for (uint32_t i = 0; i < syncInfo->countActiveActionSets; ++i) {
+        const XrActionSet set = syncInfo->activeActionSets[i].actionSet;
+        if (std::find(session->attachedSets.begin(), session->attachedSets.end(), set) ==
+            session->attachedSets.end()) {
+            return Invalid(rt, XR_ERROR_ACTIONSET_NOT_ATTACHED, "xrSyncActions set not attached");
+        }
+    }
+    if (session->state != XR_SESSION_STATE_FOCUSED) {
+        session->inputs.clear();
+        return XR_SESSION_NOT_FOCUSED;
+    }
+
+    const ScriptSample sample = SampleScript(rt.script, ScriptTime(rt, rt.lastDisplayTime));
+    for (auto& [path, state] : session->inputs) {
+        state.changed = false;
+        if (sample.inputs.find(path) == sample.inputs.end() &&
+            (state.value.x != 0.0f || state.value.y != 0.0f)) {
+            state = {{}, rt.lastDisplayTime, true};
+        }
+    }
+    for (const auto& [path, value] : sample.inputs) {
+        InputState& state = session->inputs[path];
+        if (state.value.x != value.x || state.value.y != value.y) {
+            state = {value, rt.lastDisplayTime, true};
+        }
+    }
+    return XR_SUCCESS;
+}
+
+namespace {
+
+// Collects the scripted values bound to an action for the active profile, filtered to the
+// requested hand.
+XrResult ReadActionInputs(Runtime& rt, XrSession session, const XrActionStateGetInfo* getInfo,
+                          const XrActionType type, std::vector<const InputState*>& outInputs) {
+    if (session != rt.session || getInfo == nullptr || getInfo->action == XR_NULL_HANDLE) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const XrAction action = getInfo->action;
+    if (action->type != type) {
+        return Invalid(rt, XR_ERROR_ACTION_TYPE_MISMATCH, action->name.c_str());
+    }
+    if (action->set == nullptr || !action->set->attached) {
+        return Invalid(rt, XR_ERROR_ACTIONSET_NOT_ATTACHED, action->name.c_str());
+    }
+    const std::string* handPrefix = nullptr;
+    if (getInfo->subactionPath != XR_NULL_PATH) {
+        if (std::find(action->subactionPaths.begin(), action->subactionPaths.end(),
+                      getInfo->subactionPath) == action->subactionPaths.end()) {
+            return Invalid(rt, XR_ERROR_PATH_UNSUPPORTED, "subaction path not declared");
+        }
+        handPrefix = PathString(rt, getInfo->subactionPath);
+    }
+
+    const auto profile = rt.instance->suggestedBindings.find(session->activeProfile);
+    if (profile == rt.instance->suggestedBindings.end()) {
+        return XR_SUCCESS;
+    }
+    static const InputState kIdle{};
+    for (const XrActionSuggestedBinding& binding : profile->second) {
+        const std::string* path = PathString(rt, binding.binding);
+        if (binding.action != action || path == nullptr ||
+            (handPrefix != nullptr && path->rfind(*handPrefix + "/", 0) != 0)) {
+            continue;
+        }
+        const auto input = session->inputs.find(*path);
+        outInputs.push_back(input != session->inputs.end() ? &input->second : &kIdle);
+    }
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+MOCK_XR_EXPORT XrResult xrGetActionStateBoolean(XrSession session,
+                                                const XrActionStateGetInfo* getInfo,
+                                                XrActionStateBoolean* state) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    std::vector<const InputState*> inputs;
+    const XrResult result =
+        ReadActionInputs(rt, session, getInfo, XR_ACTION_TYPE_BOOLEAN_INPUT, inputs);
+    if (XR_FAILED(result) || state == nullptr) {
+        return XR_FAILED(result) ? result : XR_ERROR_VALIDATION_FAILURE;
+    }
+    *state = {XR_TYPE_ACTION_STATE_BOOLEAN};
+    state->isActive = inputs.empty() ? XR_FALSE : XR_TRUE;
+    for (const InputState* input : inputs) {
+        state->currentState |= input->value.x > 0.5f ? XR_TRUE : XR_FALSE;
+        state->changedSinceLastSync |= input->changed ? XR_TRUE : XR_FALSE;
+        state->lastChangeTime = std::max(state->lastChangeTime, input->lastChangeTime);
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrGetActionStateFloat(XrSession session,
+                                              const XrActionStateGetInfo* getInfo,
+                                              XrActionStateFloat* state) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    std::vector<const InputState*> inputs;
+    const XrResult result =
+        ReadActionInputs(rt, session, getInfo, XR_ACTION_TYPE_FLOAT_INPUT, inputs);
+    if (XR_FAILED(result) || state == nullptr) {
+        return XR_FAILED(result) ? result : XR_ERROR_VALIDATION_FAILURE;
+    }
+    *state = {XR_TYPE_ACTION_STATE_FLOAT};
+    state->isActive = inputs.empty() ? XR_FALSE : XR_TRUE;
+    for (const InputState* input : inputs) {
+        if (std::abs(input->value.x) > std::abs(state->currentState)) {
+            state->currentState = input->value.x;
+        }
+        state->changedSinceLastSync |= input->changed ? XR_TRUE : XR_FALSE;
+        state->lastChangeTime = std::max(state->lastChangeTime, input->lastChangeTime);
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrGetActionStateVector2f(XrSession session,
+                                                 const XrActionStateGetInfo* getInfo,
+                                                 XrActionStateVector2f* state) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    std::vector<const InputState*> inputs;
+    const XrResult result =
+        ReadActionInputs(rt, session, getInfo, XR_ACTION_TYPE_VECTOR2F_INPUT, inputs);
+    if (XR_FAILED(result) || state == nullptr) {
+        return XR_FAILED(result) ? result : XR_ERROR_VALIDATION_FAILURE;
+    }
+    *state = {XR_TYPE_ACTION_STATE_VECTOR2F};
+    state->isActive = inputs.empty() ? XR_FALSE : XR_TRUE;
+    float bestLength = 0.0f;
+    for (const InputState* input : inputs) {
+        const float length = input->value.x * input->value.x + input->value.y * input->value.y;
+        if (length > bestLength) {
+            bestLength = length;
+            state->currentState = input->value;
+        }
+        state->changedSinceLastSync |= input->changed ? XR_TRUE : XR_FALSE;
+        state->lastChangeTime = std::max(state->lastChangeTime, input->lastChangeTime);
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrCreateReferenceSpace(XrSession session,
+                                               const XrReferenceSpaceCreateInfo* createInfo,
+                                               XrSpace* space) {
+    if (session == XR_NULL_HANDLE || createInfo == nullptr || space == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (createInfo->referenceSpaceType != XR_REFERENCE_SPACE_TYPE_VIEW &&
+        createInfo->referenceSpaceType != XR_REFERENCE_SPACE_TYPE_LOCAL &&
+        createInfo->referenceSpaceType != XR_REFERENCE_SPACE_TYPE_STAGE) {
+        return XR_ERROR_REFERENCE_SPACE_UNSUPPORTED;
+    }
+    *space = new XrSpace_T{createInfo->referenceSpaceType, createInfo->poseInReferenceSpace};
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroySpace(XrSpace space) {
+    if (space == XR_NULL_HANDLE) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    delete space;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrEnumerateViewConfigurationViews(
+    XrInstance instance,
+    XrSystemId systemId,
+    XrViewConfigurationType viewConfigurationType,
+    uint32_t capacity,
+    uint32_t* countOutput,
+    XrViewConfigurationView* views) {
+    if (instance == XR_NULL_HANDLE || systemId != kSystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    XrViewConfigurationView view{XR_TYPE_VIEW_CONFIGURATION_VIEW};
+    view.recommendedImageRectWidth = kRecommendedEyeSize;
+    view.recommendedImageRectHeight = kRecommendedEyeSize;
+    view.maxImageRectWidth = kMaxEyeSize;
+    view.maxImageRectHeight = kMaxEyeSize;
+    view.recommendedSwapchainSampleCount = 1;
+    view.maxSwapchainSampleCount = 4;
+    const std::array<XrViewConfigurationView, kViewCount> source = {view, view};
+    return TwoCall(capacity, countOutput, views, source.data(), kViewCount);
+}
+
+MOCK_XR_EXPORT XrResult xrLocateViews(XrSession session, const XrViewLocateInfo* locateInfo,
+                                      XrViewState* viewState, uint32_t capacity,
+                                      uint32_t* countOutput, XrView* views) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || locateInfo == nullptr || viewState == nullptr ||
+        locateInfo->space == XR_NULL_HANDLE) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (locateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    if (locateInfo->displayTime <= 0) {
+        return Invalid(rt, XR_ERROR_TIME_INVALID, "xrLocateViews display time");
+    }
+
+    const ScriptSample sample = SampleScript(rt.script, ScriptTime(rt, locateInfo->displayTime));
+    const XrPosef head = HeadPose(sample);
+    // VIEW space follows the head; LOCAL and STAGE share an origin in this runtime.
+    const XrPosef headInSpace =
+        locateInfo->space->type == XR_REFERENCE_SPACE_TYPE_VIEW
+            ? InversePose(locateInfo->space->pose)
+            : ComposePose(InversePose(locateInfo->space->pose), head);
+
+    std::array<XrView, kViewCount> located{};
+    for (uint32_t eye = 0; eye < kViewCount; ++eye) {
+        const float side = eye == 0 ? -0.5f : 0.5f;
+        const XrPosef eyeInHead{{0.0f, 0.0f, 0.0f, 1.0f}, {side * kIpd, 0.0f, 0.0f}};
+        located[eye] = {XR_TYPE_VIEW};
+        located[eye].pose = ComposePose(headInSpace, eyeInHead);
+        located[eye].fov = {-kHalfFov, kHalfFov, kHalfFov, -kHalfFov};
+    }
+    viewState->viewStateFlags =
+        XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT;
+
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = kViewCount;
+    if (capacity == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity < kViewCount) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t eye = 0; eye < kViewCount; ++eye) {
+        views[eye].pose = located[eye].pose;
+        views[eye].fov = located[eye].fov;
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrEnumerateSwapchainFormats(XrSession session, uint32_t capacity,
+                                                    uint32_t* countOutput, int64_t* formats) {
+    if (session == XR_NULL_HANDLE) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    return TwoCall(capacity, countOutput, formats, kSwapchainFormats.data(),
+                   static_cast<uint32_t>(kSwapchainFormats.size()));
+}
+
+MOCK_XR_EXPORT XrResult xrCreateSwapchain(XrSession session,
+                                          const XrSwapchainCreateInfo* createInfo,
+                                          XrSwapchain* swapchain) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || createInfo == nullptr || swapchain == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (std::find(kSwapchainFormats.begin(), kSwapchainFormats.end(), createInfo->format) ==
+        kSwapchainFormats.end()) {
+        return Invalid(rt, XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED, "swapchain format");
+    }
+    if (createInfo->width == 0 || createInfo->height == 0 || createInfo->width > kMaxEyeSize ||
+        createInfo->height > kMaxEyeSize || createInfo->faceCount != 1 ||
+        createInfo->arraySize != 1 || createInfo->mipCount != 1 ||
+        createInfo->sampleCount != 1) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "swapchain dimensions");
+    }
+    // Images live in the app's share group, which is what the session was bound to.
+    if (eglGetCurrentContext() == EGL_NO_CONTEXT) {
+        return Invalid(rt, XR_ERROR_RUNTIME_FAILURE, "xrCreateSwapchain without a current context");
+    }
+
+    auto* created = new XrSwapchain_T{};
+    created->format = createInfo->format;
+    created->depth =
+        (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0;
+    created->width = createInfo->width;
+    created->height = createInfo->height;
+    created->images.resize(kSwapchainImageCount);
+    glGenTextures(kSwapchainImageCount, created->images.data());
+    for (const GLuint image : created->images) {
+        glBindTexture(GL_TEXTURE_2D, image);
+        glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(createInfo->format),
+                       static_cast<GLsizei>(createInfo->width),
+                       static_cast<GLsizei>(createInfo->height));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    *swapchain = created;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrDestroySwapchain(XrSwapchain swapchain) {
+    if (swapchain == XR_NULL_HANDLE) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    // Without a current context the textures go away with the share group instead.
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+        glDeleteTextures(static_cast<GLsizei>(swapchain->images.size()),
+                         swapchain->images.data());
+    }
+    delete swapchain;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t capacity,
+                                                   uint32_t* countOutput,
+                                                   XrSwapchainImageBaseHeader* images) {
+    if (swapchain == XR_NULL_HANDLE || countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const auto count = static_cast<uint32_t>(swapchain->images.size());
+    *countOutput = count;
+    if (capacity == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    auto* glesImages = reinterpret_cast<XrSwapchainImageOpenGLESKHR*>(images);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (glesImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR) {
+            return XR_ERROR_VALIDATION_FAILURE;
+        }
+        glesImages[i].image = swapchain->images[i];
+    }
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrAcquireSwapchainImage(XrSwapchain swapchain,
+                                                const XrSwapchainImageAcquireInfo* acquireInfo,
+                                                uint32_t* index) {
+    (void)acquireInfo;
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (swapchain == XR_NULL_HANDLE || index == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (swapchain->acquired.size() >= swapchain->images.size()) {
+        return Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "every swapchain image already acquired");
+    }
+    *index = swapchain->nextImage;
+    swapchain->acquired.push_back(swapchain->nextImage);
+    if (swapchain->depth) {
+        ++rt.depthImagesAcquired;
+    }
+    if (swapchain->acquired.size() == 1) {
+        swapchain->oldestWaited = false;
+    }
+    swapchain->nextImage = (swapchain->nextImage + 1) % swapchain->images.size();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrWaitSwapchainImage(XrSwapchain swapchain,
+                                             const XrSwapchainImageWaitInfo* waitInfo) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (swapchain == XR_NULL_HANDLE || waitInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (swapchain->acquired.empty() || swapchain->oldestWaited) {
+        return Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "xrWaitSwapchainImage without acquire");
+    }
+    swapchain->oldestWaited = true;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrReleaseSwapchainImage(XrSwapchain swapchain,
+                                                const XrSwapchainImageReleaseInfo* releaseInfo) {
+    (void)releaseInfo;
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (swapchain == XR_NULL_HANDLE) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (swapchain->acquired.empty() || !swapchain->oldestWaited) {
+        return Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "xrReleaseSwapchainImage before wait");
+    }
+    swapchain->lastReleased = static_cast<int>(swapchain->acquired.front());
+    rt.releasesThisFrame++;
+    swapchain->acquired.pop_front();
+    // The next acquired image, if any, still has to be waited on.
+    swapchain->oldestWaited = false;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo,
+                                    XrFrameState* frameState) {
+    (void)frameWaitInfo;
+    Runtime& rt = GetRuntime();
+    std::unique_lock<std::mutex> lock(rt.mutex);
+    if (session != rt.session || frameState == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    // Frame N+1 may not be waited for until frame N has begun.
+    rt.cv.wait(lock, [&rt, session] {
+        return rt.session != session || !session->running || rt.begunFrames == rt.waitedFrames;
+    });
+    if (rt.session != session || !session->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+
+    const XrDuration period = PeriodNs(rt.refreshRate);
+    const auto now = std::chrono::steady_clock::now();
+    if (rt.nextDisplayTime == 0) {
+        rt.nextDisplayTime = SteadyNowNs() + period;
+        rt.nextWake = now;
+    } else {
+        rt.nextDisplayTime += period;
+        rt.nextWake += std::chrono::nanoseconds(period);
+    }
+    // Display times advance by exactly one period per frame so scripted poses are
+    // reproducible; only the wake-up follows the wall clock.
+    const XrTime displayTime = rt.nextDisplayTime;
+    if (rt.restartScript) {
+        rt.scriptStart = displayTime;
+        rt.restartScript = false;
+    }
+    if (rt.throttle) {
+        if (now - rt.nextWake > std::chrono::milliseconds(100)) {
+            rt.nextWake = now;
+        }
+        const auto wake = rt.nextWake;
+        lock.unlock();
+        std::this_thread::sleep_until(wake);
+        lock.lock();
+    }
+
+    rt.waitedFrames++;
+    rt.lastDisplayTime = displayTime;
+    frameState->predictedDisplayTime = displayTime;
+    frameState->predictedDisplayPeriod = period;
+    frameState->shouldRender = (session->state == XR_SESSION_STATE_VISIBLE ||
+                                session->state == XR_SESSION_STATE_FOCUSED)
+                                   ? XR_TRUE
+                                   : XR_FALSE;
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo) {
+    (void)frameBeginInfo;
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (!session->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (rt.begunFrames >= rt.waitedFrames) {
+        return Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "xrBeginFrame without xrWaitFrame");
+    }
+    XrResult result = XR_SUCCESS;
+    if (rt.begunFrames > rt.endedFrames) {
+        // The previous frame was never ended; it is discarded.
+        rt.endedFrames = rt.begunFrames;
+        result = XR_FRAME_DISCARDED;
+    }
+    rt.begunFrames++;
+    rt.beginCpuMs = ThreadCpuMs();
+    rt.releasesThisFrame = 0;
+    rt.cv.notify_all();
+    return result;
+}
+
+MOCK_XR_EXPORT XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    const double endCpuMs = ThreadCpuMs();
+    if (session != rt.session || frameEndInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (!session->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (rt.begunFrames <= rt.endedFrames) {
+        return Invalid(rt, XR_ERROR_CALL_ORDER_INVALID, "xrEndFrame without xrBeginFrame");
+    }
+    if (frameEndInfo->displayTime <= 0) {
+        return Invalid(rt, XR_ERROR_TIME_INVALID, "xrEndFrame display time");
+    }
+    if (frameEndInfo->environmentBlendMode != XR_ENVIRONMENT_BLEND_MODE_OPAQUE) {
+        return Invalid(rt, XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED, "blend mode");
+    }
+
+    const XrCompositionLayerProjection* projection = nullptr;
+    for (uint32_t i = 0; i < frameEndInfo->layerCount; ++i) {
+        const XrCompositionLayerBaseHeader* layer = frameEndInfo->layers[i];
+        if (layer == nullptr) {
+            return Invalid(rt, XR_ERROR_LAYER_INVALID, "null layer");
+        }
+        if (layer->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+            const auto* candidate = reinterpret_cast<const XrCompositionLayerProjection*>(layer);
+            const XrResult result = ValidateProjection(rt, *candidate);
+            if (XR_FAILED(result)) {
+                return result;
+            }
+            projection = projection != nullptr ? projection : candidate;
+        } else if (layer->type == XR_TYPE_COMPOSITION_LAYER_QUAD) {
+            const auto* quad = reinterpret_cast<const XrCompositionLayerQuad*>(layer);
+            const XrResult result = ValidateSubImage(rt, quad->subImage, false, "quad layer");
+            if (XR_FAILED(result)) {
+                return result;
+            }
+        } else {
+            return Invalid(rt, XR_ERROR_LAYER_INVALID, "unsupported layer type");
+        }
+    }
+
+    if (rt.captureRequested && projection != nullptr) {
+        // Compositors sample the image each swapchain released last.
+        bool captured = eglGetCurrentContext() != EGL_NO_CONTEXT;
+        for (uint32_t eye = 0; captured && eye < kViewCount; ++eye) {
+            const XrSwapchainSubImage& subImage = projection->views[eye].subImage;
+            const GLuint texture = subImage.swapchain->images[subImage.swapchain->lastReleased];
+            captured = ReadImage(texture, subImage.imageRect, rt.capture[eye]);
+            rt.captureWidth[eye] = subImage.imageRect.extent.width;
+            rt.captureHeight[eye] = subImage.imageRect.extent.height;
+        }
+        rt.captureRequested = false;
+        rt.captureReady = captured;
+        if (!captured) {
+            std::fprintf(stderr, "mock-xr: capture failed (no context or incomplete FBO)\n");
+        }
+    }
+
+    // A frame that released no image resubmits the previous one and is timed separately.
+    if (rt.releasesThisFrame == 0) {
+        rt.resubmittedFrames++;
+    } else if (rt.frameCpuMs.size() < kMaxFrameTimes) {
+        rt.frameCpuMs.push_back(endCpuMs - rt.beginCpuMs);
+    }
+    rt.releasesThisFrame = 0;
+    rt.endedFrames++;
+    rt.cv.notify_all();
+    return XR_SUCCESS;
+}
+
+MOCK_XR_EXPORT XrResult xrResultToString(XrInstance instance, XrResult value,
+                                         char buffer[XR_MAX_RESULT_STRING_SIZE]) {
+    if (instance == XR_NULL_HANDLE || buffer == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    std::snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_RESULT_%d", static_cast<int>(value));
+    return XR_SUCCESS;
+}
+
+namespace {
+
+XrResult MockEnumerateDisplayRefreshRatesFB(XrSession session, uint32_t capacity,
+                                            uint32_t* countOutput, float* rates) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    return TwoCall(capacity, countOutput, rates, rt.refreshRates.data(),
+                   static_cast<uint32_t>(rt.refreshRates.size()));
+}
+
+XrResult MockGetDisplayRefreshRateFB(XrSession session, float* rate) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session || rate == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *rate = rt.refreshRate;
+    return XR_SUCCESS;
+}
+
+// XrTime is steady_clock nanoseconds, which is CLOCK_MONOTONIC on Linux as on Android.
+XrResult MockConvertTimeToTimespecTimeKHR(XrInstance instance, XrTime time,
+                                          timespec* timespecTime) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || timespecTime == nullptr || time <= 0) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    timespecTime->tv_sec = static_cast<time_t>(time / 1000000000);
+    timespecTime->tv_nsec = static_cast<long>(time % 1000000000);
+    return XR_SUCCESS;
+}
+
+XrResult MockConvertTimespecTimeToTimeKHR(XrInstance instance, const timespec* timespecTime,
+                                          XrTime* time) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (instance != rt.instance || timespecTime == nullptr || time == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *time = static_cast<XrTime>(timespecTime->tv_sec) * 1000000000 + timespecTime->tv_nsec;
+    return XR_SUCCESS;
+}
+
+XrResult MockSetAndroidApplicationThreadKHR(
+    XrSession session, XrAndroidThreadTypeKHR threadType, uint32_t threadId) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session == XR_NULL_HANDLE || session != rt.session) {
+        return Invalid(rt, XR_ERROR_HANDLE_INVALID, "xrSetAndroidApplicationThreadKHR session");
+    }
+    if (threadType < XR_ANDROID_THREAD_TYPE_APPLICATION_MAIN_KHR ||
+        threadType > XR_ANDROID_THREAD_TYPE_RENDERER_WORKER_KHR) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "xrSetAndroidApplicationThreadKHR type");
+    }
+    // The id must name a thread of this process, as on Android.
+    char taskPath[64];
+    std::snprintf(taskPath, sizeof(taskPath), "/proc/self/task/%u", threadId);
+    if (std::ifstream(taskPath + std::string("/stat")).fail()) {
+        return Invalid(rt, XR_ERROR_VALIDATION_FAILURE, "xrSetAndroidApplicationThreadKHR tid");
+    }
+    rt.androidThreadTypes |= 1u << threadType;
+    return XR_SUCCESS;
+}
+
+XrResult MockRequestDisplayRefreshRateFB(XrSession session, float rate) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (session != rt.session) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    // 0 asks for the runtime default.
+    const float target = rate == 0.0f ? rt.refreshRates.front() : rate;
+    if (std::find(rt.refreshRates.begin(), rt.refreshRates.end(), target) ==
+        rt.refreshRates.end()) {
+        return Invalid(rt, XR_ERROR_DISPLAY_REFRESH_RATE_UNSUPPORTED_FB, "refresh rate");
+    }
+    if (target != rt.refreshRate) {
+        XrEventDataDisplayRefreshRateChangedFB event{
+            XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB};
+        event.fromDisplayRefreshRate = rt.refreshRate;
+        event.toDisplayRefreshRate = target;
+        XrEventDataBuffer buffer{XR_TYPE_EVENT_DATA_BUFFER};
+        std::memcpy(&buffer, &event, sizeof(event));
+        rt.events.push_back(buffer);
+        rt.refreshRate = target;
+    }
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+MOCK_XR_EXPORT XrResult xrGetInstanceProcAddr(XrInstance instance, const char* name,
+                                              PFN_xrVoidFunction* function) {
+    if (name == nullptr || function == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *function = nullptr;
+
+#define MOCK_XR_ENTRY(entryName, entryPoint)                                  \
+    if (std::strcmp(name, entryName) == 0) {                                  \
+        *function = reinterpret_cast<PFN_xrVoidFunction>(&(entryPoint));      \
+        return XR_SUCCESS;                                                    \
+    }
+
+    // Only these may be queried before an instance exists.
+    MOCK_XR_ENTRY("xrGetInstanceProcAddr", xrGetInstanceProcAddr)
+    MOCK_XR_ENTRY("xrEnumerateInstanceExtensionProperties", xrEnumerateInstanceExtensionProperties)
+    MOCK_XR_ENTRY("xrEnumerateApiLayerProperties", xrEnumerateApiLayerProperties)
+    MOCK_XR_ENTRY("xrCreateInstance", xrCreateInstance)
+    if (instance == XR_NULL_HANDLE) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+
+    MOCK_XR_ENTRY("xrDestroyInstance", xrDestroyInstance)
+    MOCK_XR_ENTRY("xrResultToString", xrResultToString)
+    MOCK_XR_ENTRY("xrGetSystem", xrGetSystem)
+    MOCK_XR_ENTRY("xrCreateSession", xrCreateSession)
+    MOCK_XR_ENTRY("xrDestroySession", xrDestroySession)
+    MOCK_XR_ENTRY("xrBeginSession", xrBeginSession)
+    MOCK_XR_ENTRY("xrEndSession", xrEndSession)
+    MOCK_XR_ENTRY("xrPollEvent", xrPollEvent)
+    MOCK_XR_ENTRY("xrStringToPath", xrStringToPath)
+    MOCK_XR_ENTRY("xrCreateActionSet", xrCreateActionSet)
+    MOCK_XR_ENTRY("xrDestroyActionSet", xrDestroyActionSet)
+    MOCK_XR_ENTRY("xrCreateAction", xrCreateAction)
+    MOCK_XR_ENTRY("xrDestroyAction", xrDestroyAction)
+    MOCK_XR_ENTRY("xrSuggestInteractionProfileBindings", xrSuggestInteractionProfileBindings)
+    MOCK_XR_ENTRY("xrAttachSessionActionSets", xrAttachSessionActionSets)
+    MOCK_XR_ENTRY("xrSyncActions", xrSyncActions)
+    MOCK_XR_ENTRY("xrGetActionStateBoolean", xrGetActionStateBoolean)
+    MOCK_XR_ENTRY("xrGetActionStateFloat", xrGetActionStateFloat)
+    MOCK_XR_ENTRY("xrGetActionStateVector2f", xrGetActionStateVector2f)
+    MOCK_XR_ENTRY("xrCreateReferenceSpace", xrCreateReferenceSpace)
+    MOCK_XR_ENTRY("xrDestroySpace", xrDestroySpace)
+    MOCK_XR_ENTRY("xrEnumerateViewConfigurationViews", xrEnumerateViewConfigurationViews)
+    MOCK_XR_ENTRY("xrLocateViews", xrLocateViews)
+    MOCK_XR_ENTRY("xrEnumerateSwapchainFormats", xrEnumerateSwapchainFormats)
+    MOCK_XR_ENTRY("xrCreateSwapchain", xrCreateSwapchain)
+    MOCK_XR_ENTRY("xrDestroySwapchain", xrDestroySwapchain)
+    MOCK_XR_ENTRY("xrEnumerateSwapchainImages", xrEnumerateSwapchainImages)
+    MOCK_XR_ENTRY("xrAcquireSwapchainImage", xrAcquireSwapchainImage)
+    MOCK_XR_ENTRY("xrWaitSwapchainImage", xrWaitSwapchainImage)
+    MOCK_XR_ENTRY("xrReleaseSwapchainImage", xrReleaseSwapchainImage)
+    MOCK_XR_ENTRY("xrWaitFrame", xrWaitFrame)
+    MOCK_XR_ENTRY("xrBeginFrame", xrBeginFrame)
+    MOCK_XR_ENTRY("xrEndFrame", xrEndFrame)
+    MOCK_XR_ENTRY("xrGetOpenGLESGraphicsRequirementsKHR", MockGetOpenGLESGraphicsRequirementsKHR)
+    if (instance->refreshRateEnabled) {
+        MOCK_XR_ENTRY("xrEnumerateDisplayRefreshRatesFB", MockEnumerateDisplayRefreshRatesFB)
+        MOCK_XR_ENTRY("xrGetDisplayRefreshRateFB", MockGetDisplayRefreshRateFB)
+        MOCK_XR_ENTRY("xrRequestDisplayRefreshRateFB", MockRequestDisplayRefreshRateFB)
+    }
+    if (instance->threadSettingsEnabled) {
+        MOCK_XR_ENTRY("xrSetAndroidApplicationThreadKHR", MockSetAndroidApplicationThreadKHR)
+    }
+    if (instance->timespecEnabled) {
+        MOCK_XR_ENTRY("xrConvertTimeToTimespecTimeKHR", MockConvertTimeToTimespecTimeKHR)
+        MOCK_XR_ENTRY("xrConvertTimespecTimeToTimeKHR", MockConvertTimespecTimeToTimeKHR)
+    }
+#undef MOCK_XR_ENTRY
+
+    return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+#ifdef MOCK_XR_LOADER_NEGOTIATION
+MOCK_XR_EXPORT XrResult xrNegotiateLoaderRuntimeInterface(
+    const XrNegotiateLoaderInfo* loaderInfo, XrNegotiateRuntimeRequest* runtimeRequest) {
+    if (loaderInfo == nullptr || runtimeRequest == nullptr ||
+        loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION ||
+        loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+        runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST ||
+        runtimeRequest->structVersion != XR_RUNTIME_INFO_STRUCT_VERSION ||
+        runtimeRequest->structSize != sizeof(XrNegotiateRuntimeRequest)) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    if (loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+    runtimeRequest->getInstanceProcAddr = xrGetInstanceProcAddr;
+    return XR_SUCCESS;
+}
+#endif
+
+MOCK_XR_EXPORT bool MockXrSetScript(const char* text) {
+    std::vector<Keyframe> script;
+    if (!ParseScript(text, script)) {
+        return false;
+    }
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    rt.script = std::move(script);
+    rt.restartScript = true;
+    return true;
+}
+
+MOCK_XR_EXPORT void MockXrSetRefreshRates(const float* rates, size_t count) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (rates == nullptr || count == 0) {
+        return;
+    }
+    rt.refreshRates.assign(rates, rates + count);
+    rt.refreshRate = rates[0];
+}
+
+MOCK_XR_EXPORT void MockXrSetThrottle(bool throttle) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    rt.throttle = throttle;
+}
+
+MOCK_XR_EXPORT void MockXrCaptureNextFrame() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    rt.captureRequested = true;
+    rt.captureReady = false;
+}
+
+MOCK_XR_EXPORT bool MockXrWaitForCapture(int timeoutMs) {
+    Runtime& rt = GetRuntime();
+    std::unique_lock<std::mutex> lock(rt.mutex);
+    return rt.cv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                          [&rt] { return rt.captureReady; });
+}
+
+MOCK_XR_EXPORT bool MockXrCapturedEye(uint32_t eye, MockXrImage* outImage) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (!rt.captureReady || eye >= kViewCount || outImage == nullptr) {
+        return false;
+    }
+    outImage->width = rt.captureWidth[eye];
+    outImage->height = rt.captureHeight[eye];
+    outImage->rgba = rt.capture[eye].data();
+    return true;
+}
+
+MOCK_XR_EXPORT uint64_t MockXrEndedFrameCount() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.endedFrames;
+}
+
+MOCK_XR_EXPORT bool MockXrWaitForEndedFrames(uint64_t frameCount, int timeoutMs) {
+    Runtime& rt = GetRuntime();
+    std::unique_lock<std::mutex> lock(rt.mutex);
+    return rt.cv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                          [&rt, frameCount] { return rt.endedFrames >= frameCount; });
+}
+
+MOCK_XR_EXPORT size_t MockXrTakeFrameCpuTimes(double* outMs, size_t maxCount) {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    const size_t count = std::min(maxCount, rt.frameCpuMs.size());
+    std::copy(rt.frameCpuMs.end() - static_cast<std::ptrdiff_t>(count), rt.frameCpuMs.end(), outMs);
+    rt.frameCpuMs.clear();
+    return count;
+}
+
+MOCK_XR_EXPORT uint64_t MockXrResubmittedFrameCount() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.resubmittedFrames;
+}
+
+MOCK_XR_EXPORT float MockXrDisplayRefreshRate() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.refreshRate;
+}
+
+MOCK_XR_EXPORT uint32_t MockXrAndroidThreadTypes() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.androidThreadTypes;
+}
+
+MOCK_XR_EXPORT uint32_t MockXrValidationErrors() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.validationErrors;
+}
+
+MOCK_XR_EXPORT uint64_t MockXrDepthImagesAcquired() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.depthImagesAcquired;
+}
+
+MOCK_XR_EXPORT uint64_t MockXrSyncActionsCount() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    return rt.syncedActions;
+}
+
+MOCK_XR_EXPORT void MockXrRequestExit() {
+    Runtime& rt = GetRuntime();
+    std::lock_guard<std::mutex> lock(rt.mutex);
+    if (rt.session == XR_NULL_HANDLE) {
+        return;
+    }
+    rt.session->exitRequested = true;
+    if (rt.session->running) {
+        QueueStateChange(rt, XR_SESSION_STATE_STOPPING);
+    } else {
+        QueueStateChange(rt, XR_SESSION_STATE_EXITING);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Control interface of the mock OpenXR runtime. The harness links the runtime directly and
+// drives it through these calls; a loader-hosted instance reads the XR_MOCK_* environment
+// variables instead.
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+
+struct MockXrImage {
+    int width;
+    int height;
+    // Tightly packed RGBA8, top row first.
+    const uint8_t* rgba;
+};
+
+// Replaces the pose/input script. Script time restarts at the next xrWaitFrame.
+// One keyframe per line: "<seconds> key=value ...". Keys: head=x,y,z (metres), yaw=, pitch=
+// (degrees, interpolated), and any /user/... input path with one or two floats (held until
+// the next keyframe that names it). '#' starts a comment.
+bool MockXrSetScript(const char* text);
+// Rates offered through XR_FB_display_refresh_rate; the first one is active at startup.
+void MockXrSetRefreshRates(const float* rates, size_t count);
+// When false, xrWaitFrame returns immediately instead of sleeping to the next refresh.
+void MockXrSetThrottle(bool throttle);
+
+// Captures the projection views submitted by the next xrEndFrame.
+void MockXrCaptureNextFrame();
+bool MockXrWaitForCapture(int timeoutMs);
+bool MockXrCapturedEye(uint32_t eye, MockXrImage* outImage);
+
+uint64_t MockXrEndedFrameCount();
+// Blocks until at least frameCount frames have been ended.
+bool MockXrWaitForEndedFrames(uint64_t frameCount, int timeoutMs);
+// Thread CPU time between xrBeginFrame and xrEndFrame of frames that released new images,
+// oldest first; clears the record.
+size_t MockXrTakeFrameCpuTimes(double* outMs, size_t maxCount);
+// Frames ended without releasing any image, i.e. resubmissions of the previous images.
+uint64_t MockXrResubmittedFrameCount();
+float MockXrDisplayRefreshRate();
+// Bit n is set once a thread was registered as XrAndroidThreadTypeKHR n.
+uint32_t MockXrAndroidThreadTypes();
+// Spec violations seen so far (bad call order, unreleased images, bad rects).
+uint32_t MockXrValidationErrors();
+// Images acquired from depth swapchains so far.
+uint64_t MockXrDepthImagesAcquired();
+// xrSyncActions calls so far.
+uint64_t MockXrSyncActionsCount();
+
+// Queues STOPPING; the session then goes IDLE and EXITING once the app ends it.
+void MockXrRequestExit();
+}
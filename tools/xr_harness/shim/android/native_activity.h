@@ -0,0 +1,11 @@
+#pragma once
+
+// Only the fields XrStereoRenderer hands to the OpenXR loader.
+#include <jni.h>
+
+struct AHardwareBuffer;
+
+struct ANativeActivity {
+    JavaVM* vm = nullptr;
+    jobject clazz = nullptr;
+};
@@ -0,0 +1,4 @@
+#pragma once
+
+// GlRenderer only passes the window through to EGL; host tests render to a pbuffer instead.
+struct ANativeWindow;
@@ -0,0 +1,6 @@
+#pragma once
+
+// Opaque JNI types; the mock runtime never dereferences them.
+struct _JavaVM;
+typedef _JavaVM JavaVM;
+typedef void* jobject;